@@ -22,17 +22,25 @@
  SOFTWARE.
 */
 
+#define _GNU_SOURCE 1
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
 #include <elf.h>
 #include "common.h"
 #include "segment.h"
 #include "parse.h"
+#include "journal.h"
+#include "gnuhash.h"
+#include "dynamic.h"
 #include "cJSON/cJSON.h"
 
 int MODE;
@@ -484,6 +492,12 @@ int create_file(char *elf_name, char *elf_map, uint32_t map_size, uint32_t is_ne
         snprintf(new_name, PATH_LENGTH_NEW, "%s.new", elf_name);
     else
         strncpy(new_name, elf_name, PATH_LENGTH_NEW);
+
+    /* share the unmodified extents with the original file */
+    if (is_new && !copy_file(elf_name, new_name) && !write_modified_extents(new_name, elf_map, map_size)) {
+        INFO("create %s\n", new_name);
+        return 0;
+    }
         
     int fd_new = open(new_name, O_RDWR|O_CREAT|O_TRUNC, 0777);
     if (fd_new < 0) {
@@ -497,6 +511,165 @@ int create_file(char *elf_name, char *elf_map, uint32_t map_size, uint32_t is_ne
     return 0;
 }
 
+/**
+ * @brief 使用reflink克隆文件，新文件与原文件共享数据块（写时复制）
+ * clone a file with FICLONE, the new file shares extents with the source (copy-on-write)
+ * @param src_fd source file descriptor
+ * @param dst_fd destination file descriptor
+ * @return int error code {-1:error,0:sucess}
+ */
+int reflink_file(int src_fd, int dst_fd) {
+#ifdef FICLONE
+    if (ioctl(dst_fd, FICLONE, src_fd) == 0) {
+        return 0;
+    }
+#endif
+    return -1;
+}
+
+/**
+ * @brief 复制文件，优先使用reflink，其次copy_file_range，最后使用普通的读写
+ * copy a file, FICLONE is preferred, then copy_file_range, then read/write
+ * @param src_name source file name
+ * @param dst_name destination file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int copy_file(char *src_name, char *dst_name) {
+    int src_fd, dst_fd;
+    struct stat st, dst_st;
+    char buf[PAGE_SIZE * 16];
+    ssize_t n;
+    loff_t left;
+
+    src_fd = open(src_name, O_RDONLY);
+    if (src_fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    if (fstat(src_fd, &st) < 0) {
+        perror("fstat");
+        close(src_fd);
+        return -1;
+    }
+
+    /* O_TRUNC would empty the source if both names are the same file */
+    if (!stat(dst_name, &dst_st) && dst_st.st_dev == st.st_dev && dst_st.st_ino == st.st_ino) {
+        ERROR("%s and %s are the same file\n", src_name, dst_name);
+        close(src_fd);
+        return -1;
+    }
+
+    dst_fd = open(dst_name, O_RDWR | O_CREAT | O_TRUNC, st.st_mode & 0777);
+    if (dst_fd < 0) {
+        perror("open");
+        close(src_fd);
+        return -1;
+    }
+
+    if (!reflink_file(src_fd, dst_fd)) {
+        goto OK_EXIT;
+    }
+
+    /* in kernel copy, some file systems share the extents as well */
+    left = st.st_size;
+    while (left > 0) {
+        n = copy_file_range(src_fd, NULL, dst_fd, NULL, left, 0);
+        if (n <= 0)
+            break;
+        left -= n;
+    }
+
+    /* fall back to a normal copy from where copy_file_range stopped */
+    if (left > 0) {
+        lseek(src_fd, st.st_size - left, SEEK_SET);
+        lseek(dst_fd, st.st_size - left, SEEK_SET);
+        while ((n = read(src_fd, buf, sizeof(buf))) > 0) {
+            if (write(dst_fd, buf, n) != n) {
+                perror("write");
+                close(src_fd);
+                close(dst_fd);
+                return -1;
+            }
+        }
+        if (n < 0) {
+            perror("read");
+            close(src_fd);
+            close(dst_fd);
+            return -1;
+        }
+    }
+
+OK_EXIT:
+    close(src_fd);
+    close(dst_fd);
+    return 0;
+}
+
+/**
+ * @brief 将内存中的新文件写入已有的文件，只写入与原内容不同的数据块
+ * write the new image over an existing file, only the blocks that differ are written,
+ * so the unmodified extents of a reflinked file stay shared
+ * @param file_name existing file name, usually a copy of the original file
+ * @param map new file content
+ * @param map_size new file size
+ * @return int error code {-1:error,0:sucess}
+ */
+int write_modified_extents(char *file_name, char *map, uint64_t map_size) {
+    int fd;
+    struct stat st;
+    uint8_t *old_map = NULL;
+    uint64_t i, len, common;
+
+    fd = open(file_name, O_RDWR);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+
+    common = st.st_size < map_size ? st.st_size : map_size;
+    if (common) {
+        old_map = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (old_map == MAP_FAILED) {
+            perror("mmap");
+            close(fd);
+            return -1;
+        }
+    }
+
+    for (i = 0; i < map_size; i += PAGE_SIZE) {
+        len = map_size - i < PAGE_SIZE ? map_size - i : PAGE_SIZE;
+        if (i + len <= common && !memcmp(old_map + i, map + i, len))
+            continue;
+        if (pwrite(fd, map + i, len, i) != len) {
+            perror("pwrite");
+            goto ERR_EXIT;
+        }
+    }
+
+    if (st.st_size != map_size && ftruncate(fd, map_size) < 0) {
+        perror("ftruncate");
+        goto ERR_EXIT;
+    }
+
+    if (old_map)
+        munmap(old_map, st.st_size);
+    close(fd);
+    return 0;
+
+ERR_EXIT:
+    if (old_map)
+        munmap(old_map, st.st_size);
+    close(fd);
+    return -1;
+}
+
 /**
  * @description: Create json object from json file
  * @param {char} *name original json file name
@@ -675,6 +848,191 @@ uint64_t get_entry(char *elf_name) {
     }
 }
 
+static int compare_load_addr(const void *a, const void *b) {
+    const load_range_t *x = a, *y = b;
+    if (x->vaddr != y->vaddr)
+        return x->vaddr < y->vaddr ? -1 : 1;
+    return 0;
+}
+
+static int compare_load_offset(const void *a, const void *b) {
+    const load_range_t *x = a, *y = b;
+    if (x->offset != y->offset)
+        return x->offset < y->offset ? -1 : 1;
+    return 0;
+}
+
+/**
+ * @brief 根据程序头表建立LOAD段索引，用于虚拟地址和文件偏移的相互转换
+ * build the PT_LOAD index used to translate virtual addresses and file offsets
+ * @param mem elf file content
+ * @param size elf file size
+ * @param index output, free it with finit_load_index
+ * @return int error code {-1:error,0:sucess}
+ */
+int init_load_index(uint8_t *mem, size_t size, load_index_t *index) {
+    int phnum = 0;
+
+    memset(index, 0, sizeof(load_index_t));
+    if (MODE == ELFCLASS32) {
+        Elf32_Ehdr *ehdr = (Elf32_Ehdr *)mem;
+        Elf32_Phdr *phdr = (Elf32_Phdr *)(mem + ehdr->e_phoff);
+        if (size < sizeof(Elf32_Ehdr) || ehdr->e_phoff + ehdr->e_phnum * sizeof(Elf32_Phdr) > size)
+            return -1;
+        phnum = ehdr->e_phnum;
+        index->by_addr = malloc((phnum + 1) * sizeof(load_range_t));
+        if (!index->by_addr)
+            return -1;
+        for (int i = 0; i < phnum; i++) {
+            if (phdr[i].p_type != PT_LOAD)
+                continue;
+            index->by_addr[index->num].vaddr = phdr[i].p_vaddr;
+            index->by_addr[index->num].offset = phdr[i].p_offset;
+            index->by_addr[index->num].filesz = phdr[i].p_filesz;
+            index->by_addr[index->num].memsz = phdr[i].p_memsz;
+            index->num++;
+        }
+    }
+
+    if (MODE == ELFCLASS64) {
+        Elf64_Ehdr *ehdr = (Elf64_Ehdr *)mem;
+        Elf64_Phdr *phdr = (Elf64_Phdr *)(mem + ehdr->e_phoff);
+        if (size < sizeof(Elf64_Ehdr) || ehdr->e_phoff + ehdr->e_phnum * sizeof(Elf64_Phdr) > size)
+            return -1;
+        phnum = ehdr->e_phnum;
+        index->by_addr = malloc((phnum + 1) * sizeof(load_range_t));
+        if (!index->by_addr)
+            return -1;
+        for (int i = 0; i < phnum; i++) {
+            if (phdr[i].p_type != PT_LOAD)
+                continue;
+            index->by_addr[index->num].vaddr = phdr[i].p_vaddr;
+            index->by_addr[index->num].offset = phdr[i].p_offset;
+            index->by_addr[index->num].filesz = phdr[i].p_filesz;
+            index->by_addr[index->num].memsz = phdr[i].p_memsz;
+            index->num++;
+        }
+    }
+
+    if (!index->by_addr) {
+        return -1;
+    }
+    index->by_offset = malloc((index->num + 1) * sizeof(load_range_t));
+    if (!index->by_offset) {
+        finit_load_index(index);
+        return -1;
+    }
+    memcpy(index->by_offset, index->by_addr, index->num * sizeof(load_range_t));
+    qsort(index->by_addr, index->num, sizeof(load_range_t), compare_load_addr);
+    qsort(index->by_offset, index->num, sizeof(load_range_t), compare_load_offset);
+    return 0;
+}
+
+void finit_load_index(load_index_t *index) {
+    free(index->by_addr);
+    free(index->by_offset);
+    memset(index, 0, sizeof(load_index_t));
+}
+
+/* the last range which starts at or before key, -1 if none */
+static int search_load(load_range_t *ranges, int num, uint64_t key, int by_offset) {
+    int lo = 0, hi = num - 1, found = -1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        uint64_t start = by_offset ? ranges[mid].offset : ranges[mid].vaddr;
+        if (start <= key) {
+            found = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief 将虚拟地址转换为文件偏移，整个区域都必须在文件中
+ * translate a virtual address to a file offset, the whole region must be
+ * backed by the file
+ * @param index PT_LOAD index
+ * @param addr virtual address
+ * @param size region size
+ * @param offset output, file offset
+ * @return int error code {-1:error,0:sucess}
+ */
+int load_addr_to_offset(load_index_t *index, uint64_t addr, uint64_t size, uint64_t *offset) {
+    /* segments may overlap after some edits, step back to the one holding addr */
+    for (int i = search_load(index->by_addr, index->num, addr, 0); i >= 0; i--) {
+        load_range_t *r = &index->by_addr[i];
+        if (addr >= r->vaddr && addr + size <= r->vaddr + r->filesz && addr < r->vaddr + r->filesz) {
+            *offset = addr - r->vaddr + r->offset;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 将文件偏移转换为虚拟地址
+ * translate a file offset to a virtual address
+ * @param index PT_LOAD index
+ * @param offset file offset
+ * @param addr output, virtual address
+ * @return int error code {-1:error,0:sucess}
+ */
+int load_offset_to_addr(load_index_t *index, uint64_t offset, uint64_t *addr) {
+    for (int i = search_load(index->by_offset, index->num, offset, 1); i >= 0; i--) {
+        load_range_t *r = &index->by_offset[i];
+        if (offset >= r->offset && offset < r->offset + r->filesz) {
+            *addr = offset - r->offset + r->vaddr;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 将虚拟地址转换为文件偏移
+ * translate a virtual address of a file to a file offset
+ * @param elf_name elf file name
+ * @param addr virtual address
+ * @param offset output, file offset
+ * @return int error code {-1:error,0:sucess}
+ */
+int addr_to_offset(char *elf_name, uint64_t addr, uint64_t *offset) {
+    int fd;
+    struct stat st;
+    uint8_t *mapped;
+    load_index_t index;
+    int err = -1;
+
+    fd = open(elf_name, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+
+    mapped = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+
+    if (!init_load_index(mapped, st.st_size, &index)) {
+        err = load_addr_to_offset(&index, addr, 1, offset);
+        finit_load_index(&index);
+    }
+    munmap(mapped, st.st_size);
+    return err;
+}
+
 /**
  * @brief Extract binary fragments from the target file
  * 
@@ -770,6 +1128,9 @@ int set_pointer(char *elf_name, uint64_t offset, uint64_t value) {
         ) {
             goto ERR_EXIT;
         }
+        if (journal_region(elf_name, offset, sizeof(*start_addr))) {
+            goto ERR_EXIT;
+        }
         *start_addr = (uint32_t) value;
     }
     if (MODE == ELFCLASS64) {
@@ -779,6 +1140,9 @@ int set_pointer(char *elf_name, uint64_t offset, uint64_t value) {
         ) {
             goto ERR_EXIT;
         }
+        if (journal_region(elf_name, offset, sizeof(*start_addr))) {
+            goto ERR_EXIT;
+        }
         *start_addr = value;
     }
     printf("0x%x->0x%x\n", offset, value);
@@ -836,6 +1200,9 @@ int set_content(char *elf_name, uint64_t offset, char *content, size_t size) {
         goto ERR_EXIT;
     }
 
+    if (journal_region(elf_name, offset, size)) {
+        goto ERR_EXIT;
+    }
     memset(start_addr, 0, size);
     memcpy(start_addr, content, size);
 
@@ -888,39 +1255,21 @@ int set_interpreter(char *elf_name, char *new_interpreter) {
 }
 
 /**
- * @brief 增加一个dynamic条目
- * add a dynamic segment
+ * @brief 增加一个dynamic条目，已存在则替换它的值
+ * add a dynamic item, or replace the value of the existing one
  * @param elf_name elf file name
  * @param dt_tag dynamic tag
- * @param dt_value dynamic value
+ * @param dt_value dynamic string value
  * @return int error code {-1:error,0:sucess}
  */
 int add_dynamic_item(char *elf_name, int dt_tag, char *dt_value) {
-    // use uint64_t instead of int: avoid overflow
-    uint64_t index;
-    uint64_t size;
-
-    index = has_dynamic_by_tag(elf_name, dt_tag);
-    if (index != -1) {
-        VERBOSE("change dynamic %d to PT_NULL\n", dt_tag);
-        set_dyn_tag(elf_name, index, PT_NULL);
-    }
-
-    get_dynamic_value_by_tag(elf_name, DT_STRSZ, &size);
-    VERBOSE("change dynamic PT_NULL value 0x%x\n", size);
-    set_dynamic_value_by_tag(elf_name, PT_NULL, &size);
-    
-    get_dynamic_index_by_tag(elf_name, PT_NULL, &index);
-    VERBOSE("change dynamic [%d] PT_NULL to %d\n", index, dt_tag);
-    set_dyn_tag(elf_name, index, dt_tag);
-
-    VERBOSE("add a new segment for rapth name\n");
-    int result = expand_dynstr_segment(elf_name, dt_value);
-    if (result) {
-        return -1;
-    } else {
-        return 0;
-    }
+    dyn_op_t op;
+    memset(&op, 0, sizeof(op));
+    op.op = DYN_SET;
+    op.tag = dt_tag;
+    op.str = dt_value;
+    op.has_val = 1;
+    return edit_dynamic(elf_name, &op, 1);
 }
 
 /**
@@ -991,7 +1340,7 @@ int hook_extern(char *elf_name, char *symbol, char *hookfile, uint64_t hook_offs
             }
             if (!strncmp(name, symbol, strlen(name))) {
                 offset = get_rel32_offset(&h32, ".rel.plt", i);
-                if (offset == -1) {
+                if (offset == (uint32_t)-1) {
                     goto ERR_EXIT;
                 }
                 break;
@@ -999,6 +1348,9 @@ int hook_extern(char *elf_name, char *symbol, char *hookfile, uint64_t hook_offs
         }
         VERBOSE("%s offset: 0x%x, new value: 0x%x\n", symbol, offset, addr + hook_offset);
         uint32_t *p = (uint32_t *)(h32.mem + offset);
+        if (journal_region(elf_name, offset, sizeof(*p))) {
+            goto ERR_EXIT;
+        }
         *p = addr + hook_offset;
     }
 
@@ -1019,6 +1371,9 @@ int hook_extern(char *elf_name, char *symbol, char *hookfile, uint64_t hook_offs
         }
         VERBOSE("%s offset: 0x%x, new value: 0x%x\n", symbol, offset, addr + hook_offset);
         uint64_t *p = (uint64_t *)(h64.mem + offset);
+        if (journal_region(elf_name, offset, sizeof(*p))) {
+            goto ERR_EXIT;
+        }
         *p = addr + hook_offset;
     }
     
@@ -1030,41 +1385,300 @@ ERR_EXIT:
 }
 
 /**
- * @brief 增加一个.dynsym table条目
- * add a dynamic symbol stable item
+ * @brief 获取地址所在的节索引
+ * get the index of the section which contains the address
+ * @param h32 32-bit elf handle
+ * @param h64 64-bit elf handle
+ * @param addr virtual address
+ * @return section index, SHN_ABS if no section contains it
+ */
+static int get_section_index_by_addr(handle_t32 *h32, handle_t64 *h64, uint64_t addr) {
+    if (MODE == ELFCLASS32) {
+        for (int i = 1; i < h32->ehdr->e_shnum; i++) {
+            Elf32_Shdr *shdr = &h32->shdr[i];
+            if ((shdr->sh_flags & SHF_ALLOC) && addr >= shdr->sh_addr && addr < shdr->sh_addr + shdr->sh_size)
+                return i;
+        }
+    }
+    if (MODE == ELFCLASS64) {
+        for (int i = 1; i < h64->ehdr->e_shnum; i++) {
+            Elf64_Shdr *shdr = &h64->shdr[i];
+            if ((shdr->sh_flags & SHF_ALLOC) && addr >= shdr->sh_addr && addr < shdr->sh_addr + shdr->sh_size)
+                return i;
+        }
+    }
+    return SHN_ABS;
+}
+
+typedef struct sym_order {
+    uint32_t bucket;
+    int index;
+} sym_order_t;
+
+static int compare_sym_order(const void *a, const void *b) {
+    const sym_order_t *x = a, *y = b;
+    if (x->bucket != y->bucket)
+        return x->bucket < y->bucket ? -1 : 1;
+    return x->index - y->index;
+}
+
+/**
+ * @brief GNU hash要求符号按桶排序，获取旧符号和新符号合并后的顺序
+ * the GNU hash table requires the symbols ordered by bucket, get the order of
+ * the old symbols merged with the new ones. index i < dynsym_num is an old
+ * symbol, others are entries[i - dynsym_num]. the unhashed symbols keep their place.
+ * @param h32 elf struct
+ * @param h64 elf struct
+ * @param sec_i .dynsym section index
+ * @param dynsym_num number of old dynamic symbols
+ * @param entries new dynamic symbols
+ * @param count number of new dynamic symbols
+ * @param symndx first hashed symbol
+ * @param nbuckets number of hash buckets
+ * @param order output, old or new symbol index of each slot in the new .dynsym
+ * @return int error code {-1:error,0:sucess}
+ */
+static int get_sym_order(handle_t32 *h32, handle_t64 *h64, int sec_i, size_t dynsym_num, sym_entry_t *entries, int count, size_t symndx, uint32_t nbuckets, int *order) {
+    sym_order_t *keys;
+    size_t key_num;
+    char *name = "";
+
+    key_num = dynsym_num - symndx + count;
+    keys = malloc(key_num * sizeof(sym_order_t));
+    if (!keys) {
+        return -1;
+    }
+    for (size_t i = symndx; i < dynsym_num; i++) {
+        if (MODE == ELFCLASS32) {
+            Elf32_Sym *sym = (Elf32_Sym *)&h32->mem[h32->shdr[sec_i].sh_offset] + i;
+            name = (char *)&h32->mem[h32->shdr[h32->shdr[sec_i].sh_link].sh_offset + sym->st_name];
+        }
+        if (MODE == ELFCLASS64) {
+            Elf64_Sym *sym = (Elf64_Sym *)&h64->mem[h64->shdr[sec_i].sh_offset] + i;
+            name = (char *)&h64->mem[h64->shdr[h64->shdr[sec_i].sh_link].sh_offset + sym->st_name];
+        }
+        keys[i - symndx].bucket = dl_new_hash(name) % nbuckets;
+        keys[i - symndx].index = i;
+    }
+    for (int i = 0; i < count; i++) {
+        keys[dynsym_num - symndx + i].bucket = dl_new_hash(entries[i].name) % nbuckets;
+        keys[dynsym_num - symndx + i].index = dynsym_num + i;
+    }
+    qsort(keys, key_num, sizeof(sym_order_t), compare_sym_order);
+    for (size_t i = 0; i < symndx; i++) {
+        order[i] = i;
+    }
+    for (size_t i = 0; i < key_num; i++) {
+        order[symndx + i] = keys[i].index;
+    }
+    free(keys);
+    return 0;
+}
+
+/**
+ * @brief 符号重排后，更新重定位表中的符号下标
+ * update the symbol index of the relocations after the symbols are reordered
  * @param elf_name elf file name
- * @param name dynamic symbol name
- * @param value dynamic symbol address
- * @param code_size func size
+ * @param map new index of each old symbol
  * @return int error code {-1:error,0:sucess}
  */
-int add_dynsym_entry(char *elf_name, char *name, uint64_t value, size_t code_size) {
-    uint64_t size, dynstr_size;
-    uint64_t addr, offset;
-    int seg_i, sec_i;
-    int ret;
+static int remap_reloc_sym(char *elf_name, int *map) {
+    handle_t32 h32;
+    handle_t64 h64;
+    uint32_t dynsym_i = get_section_index(elf_name, ".dynsym");
+
+    if (init_elf(elf_name, &h32, &h64) < 0) {
+        ERROR("init elf error\n");
+        return -1;
+    }
+
+    if (MODE == ELFCLASS32) {
+        for (int i = 1; i < h32.ehdr->e_shnum; i++) {
+            Elf32_Shdr *shdr = &h32.shdr[i];
+            if (shdr->sh_link != dynsym_i)
+                continue;
+            if (shdr->sh_type == SHT_REL) {
+                Elf32_Rel *rel = (Elf32_Rel *)&h32.mem[shdr->sh_offset];
+                for (size_t j = 0; j < shdr->sh_size / sizeof(Elf32_Rel); j++)
+                    rel[j].r_info = ELF32_R_INFO(map[ELF32_R_SYM(rel[j].r_info)], ELF32_R_TYPE(rel[j].r_info));
+            }
+            if (shdr->sh_type == SHT_RELA) {
+                Elf32_Rela *rela = (Elf32_Rela *)&h32.mem[shdr->sh_offset];
+                for (size_t j = 0; j < shdr->sh_size / sizeof(Elf32_Rela); j++)
+                    rela[j].r_info = ELF32_R_INFO(map[ELF32_R_SYM(rela[j].r_info)], ELF32_R_TYPE(rela[j].r_info));
+            }
+        }
+    }
+
+    if (MODE == ELFCLASS64) {
+        for (int i = 1; i < h64.ehdr->e_shnum; i++) {
+            Elf64_Shdr *shdr = &h64.shdr[i];
+            if (shdr->sh_link != dynsym_i)
+                continue;
+            if (shdr->sh_type == SHT_REL) {
+                Elf64_Rel *rel = (Elf64_Rel *)&h64.mem[shdr->sh_offset];
+                for (size_t j = 0; j < shdr->sh_size / sizeof(Elf64_Rel); j++)
+                    rel[j].r_info = ELF64_R_INFO(map[ELF64_R_SYM(rel[j].r_info)], ELF64_R_TYPE(rel[j].r_info));
+            }
+            if (shdr->sh_type == SHT_RELA) {
+                Elf64_Rela *rela = (Elf64_Rela *)&h64.mem[shdr->sh_offset];
+                for (size_t j = 0; j < shdr->sh_size / sizeof(Elf64_Rela); j++)
+                    rela[j].r_info = ELF64_R_INFO(map[ELF64_R_SYM(rela[j].r_info)], ELF64_R_TYPE(rela[j].r_info));
+            }
+        }
+    }
+
+    finit_elf(&h32, &h64);
+    return 0;
+}
+
+/**
+ * @brief 增加多个.dynsym table条目，只添加一个.dynstr段，一个.dynsym段和一个hash表，同时扩展.gnu.version
+ * add several dynamic symbol table items, with only one new .dynstr segment,
+ * one new .dynsym segment and one hash table, .gnu.version is extended to match.
+ * the hashed symbols are reordered by bucket, .gnu.version and the relocations follow them
+ * @param elf_name elf file name
+ * @param entries dynamic symbols
+ * @param count number of dynamic symbols
+ * @return int error code {-1:error,0:sucess}
+ */
+int add_dynsym_entries(char *elf_name, sym_entry_t *entries, int count) {
+    uint64_t size, addr, offset;
+    uint64_t *name_offsets;
+    uint16_t *shndx;
+    int *order = NULL;
+    int *map = NULL;
+    char **names;
+    char *syms = NULL;
+    char *src_sym = NULL;
+    size_t sym_size;
+    uint16_t *versym = NULL;
+    uint16_t *src_versym = NULL;
+    size_t dynsym_num, versym_num, symndx;
+    uint32_t nbuckets = 1;
+    gnuhash_t *gnuhash = NULL;
+    int moved = 0;
+    handle_t32 h32;
+    handle_t64 h64;
+    int seg_i, sec_i, ver_i;
+    int ret = -1;
+
+    if (count <= 0) {
+        return -1;
+    }
+
+    names = malloc(count * sizeof(char *));
+    name_offsets = malloc(count * sizeof(uint64_t));
+    shndx = malloc(count * sizeof(uint16_t));
+    sym_size = MODE == ELFCLASS32 ? sizeof(Elf32_Sym) : sizeof(Elf64_Sym);
+    if (!names || !name_offsets || !shndx) {
+        goto ERR_EXIT;
+    }
+
+    sec_i = get_section_index(elf_name, ".dynsym");
+    ver_i = get_section_index(elf_name, ".gnu.version");
+    if (sec_i == -1) {
+        ERROR("no .dynsym section\n");
+        goto ERR_EXIT;
+    }
+    dynsym_num = get_section_size(elf_name, ".dynsym") / sym_size;
+    symndx = dynsym_num;
+    if (get_section_index(elf_name, ".gnu.hash") != -1) {
+        if (read_file_offset(elf_name, get_section_offset(elf_name, ".gnu.hash"), sizeof(gnuhash_t), (char **)&gnuhash) == -1) {
+            goto ERR_EXIT;
+        }
+        if (gnuhash->nbuckets) {
+            nbuckets = gnuhash->nbuckets;
+        }
+        if (gnuhash->symndx < dynsym_num) {
+            symndx = gnuhash->symndx;
+        }
+        free(gnuhash);
+    }
+
+    order = malloc((dynsym_num + count) * sizeof(int));
+    map = malloc((dynsym_num + 1) * sizeof(int));
+    syms = calloc(dynsym_num + count, sym_size);
+    versym = malloc((dynsym_num + count) * sizeof(uint16_t));
+    if (!order || !map || !syms || !versym) {
+        goto ERR_EXIT;
+    }
+
+    // 0. reorder the hashed symbols, nothing is written before the new order is known
+    if (init_elf(elf_name, &h32, &h64) < 0) {
+        ERROR("init elf error\n");
+        goto ERR_EXIT;
+    }
+    if (get_sym_order(&h32, &h64, sec_i, dynsym_num, entries, count, symndx, nbuckets, order) == -1) {
+        finit_elf(&h32, &h64);
+        goto ERR_EXIT;
+    }
+    if (MODE == ELFCLASS32)
+        src_sym = (char *)&h32.mem[h32.shdr[sec_i].sh_offset];
+    if (MODE == ELFCLASS64)
+        src_sym = (char *)&h64.mem[h64.shdr[sec_i].sh_offset];
+    versym_num = 0;
+    if (ver_i != -1 && MODE == ELFCLASS32) {
+        src_versym = (uint16_t *)&h32.mem[h32.shdr[ver_i].sh_offset];
+        versym_num = h32.shdr[ver_i].sh_size / sizeof(uint16_t);
+    }
+    if (ver_i != -1 && MODE == ELFCLASS64) {
+        src_versym = (uint16_t *)&h64.mem[h64.shdr[ver_i].sh_offset];
+        versym_num = h64.shdr[ver_i].sh_size / sizeof(uint16_t);
+    }
+    for (size_t i = 0; i < dynsym_num + count; i++) {
+        // the new symbols are global, a short table is also filled up
+        versym[i] = (size_t)order[i] < versym_num ? src_versym[order[i]] : VER_NDX_GLOBAL;
+        if ((size_t)order[i] < dynsym_num) {
+            memcpy(syms + i * sym_size, src_sym + order[i] * sym_size, sym_size);
+            map[order[i]] = i;
+            moved |= (size_t)order[i] != i;
+        } else {
+            // section index of each symbol, the section table is not changed below
+            names[order[i] - dynsym_num] = entries[order[i] - dynsym_num].name;
+            shndx[order[i] - dynsym_num] = get_section_index_by_addr(&h32, &h64, entries[order[i] - dynsym_num].value);
+        }
+    }
+    finit_elf(&h32, &h64);
 
     // 1. expand .dynstr section
-    VERBOSE("1. add a new segment for .dynstr entry\n");
-    dynstr_size = get_section_size(elf_name, ".dynstr");
-    seg_i = expand_dynstr_segment(elf_name, name);
+    VERBOSE("1. add a new segment for %d .dynstr entries\n", count);
+    seg_i = expand_dynstr_segment_multi(elf_name, names, count, name_offsets);
     if (seg_i == -1) {
         ERROR("expand .dynstr section error!\n");
-        return -1;
+        goto ERR_EXIT;
     }
 
     // 2. expand .dynsym section
-    VERBOSE("2. add a new segment for .dynsym entry\n");
-    size = get_section_size(elf_name, ".dynsym");
+    VERBOSE("2. add a new segment for %d .dynsym entries\n", count);
+    for (size_t i = 0; i < dynsym_num + count; i++) {
+        int j = order[i] - dynsym_num;
+        if ((size_t)order[i] < dynsym_num)
+            continue;
+        if (MODE == ELFCLASS32) {
+            Elf32_Sym *sym = (Elf32_Sym *)syms + i;
+            sym->st_name = name_offsets[j];
+            sym->st_value = entries[j].value;
+            sym->st_size = entries[j].size;
+            sym->st_info = ELF32_ST_INFO(STB_GLOBAL, entries[j].type);
+            sym->st_other = STV_DEFAULT;
+            sym->st_shndx = shndx[j];
+        }
+        if (MODE == ELFCLASS64) {
+            Elf64_Sym *sym = (Elf64_Sym *)syms + i;
+            sym->st_name = name_offsets[j];
+            sym->st_value = entries[j].value;
+            sym->st_size = entries[j].size;
+            sym->st_info = ELF64_ST_INFO(STB_GLOBAL, entries[j].type);
+            sym->st_other = STV_DEFAULT;
+            sym->st_shndx = shndx[j];
+        }
+    }
     offset = get_section_offset(elf_name, ".dynsym");
-    if (MODE == ELFCLASS64) {
-        Elf64_Sym sym;
-        sym.st_value = value;
-        sym.st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC);
-        sym.st_other = STV_DEFAULT;
-        sym.st_name = dynstr_size;
-        sym.st_size = code_size;
-        seg_i = expand_segment(elf_name, offset, size, &sym, sizeof(Elf64_Sym));
+    seg_i = expand_segment(elf_name, offset, 0, syms, (dynsym_num + count) * sym_size);
+    if (seg_i == -1) {
+        ERROR("expand .dynsym section error!\n");
+        goto ERR_EXIT;
     }
     
     // 3. set phdr
@@ -1073,26 +1687,170 @@ int add_dynsym_entry(char *elf_name, char *name, uint64_t value, size_t code_siz
     offset = get_segment_offset(elf_name, seg_i);
     size = get_segment_memsz(elf_name, seg_i);
     set_dynamic_value_by_tag(elf_name, DT_SYMTAB, &addr);
-    // set_dynamic_value_by_tag(elf_name, DT_SYMENT, &size);       // entry size == size?
     
     // 4. set shdr
     VERBOSE("4. set shdr for .dynsym section\n");
-    sec_i = get_section_index(elf_name, ".dynsym");
     set_section_off(elf_name, sec_i, offset);
     set_section_addr(elf_name, sec_i, addr);
     set_section_size(elf_name, sec_i, size);
-    
-    // 5. compute hash table
-    VERBOSE("5. compute hash table\n");
+
+    // 5. rewrite .gnu.version section, one entry per .dynsym entry
+    if (ver_i != -1 && (moved || versym_num < dynsym_num + count)) {
+        VERBOSE("5. add a new segment for %d .gnu.version entries\n", (int)(dynsym_num + count));
+        offset = get_section_offset(elf_name, ".gnu.version");
+        seg_i = expand_segment(elf_name, offset, 0, (char *)versym, (dynsym_num + count) * sizeof(uint16_t));
+        if (seg_i == -1) {
+            ERROR("expand .gnu.version section error!\n");
+            goto ERR_EXIT;
+        }
+        addr = get_segment_vaddr(elf_name, seg_i);
+        offset = get_segment_offset(elf_name, seg_i);
+        set_dynamic_value_by_tag(elf_name, DT_VERSYM, &addr);
+        set_section_off(elf_name, ver_i, offset);
+        set_section_addr(elf_name, ver_i, addr);
+        set_section_size(elf_name, ver_i, (dynsym_num + count) * sizeof(uint16_t));
+    }
+
+    // 6. update the symbol index of relocations
+    if (moved) {
+        VERBOSE("6. update the symbol index of relocations\n");
+        if (remap_reloc_sym(elf_name, map) == -1) {
+            ERROR("update relocations error\n");
+            goto ERR_EXIT;
+        }
+    }
+
+    // 7. compute hash table
+    VERBOSE("7. compute hash table\n");
     if (MODE == ELFCLASS32)
         ret = set_hash_table32(elf_name);
     if (MODE == ELFCLASS64)
         ret = set_hash_table64(elf_name);
     if (ret == -1) {
         ERROR("compute hash table error\n");
+    }
+
+ERR_EXIT:
+    free(versym);
+    free(syms);
+    free(map);
+    free(order);
+    free(shndx);
+    free(name_offsets);
+    free(names);
+    return ret;
+}
+
+/**
+ * @brief 增加一个.dynsym table条目
+ * add a dynamic symbol stable item
+ * @param elf_name elf file name
+ * @param name dynamic symbol name
+ * @param value dynamic symbol address
+ * @param code_size func size
+ * @return int error code {-1:error,0:sucess}
+ */
+int add_dynsym_entry(char *elf_name, char *name, uint64_t value, size_t code_size) {
+    sym_entry_t entry;
+    entry.name = name;
+    entry.value = value;
+    entry.size = code_size;
+    entry.type = STT_FUNC;
+    return add_dynsym_entries(elf_name, &entry, 1);
+}
+
+/**
+ * @brief 解析符号列表文件，每行格式为：名称,地址,大小[,类型]，#开头为注释
+ * parse the symbol list file, one "name,value,size[,type]" per line, '#' starts a comment.
+ * type is FUNC, OBJECT, NOTYPE or a number, FUNC by default
+ * @param list_name symbol list file name
+ * @param entries output, symbols, free them with free_sym_list
+ * @param count output, number of symbols
+ * @return int error code {-1:error,0:sucess}
+ */
+int parse_sym_list(char *list_name, sym_entry_t **entries, int *count) {
+    char line[1024];
+    char *name, *value, *size, *type;
+    sym_entry_t *list = NULL;
+    int num = 0, cap = 0;
+    int line_num = 0;
+    FILE *fp;
+
+    fp = fopen(list_name, "r");
+    if (!fp) {
+        perror("fopen");
         return -1;
     }
+
+    while (fgets(line, sizeof(line), fp)) {
+        line_num++;
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+
+        name = strtok(line, ", \t\r\n");
+        if (!name) {
+            continue;
+        }
+        value = strtok(NULL, ", \t\r\n");
+        size = strtok(NULL, ", \t\r\n");
+        type = strtok(NULL, ", \t\r\n");
+        if (!value || !size) {
+            ERROR("%s:%d: expect name,value,size[,type]\n", list_name, line_num);
+            goto ERR_EXIT;
+        }
+
+        if (num == cap) {
+            cap = cap ? cap * 2 : 64;
+            sym_entry_t *tmp = realloc(list, cap * sizeof(sym_entry_t));
+            if (!tmp) {
+                goto ERR_EXIT;
+            }
+            list = tmp;
+        }
+
+        list[num].name = strdup(name);
+        list[num].value = strtoull(value, NULL, 0);
+        list[num].size = strtoull(size, NULL, 0);
+        if (!type || !strcasecmp(type, "FUNC"))
+            list[num].type = STT_FUNC;
+        else if (!strcasecmp(type, "OBJECT"))
+            list[num].type = STT_OBJECT;
+        else if (!strcasecmp(type, "NOTYPE"))
+            list[num].type = STT_NOTYPE;
+        else
+            list[num].type = strtoul(type, NULL, 0) & 0xf;
+        num++;
+    }
+    fclose(fp);
+
+    if (!num) {
+        WARNING("%s has no symbol\n", list_name);
+        free(list);
+        return -1;
+    }
+    *entries = list;
+    *count = num;
     return 0;
+
+ERR_EXIT:
+    fclose(fp);
+    free_sym_list(list, num);
+    return -1;
+}
+
+/**
+ * @brief 释放符号列表
+ * free the symbol list
+ * @param entries symbols
+ * @param count number of symbols
+ */
+void free_sym_list(sym_entry_t *entries, int count) {
+    for (int i = 0; i < count; i++) {
+        free(entries[i].name);
+    }
+    free(entries);
 }
 
 /**
@@ -38,18 +38,22 @@
 #define L_GREEN   "\e[1;32m"           // Light Green 鲜绿
 #define YELLOW    "\e[1;33m"           // Light Yellow 鲜黄
 
-#define WARNING(format, ...) printf (""YELLOW"[!] "format""NONE"", ##__VA_ARGS__)
-#define ERROR(format, ...) printf (""L_RED"[-] "format""NONE"", ##__VA_ARGS__)
-#define INFO(format, ...) printf (""L_GREEN"[+] "format""NONE"", ##__VA_ARGS__)
-#define VERBOSE(format, ...) printf (""YELLOW"[*] "format""NONE"", ##__VA_ARGS__)
-
-#define CHECK_WARNING(format, ...) printf (""YELLOW""format""NONE"", ##__VA_ARGS__)
-#define CHECK_ERROR(format, ...) printf (""L_RED""format""NONE"", ##__VA_ARGS__)
-#define CHECK_INFO(format, ...) printf (""L_GREEN""format""NONE"", ##__VA_ARGS__)
+/* no colour escapes if stdout is not a terminal, see init_render */
+extern int g_color;
+#define COLOR_FMT(color, format) (g_color ? color format NONE : format)
+
+#define WARNING(format, ...) printf (COLOR_FMT(YELLOW, "[!] "format), ##__VA_ARGS__)
+#define ERROR(format, ...) printf (COLOR_FMT(L_RED, "[-] "format), ##__VA_ARGS__)
+#define INFO(format, ...) printf (COLOR_FMT(L_GREEN, "[+] "format), ##__VA_ARGS__)
+#define VERBOSE(format, ...) printf (COLOR_FMT(YELLOW, "[*] "format), ##__VA_ARGS__)
+
+#define CHECK_WARNING(format, ...) printf (COLOR_FMT(YELLOW, format), ##__VA_ARGS__)
+#define CHECK_ERROR(format, ...) printf (COLOR_FMT(L_RED, format), ##__VA_ARGS__)
+#define CHECK_INFO(format, ...) printf (COLOR_FMT(L_GREEN, format), ##__VA_ARGS__)
 #define CHECK_COMMON(format, ...) printf (""format"", ##__VA_ARGS__)
 
 #ifdef debug
-    #define DEBUG(format, ...) printf (""YELLOW"[d] "format""NONE"", ##__VA_ARGS__)
+    #define DEBUG(format, ...) printf (COLOR_FMT(YELLOW, "[d] "format), ##__VA_ARGS__)
 #else
     #define DEBUG(format, ...)
 #endif
@@ -63,6 +67,21 @@ extern int MODE;
 /* ELF architecture */
 extern int ARCH;
 
+/* a PT_LOAD mapping between virtual addresses and file offsets */
+typedef struct load_range {
+    uint64_t vaddr;
+    uint64_t offset;
+    uint64_t filesz;
+    uint64_t memsz;
+} load_range_t;
+
+/* PT_LOAD segments sorted by address and by offset, for binary search */
+typedef struct load_index {
+    load_range_t *by_addr;
+    load_range_t *by_offset;
+    int num;
+} load_index_t;
+
 typedef struct handle32 {
     Elf32_Ehdr *ehdr;
     Elf32_Phdr *phdr;
@@ -73,6 +92,7 @@ typedef struct handle32 {
     uint8_t *mem;
     int fd;
     size_t size;        // file size
+    load_index_t loads; // address and offset translation
 } handle_t32;
 
 typedef struct handle64 {
@@ -85,6 +105,7 @@ typedef struct handle64 {
     uint8_t *mem;
     int fd;
     size_t size;        // file size
+    load_index_t loads; // address and offset translation
 } handle_t64;
 
 typedef struct GnuHash {
@@ -96,6 +117,13 @@ typedef struct GnuHash {
     // 后面可能跟着链表和其他数据
 } gnuhash_t;
 
+typedef struct sym_entry {
+    char *name;
+    uint64_t value;
+    uint64_t size;
+    int type;               // STT_FUNC, STT_OBJECT ...
+} sym_entry_t;
+
 void log_warning(char *str);
 void log_error(char *str);
 void log_info(char *str);
@@ -186,6 +214,35 @@ int is_sec_addr(char *elf_name, int offset);
  */
 int create_file(char *elf_name, char *elf_map, uint32_t map_size, uint32_t is_new);
 
+/**
+ * @brief 使用reflink克隆文件，新文件与原文件共享数据块（写时复制）
+ * clone a file with FICLONE, the new file shares extents with the source (copy-on-write)
+ * @param src_fd source file descriptor
+ * @param dst_fd destination file descriptor
+ * @return int error code {-1:error,0:sucess}
+ */
+int reflink_file(int src_fd, int dst_fd);
+
+/**
+ * @brief 复制文件，优先使用reflink，其次copy_file_range，最后使用普通的读写
+ * copy a file, FICLONE is preferred, then copy_file_range, then read/write
+ * @param src_name source file name
+ * @param dst_name destination file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int copy_file(char *src_name, char *dst_name);
+
+/**
+ * @brief 将内存中的新文件写入已有的文件，只写入与原内容不同的数据块
+ * write the new image over an existing file, only the blocks that differ are written,
+ * so the unmodified extents of a reflinked file stay shared
+ * @param file_name existing file name, usually a copy of the original file
+ * @param map new file content
+ * @param map_size new file size
+ * @return int error code {-1:error,0:sucess}
+ */
+int write_modified_extents(char *file_name, char *map, uint64_t map_size);
+
 /**
  * @description: Create json object from json file
  * @param {char} *name original json file name
@@ -214,6 +271,49 @@ uint64_t get_phdr_offset(char *elf_name);
  */
 uint64_t get_entry(char *elf_name);
 
+/**
+ * @brief 根据程序头表建立LOAD段索引，用于虚拟地址和文件偏移的相互转换
+ * build the PT_LOAD index used to translate virtual addresses and file offsets
+ * @param mem elf file content
+ * @param size elf file size
+ * @param index output, free it with finit_load_index
+ * @return int error code {-1:error,0:sucess}
+ */
+int init_load_index(uint8_t *mem, size_t size, load_index_t *index);
+void finit_load_index(load_index_t *index);
+
+/**
+ * @brief 将虚拟地址转换为文件偏移，整个区域都必须在文件中
+ * translate a virtual address to a file offset, the whole region must be
+ * backed by the file
+ * @param index PT_LOAD index
+ * @param addr virtual address
+ * @param size region size
+ * @param offset output, file offset
+ * @return int error code {-1:error,0:sucess}
+ */
+int load_addr_to_offset(load_index_t *index, uint64_t addr, uint64_t size, uint64_t *offset);
+
+/**
+ * @brief 将文件偏移转换为虚拟地址
+ * translate a file offset to a virtual address
+ * @param index PT_LOAD index
+ * @param offset file offset
+ * @param addr output, virtual address
+ * @return int error code {-1:error,0:sucess}
+ */
+int load_offset_to_addr(load_index_t *index, uint64_t offset, uint64_t *addr);
+
+/**
+ * @brief 将虚拟地址转换为文件偏移
+ * translate a virtual address of a file to a file offset
+ * @param elf_name elf file name
+ * @param addr virtual address
+ * @param offset output, file offset
+ * @return int error code {-1:error,0:sucess}
+ */
+int addr_to_offset(char *elf_name, uint64_t addr, uint64_t *offset);
+
 /**
  * @brief Extract binary fragments from the target file
  * 
@@ -322,6 +422,36 @@ int hook_extern(char *elf_name, char *symbol, char *hookfile, uint64_t hook_offs
  */
 int add_dynsym_entry(char *elf_name, char *name, uint64_t value, size_t code_size);
 
+/**
+ * @brief 增加多个.dynsym table条目，只添加一个.dynstr段，一个.dynsym段和一个hash表，同时扩展.gnu.version
+ * add several dynamic symbol table items, with only one new .dynstr segment,
+ * one new .dynsym segment and one hash table, .gnu.version is extended to match
+ * @param elf_name elf file name
+ * @param entries dynamic symbols
+ * @param count number of dynamic symbols
+ * @return int error code {-1:error,0:sucess}
+ */
+int add_dynsym_entries(char *elf_name, sym_entry_t *entries, int count);
+
+/**
+ * @brief 解析符号列表文件，每行格式为：名称,地址,大小[,类型]，#开头为注释
+ * parse the symbol list file, one "name,value,size[,type]" per line, '#' starts a comment.
+ * type is FUNC, OBJECT, NOTYPE or a number, FUNC by default
+ * @param list_name symbol list file name
+ * @param entries output, symbols, free them with free_sym_list
+ * @param count output, number of symbols
+ * @return int error code {-1:error,0:sucess}
+ */
+int parse_sym_list(char *list_name, sym_entry_t **entries, int *count);
+
+/**
+ * @brief 释放符号列表
+ * free the symbol list
+ * @param entries symbols
+ * @param count number of symbols
+ */
+void free_sym_list(sym_entry_t *entries, int count);
+
 /**
  * @brief 调整字符串表中的字符串顺序
  * adjust the string order in the string table
@@ -0,0 +1,252 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#define _GNU_SOURCE 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include "hashmap.h"
+#include "demangle.h"
+
+typedef char *(*cxa_demangle_t)(const char *mangled, char *buf, size_t *len, int *status);
+
+static cxa_demangle_t s_cxa_demangle;
+
+typedef struct demangle_job {
+    demangle_item_t **items;
+    size_t begin;
+    size_t end;
+    uint8_t *mem;
+} demangle_job_t;
+
+static cxa_demangle_t load_cxa_demangle(void) {
+    static const char *libs[] = {"libstdc++.so.6", "libc++abi.so.1", "libc++.so.1"};
+    void *handle;
+
+    if (s_cxa_demangle) {
+        return s_cxa_demangle;
+    }
+    /* already linked, e.g. by a preloaded library */
+    s_cxa_demangle = (cxa_demangle_t)dlsym(RTLD_DEFAULT, "__cxa_demangle");
+    for (int i = 0; !s_cxa_demangle && i < sizeof(libs) / sizeof(libs[0]); i++) {
+        handle = dlopen(libs[i], RTLD_LAZY);
+        if (handle)
+            s_cxa_demangle = (cxa_demangle_t)dlsym(handle, "__cxa_demangle");
+    }
+    return s_cxa_demangle;
+}
+
+/**
+ * @brief 初始化C++符号名还原的缓存，运行时从libstdc++加载__cxa_demangle
+ * initialize the cache of demangled C++ names, __cxa_demangle is loaded from
+ * libstdc++ at run time
+ * @param c cache
+ * @return int error code {-1:error or no __cxa_demangle,0:sucess}
+ */
+int init_demangle(demangle_cache_t *c) {
+    memset(c, 0, sizeof(demangle_cache_t));
+    if (!load_cxa_demangle()) {
+        return -1;
+    }
+    return hashmap_init(&c->map, DEMANGLE_CHUNK);
+}
+
+/**
+ * @brief 释放缓存和还原后的名字
+ * free the cache and the demangled names
+ * @param c cache
+ */
+void finit_demangle(demangle_cache_t *c) {
+    for (size_t i = 0; i < c->batch_num; i++) {
+        size_t used = i + 1 == c->batch_num ? c->used : DEMANGLE_CHUNK;
+        for (size_t j = 0; j < used; j++)
+            free(c->batches[i][j].name);
+        free(c->batches[i]);
+    }
+    free(c->batches);
+    hashmap_free(&c->map);
+    memset(c, 0, sizeof(demangle_cache_t));
+}
+
+/* look up an offset, or add an empty item for it */
+static demangle_item_t *get_item(demangle_cache_t *c, uint64_t offset, int *is_new) {
+    uint64_t hash = hash_bytes(&offset, sizeof(offset));
+    uint64_t value;
+    demangle_item_t *item;
+
+    *is_new = 0;
+    if (!hashmap_get(&c->map, hash, &offset, sizeof(offset), &value)) {
+        return (demangle_item_t *)value;
+    }
+
+    if (!c->batch_num || c->used == DEMANGLE_CHUNK) {
+        demangle_item_t **tmp = realloc(c->batches, (c->batch_num + 1) * sizeof(demangle_item_t *));
+        if (!tmp) {
+            return NULL;
+        }
+        c->batches = tmp;
+        c->batches[c->batch_num] = malloc(DEMANGLE_CHUNK * sizeof(demangle_item_t));
+        if (!c->batches[c->batch_num]) {
+            return NULL;
+        }
+        c->batch_num++;
+        c->used = 0;
+    }
+    item = &c->batches[c->batch_num - 1][c->used];
+    item->offset = offset;
+    item->name = NULL;
+    /* the key is the offset stored in the item */
+    if (hashmap_put(&c->map, hash, &item->offset, sizeof(item->offset), (uint64_t)item) < 0) {
+        return NULL;
+    }
+    c->used++;
+    *is_new = 1;
+    return item;
+}
+
+static void demangle_item(demangle_item_t *item, uint8_t *mem) {
+    char *mangled = (char *)mem + item->offset;
+    int status;
+
+    /* only names of the Itanium C++ ABI */
+    if (strncmp(mangled, "_Z", 2)) {
+        return;
+    }
+    item->name = s_cxa_demangle(mangled, NULL, NULL, &status);
+    if (status) {
+        free(item->name);
+        item->name = NULL;
+    }
+}
+
+static void *demangle_worker(void *arg) {
+    demangle_job_t *job = arg;
+    for (size_t i = job->begin; i < job->end; i++) {
+        demangle_item(job->items[i], job->mem);
+    }
+    return NULL;
+}
+
+/**
+ * @brief 多线程分块还原一组名字，结果保存在缓存中
+ * demangle a set of names in parallel chunks, the results are cached
+ * @param c cache
+ * @param mem elf file content
+ * @param size elf file size
+ * @param offsets file offsets of the names, duplicates are demangled once
+ * @param num number of offsets
+ * @return int error code {-1:error,0:sucess}
+ */
+int demangle_prefetch(demangle_cache_t *c, uint8_t *mem, size_t size, uint64_t *offsets, size_t num) {
+    pthread_t threads[DEMANGLE_MAX_THREADS];
+    demangle_job_t jobs[DEMANGLE_MAX_THREADS];
+    demangle_item_t **items;
+    size_t item_num = 0, chunk;
+    int thread_num, created;
+    int is_new;
+
+    items = malloc((num + 1) * sizeof(demangle_item_t *));
+    if (!items) {
+        return -1;
+    }
+    /* the map is only changed here, the workers fill the new items */
+    for (size_t i = 0; i < num; i++) {
+        demangle_item_t *item;
+        if (offsets[i] + 2 >= size)
+            continue;
+        item = get_item(c, offsets[i], &is_new);
+        if (!item) {
+            free(items);
+            return -1;
+        }
+        if (is_new && !strncmp((char *)mem + offsets[i], "_Z", 2))
+            items[item_num++] = item;
+    }
+
+    thread_num = sysconf(_SC_NPROCESSORS_ONLN);
+    if (thread_num < 1)
+        thread_num = 1;
+    if (thread_num > DEMANGLE_MAX_THREADS)
+        thread_num = DEMANGLE_MAX_THREADS;
+    if (thread_num > item_num / DEMANGLE_CHUNK)
+        thread_num = item_num / DEMANGLE_CHUNK ? item_num / DEMANGLE_CHUNK : 1;
+    chunk = (item_num + thread_num - 1) / thread_num;
+
+    /* the main thread takes the first chunk */
+    created = 0;
+    for (int i = 1; i < thread_num; i++) {
+        jobs[i].items = items;
+        jobs[i].mem = mem;
+        jobs[i].begin = i * chunk < item_num ? i * chunk : item_num;
+        jobs[i].end = (i + 1) * chunk < item_num ? (i + 1) * chunk : item_num;
+        if (pthread_create(&threads[i], NULL, demangle_worker, &jobs[i])) {
+            /* demangle the rest in the main thread */
+            jobs[i].end = item_num;
+            demangle_worker(&jobs[i]);
+            break;
+        }
+        created = i;
+    }
+    jobs[0].items = items;
+    jobs[0].mem = mem;
+    jobs[0].begin = 0;
+    jobs[0].end = chunk < item_num ? chunk : item_num;
+    demangle_worker(&jobs[0]);
+    for (int i = 1; i <= created; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(items);
+    return 0;
+}
+
+/**
+ * @brief 得到某个偏移处名字还原后的结果
+ * get the demangled name at a file offset
+ * @param c cache
+ * @param mem elf file content
+ * @param size elf file size
+ * @param offset file offset of the mangled name
+ * @return char* demangled name, NULL if it is not a C++ name
+ */
+char *demangle_get(demangle_cache_t *c, uint8_t *mem, size_t size, uint64_t offset) {
+    demangle_item_t *item;
+    int is_new;
+
+    if (offset + 2 >= size) {
+        return NULL;
+    }
+    item = get_item(c, offset, &is_new);
+    if (!item) {
+        return NULL;
+    }
+    if (is_new) {
+        demangle_item(item, mem);
+    }
+    return item->name;
+}
@@ -0,0 +1,78 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#define DEMANGLE_MAX_THREADS 16
+#define DEMANGLE_CHUNK 1024         // names per thread at least, and per batch
+
+/* a name of the file, keyed by its file offset */
+typedef struct demangle_item {
+    uint64_t offset;                // file offset of the mangled name
+    char *name;                     // demangled name, NULL if it is not a C++ name
+} demangle_item_t;
+
+typedef struct demangle_cache {
+    hashmap_t map;                  // offset -> demangle_item_t *
+    demangle_item_t **batches;      // items never move, the map points to them
+    size_t batch_num;
+    size_t used;                    // items used in the last batch
+} demangle_cache_t;
+
+/**
+ * @brief 初始化C++符号名还原的缓存，运行时从libstdc++加载__cxa_demangle
+ * initialize the cache of demangled C++ names, __cxa_demangle is loaded from
+ * libstdc++ at run time
+ * @param c cache
+ * @return int error code {-1:error or no __cxa_demangle,0:sucess}
+ */
+int init_demangle(demangle_cache_t *c);
+
+/**
+ * @brief 释放缓存和还原后的名字
+ * free the cache and the demangled names
+ * @param c cache
+ */
+void finit_demangle(demangle_cache_t *c);
+
+/**
+ * @brief 多线程分块还原一组名字，结果保存在缓存中
+ * demangle a set of names in parallel chunks, the results are cached
+ * @param c cache
+ * @param mem elf file content
+ * @param size elf file size
+ * @param offsets file offsets of the names, duplicates are demangled once
+ * @param num number of offsets
+ * @return int error code {-1:error,0:sucess}
+ */
+int demangle_prefetch(demangle_cache_t *c, uint8_t *mem, size_t size, uint64_t *offsets, size_t num);
+
+/**
+ * @brief 得到某个偏移处名字还原后的结果
+ * get the demangled name at a file offset
+ * @param c cache
+ * @param mem elf file content
+ * @param size elf file size
+ * @param offset file offset of the mangled name
+ * @return char* demangled name, NULL if it is not a C++ name
+ */
+char *demangle_get(demangle_cache_t *c, uint8_t *mem, size_t size, uint64_t offset);
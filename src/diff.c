@@ -0,0 +1,957 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <elf.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "common.h"
+#include "parse.h"
+#include "hashmap.h"
+#include "version.h"
+#include "dynamic.h"
+#include "relr.h"
+#include "diff.h"
+
+#define DIFF_KEY_LEN 1024
+
+static char *header_fields[] = {
+    "type", "machine", "version", "entry", "phoff", "shoff", "flags", "ehsize",
+    "phentsize", "phnum", "shentsize", "shnum", "shstrndx", "data", "osabi", "abiversion",
+};
+static char *segment_fields[] = {"offset", "vaddr", "paddr", "filesz", "memsz", "flags", "align"};
+static char *section_fields[] = {"type", "flags", "addr", "offset", "size", "link", "info", "addralign", "entsize"};
+static char *sym_fields[] = {"value", "size", "type", "bind", "vis", "ndx"};
+static char *reloc_fields[] = {"section", "type", "sym", "addend"};
+static char *dynamic_fields[] = {"value", "string"};
+
+static const struct {
+    char *name;
+    char **fields;
+    int field_num;
+    uint32_t str_mask;
+    PARSE_OPT_T option;
+} diff_tables[DIFF_TABLE_NUM] = {
+    [DIFF_HEADER] = {"ELF header", header_fields, 16, 0, HEADERS},
+    [DIFF_SEGMENT] = {"program header", segment_fields, 7, 0, SEGMENTS},
+    [DIFF_SECTION] = {"section header", section_fields, 9, 1 << 5, SECTIONS},
+    [DIFF_DYNSYM] = {".dynsym", sym_fields, 6, 1 << 5, DYNSYM},
+    [DIFF_SYMTAB] = {".symtab", sym_fields, 6, 1 << 5, SYMTAB},
+    [DIFF_RELOC] = {"relocation", reloc_fields, 4, 1 << 0 | 1 << 2, RELA},
+    [DIFF_DYNAMIC] = {".dynamic", dynamic_fields, 2, 1 << 1, LINK},
+};
+
+static const struct {
+    char *name;
+    uint32_t type;
+} segment_types[] = {
+    {"NULL", PT_NULL},
+    {"LOAD", PT_LOAD},
+    {"DYNAMIC", PT_DYNAMIC},
+    {"INTERP", PT_INTERP},
+    {"NOTE", PT_NOTE},
+    {"SHLIB", PT_SHLIB},
+    {"PHDR", PT_PHDR},
+    {"TLS", PT_TLS},
+    {"GNU_EH_FRAME", PT_GNU_EH_FRAME},
+    {"GNU_STACK", PT_GNU_STACK},
+    {"GNU_RELRO", PT_GNU_RELRO},
+    {"GNU_PROPERTY", 0x6474e553},
+};
+
+static int check_range(diff_elf_t *e, uint64_t offset, uint64_t size) {
+    return offset <= e->size && size <= e->size - offset;
+}
+
+/* strings out of the table or without '\0' are shown as "" */
+static char *get_str(diff_elf_t *e, uint64_t table, uint64_t table_size, uint64_t offset) {
+    if (!check_range(e, table, table_size) || offset >= table_size) {
+        return "";
+    }
+    if (!memchr(e->mem + table + offset, '\0', table_size - offset)) {
+        return "";
+    }
+    return (char *)e->mem + table + offset;
+}
+
+/* sections are compared by name, their indexes change with the layout */
+static char *get_sec_name(diff_elf_t *e, uint64_t index) {
+    switch (index) {
+        case SHN_UNDEF:
+            return "UND";
+        case SHN_ABS:
+            return "ABS";
+        case SHN_COMMON:
+            return "COMMON";
+    }
+    return index < e->sec_num ? e->sec_names[index] : "";
+}
+
+static char *get_segment_name(uint32_t type, char *name) {
+    for (int i = 0; i < sizeof(segment_types) / sizeof(segment_types[0]); i++) {
+        if (segment_types[i].type == type) {
+            return segment_types[i].name;
+        }
+    }
+    snprintf(name, DIFF_KEY_LEN, "0x%x", type);
+    return name;
+}
+
+/**
+ * @brief 增加一行，重复的键值按照文件中的顺序编号为"key#2"、"key#3"...
+ * add a row, the duplicated keys are numbered "key#2", "key#3"... in file order
+ */
+static int add_row(diff_table_t *t, char *key, diff_row_t **row) {
+    size_t len = strlen(key);
+    uint64_t hash, first;
+    char *name;
+    int ret;
+
+    if (t->num == t->cap) {
+        size_t cap = t->cap ? t->cap * 2 : 64;
+        diff_row_t *tmp = realloc(t->rows, cap * sizeof(diff_row_t));
+        if (!tmp)
+            return -1;
+        t->rows = tmp;
+        t->cap = cap;
+    }
+
+    name = strdup(key);
+    if (!name) {
+        return -1;
+    }
+    hash = hash_bytes(name, len);
+    ret = hashmap_put(&t->map, hash, name, len, t->num);
+    if (ret == 1) {
+        hashmap_get(&t->map, hash, name, len, &first);
+        free(name);
+        name = malloc(len + 16);
+        if (!name) {
+            return -1;
+        }
+        do {
+            t->rows[first].dup_num++;
+            snprintf(name, len + 16, "%s#%d", key, t->rows[first].dup_num + 1);
+            ret = hashmap_put(&t->map, hash_bytes(name, strlen(name)), name, strlen(name), t->num);
+        } while (ret == 1);
+    }
+    if (ret == -1) {
+        free(name);
+        return -1;
+    }
+
+    *row = &t->rows[t->num++];
+    memset(*row, 0, sizeof(diff_row_t));
+    (*row)->key = name;
+    return 0;
+}
+
+static int load_sym32(diff_elf_t *e, Elf32_Shdr *shdr, int index) {
+    diff_table_t *t = &e->tables[shdr[index].sh_type == SHT_DYNSYM ? DIFF_DYNSYM : DIFF_SYMTAB];
+    Elf32_Shdr *str;
+    Elf32_Sym *sym;
+    version_index_t vers;
+    int has_vers = 0;
+    size_t num;
+    char key[DIFF_KEY_LEN];
+    diff_row_t *row;
+    int ret = -1;
+
+    if (!check_range(e, shdr[index].sh_offset, shdr[index].sh_size) || shdr[index].sh_link >= e->sec_num) {
+        WARNING("%s: %s is out of file\n", e->name, e->sec_names[index]);
+        return 0;
+    }
+    str = &shdr[shdr[index].sh_link];
+    sym = (Elf32_Sym *)(e->mem + shdr[index].sh_offset);
+    num = shdr[index].sh_size / sizeof(Elf32_Sym);
+    if (shdr[index].sh_type == SHT_DYNSYM) {
+        has_vers = !init_version_index(e->mem, e->size, &vers);
+    }
+
+    for (size_t i = 1; i < num; i++) {
+        char *name = get_str(e, str->sh_offset, str->sh_size, sym[i].st_name);
+        char *ver = NULL;
+        int hidden = 0;
+        if (has_vers) {
+            ver = get_symbol_version(&vers, i, &hidden);
+        }
+        /* the versions of the same name are different symbols */
+        if (ver) {
+            snprintf(key, sizeof(key), "%s%s%s", name, hidden || sym[i].st_shndx == SHN_UNDEF ? "@" : "@@", ver);
+        } else if (!name[0] && ELF32_ST_TYPE(sym[i].st_info) == STT_SECTION) {
+            snprintf(key, sizeof(key), "[%s]", get_sec_name(e, sym[i].st_shndx));
+        } else {
+            snprintf(key, sizeof(key), "%s", name);
+        }
+        if (add_row(t, key, &row))
+            goto ERR_EXIT;
+        row->field[0] = sym[i].st_value;
+        row->field[1] = sym[i].st_size;
+        row->field[2] = ELF32_ST_TYPE(sym[i].st_info);
+        row->field[3] = ELF32_ST_BIND(sym[i].st_info);
+        row->field[4] = ELF32_ST_VISIBILITY(sym[i].st_other);
+        row->field[5] = (uint64_t)get_sec_name(e, sym[i].st_shndx);
+    }
+    ret = 0;
+
+ERR_EXIT:
+    if (has_vers)
+        finit_version_index(&vers);
+    return ret;
+}
+
+static int load_rel32(diff_elf_t *e, Elf32_Shdr *shdr, int index) {
+    diff_table_t *t = &e->tables[DIFF_RELOC];
+    Elf32_Shdr *symtab = NULL, *str = NULL;
+    uint8_t *rel;
+    size_t ent, num;
+    char key[DIFF_KEY_LEN];
+    diff_row_t *row;
+
+    ent = shdr[index].sh_type == SHT_RELA ? sizeof(Elf32_Rela) : sizeof(Elf32_Rel);
+    if (!check_range(e, shdr[index].sh_offset, shdr[index].sh_size)) {
+        WARNING("%s: %s is out of file\n", e->name, e->sec_names[index]);
+        return 0;
+    }
+    if (shdr[index].sh_link && shdr[index].sh_link < e->sec_num) {
+        symtab = &shdr[shdr[index].sh_link];
+        if (symtab->sh_link < e->sec_num && check_range(e, symtab->sh_offset, symtab->sh_size))
+            str = &shdr[symtab->sh_link];
+    }
+    rel = e->mem + shdr[index].sh_offset;
+    num = shdr[index].sh_size / ent;
+
+    for (size_t i = 0; i < num; i++) {
+        Elf32_Rela *r = (Elf32_Rela *)(rel + i * ent);
+        uint64_t sym_index = ELF32_R_SYM(r->r_info);
+        char *name = "";
+        if (str && sym_index < symtab->sh_size / sizeof(Elf32_Sym)) {
+            Elf32_Sym *sym = (Elf32_Sym *)(e->mem + symtab->sh_offset) + sym_index;
+            name = get_str(e, str->sh_offset, str->sh_size, sym->st_name);
+        }
+        /* the offsets of a relocatable file are relative to the target section */
+        if (((Elf32_Ehdr *)e->mem)->e_type == ET_REL)
+            snprintf(key, sizeof(key), "%s+0x%lx", get_sec_name(e, shdr[index].sh_info), (uint64_t)r->r_offset);
+        else
+            snprintf(key, sizeof(key), "0x%lx", (uint64_t)r->r_offset);
+        if (add_row(t, key, &row))
+            return -1;
+        row->field[0] = (uint64_t)e->sec_names[index];
+        row->field[1] = ELF32_R_TYPE(r->r_info);
+        row->field[2] = (uint64_t)name;
+        row->field[3] = shdr[index].sh_type == SHT_RELA ? r->r_addend : 0;
+    }
+    return 0;
+}
+
+static int load_relr32(diff_elf_t *e, Elf32_Shdr *shdr, uint64_t addr, uint64_t size) {
+    diff_table_t *t = &e->tables[DIFF_RELOC];
+    Elf32_Ehdr *ehdr = (Elf32_Ehdr *)e->mem;
+    load_index_t loads;
+    uint64_t offset;
+    uint64_t *addrs = NULL;
+    size_t count = 0;
+    char *name = "DT_RELR";
+    char key[DIFF_KEY_LEN];
+    diff_row_t *row;
+    int ret = -1;
+
+    if (init_load_index(e->mem, e->size, &loads)) {
+        return -1;
+    }
+    if (load_addr_to_offset(&loads, addr, size, &offset) || !check_range(e, offset, size) ||
+        decode_relr(e->mem + offset, size, sizeof(Elf32_Addr), &addrs, &count)) {
+        WARNING("%s: DT_RELR is out of file\n", e->name);
+        ret = 0;
+        goto ERR_EXIT;
+    }
+    for (size_t i = 1; i < e->sec_num; i++) {
+        if (shdr[i].sh_addr == addr && shdr[i].sh_type != SHT_NOBITS)
+            name = e->sec_names[i];
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        snprintf(key, sizeof(key), "0x%lx", addrs[i]);
+        if (add_row(t, key, &row))
+            goto ERR_EXIT;
+        row->field[0] = (uint64_t)name;
+        row->field[1] = get_relative_type(ehdr->e_machine);
+        row->field[2] = (uint64_t)"";
+        /* the addend is stored at the relocated place */
+        if (!load_addr_to_offset(&loads, addrs[i], sizeof(Elf64_Addr), &offset) && check_range(e, offset, sizeof(Elf64_Addr)))
+            row->field[3] = *(Elf64_Addr *)(e->mem + offset);
+    }
+    ret = 0;
+
+ERR_EXIT:
+    free(addrs);
+    finit_load_index(&loads);
+    return ret;
+}
+
+static int load_dynamic32(diff_elf_t *e, Elf32_Shdr *shdr, int index) {
+    diff_table_t *t = &e->tables[DIFF_DYNAMIC];
+    Elf32_Shdr *str = NULL;
+    Elf32_Dyn *dyn;
+    size_t num;
+    uint64_t relr = 0, relr_size = 0;
+    int needed = 0;
+    char key[DIFF_KEY_LEN];
+    diff_row_t *row;
+
+    if (!check_range(e, shdr[index].sh_offset, shdr[index].sh_size)) {
+        WARNING("%s: %s is out of file\n", e->name, e->sec_names[index]);
+        return 0;
+    }
+    if (shdr[index].sh_link < e->sec_num)
+        str = &shdr[shdr[index].sh_link];
+    dyn = (Elf32_Dyn *)(e->mem + shdr[index].sh_offset);
+    num = shdr[index].sh_size / sizeof(Elf32_Dyn);
+
+    for (size_t i = 0; i < num && dyn[i].d_tag != DT_NULL; i++) {
+        char *tag = get_dyn_tag_name(dyn[i].d_tag);
+        char *value = "";
+        if (is_str_tag(dyn[i].d_tag) && str)
+            value = get_str(e, str->sh_offset, str->sh_size, dyn[i].d_un.d_val);
+        /* DT_NEEDED is keyed by the library, its value is the search order */
+        if (dyn[i].d_tag == DT_NEEDED)
+            snprintf(key, sizeof(key), "NEEDED %s", value);
+        else if (tag)
+            snprintf(key, sizeof(key), "%s", tag);
+        else
+            snprintf(key, sizeof(key), "0x%lx", (uint64_t)dyn[i].d_tag);
+        if (add_row(t, key, &row))
+            return -1;
+        if (dyn[i].d_tag == DT_NEEDED)
+            row->field[0] = needed++;
+        else if (!is_str_tag(dyn[i].d_tag))
+            row->field[0] = dyn[i].d_un.d_val;
+        row->field[1] = (uint64_t)value;
+
+        if (dyn[i].d_tag == DT_RELR)
+            relr = dyn[i].d_un.d_ptr;
+        else if (dyn[i].d_tag == DT_RELRSZ)
+            relr_size = dyn[i].d_un.d_val;
+    }
+
+    if (relr && relr_size) {
+        return load_relr32(e, shdr, relr, relr_size);
+    }
+    return 0;
+}
+
+/**
+ * @brief 将ELF的各个表读入行，键值相同的行之后与另一个文件连接
+ * read the tables of ELF into rows, the rows are joined with the other file by key
+ */
+static int load_elf32(diff_elf_t *e) {
+    Elf32_Ehdr *ehdr = (Elf32_Ehdr *)e->mem;
+    Elf32_Phdr *phdr;
+    Elf32_Shdr *shdr = NULL;
+    char key[DIFF_KEY_LEN];
+    diff_row_t *row;
+
+    if (e->size < sizeof(Elf32_Ehdr)) {
+        ERROR("%s is too small\n", e->name);
+        return -1;
+    }
+
+    /* 1. ELF header */
+    if (add_row(&e->tables[DIFF_HEADER], "ELF header", &row))
+        return -1;
+    row->field[0] = ehdr->e_type;
+    row->field[1] = ehdr->e_machine;
+    row->field[2] = ehdr->e_version;
+    row->field[3] = ehdr->e_entry;
+    row->field[4] = ehdr->e_phoff;
+    row->field[5] = ehdr->e_shoff;
+    row->field[6] = ehdr->e_flags;
+    row->field[7] = ehdr->e_ehsize;
+    row->field[8] = ehdr->e_phentsize;
+    row->field[9] = ehdr->e_phnum;
+    row->field[10] = ehdr->e_shentsize;
+    row->field[11] = ehdr->e_shnum;
+    row->field[12] = ehdr->e_shstrndx;
+    row->field[13] = ehdr->e_ident[EI_DATA];
+    row->field[14] = ehdr->e_ident[EI_OSABI];
+    row->field[15] = ehdr->e_ident[EI_ABIVERSION];
+
+    /* 2. program headers, keyed by type and order */
+    if (check_range(e, ehdr->e_phoff, ehdr->e_phnum * sizeof(Elf32_Phdr))) {
+        phdr = (Elf32_Phdr *)(e->mem + ehdr->e_phoff);
+        for (int i = 0; i < ehdr->e_phnum; i++) {
+            if (add_row(&e->tables[DIFF_SEGMENT], get_segment_name(phdr[i].p_type, key), &row))
+                return -1;
+            row->field[0] = phdr[i].p_offset;
+            row->field[1] = phdr[i].p_vaddr;
+            row->field[2] = phdr[i].p_paddr;
+            row->field[3] = phdr[i].p_filesz;
+            row->field[4] = phdr[i].p_memsz;
+            row->field[5] = phdr[i].p_flags;
+            row->field[6] = phdr[i].p_align;
+        }
+    }
+
+    /* 3. section headers, keyed by name */
+    if (ehdr->e_shoff && check_range(e, ehdr->e_shoff, ehdr->e_shnum * sizeof(Elf32_Shdr))) {
+        shdr = (Elf32_Shdr *)(e->mem + ehdr->e_shoff);
+        e->sec_names = calloc(ehdr->e_shnum + 1, sizeof(char *));
+        if (!e->sec_names)
+            return -1;
+        e->sec_num = ehdr->e_shnum;
+        for (int i = 0; i < ehdr->e_shnum; i++) {
+            if (ehdr->e_shstrndx < ehdr->e_shnum)
+                e->sec_names[i] = get_str(e, shdr[ehdr->e_shstrndx].sh_offset, shdr[ehdr->e_shstrndx].sh_size, shdr[i].sh_name);
+            else
+                e->sec_names[i] = "";
+        }
+        for (int i = 1; i < ehdr->e_shnum; i++) {
+            if (add_row(&e->tables[DIFF_SECTION], e->sec_names[i], &row))
+                return -1;
+            row->field[0] = shdr[i].sh_type;
+            row->field[1] = shdr[i].sh_flags;
+            row->field[2] = shdr[i].sh_addr;
+            row->field[3] = shdr[i].sh_offset;
+            row->field[4] = shdr[i].sh_size;
+            row->field[5] = (uint64_t)get_sec_name(e, shdr[i].sh_link);
+            row->field[6] = shdr[i].sh_info;
+            row->field[7] = shdr[i].sh_addralign;
+            row->field[8] = shdr[i].sh_entsize;
+        }
+    }
+
+    /* 4. symbols, relocations and dynamic entries */
+    for (int i = 1; i < e->sec_num; i++) {
+        int err = 0;
+        switch (shdr[i].sh_type) {
+            case SHT_SYMTAB:
+            case SHT_DYNSYM:
+                err = load_sym32(e, shdr, i);
+                break;
+            case SHT_REL:
+            case SHT_RELA:
+                err = load_rel32(e, shdr, i);
+                break;
+            case SHT_DYNAMIC:
+                err = load_dynamic32(e, shdr, i);
+                break;
+        }
+        if (err)
+            return -1;
+    }
+    return 0;
+}
+
+static int load_sym64(diff_elf_t *e, Elf64_Shdr *shdr, int index) {
+    diff_table_t *t = &e->tables[shdr[index].sh_type == SHT_DYNSYM ? DIFF_DYNSYM : DIFF_SYMTAB];
+    Elf64_Shdr *str;
+    Elf64_Sym *sym;
+    version_index_t vers;
+    int has_vers = 0;
+    size_t num;
+    char key[DIFF_KEY_LEN];
+    diff_row_t *row;
+    int ret = -1;
+
+    if (!check_range(e, shdr[index].sh_offset, shdr[index].sh_size) || shdr[index].sh_link >= e->sec_num) {
+        WARNING("%s: %s is out of file\n", e->name, e->sec_names[index]);
+        return 0;
+    }
+    str = &shdr[shdr[index].sh_link];
+    sym = (Elf64_Sym *)(e->mem + shdr[index].sh_offset);
+    num = shdr[index].sh_size / sizeof(Elf64_Sym);
+    if (shdr[index].sh_type == SHT_DYNSYM) {
+        has_vers = !init_version_index(e->mem, e->size, &vers);
+    }
+
+    for (size_t i = 1; i < num; i++) {
+        char *name = get_str(e, str->sh_offset, str->sh_size, sym[i].st_name);
+        char *ver = NULL;
+        int hidden = 0;
+        if (has_vers) {
+            ver = get_symbol_version(&vers, i, &hidden);
+        }
+        /* the versions of the same name are different symbols */
+        if (ver) {
+            snprintf(key, sizeof(key), "%s%s%s", name, hidden || sym[i].st_shndx == SHN_UNDEF ? "@" : "@@", ver);
+        } else if (!name[0] && ELF64_ST_TYPE(sym[i].st_info) == STT_SECTION) {
+            snprintf(key, sizeof(key), "[%s]", get_sec_name(e, sym[i].st_shndx));
+        } else {
+            snprintf(key, sizeof(key), "%s", name);
+        }
+        if (add_row(t, key, &row))
+            goto ERR_EXIT;
+        row->field[0] = sym[i].st_value;
+        row->field[1] = sym[i].st_size;
+        row->field[2] = ELF64_ST_TYPE(sym[i].st_info);
+        row->field[3] = ELF64_ST_BIND(sym[i].st_info);
+        row->field[4] = ELF64_ST_VISIBILITY(sym[i].st_other);
+        row->field[5] = (uint64_t)get_sec_name(e, sym[i].st_shndx);
+    }
+    ret = 0;
+
+ERR_EXIT:
+    if (has_vers)
+        finit_version_index(&vers);
+    return ret;
+}
+
+static int load_rel64(diff_elf_t *e, Elf64_Shdr *shdr, int index) {
+    diff_table_t *t = &e->tables[DIFF_RELOC];
+    Elf64_Shdr *symtab = NULL, *str = NULL;
+    uint8_t *rel;
+    size_t ent, num;
+    char key[DIFF_KEY_LEN];
+    diff_row_t *row;
+
+    ent = shdr[index].sh_type == SHT_RELA ? sizeof(Elf64_Rela) : sizeof(Elf64_Rel);
+    if (!check_range(e, shdr[index].sh_offset, shdr[index].sh_size)) {
+        WARNING("%s: %s is out of file\n", e->name, e->sec_names[index]);
+        return 0;
+    }
+    if (shdr[index].sh_link && shdr[index].sh_link < e->sec_num) {
+        symtab = &shdr[shdr[index].sh_link];
+        if (symtab->sh_link < e->sec_num && check_range(e, symtab->sh_offset, symtab->sh_size))
+            str = &shdr[symtab->sh_link];
+    }
+    rel = e->mem + shdr[index].sh_offset;
+    num = shdr[index].sh_size / ent;
+
+    for (size_t i = 0; i < num; i++) {
+        Elf64_Rela *r = (Elf64_Rela *)(rel + i * ent);
+        uint64_t sym_index = ELF64_R_SYM(r->r_info);
+        char *name = "";
+        if (str && sym_index < symtab->sh_size / sizeof(Elf64_Sym)) {
+            Elf64_Sym *sym = (Elf64_Sym *)(e->mem + symtab->sh_offset) + sym_index;
+            name = get_str(e, str->sh_offset, str->sh_size, sym->st_name);
+        }
+        /* the offsets of a relocatable file are relative to the target section */
+        if (((Elf64_Ehdr *)e->mem)->e_type == ET_REL)
+            snprintf(key, sizeof(key), "%s+0x%lx", get_sec_name(e, shdr[index].sh_info), (uint64_t)r->r_offset);
+        else
+            snprintf(key, sizeof(key), "0x%lx", (uint64_t)r->r_offset);
+        if (add_row(t, key, &row))
+            return -1;
+        row->field[0] = (uint64_t)e->sec_names[index];
+        row->field[1] = ELF64_R_TYPE(r->r_info);
+        row->field[2] = (uint64_t)name;
+        row->field[3] = shdr[index].sh_type == SHT_RELA ? r->r_addend : 0;
+    }
+    return 0;
+}
+
+static int load_relr64(diff_elf_t *e, Elf64_Shdr *shdr, uint64_t addr, uint64_t size) {
+    diff_table_t *t = &e->tables[DIFF_RELOC];
+    Elf64_Ehdr *ehdr = (Elf64_Ehdr *)e->mem;
+    load_index_t loads;
+    uint64_t offset;
+    uint64_t *addrs = NULL;
+    size_t count = 0;
+    char *name = "DT_RELR";
+    char key[DIFF_KEY_LEN];
+    diff_row_t *row;
+    int ret = -1;
+
+    if (init_load_index(e->mem, e->size, &loads)) {
+        return -1;
+    }
+    if (load_addr_to_offset(&loads, addr, size, &offset) || !check_range(e, offset, size) ||
+        decode_relr(e->mem + offset, size, sizeof(Elf64_Addr), &addrs, &count)) {
+        WARNING("%s: DT_RELR is out of file\n", e->name);
+        ret = 0;
+        goto ERR_EXIT;
+    }
+    for (size_t i = 1; i < e->sec_num; i++) {
+        if (shdr[i].sh_addr == addr && shdr[i].sh_type != SHT_NOBITS)
+            name = e->sec_names[i];
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        snprintf(key, sizeof(key), "0x%lx", addrs[i]);
+        if (add_row(t, key, &row))
+            goto ERR_EXIT;
+        row->field[0] = (uint64_t)name;
+        row->field[1] = get_relative_type(ehdr->e_machine);
+        row->field[2] = (uint64_t)"";
+        /* the addend is stored at the relocated place */
+        if (!load_addr_to_offset(&loads, addrs[i], sizeof(Elf32_Addr), &offset) && check_range(e, offset, sizeof(Elf32_Addr)))
+            row->field[3] = *(Elf32_Addr *)(e->mem + offset);
+    }
+    ret = 0;
+
+ERR_EXIT:
+    free(addrs);
+    finit_load_index(&loads);
+    return ret;
+}
+
+static int load_dynamic64(diff_elf_t *e, Elf64_Shdr *shdr, int index) {
+    diff_table_t *t = &e->tables[DIFF_DYNAMIC];
+    Elf64_Shdr *str = NULL;
+    Elf64_Dyn *dyn;
+    size_t num;
+    uint64_t relr = 0, relr_size = 0;
+    int needed = 0;
+    char key[DIFF_KEY_LEN];
+    diff_row_t *row;
+
+    if (!check_range(e, shdr[index].sh_offset, shdr[index].sh_size)) {
+        WARNING("%s: %s is out of file\n", e->name, e->sec_names[index]);
+        return 0;
+    }
+    if (shdr[index].sh_link < e->sec_num)
+        str = &shdr[shdr[index].sh_link];
+    dyn = (Elf64_Dyn *)(e->mem + shdr[index].sh_offset);
+    num = shdr[index].sh_size / sizeof(Elf64_Dyn);
+
+    for (size_t i = 0; i < num && dyn[i].d_tag != DT_NULL; i++) {
+        char *tag = get_dyn_tag_name(dyn[i].d_tag);
+        char *value = "";
+        if (is_str_tag(dyn[i].d_tag) && str)
+            value = get_str(e, str->sh_offset, str->sh_size, dyn[i].d_un.d_val);
+        /* DT_NEEDED is keyed by the library, its value is the search order */
+        if (dyn[i].d_tag == DT_NEEDED)
+            snprintf(key, sizeof(key), "NEEDED %s", value);
+        else if (tag)
+            snprintf(key, sizeof(key), "%s", tag);
+        else
+            snprintf(key, sizeof(key), "0x%lx", (uint64_t)dyn[i].d_tag);
+        if (add_row(t, key, &row))
+            return -1;
+        if (dyn[i].d_tag == DT_NEEDED)
+            row->field[0] = needed++;
+        else if (!is_str_tag(dyn[i].d_tag))
+            row->field[0] = dyn[i].d_un.d_val;
+        row->field[1] = (uint64_t)value;
+
+        if (dyn[i].d_tag == DT_RELR)
+            relr = dyn[i].d_un.d_ptr;
+        else if (dyn[i].d_tag == DT_RELRSZ)
+            relr_size = dyn[i].d_un.d_val;
+    }
+
+    if (relr && relr_size) {
+        return load_relr64(e, shdr, relr, relr_size);
+    }
+    return 0;
+}
+
+/**
+ * @brief 将ELF的各个表读入行，键值相同的行之后与另一个文件连接
+ * read the tables of ELF into rows, the rows are joined with the other file by key
+ */
+static int load_elf64(diff_elf_t *e) {
+    Elf64_Ehdr *ehdr = (Elf64_Ehdr *)e->mem;
+    Elf64_Phdr *phdr;
+    Elf64_Shdr *shdr = NULL;
+    char key[DIFF_KEY_LEN];
+    diff_row_t *row;
+
+    if (e->size < sizeof(Elf64_Ehdr)) {
+        ERROR("%s is too small\n", e->name);
+        return -1;
+    }
+
+    /* 1. ELF header */
+    if (add_row(&e->tables[DIFF_HEADER], "ELF header", &row))
+        return -1;
+    row->field[0] = ehdr->e_type;
+    row->field[1] = ehdr->e_machine;
+    row->field[2] = ehdr->e_version;
+    row->field[3] = ehdr->e_entry;
+    row->field[4] = ehdr->e_phoff;
+    row->field[5] = ehdr->e_shoff;
+    row->field[6] = ehdr->e_flags;
+    row->field[7] = ehdr->e_ehsize;
+    row->field[8] = ehdr->e_phentsize;
+    row->field[9] = ehdr->e_phnum;
+    row->field[10] = ehdr->e_shentsize;
+    row->field[11] = ehdr->e_shnum;
+    row->field[12] = ehdr->e_shstrndx;
+    row->field[13] = ehdr->e_ident[EI_DATA];
+    row->field[14] = ehdr->e_ident[EI_OSABI];
+    row->field[15] = ehdr->e_ident[EI_ABIVERSION];
+
+    /* 2. program headers, keyed by type and order */
+    if (check_range(e, ehdr->e_phoff, ehdr->e_phnum * sizeof(Elf64_Phdr))) {
+        phdr = (Elf64_Phdr *)(e->mem + ehdr->e_phoff);
+        for (int i = 0; i < ehdr->e_phnum; i++) {
+            if (add_row(&e->tables[DIFF_SEGMENT], get_segment_name(phdr[i].p_type, key), &row))
+                return -1;
+            row->field[0] = phdr[i].p_offset;
+            row->field[1] = phdr[i].p_vaddr;
+            row->field[2] = phdr[i].p_paddr;
+            row->field[3] = phdr[i].p_filesz;
+            row->field[4] = phdr[i].p_memsz;
+            row->field[5] = phdr[i].p_flags;
+            row->field[6] = phdr[i].p_align;
+        }
+    }
+
+    /* 3. section headers, keyed by name */
+    if (ehdr->e_shoff && check_range(e, ehdr->e_shoff, ehdr->e_shnum * sizeof(Elf64_Shdr))) {
+        shdr = (Elf64_Shdr *)(e->mem + ehdr->e_shoff);
+        e->sec_names = calloc(ehdr->e_shnum + 1, sizeof(char *));
+        if (!e->sec_names)
+            return -1;
+        e->sec_num = ehdr->e_shnum;
+        for (int i = 0; i < ehdr->e_shnum; i++) {
+            if (ehdr->e_shstrndx < ehdr->e_shnum)
+                e->sec_names[i] = get_str(e, shdr[ehdr->e_shstrndx].sh_offset, shdr[ehdr->e_shstrndx].sh_size, shdr[i].sh_name);
+            else
+                e->sec_names[i] = "";
+        }
+        for (int i = 1; i < ehdr->e_shnum; i++) {
+            if (add_row(&e->tables[DIFF_SECTION], e->sec_names[i], &row))
+                return -1;
+            row->field[0] = shdr[i].sh_type;
+            row->field[1] = shdr[i].sh_flags;
+            row->field[2] = shdr[i].sh_addr;
+            row->field[3] = shdr[i].sh_offset;
+            row->field[4] = shdr[i].sh_size;
+            row->field[5] = (uint64_t)get_sec_name(e, shdr[i].sh_link);
+            row->field[6] = shdr[i].sh_info;
+            row->field[7] = shdr[i].sh_addralign;
+            row->field[8] = shdr[i].sh_entsize;
+        }
+    }
+
+    /* 4. symbols, relocations and dynamic entries */
+    for (int i = 1; i < e->sec_num; i++) {
+        int err = 0;
+        switch (shdr[i].sh_type) {
+            case SHT_SYMTAB:
+            case SHT_DYNSYM:
+                err = load_sym64(e, shdr, i);
+                break;
+            case SHT_REL:
+            case SHT_RELA:
+                err = load_rel64(e, shdr, i);
+                break;
+            case SHT_DYNAMIC:
+                err = load_dynamic64(e, shdr, i);
+                break;
+        }
+        if (err)
+            return -1;
+    }
+    return 0;
+}
+
+static int open_elf(char *name, diff_elf_t *e) {
+    struct stat st;
+    int fd;
+
+    memset(e, 0, sizeof(diff_elf_t));
+    e->name = name;
+    fd = open(name, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+    e->size = st.st_size;
+    e->mem = mmap(0, e->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (e->mem == MAP_FAILED) {
+        perror("mmap");
+        e->mem = NULL;
+        return -1;
+    }
+
+    for (int i = 0; i < DIFF_TABLE_NUM; i++) {
+        e->tables[i].name = diff_tables[i].name;
+        e->tables[i].fields = diff_tables[i].fields;
+        e->tables[i].field_num = diff_tables[i].field_num;
+        e->tables[i].str_mask = diff_tables[i].str_mask;
+        if (hashmap_init(&e->tables[i].map, 64))
+            return -1;
+    }
+
+    if (e->size < EI_NIDENT || memcmp(e->mem, ELFMAG, SELFMAG)) {
+        ERROR("%s is not an ELF file\n", name);
+        return -1;
+    }
+    e->class = e->mem[EI_CLASS];
+    /* the load index and the version index follow MODE */
+    MODE = e->class;
+    if (e->class == ELFCLASS32) {
+        return load_elf32(e);
+    } else if (e->class == ELFCLASS64) {
+        return load_elf64(e);
+    }
+    ERROR("%s has an unknown class %d\n", name, e->class);
+    return -1;
+}
+
+static void close_elf(diff_elf_t *e) {
+    for (int i = 0; i < DIFF_TABLE_NUM; i++) {
+        for (size_t j = 0; j < e->tables[i].num; j++) {
+            free(e->tables[i].rows[j].key);
+        }
+        free(e->tables[i].rows);
+        hashmap_free(&e->tables[i].map);
+    }
+    free(e->sec_names);
+    if (e->mem) {
+        munmap(e->mem, e->size);
+    }
+}
+
+static void print_field(diff_table_t *t, int i, uint64_t value) {
+    if (t->str_mask & 1 << i)
+        printf("%s", ((char *)value)[0] ? (char *)value : "-");
+    else
+        printf("0x%lx", value);
+}
+
+/* added and removed rows show the fields that are set */
+static void print_row(diff_table_t *t, diff_row_t *row, char sign) {
+    printf("%c %s", sign, row->key);
+    for (int i = 0; i < t->field_num; i++) {
+        if (t->str_mask & 1 << i ? !((char *)row->field[i])[0] : !row->field[i])
+            continue;
+        printf(" %s=", t->fields[i]);
+        print_field(t, i, row->field[i]);
+    }
+    printf("\n");
+}
+
+static int is_same_field(diff_table_t *t, int i, uint64_t a, uint64_t b) {
+    if (t->str_mask & 1 << i)
+        return !strcmp((char *)a, (char *)b);
+    return a == b;
+}
+
+static void print_title(diff_table_t *t, int *title) {
+    if (!*title) {
+        printf("[%s]\n", t->name);
+        *title = 1;
+    }
+}
+
+/**
+ * @brief 通过哈希表连接两个表，时间复杂度O(n)
+ * join two tables through the hash map of the new table in O(n)
+ */
+static void join_table(diff_table_t *a, diff_table_t *b, size_t count[3]) {
+    int title = 0;
+
+    for (size_t i = 0; i < a->num; i++) {
+        diff_row_t *old = &a->rows[i];
+        diff_row_t *new;
+        size_t len = strlen(old->key);
+        uint64_t index;
+        int changed = 0;
+
+        if (hashmap_get(&b->map, hash_bytes(old->key, len), old->key, len, &index)) {
+            print_title(a, &title);
+            print_row(a, old, '-');
+            count[1]++;
+            continue;
+        }
+        new = &b->rows[index];
+        new->matched = 1;
+        for (int j = 0; j < a->field_num; j++) {
+            if (is_same_field(a, j, old->field[j], new->field[j]))
+                continue;
+            if (!changed) {
+                print_title(a, &title);
+                printf("~ %s:", old->key);
+                changed = 1;
+            } else {
+                printf(",");
+            }
+            printf(" %s ", a->fields[j]);
+            print_field(a, j, old->field[j]);
+            printf(" -> ");
+            print_field(a, j, new->field[j]);
+        }
+        if (changed) {
+            printf("\n");
+            count[2]++;
+        }
+    }
+
+    for (size_t i = 0; i < b->num; i++) {
+        if (!b->rows[i].matched) {
+            print_title(b, &title);
+            print_row(b, &b->rows[i], '+');
+            count[0]++;
+        }
+    }
+}
+
+/**
+ * @brief 比较两个ELF文件的结构，按键值通过哈希表连接各个表，
+ * 输出增加、删除和修改的头、段、节、符号、重定位和dynamic条目
+ * compare the structure of two ELF files, join each table by its key through
+ * hash maps and report the added, removed and changed headers, segments,
+ * sections, symbols, relocations and dynamic entries
+ * @param old_name original elf file name
+ * @param new_name modified elf file name
+ * @param po tables to compare, all tables if none is selected
+ * @return int {-1:error,0:same,1:different}
+ */
+int diff_elf(char *old_name, char *new_name, parser_opt_t *po) {
+    diff_elf_t a, b;
+    size_t count[3] = {0};      // added, removed, changed
+    int all = !get_option(po, ALL) || po->index == 0;
+    int ret = -1;
+
+    if (open_elf(old_name, &a)) {
+        close_elf(&a);
+        return -1;
+    }
+    if (open_elf(new_name, &b)) {
+        goto ERR_EXIT;
+    }
+    if (a.class != b.class) {
+        WARNING("%s is ELFCLASS%d, %s is ELFCLASS%d\n", old_name, a.class == ELFCLASS32 ? 32 : 64,
+            new_name, b.class == ELFCLASS32 ? 32 : 64);
+    }
+
+    printf("--- %s\n+++ %s\n", old_name, new_name);
+    for (int i = 0; i < DIFF_TABLE_NUM; i++) {
+        if (all || !get_option(po, diff_tables[i].option))
+            join_table(&a.tables[i], &b.tables[i], count);
+    }
+    INFO("%lu added, %lu removed, %lu changed\n", count[0], count[1], count[2]);
+    ret = count[0] || count[1] || count[2];
+
+ERR_EXIT:
+    close_elf(&b);
+    close_elf(&a);
+    return ret;
+}
@@ -0,0 +1,78 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#define DIFF_MAX_FIELDS 16
+
+enum DIFF_TABLE {
+    DIFF_HEADER = 0,
+    DIFF_SEGMENT,
+    DIFF_SECTION,
+    DIFF_DYNSYM,
+    DIFF_SYMTAB,
+    DIFF_RELOC,
+    DIFF_DYNAMIC,
+    DIFF_TABLE_NUM,
+};
+
+/* a row of a table, joined with the other file by its key */
+typedef struct diff_row {
+    char *key;                          // e.g. section name, symbol name@version, relocation offset
+    uint64_t field[DIFF_MAX_FIELDS];    // numbers, or char * of the string fields
+    int dup_num;                        // rows with the same key, the later ones have a "#n" suffix
+    int matched;
+} diff_row_t;
+
+typedef struct diff_table {
+    char *name;
+    char **fields;          // field names
+    int field_num;
+    uint32_t str_mask;      // bit n is set if field n is a string
+    diff_row_t *rows;
+    size_t num;
+    size_t cap;
+    hashmap_t map;          // key -> row index
+} diff_table_t;
+
+typedef struct diff_elf {
+    char *name;
+    uint8_t *mem;
+    size_t size;
+    int class;
+    char **sec_names;       // name of each section, "" if it is out of .shstrtab
+    size_t sec_num;
+    diff_table_t tables[DIFF_TABLE_NUM];
+} diff_elf_t;
+
+/**
+ * @brief 比较两个ELF文件的结构，按键值通过哈希表连接各个表，
+ * 输出增加、删除和修改的头、段、节、符号、重定位和dynamic条目
+ * compare the structure of two ELF files, join each table by its key through
+ * hash maps and report the added, removed and changed headers, segments,
+ * sections, symbols, relocations and dynamic entries
+ * @param old_name original elf file name
+ * @param new_name modified elf file name
+ * @param po tables to compare, all tables if none is selected
+ * @return int {-1:error,0:same,1:different}
+ */
+int diff_elf(char *old_name, char *new_name, parser_opt_t *po);
@@ -0,0 +1,719 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <elf.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "common.h"
+#include "segment.h"
+#include "parse.h"
+#include "edit.h"
+#include "journal.h"
+#include "dynamic.h"
+#include "relr.h"
+
+/* the dynamic table read from the file */
+typedef struct dyn_table {
+    dyn_item_t *items;      // entries before DT_NULL
+    int num;                // number of entries before DT_NULL
+    int slot_num;           // number of entries the table can hold
+    uint64_t offset;        // .dynamic file offset
+    uint64_t addr;          // .dynamic virtual address
+    char *dynstr;           // copy of the dynamic string table
+    size_t dynstr_size;
+} dyn_table_t;
+
+static const struct {
+    char *name;
+    int64_t tag;
+} dyn_tags[] = {
+    {"NULL", DT_NULL},
+    {"NEEDED", DT_NEEDED},
+    {"PLTRELSZ", DT_PLTRELSZ},
+    {"PLTGOT", DT_PLTGOT},
+    {"HASH", DT_HASH},
+    {"STRTAB", DT_STRTAB},
+    {"SYMTAB", DT_SYMTAB},
+    {"RELA", DT_RELA},
+    {"RELASZ", DT_RELASZ},
+    {"RELAENT", DT_RELAENT},
+    {"STRSZ", DT_STRSZ},
+    {"SYMENT", DT_SYMENT},
+    {"INIT", DT_INIT},
+    {"FINI", DT_FINI},
+    {"SONAME", DT_SONAME},
+    {"RPATH", DT_RPATH},
+    {"SYMBOLIC", DT_SYMBOLIC},
+    {"REL", DT_REL},
+    {"RELSZ", DT_RELSZ},
+    {"RELENT", DT_RELENT},
+    {"PLTREL", DT_PLTREL},
+    {"DEBUG", DT_DEBUG},
+    {"TEXTREL", DT_TEXTREL},
+    {"JMPREL", DT_JMPREL},
+    {"BIND_NOW", DT_BIND_NOW},
+    {"INIT_ARRAY", DT_INIT_ARRAY},
+    {"FINI_ARRAY", DT_FINI_ARRAY},
+    {"INIT_ARRAYSZ", DT_INIT_ARRAYSZ},
+    {"FINI_ARRAYSZ", DT_FINI_ARRAYSZ},
+    {"RUNPATH", DT_RUNPATH},
+    {"FLAGS", DT_FLAGS},
+    {"PREINIT_ARRAY", DT_PREINIT_ARRAY},
+    {"PREINIT_ARRAYSZ", DT_PREINIT_ARRAYSZ},
+    {"GNU_HASH", DT_GNU_HASH},
+    {"VERSYM", DT_VERSYM},
+    {"RELACOUNT", DT_RELACOUNT},
+    {"RELCOUNT", DT_RELCOUNT},
+    {"FLAGS_1", DT_FLAGS_1},
+    {"VERDEF", DT_VERDEF},
+    {"VERDEFNUM", DT_VERDEFNUM},
+    {"VERNEED", DT_VERNEED},
+    {"VERNEEDNUM", DT_VERNEEDNUM},
+    {"AUXILIARY", DT_AUXILIARY},
+    {"FILTER", DT_FILTER},
+    {"CONFIG", DT_CONFIG},
+    {"DEPAUDIT", DT_DEPAUDIT},
+    {"AUDIT", DT_AUDIT},
+    {"RELRSZ", DT_RELRSZ},
+    {"RELR", DT_RELR},
+    {"RELRENT", DT_RELRENT},
+};
+
+/**
+ * @brief 根据名字获取dynamic tag，支持"DT_NEEDED"、"NEEDED"和数字
+ * get the dynamic tag by name, "DT_NEEDED", "NEEDED" and numbers are accepted
+ * @param name tag name
+ * @return tag {-1:error}
+ */
+static int64_t get_dyn_tag(char *name) {
+    if (!strncasecmp(name, "DT_", 3)) {
+        name += 3;
+    }
+    for (int i = 0; i < sizeof(dyn_tags) / sizeof(dyn_tags[0]); i++) {
+        if (!strcasecmp(name, dyn_tags[i].name)) {
+            return dyn_tags[i].tag;
+        }
+    }
+    if (isdigit(name[0])) {
+        return strtoll(name, NULL, 0);
+    }
+    return -1;
+}
+
+/**
+ * @brief 根据dynamic tag获取名字，如DT_NEEDED为"NEEDED"
+ * get the name of a dynamic tag, e.g. "NEEDED" for DT_NEEDED
+ * @param tag dynamic tag
+ * @return char* tag name, NULL for unknown tags
+ */
+char *get_dyn_tag_name(int64_t tag) {
+    for (int i = 0; i < sizeof(dyn_tags) / sizeof(dyn_tags[0]); i++) {
+        if (dyn_tags[i].tag == tag) {
+            return dyn_tags[i].name;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 判断dynamic条目的值是否为.dynstr的偏移
+ * whether the value of a dynamic entry is an offset of .dynstr
+ * @param tag dynamic tag
+ * @return {0:false, 1:true}
+ */
+int is_str_tag(int64_t tag) {
+    switch (tag) {
+        case DT_NEEDED:
+        case DT_SONAME:
+        case DT_RPATH:
+        case DT_RUNPATH:
+        case DT_AUXILIARY:
+        case DT_FILTER:
+        case DT_CONFIG:
+        case DT_DEPAUDIT:
+        case DT_AUDIT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief 解析dynamic操作，如"+NEEDED=libfoo.so,-RPATH,=FLAGS_1=0x8000001"
+ * parse dynamic operations, e.g. "+NEEDED=libfoo.so,-RPATH,=FLAGS_1=0x8000001"
+ * @param spec operations separated by ','
+ * @param ops output, operations, free them with free_dyn_ops
+ * @param count output, number of operations
+ * @return int error code {-1:error,0:sucess}
+ */
+int parse_dyn_ops(char *spec, dyn_op_t **ops, int *count) {
+    char *buf, *token, *saveptr, *value;
+    dyn_op_t *list;
+    int num = 0;
+
+    buf = strdup(spec);
+    if (!buf) {
+        return -1;
+    }
+    /* each operation takes at least two characters and a separator */
+    list = calloc(strlen(spec) / 2 + 1, sizeof(dyn_op_t));
+    if (!list) {
+        free(buf);
+        return -1;
+    }
+
+    for (token = strtok_r(buf, ",", &saveptr); token; token = strtok_r(NULL, ",", &saveptr)) {
+        dyn_op_t *op = &list[num];
+        switch (token[0]) {
+            case '+':
+                op->op = DYN_ADD;
+                break;
+            case '=':
+                op->op = DYN_SET;
+                break;
+            case '-':
+                op->op = DYN_DEL;
+                break;
+            case '^':
+                op->op = DYN_FRONT;
+                break;
+            default:
+                ERROR("unknown dynamic operation %s, expect +TAG=VALUE, =TAG=VALUE, -TAG[=VALUE] or ^TAG[=VALUE]\n", token);
+                goto ERR_EXIT;
+        }
+        token++;
+
+        value = strchr(token, '=');
+        if (value) {
+            *value++ = '\0';
+        }
+        op->tag = get_dyn_tag(token);
+        if (op->tag == -1) {
+            ERROR("unknown dynamic tag %s\n", token);
+            goto ERR_EXIT;
+        }
+        if (!value && (op->op == DYN_ADD || op->op == DYN_SET)) {
+            ERROR("dynamic tag %s needs a value\n", token);
+            goto ERR_EXIT;
+        }
+
+        if (value) {
+            op->has_val = 1;
+            if (is_str_tag(op->tag)) {
+                op->str = strdup(value);
+            } else {
+                op->val = strtoull(value, NULL, 0);
+            }
+        }
+        num++;
+    }
+
+    free(buf);
+    if (!num) {
+        free(list);
+        return -1;
+    }
+    *ops = list;
+    *count = num;
+    return 0;
+
+ERR_EXIT:
+    free(buf);
+    free_dyn_ops(list, num);
+    return -1;
+}
+
+/**
+ * @brief 释放dynamic操作
+ * free dynamic operations
+ * @param ops operations
+ * @param count number of operations
+ */
+void free_dyn_ops(dyn_op_t *ops, int count) {
+    for (int i = 0; i < count; i++) {
+        free(ops[i].str);
+    }
+    free(ops);
+}
+
+/**
+ * @brief 读取dynamic表和.dynstr
+ * read the dynamic table and .dynstr
+ * @param elf_name elf file name
+ * @param table output
+ * @return int error code {-1:error,0:sucess}
+ */
+static int read_dynamic(char *elf_name, dyn_table_t *table) {
+    int fd;
+    struct stat st;
+    uint8_t *mapped;
+    uint64_t strtab = 0;
+    uint64_t strtab_off = 0;
+    load_index_t loads;
+    int err = -1;
+
+    memset(table, 0, sizeof(dyn_table_t));
+    fd = open(elf_name, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+
+    mapped = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        perror("mmap");
+        close(fd);
+        return -1;
+    }
+
+    if (MODE == ELFCLASS32) {
+        Elf32_Ehdr *ehdr = (Elf32_Ehdr *)mapped;
+        Elf32_Phdr *phdr = (Elf32_Phdr *)&mapped[ehdr->e_phoff];
+        Elf32_Dyn *dyn;
+
+        for (int i = 0; i < ehdr->e_phnum; i++) {
+            if (phdr[i].p_type != PT_DYNAMIC)
+                continue;
+            dyn = (Elf32_Dyn *)(mapped + phdr[i].p_offset);
+            table->offset = phdr[i].p_offset;
+            table->addr = phdr[i].p_vaddr;
+            table->slot_num = phdr[i].p_filesz / sizeof(Elf32_Dyn);
+            table->items = malloc((table->slot_num + 1) * sizeof(dyn_item_t));
+            if (!table->items)
+                goto ERR_EXIT;
+            while (table->num < table->slot_num && dyn[table->num].d_tag != DT_NULL) {
+                table->items[table->num].tag = dyn[table->num].d_tag;
+                table->items[table->num].val = dyn[table->num].d_un.d_val;
+                if (dyn[table->num].d_tag == DT_STRTAB)
+                    strtab = dyn[table->num].d_un.d_ptr;
+                if (dyn[table->num].d_tag == DT_STRSZ)
+                    table->dynstr_size = dyn[table->num].d_un.d_val;
+                table->num++;
+            }
+            break;
+        }
+    }
+
+    if (MODE == ELFCLASS64) {
+        Elf64_Ehdr *ehdr = (Elf64_Ehdr *)mapped;
+        Elf64_Phdr *phdr = (Elf64_Phdr *)&mapped[ehdr->e_phoff];
+        Elf64_Dyn *dyn;
+
+        for (int i = 0; i < ehdr->e_phnum; i++) {
+            if (phdr[i].p_type != PT_DYNAMIC)
+                continue;
+            dyn = (Elf64_Dyn *)(mapped + phdr[i].p_offset);
+            table->offset = phdr[i].p_offset;
+            table->addr = phdr[i].p_vaddr;
+            table->slot_num = phdr[i].p_filesz / sizeof(Elf64_Dyn);
+            table->items = malloc((table->slot_num + 1) * sizeof(dyn_item_t));
+            if (!table->items)
+                goto ERR_EXIT;
+            while (table->num < table->slot_num && dyn[table->num].d_tag != DT_NULL) {
+                table->items[table->num].tag = dyn[table->num].d_tag;
+                table->items[table->num].val = dyn[table->num].d_un.d_val;
+                if (dyn[table->num].d_tag == DT_STRTAB)
+                    strtab = dyn[table->num].d_un.d_ptr;
+                if (dyn[table->num].d_tag == DT_STRSZ)
+                    table->dynstr_size = dyn[table->num].d_un.d_val;
+                table->num++;
+            }
+            break;
+        }
+    }
+
+    if (!table->items) {
+        ERROR("%s has no dynamic segment\n", elf_name);
+        goto ERR_EXIT;
+    }
+
+    if (strtab && !init_load_index(mapped, st.st_size, &loads)) {
+        load_addr_to_offset(&loads, strtab, 1, &strtab_off);
+        finit_load_index(&loads);
+    }
+    if (strtab_off && strtab_off + table->dynstr_size <= st.st_size) {
+        table->dynstr = malloc(table->dynstr_size + 1);
+        if (!table->dynstr)
+            goto ERR_EXIT;
+        memcpy(table->dynstr, mapped + strtab_off, table->dynstr_size);
+        table->dynstr[table->dynstr_size] = '\0';
+    } else {
+        table->dynstr_size = 0;
+    }
+    err = 0;
+
+ERR_EXIT:
+    munmap(mapped, st.st_size);
+    close(fd);
+    return err;
+}
+
+static int match_dyn_item(dyn_table_t *table, dyn_item_t *item, dyn_op_t *op) {
+    if (item->tag != op->tag)
+        return 0;
+    if (!op->has_val)
+        return 1;
+    if (op->str)
+        return table->dynstr && item->val < table->dynstr_size && !strcmp(table->dynstr + item->val, op->str);
+    return item->val == op->val;
+}
+
+/**
+ * @brief 在内存中对dynamic表执行一个操作
+ * apply an operation on the dynamic table in memory
+ * @param table dynamic table, items has room for the new entry
+ * @param op operation
+ */
+static void apply_dyn_op(dyn_table_t *table, dyn_op_t *op) {
+    dyn_item_t item;
+    int pos, j;
+
+    switch (op->op) {
+        case DYN_SET:
+            for (j = 0; j < table->num; j++) {
+                if (table->items[j].tag == op->tag) {
+                    table->items[j].val = op->val;
+                    return;
+                }
+            }
+            /* no entry with the tag, add it */
+            /* fall through */
+        case DYN_ADD:
+            /* keep the same tags together, DT_NEEDED is the first by default */
+            pos = op->tag == DT_NEEDED ? 0 : table->num;
+            for (j = 0; j < table->num; j++) {
+                if (table->items[j].tag == op->tag)
+                    pos = j + 1;
+            }
+            memmove(&table->items[pos + 1], &table->items[pos], (table->num - pos) * sizeof(dyn_item_t));
+            table->items[pos].tag = op->tag;
+            table->items[pos].val = op->val;
+            table->num++;
+            break;
+
+        case DYN_DEL:
+            for (pos = 0, j = 0; j < table->num; j++) {
+                if (!match_dyn_item(table, &table->items[j], op))
+                    table->items[pos++] = table->items[j];
+            }
+            table->num = pos;
+            break;
+
+        case DYN_FRONT:
+            /* stable, the matching entries keep their order */
+            for (pos = 0, j = 0; j < table->num; j++) {
+                if (match_dyn_item(table, &table->items[j], op)) {
+                    item = table->items[j];
+                    memmove(&table->items[pos + 1], &table->items[pos], (j - pos) * sizeof(dyn_item_t));
+                    table->items[pos++] = item;
+                }
+            }
+            break;
+    }
+}
+
+/**
+ * @brief 移动.dynamic之后，更新PT_DYNAMIC、.dynamic节头、_DYNAMIC符号和GOT[0]
+ * update PT_DYNAMIC, the .dynamic section header, _DYNAMIC symbols and GOT[0]
+ * after .dynamic is moved
+ * @param elf_name elf file name
+ * @param old_addr old .dynamic virtual address
+ * @param seg_i index of the segment which holds the new .dynamic
+ * @return int error code {-1:error,0:sucess}
+ */
+static int move_dynamic_refs(char *elf_name, uint64_t old_addr, int seg_i) {
+    int fd;
+    struct stat st;
+    uint8_t *mapped;
+    char *shstrtab, *strtab;
+
+    fd = open(elf_name, O_RDWR);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+
+    if (journal_headers(elf_name)) {
+        close(fd);
+        return -1;
+    }
+    mapped = mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        perror("mmap");
+        close(fd);
+        return -1;
+    }
+
+    if (MODE == ELFCLASS32) {
+        Elf32_Ehdr *ehdr = (Elf32_Ehdr *)mapped;
+        Elf32_Phdr *phdr = (Elf32_Phdr *)&mapped[ehdr->e_phoff];
+        Elf32_Shdr *shdr = (Elf32_Shdr *)&mapped[ehdr->e_shoff];
+        Elf32_Phdr *new = &phdr[seg_i];
+
+        for (int i = 0; i < ehdr->e_phnum; i++) {
+            if (phdr[i].p_type == PT_DYNAMIC) {
+                phdr[i].p_offset = new->p_offset;
+                phdr[i].p_vaddr = new->p_vaddr;
+                phdr[i].p_paddr = new->p_paddr;
+                phdr[i].p_filesz = new->p_filesz;
+                phdr[i].p_memsz = new->p_memsz;
+            }
+        }
+
+        shstrtab = ehdr->e_shnum ? (char *)mapped + shdr[ehdr->e_shstrndx].sh_offset : NULL;
+        for (int i = 0; i < ehdr->e_shnum; i++) {
+            if (shdr[i].sh_type == SHT_DYNAMIC) {
+                shdr[i].sh_offset = new->p_offset;
+                shdr[i].sh_addr = new->p_vaddr;
+                shdr[i].sh_size = new->p_filesz;
+            }
+            /* _DYNAMIC in .symtab and .dynsym */
+            else if (shdr[i].sh_type == SHT_SYMTAB || shdr[i].sh_type == SHT_DYNSYM) {
+                Elf32_Sym *sym = (Elf32_Sym *)(mapped + shdr[i].sh_offset);
+                strtab = (char *)mapped + shdr[shdr[i].sh_link].sh_offset;
+                for (int j = 0; j < shdr[i].sh_size / sizeof(Elf32_Sym); j++) {
+                    if (sym[j].st_value == old_addr && !strcmp(strtab + sym[j].st_name, "_DYNAMIC")) {
+                        if (journal_region(elf_name, (uint8_t *)&sym[j] - mapped, sizeof(sym[j]))) {
+                            goto ERR_EXIT;
+                        }
+                        sym[j].st_value = new->p_vaddr;
+                    }
+                }
+            }
+            /* GOT[0] holds the link-time address of _DYNAMIC */
+            else if (shdr[i].sh_type == SHT_PROGBITS && shstrtab &&
+                    (!strcmp(shstrtab + shdr[i].sh_name, ".got.plt") || !strcmp(shstrtab + shdr[i].sh_name, ".got"))) {
+                uint32_t *got = (uint32_t *)(mapped + shdr[i].sh_offset);
+                if (shdr[i].sh_size >= sizeof(*got) && *got == old_addr) {
+                    if (journal_region(elf_name, shdr[i].sh_offset, sizeof(*got))) {
+                        goto ERR_EXIT;
+                    }
+                    *got = new->p_vaddr;
+                }
+            }
+        }
+    }
+
+    if (MODE == ELFCLASS64) {
+        Elf64_Ehdr *ehdr = (Elf64_Ehdr *)mapped;
+        Elf64_Phdr *phdr = (Elf64_Phdr *)&mapped[ehdr->e_phoff];
+        Elf64_Shdr *shdr = (Elf64_Shdr *)&mapped[ehdr->e_shoff];
+        Elf64_Phdr *new = &phdr[seg_i];
+
+        for (int i = 0; i < ehdr->e_phnum; i++) {
+            if (phdr[i].p_type == PT_DYNAMIC) {
+                phdr[i].p_offset = new->p_offset;
+                phdr[i].p_vaddr = new->p_vaddr;
+                phdr[i].p_paddr = new->p_paddr;
+                phdr[i].p_filesz = new->p_filesz;
+                phdr[i].p_memsz = new->p_memsz;
+            }
+        }
+
+        shstrtab = ehdr->e_shnum ? (char *)mapped + shdr[ehdr->e_shstrndx].sh_offset : NULL;
+        for (int i = 0; i < ehdr->e_shnum; i++) {
+            if (shdr[i].sh_type == SHT_DYNAMIC) {
+                shdr[i].sh_offset = new->p_offset;
+                shdr[i].sh_addr = new->p_vaddr;
+                shdr[i].sh_size = new->p_filesz;
+            }
+            /* _DYNAMIC in .symtab and .dynsym */
+            else if (shdr[i].sh_type == SHT_SYMTAB || shdr[i].sh_type == SHT_DYNSYM) {
+                Elf64_Sym *sym = (Elf64_Sym *)(mapped + shdr[i].sh_offset);
+                strtab = (char *)mapped + shdr[shdr[i].sh_link].sh_offset;
+                for (int j = 0; j < shdr[i].sh_size / sizeof(Elf64_Sym); j++) {
+                    if (sym[j].st_value == old_addr && !strcmp(strtab + sym[j].st_name, "_DYNAMIC")) {
+                        if (journal_region(elf_name, (uint8_t *)&sym[j] - mapped, sizeof(sym[j]))) {
+                            goto ERR_EXIT;
+                        }
+                        sym[j].st_value = new->p_vaddr;
+                    }
+                }
+            }
+            /* GOT[0] holds the link-time address of _DYNAMIC */
+            else if (shdr[i].sh_type == SHT_PROGBITS && shstrtab &&
+                    (!strcmp(shstrtab + shdr[i].sh_name, ".got.plt") || !strcmp(shstrtab + shdr[i].sh_name, ".got"))) {
+                uint64_t *got = (uint64_t *)(mapped + shdr[i].sh_offset);
+                if (shdr[i].sh_size >= sizeof(*got) && *got == old_addr) {
+                    if (journal_region(elf_name, shdr[i].sh_offset, sizeof(*got))) {
+                        goto ERR_EXIT;
+                    }
+                    *got = new->p_vaddr;
+                }
+            }
+        }
+    }
+
+    munmap(mapped, st.st_size);
+    close(fd);
+    return 0;
+
+ERR_EXIT:
+    munmap(mapped, st.st_size);
+    close(fd);
+    return -1;
+}
+
+/**
+ * @brief 将dynamic表写回文件，空间不足时移动到新的段
+ * write the dynamic table back, move it to a new segment if it does not fit
+ * @param elf_name elf file name
+ * @param table dynamic table
+ * @return int error code {-1:error,0:sucess}
+ */
+static int write_dynamic(char *elf_name, dyn_table_t *table) {
+    size_t ent_size = MODE == ELFCLASS32 ? sizeof(Elf32_Dyn) : sizeof(Elf64_Dyn);
+    int slot_num = table->slot_num;
+    int moved = 0;
+    char *buf;
+    int seg_i;
+    int ret;
+
+    /* one DT_NULL at least */
+    if (table->num + 1 > slot_num) {
+        slot_num = table->num + 1 + DYN_SPARE_NUM;
+        moved = 1;
+    }
+
+    buf = calloc(slot_num, ent_size);
+    if (!buf) {
+        return -1;
+    }
+    for (int i = 0; i < table->num; i++) {
+        if (MODE == ELFCLASS32) {
+            ((Elf32_Dyn *)buf)[i].d_tag = table->items[i].tag;
+            ((Elf32_Dyn *)buf)[i].d_un.d_val = table->items[i].val;
+        } else {
+            ((Elf64_Dyn *)buf)[i].d_tag = table->items[i].tag;
+            ((Elf64_Dyn *)buf)[i].d_un.d_val = table->items[i].val;
+        }
+    }
+
+    if (!moved) {
+        ret = set_content(elf_name, table->offset, buf, slot_num * ent_size);
+        free(buf);
+        return ret;
+    }
+
+    VERBOSE("dynamic table is full, move it to a new segment\n");
+    seg_i = add_segment_content(elf_name, PT_LOAD, buf, slot_num * ent_size);
+    free(buf);
+    if (seg_i == -1) {
+        return -1;
+    }
+    /* ld.so writes DT_DEBUG */
+    set_segment_flags(elf_name, seg_i, 6);
+    return move_dynamic_refs(elf_name, table->addr, seg_i);
+}
+
+/**
+ * @brief 一次完成多个dynamic条目的增加、删除和排序，空间不足时将.dynamic移动到新的段
+ * add, remove and reorder dynamic entries in one pass, move .dynamic to a new
+ * segment if the table is full
+ * @param elf_name elf file name
+ * @param ops operations
+ * @param count number of operations
+ * @return int error code {-1:error,0:sucess}
+ */
+int edit_dynamic(char *elf_name, dyn_op_t *ops, int count) {
+    dyn_table_t table;
+    uint64_t *offsets = NULL;
+    char **strs = NULL;
+    int str_num = 0;
+    int add_num = 0;
+    int ret = -1;
+
+    /* 1. all new strings go into one new .dynstr */
+    strs = malloc(count * sizeof(char *));
+    offsets = malloc(count * sizeof(uint64_t));
+    if (!strs || !offsets) {
+        goto ERR_EXIT;
+    }
+    for (int i = 0; i < count; i++) {
+        if ((ops[i].op == DYN_ADD || ops[i].op == DYN_SET) && ops[i].str) {
+            strs[str_num++] = ops[i].str;
+        }
+    }
+    if (str_num) {
+        VERBOSE("add a new segment for %d .dynstr entries\n", str_num);
+        if (expand_dynstr_segment_multi(elf_name, strs, str_num, offsets) == -1) {
+            ERROR("expand .dynstr section error!\n");
+            goto ERR_EXIT;
+        }
+        for (int i = 0, j = 0; i < count; i++) {
+            if ((ops[i].op == DYN_ADD || ops[i].op == DYN_SET) && ops[i].str) {
+                ops[i].val = offsets[j++];
+            }
+        }
+    }
+
+    /* 2. edit the table in memory */
+    if (read_dynamic(elf_name, &table)) {
+        goto ERR_EXIT;
+    }
+    for (int i = 0; i < count; i++) {
+        if (ops[i].op == DYN_ADD || ops[i].op == DYN_SET) {
+            add_num++;
+        }
+    }
+    dyn_item_t *tmp = realloc(table.items, (table.num + add_num + 1) * sizeof(dyn_item_t));
+    if (!tmp) {
+        goto FREE_TABLE;
+    }
+    table.items = tmp;
+    for (int i = 0; i < count; i++) {
+        apply_dyn_op(&table, &ops[i]);
+    }
+
+    /* 3. write it back in place, or move it */
+    ret = write_dynamic(elf_name, &table);
+
+FREE_TABLE:
+    free(table.items);
+    free(table.dynstr);
+ERR_EXIT:
+    free(offsets);
+    free(strs);
+    return ret;
+}
@@ -0,0 +1,91 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+/* spare DT_NULL slots reserved when .dynamic is moved to a new segment */
+#define DYN_SPARE_NUM 4
+
+enum DYN_OP {
+    DYN_ADD = 1,    // +TAG=VALUE, add an entry
+    DYN_SET,        // =TAG=VALUE, replace the first entry with TAG, or add it
+    DYN_DEL,        // -TAG[=VALUE], remove the matching entries
+    DYN_FRONT,      // ^TAG[=VALUE], move the matching entries to the front
+};
+
+typedef struct dyn_op {
+    int op;
+    int64_t tag;
+    char *str;          // string value of DT_NEEDED, DT_SONAME, DT_RPATH ...
+    uint64_t val;       // numeric value, or .dynstr offset of str
+    int has_val;        // DYN_DEL and DYN_FRONT match all entries with TAG if no value
+} dyn_op_t;
+
+typedef struct dyn_item {
+    int64_t tag;
+    uint64_t val;
+} dyn_item_t;
+
+/**
+ * @brief 根据dynamic tag获取名字，如DT_NEEDED为"NEEDED"
+ * get the name of a dynamic tag, e.g. "NEEDED" for DT_NEEDED
+ * @param tag dynamic tag
+ * @return char* tag name, NULL for unknown tags
+ */
+char *get_dyn_tag_name(int64_t tag);
+
+/**
+ * @brief 判断dynamic条目的值是否为.dynstr的偏移
+ * whether the value of a dynamic entry is an offset of .dynstr
+ * @param tag dynamic tag
+ * @return {0:false, 1:true}
+ */
+int is_str_tag(int64_t tag);
+
+/**
+ * @brief 解析dynamic操作，如"+NEEDED=libfoo.so,-RPATH,=FLAGS_1=0x8000001"
+ * parse dynamic operations, e.g. "+NEEDED=libfoo.so,-RPATH,=FLAGS_1=0x8000001"
+ * @param spec operations separated by ','
+ * @param ops output, operations, free them with free_dyn_ops
+ * @param count output, number of operations
+ * @return int error code {-1:error,0:sucess}
+ */
+int parse_dyn_ops(char *spec, dyn_op_t **ops, int *count);
+
+/**
+ * @brief 释放dynamic操作
+ * free dynamic operations
+ * @param ops operations
+ * @param count number of operations
+ */
+void free_dyn_ops(dyn_op_t *ops, int count);
+
+/**
+ * @brief 一次完成多个dynamic条目的增加、删除和排序，空间不足时将.dynamic移动到新的段
+ * add, remove and reorder dynamic entries in one pass, move .dynamic to a new
+ * segment if the table is full
+ * @param elf_name elf file name
+ * @param ops operations
+ * @param count number of operations
+ * @return int error code {-1:error,0:sucess}
+ */
+int edit_dynamic(char *elf_name, dyn_op_t *ops, int count);
@@ -32,6 +32,7 @@
 #include <elf.h>
 #include "common.h"
 #include "parse.h"
+#include "journal.h"
 
 enum HeaderLabel {
     E_IDENT,        /* Magic number and other info */
@@ -133,6 +134,9 @@ static int set_header(char *elf_name, int value, enum HeaderLabel label) {
         Elf32_Ehdr *ehdr;
         ehdr = (Elf32_Ehdr *)elf_map;
 
+        if (journal_region(elf_name, 0, sizeof(*ehdr))) {
+            goto ERR_EXIT;
+        }
         switch (label)
         {
             case E_IDENT:
@@ -213,6 +217,9 @@ static int set_header(char *elf_name, int value, enum HeaderLabel label) {
         Elf64_Ehdr *ehdr;
         ehdr = (Elf64_Ehdr *)elf_map;
 
+        if (journal_region(elf_name, 0, sizeof(*ehdr))) {
+            goto ERR_EXIT;
+        }
         switch (label)
         {
             case E_IDENT:
@@ -291,6 +298,11 @@ static int set_header(char *elf_name, int value, enum HeaderLabel label) {
     close(fd);
     munmap(elf_map, st.st_size);
     return 0;
+
+ERR_EXIT:
+    close(fd);
+    munmap(elf_map, st.st_size);
+    return -1;
 }
 
 /**
@@ -394,6 +406,9 @@ static int set_section(char *elf_name, int index, int value, enum SectionLabel l
         ehdr = (Elf32_Ehdr *)elf_map;
         shdr = (Elf32_Shdr *)&elf_map[ehdr->e_shoff];
 
+        if (journal_region(elf_name, (uint8_t *)&shdr[index] - elf_map, sizeof(shdr[index]))) {
+            goto ERR_EXIT;
+        }
         switch (label)
         {
             case S_NAME:
@@ -459,6 +474,9 @@ static int set_section(char *elf_name, int index, int value, enum SectionLabel l
         ehdr = (Elf64_Ehdr *)elf_map;
         shdr = (Elf64_Shdr *)&elf_map[ehdr->e_shoff];
 
+        if (journal_region(elf_name, (uint8_t *)&shdr[index] - elf_map, sizeof(shdr[index]))) {
+            goto ERR_EXIT;
+        }
         switch (label)
         {
             case S_NAME:
@@ -519,6 +537,11 @@ static int set_section(char *elf_name, int index, int value, enum SectionLabel l
     close(fd);
     munmap(elf_map, st.st_size);
     return 0;
+
+ERR_EXIT:
+    close(fd);
+    munmap(elf_map, st.st_size);
+    return -1;
 };
 
 /**
@@ -611,6 +634,9 @@ int set_section_name_by_str(char *elf_name, int index, char *value) {
             goto ERR_EXIT;
         }
         printf("%s->%s\n", sec_name, value);
+        if (journal_region(elf_name, sec_name - elf_map, strlen(value) + 1)) {
+            goto ERR_EXIT;
+        }
         strcpy(sec_name, value);
     }
 
@@ -633,6 +659,9 @@ int set_section_name_by_str(char *elf_name, int index, char *value) {
             goto ERR_EXIT;
         }
         printf("%s->%s\n", sec_name, value);
+        if (journal_region(elf_name, sec_name - elf_map, strlen(value) + 1)) {
+            goto ERR_EXIT;
+        }
         strcpy(sec_name, value);
     }
 
@@ -690,6 +719,9 @@ static int set_segment(char *elf_name, int index, int value, enum SegmentLabel l
         ehdr = (Elf32_Ehdr *)elf_map;
         phdr = (Elf32_Phdr *)&elf_map[ehdr->e_phoff];
 
+        if (journal_region(elf_name, (uint8_t *)&phdr[index] - elf_map, sizeof(phdr[index]))) {
+            goto ERR_EXIT;
+        }
         switch (label)
         {
             case P_TYPE:
@@ -745,6 +777,9 @@ static int set_segment(char *elf_name, int index, int value, enum SegmentLabel l
         ehdr = (Elf64_Ehdr *)elf_map;
         phdr = (Elf64_Phdr *)&elf_map[ehdr->e_phoff];
 
+        if (journal_region(elf_name, (uint8_t *)&phdr[index] - elf_map, sizeof(phdr[index]))) {
+            goto ERR_EXIT;
+        }
         switch (label)
         {
                         case P_TYPE:
@@ -795,6 +830,11 @@ static int set_segment(char *elf_name, int index, int value, enum SegmentLabel l
     close(fd);
     munmap(elf_map, st.st_size);
     return 0;
+
+ERR_EXIT:
+    close(fd);
+    munmap(elf_map, st.st_size);
+    return -1;
 };
 
 /**
@@ -936,6 +976,9 @@ static int set_symbol(char *elf_name, int index, int value, enum SymbolLabel lab
     /* 32bit */
     if (MODE == ELFCLASS32) {
         Elf32_Sym *sym = (Elf32_Sym *)(elf_map + sym_offset);
+        if (journal_region(elf_name, (uint8_t *)&sym[index] - elf_map, sizeof(sym[index]))) {
+            goto ERR_EXIT;
+        }
         switch (label)
         {
             case ST_NAME:
@@ -985,6 +1028,9 @@ static int set_symbol(char *elf_name, int index, int value, enum SymbolLabel lab
     /* 64bit */
     else if (MODE == ELFCLASS64) {
         Elf64_Sym *sym = (Elf64_Sym *)(elf_map + sym_offset);
+        if (journal_region(elf_name, (uint8_t *)&sym[index] - elf_map, sizeof(sym[index]))) {
+            goto ERR_EXIT;
+        }
         switch (label)
         {
             case ST_NAME:
@@ -1181,6 +1227,9 @@ int set_rel(char *elf_name, int index, int value, enum RelocationLabel label, ch
                     return -1;
                 /* security check end*/
                 rel = (Elf32_Rel *)(elf_map + shdr[i].sh_offset);
+                if (journal_region(elf_name, (uint8_t *)&rel[index] - elf_map, sizeof(rel[index]))) {
+                    goto ERR_EXIT;
+                }
                 switch (label)
                 {
                     case R_OFFSET:
@@ -1235,6 +1284,9 @@ int set_rel(char *elf_name, int index, int value, enum RelocationLabel label, ch
                     return -1;
                 /* security check end*/
                 rel = (Elf64_Rel *)(elf_map + shdr[i].sh_offset);
+                if (journal_region(elf_name, (uint8_t *)&rel[index] - elf_map, sizeof(rel[index]))) {
+                    goto ERR_EXIT;
+                }
                 switch (label)
                 {
                     case R_OFFSET:
@@ -1268,6 +1320,11 @@ int set_rel(char *elf_name, int index, int value, enum RelocationLabel label, ch
     close(fd);
     munmap(elf_map, st.st_size);
     return 0;
+
+ERR_EXIT:
+    close(fd);
+    munmap(elf_map, st.st_size);
+    return -1;
 }
 
 int set_rela(char *elf_name, int index, int value, enum RelocationLabel label, char *section_name)  {
@@ -1319,6 +1376,9 @@ int set_rela(char *elf_name, int index, int value, enum RelocationLabel label, c
                     return -1;
                 /* security check end*/
                 rela = (Elf32_Rela *)(elf_map + shdr[i].sh_offset);
+                if (journal_region(elf_name, (uint8_t *)&rela[index] - elf_map, sizeof(rela[index]))) {
+                    goto ERR_EXIT;
+                }
                 switch (label)
                 {
                     case R_OFFSET:
@@ -1377,6 +1437,9 @@ int set_rela(char *elf_name, int index, int value, enum RelocationLabel label, c
                     return -1;
                 /* security check end*/
                 rela = (Elf64_Rela *)(elf_map + shdr[i].sh_offset);
+                if (journal_region(elf_name, (uint8_t *)&rela[index] - elf_map, sizeof(rela[index]))) {
+                    goto ERR_EXIT;
+                }
                 switch (label)
                 {
                     case R_OFFSET:
@@ -1414,6 +1477,11 @@ int set_rela(char *elf_name, int index, int value, enum RelocationLabel label, c
     close(fd);
     munmap(elf_map, st.st_size);
     return 0;
+
+ERR_EXIT:
+    close(fd);
+    munmap(elf_map, st.st_size);
+    return -1;
 }
 
 /**
@@ -1522,6 +1590,9 @@ static int set_dyn(char *elf_name, int index, int value, enum DynamicLabel label
             return -1;
         }
 
+        if (journal_region(elf_name, (uint8_t *)&dyn[index] - elf_map, sizeof(dyn[index]))) {
+            goto ERR_EXIT;
+        }
         switch (label)
         {
             case D_TAG:
@@ -1576,6 +1647,9 @@ static int set_dyn(char *elf_name, int index, int value, enum DynamicLabel label
             return -1;
         }
 
+        if (journal_region(elf_name, (uint8_t *)&dyn[index] - elf_map, sizeof(dyn[index]))) {
+            goto ERR_EXIT;
+        }
         switch (label)
         {
             case D_TAG:
@@ -1595,6 +1669,11 @@ static int set_dyn(char *elf_name, int index, int value, enum DynamicLabel label
     close(fd);
     munmap(elf_map, st.st_size);
     return 0;
+
+ERR_EXIT:
+    close(fd);
+    munmap(elf_map, st.st_size);
+    return -1;
 }
 
 /**
@@ -1715,6 +1794,11 @@ int edit_sym_name_string(char *elf_name, int index, char *name, char *section_na
 
     // 1. copy name
     if (strlen(name) <= strlen(origin_name)) {
+        if (journal_region(elf_name, origin_name - elf_map, strlen(origin_name) + 1)) {
+            close(fd);
+            munmap(elf_map, st.st_size);
+            return -1;
+        }
         memset(origin_name, 0, strlen(origin_name) + 1);
         strcpy(origin_name, name);
         close(fd);
@@ -1727,22 +1811,21 @@ int edit_sym_name_string(char *elf_name, int index, char *name, char *section_na
         munmap(elf_map, st.st_size);
 
         int result = -1;
+        uint64_t name_offset;
         if (!strcmp(section_name, ".dynsym")) {
-            VERBOSE("set sym name value: 0x%x\n", str_size);
-            set_sym_name(elf_name, index, str_size, section_name);
-            result = expand_dynstr_segment(elf_name, name);
+            result = expand_dynstr_segment_multi(elf_name, &name, 1, &name_offset);
         } 
         
         if (!strcmp(section_name, ".symtab")) {
-            set_sym_name(elf_name, index, str_size, section_name);
-            result = expand_strtab_section(elf_name, name);
+            result = expand_strtab_section_multi(elf_name, &name, 1, &name_offset);
         }
 
-        if (result) {
+        if (result == -1) {
             return -1;
-        } else {
-            return 0;
         }
+        VERBOSE("set sym name value: 0x%x\n", name_offset);
+        set_sym_name(elf_name, index, name_offset, section_name);
+        return 0;
     }
 }
 
@@ -1838,6 +1921,11 @@ int edit_dyn_name_value(char *elf_name, int index, char *name) {
 
     // 1. copy name
     if (strlen(name) <= strlen(origin_name)) {
+        if (journal_region(elf_name, origin_name - elf_map, strlen(origin_name) + 1)) {
+            close(fd);
+            munmap(elf_map, st.st_size);
+            return -1;
+        }
         memset(origin_name, 0, strlen(origin_name) + 1);
         strcpy(origin_name, name);
         close(fd);
@@ -1848,15 +1936,13 @@ int edit_dyn_name_value(char *elf_name, int index, char *name) {
     else {
         close(fd);
         munmap(elf_map, st.st_size);
-        //size_t size;
-        //get_dynamic_value_by_tag(elf_name, DT_STRSZ, &size);
-        set_dyn_value(elf_name, index, dynstr_size);
-        int result = expand_dynstr_segment(elf_name, name);
-        if (result) {
+        uint64_t name_offset;
+        int result = expand_dynstr_segment_multi(elf_name, &name, 1, &name_offset);
+        if (result == -1) {
             return -1;
-        } else {
-            return 0;
         }
+        set_dyn_value(elf_name, index, name_offset);
+        return 0;
     }
 }
 
@@ -1912,6 +1998,9 @@ int edit_pointer_value(char *elf_name, int index, uint64_t value, char *section_
             goto ERR_EXIT;
         }
         printf("0x%x->0x%x\n", sec[index], value);
+        if (journal_region(elf_name, (uint8_t *)&sec[index] - elf_map, sizeof(sec[index]))) {
+            goto ERR_EXIT;
+        }
         sec[index] = value & 0xffff;    // avoid interger overflow
     }
 
@@ -1923,6 +2012,9 @@ int edit_pointer_value(char *elf_name, int index, uint64_t value, char *section_
             goto ERR_EXIT;
         }
         printf("0x%x->0x%x\n", sec[index], value);
+        if (journal_region(elf_name, (uint8_t *)&sec[index] - elf_map, sizeof(sec[index]))) {
+            goto ERR_EXIT;
+        }
         sec[index] = value;
     }
 
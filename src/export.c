@@ -0,0 +1,607 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <elf.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "common.h"
+#include "export.h"
+
+/* an input ELF, mapped until the export is written */
+typedef struct input_file {
+    char *path;
+    uint8_t *mem;
+    size_t size;
+    int class;
+    int machine;
+    uint64_t row_num[EXPORT_TABLE_NUM];
+    uint64_t str_size;              // string tables of the symbol tables
+} input_file_t;
+
+static const struct {
+    char *name;
+    uint32_t type;
+} sym_columns[SYM_COLUMN_NUM] = {
+    [SYM_FILE] = {"file", EXPORT_U32},
+    [SYM_TABLE] = {"table", EXPORT_U8},
+    [SYM_VALUE] = {"value", EXPORT_U64},
+    [SYM_SIZE] = {"size", EXPORT_U64},
+    [SYM_TYPE] = {"type", EXPORT_U8},
+    [SYM_BIND] = {"bind", EXPORT_U8},
+    [SYM_VIS] = {"vis", EXPORT_U8},
+    [SYM_SHNDX] = {"shndx", EXPORT_U16},
+    [SYM_NAME] = {"name", EXPORT_U32},
+}, reloc_columns[RELOC_COLUMN_NUM] = {
+    [RELOC_FILE] = {"file", EXPORT_U32},
+    [RELOC_OFFSET] = {"offset", EXPORT_U64},
+    [RELOC_TYPE] = {"type", EXPORT_U32},
+    [RELOC_SYM] = {"sym", EXPORT_U32},
+    [RELOC_ADDEND] = {"addend", EXPORT_I64},
+    [RELOC_NAME] = {"name", EXPORT_U32},
+};
+
+static uint32_t get_width(uint32_t type) {
+    switch (type) {
+        case EXPORT_U8:
+            return 1;
+        case EXPORT_U16:
+            return 2;
+        case EXPORT_U32:
+            return 4;
+        default:
+            return 8;
+    }
+}
+
+static int check_range(input_file_t *f, uint64_t offset, uint64_t size) {
+    return offset <= f->size && size <= f->size - offset;
+}
+
+static void *get_column(uint8_t *out, export_header_t *h, int table, int column) {
+    return out + h->tables[table].columns[column].offset;
+}
+
+/**
+ * @brief 导出的表中节的行数，不在文件范围内的节没有行
+ * rows of a section in the exported tables, sections out of the file have none
+ */
+static uint64_t get_rows32(input_file_t *f, Elf32_Shdr *shdr, int shnum, int i, int *table) {
+    Elf32_Shdr *s = &shdr[i];
+
+    if (!check_range(f, s->sh_offset, s->sh_size) || s->sh_link >= shnum ||
+        !check_range(f, shdr[s->sh_link].sh_offset, shdr[s->sh_link].sh_size)) {
+        return 0;
+    }
+    switch (s->sh_type) {
+        case SHT_SYMTAB:
+        case SHT_DYNSYM:
+            *table = EXPORT_SYM;
+            return s->sh_size / sizeof(Elf32_Sym);
+        case SHT_REL:
+            *table = EXPORT_RELOC;
+            return s->sh_size / sizeof(Elf32_Rel);
+        case SHT_RELA:
+            *table = EXPORT_RELOC;
+            return s->sh_size / sizeof(Elf32_Rela);
+    }
+    return 0;
+}
+
+static int scan_file32(input_file_t *f) {
+    Elf32_Ehdr *ehdr = (Elf32_Ehdr *)f->mem;
+    Elf32_Shdr *shdr;
+    int table;
+
+    if (f->size < sizeof(Elf32_Ehdr) || !check_range(f, ehdr->e_shoff, ehdr->e_shnum * sizeof(Elf32_Shdr))) {
+        return -1;
+    }
+    f->machine = ehdr->e_machine;
+    shdr = (Elf32_Shdr *)(f->mem + ehdr->e_shoff);
+    for (int i = 1; i < ehdr->e_shnum; i++) {
+        uint64_t rows = get_rows32(f, shdr, ehdr->e_shnum, i, &table);
+        if (!rows)
+            continue;
+        f->row_num[table] += rows;
+        /* the string table is copied whole, with a '\0' in case it has none */
+        if (table == EXPORT_SYM)
+            f->str_size += shdr[shdr[i].sh_link].sh_size + 1;
+    }
+    return 0;
+}
+
+static int fill_file32(input_file_t *f, uint32_t index, uint8_t *out, export_header_t *h, uint64_t *rows, uint64_t *str) {
+    Elf32_Ehdr *ehdr = (Elf32_Ehdr *)f->mem;
+    Elf32_Shdr *shdr = (Elf32_Shdr *)(f->mem + ehdr->e_shoff);
+    uint64_t *str_base;
+    int table;
+
+    /* pool offset of the names of each symbol table */
+    str_base = calloc(ehdr->e_shnum, sizeof(uint64_t));
+    if (!str_base) {
+        return -1;
+    }
+    for (int i = 1; i < ehdr->e_shnum; i++) {
+        Elf32_Shdr *strtab = &shdr[shdr[i].sh_link];
+        if (!get_rows32(f, shdr, ehdr->e_shnum, i, &table) || table != EXPORT_SYM)
+            continue;
+        memcpy(out + h->str_off + *str, f->mem + strtab->sh_offset, strtab->sh_size);
+        out[h->str_off + *str + strtab->sh_size] = '\0';
+        str_base[i] = *str;
+        *str += strtab->sh_size + 1;
+    }
+
+    for (int i = 1; i < ehdr->e_shnum; i++) {
+        uint64_t n = get_rows32(f, shdr, ehdr->e_shnum, i, &table);
+        uint64_t r = rows[table];
+        if (!n)
+            continue;
+        if (table == EXPORT_SYM) {
+            Elf32_Sym *sym = (Elf32_Sym *)(f->mem + shdr[i].sh_offset);
+            uint64_t str_size = shdr[shdr[i].sh_link].sh_size;
+            uint32_t *file = (uint32_t *)get_column(out, h, EXPORT_SYM, SYM_FILE) + r;
+            uint8_t *type = (uint8_t *)get_column(out, h, EXPORT_SYM, SYM_TABLE) + r;
+            uint64_t *value = (uint64_t *)get_column(out, h, EXPORT_SYM, SYM_VALUE) + r;
+            uint64_t *size = (uint64_t *)get_column(out, h, EXPORT_SYM, SYM_SIZE) + r;
+            uint8_t *stt = (uint8_t *)get_column(out, h, EXPORT_SYM, SYM_TYPE) + r;
+            uint8_t *bind = (uint8_t *)get_column(out, h, EXPORT_SYM, SYM_BIND) + r;
+            uint8_t *vis = (uint8_t *)get_column(out, h, EXPORT_SYM, SYM_VIS) + r;
+            uint16_t *shndx = (uint16_t *)get_column(out, h, EXPORT_SYM, SYM_SHNDX) + r;
+            uint32_t *name = (uint32_t *)get_column(out, h, EXPORT_SYM, SYM_NAME) + r;
+            for (uint64_t j = 0; j < n; j++) {
+                file[j] = index;
+                type[j] = shdr[i].sh_type;
+                value[j] = sym[j].st_value;
+                size[j] = sym[j].st_size;
+                stt[j] = ELF32_ST_TYPE(sym[j].st_info);
+                bind[j] = ELF32_ST_BIND(sym[j].st_info);
+                vis[j] = ELF32_ST_VISIBILITY(sym[j].st_other);
+                shndx[j] = sym[j].st_shndx;
+                name[j] = sym[j].st_name && sym[j].st_name < str_size ? str_base[i] + sym[j].st_name : 0;
+            }
+        } else {
+            Elf32_Shdr *symtab = &shdr[shdr[i].sh_link];
+            Elf32_Sym *sym = (Elf32_Sym *)(f->mem + symtab->sh_offset);
+            uint64_t sym_num = symtab->sh_size / sizeof(Elf32_Sym);
+            uint64_t str_size = 0;
+            int link_table;
+            size_t ent = shdr[i].sh_type == SHT_RELA ? sizeof(Elf32_Rela) : sizeof(Elf32_Rel);
+            uint8_t *rel = f->mem + shdr[i].sh_offset;
+            uint32_t *file = (uint32_t *)get_column(out, h, EXPORT_RELOC, RELOC_FILE) + r;
+            uint64_t *offset = (uint64_t *)get_column(out, h, EXPORT_RELOC, RELOC_OFFSET) + r;
+            uint32_t *type = (uint32_t *)get_column(out, h, EXPORT_RELOC, RELOC_TYPE) + r;
+            uint32_t *sym_index = (uint32_t *)get_column(out, h, EXPORT_RELOC, RELOC_SYM) + r;
+            int64_t *addend = (int64_t *)get_column(out, h, EXPORT_RELOC, RELOC_ADDEND) + r;
+            uint32_t *name = (uint32_t *)get_column(out, h, EXPORT_RELOC, RELOC_NAME) + r;
+            /* the names come from the string table of the linked symbol table */
+            if (get_rows32(f, shdr, ehdr->e_shnum, shdr[i].sh_link, &link_table) && link_table == EXPORT_SYM)
+                str_size = shdr[symtab->sh_link].sh_size;
+            for (uint64_t j = 0; j < n; j++) {
+                Elf32_Rela *rela = (Elf32_Rela *)(rel + j * ent);
+                uint64_t s = ELF32_R_SYM(rela->r_info);
+                file[j] = index;
+                offset[j] = rela->r_offset;
+                type[j] = ELF32_R_TYPE(rela->r_info);
+                sym_index[j] = s;
+                addend[j] = ent == sizeof(Elf32_Rela) ? rela->r_addend : 0;
+                name[j] = s && s < sym_num && sym[s].st_name && sym[s].st_name < str_size ? str_base[shdr[i].sh_link] + sym[s].st_name : 0;
+            }
+        }
+        rows[table] += n;
+    }
+    free(str_base);
+    return 0;
+}
+
+/**
+ * @brief 导出的表中节的行数，不在文件范围内的节没有行
+ * rows of a section in the exported tables, sections out of the file have none
+ */
+static uint64_t get_rows64(input_file_t *f, Elf64_Shdr *shdr, int shnum, int i, int *table) {
+    Elf64_Shdr *s = &shdr[i];
+
+    if (!check_range(f, s->sh_offset, s->sh_size) || s->sh_link >= shnum ||
+        !check_range(f, shdr[s->sh_link].sh_offset, shdr[s->sh_link].sh_size)) {
+        return 0;
+    }
+    switch (s->sh_type) {
+        case SHT_SYMTAB:
+        case SHT_DYNSYM:
+            *table = EXPORT_SYM;
+            return s->sh_size / sizeof(Elf64_Sym);
+        case SHT_REL:
+            *table = EXPORT_RELOC;
+            return s->sh_size / sizeof(Elf64_Rel);
+        case SHT_RELA:
+            *table = EXPORT_RELOC;
+            return s->sh_size / sizeof(Elf64_Rela);
+    }
+    return 0;
+}
+
+static int scan_file64(input_file_t *f) {
+    Elf64_Ehdr *ehdr = (Elf64_Ehdr *)f->mem;
+    Elf64_Shdr *shdr;
+    int table;
+
+    if (f->size < sizeof(Elf64_Ehdr) || !check_range(f, ehdr->e_shoff, ehdr->e_shnum * sizeof(Elf64_Shdr))) {
+        return -1;
+    }
+    f->machine = ehdr->e_machine;
+    shdr = (Elf64_Shdr *)(f->mem + ehdr->e_shoff);
+    for (int i = 1; i < ehdr->e_shnum; i++) {
+        uint64_t rows = get_rows64(f, shdr, ehdr->e_shnum, i, &table);
+        if (!rows)
+            continue;
+        f->row_num[table] += rows;
+        /* the string table is copied whole, with a '\0' in case it has none */
+        if (table == EXPORT_SYM)
+            f->str_size += shdr[shdr[i].sh_link].sh_size + 1;
+    }
+    return 0;
+}
+
+static int fill_file64(input_file_t *f, uint32_t index, uint8_t *out, export_header_t *h, uint64_t *rows, uint64_t *str) {
+    Elf64_Ehdr *ehdr = (Elf64_Ehdr *)f->mem;
+    Elf64_Shdr *shdr = (Elf64_Shdr *)(f->mem + ehdr->e_shoff);
+    uint64_t *str_base;
+    int table;
+
+    /* pool offset of the names of each symbol table */
+    str_base = calloc(ehdr->e_shnum, sizeof(uint64_t));
+    if (!str_base) {
+        return -1;
+    }
+    for (int i = 1; i < ehdr->e_shnum; i++) {
+        Elf64_Shdr *strtab = &shdr[shdr[i].sh_link];
+        if (!get_rows64(f, shdr, ehdr->e_shnum, i, &table) || table != EXPORT_SYM)
+            continue;
+        memcpy(out + h->str_off + *str, f->mem + strtab->sh_offset, strtab->sh_size);
+        out[h->str_off + *str + strtab->sh_size] = '\0';
+        str_base[i] = *str;
+        *str += strtab->sh_size + 1;
+    }
+
+    for (int i = 1; i < ehdr->e_shnum; i++) {
+        uint64_t n = get_rows64(f, shdr, ehdr->e_shnum, i, &table);
+        uint64_t r = rows[table];
+        if (!n)
+            continue;
+        if (table == EXPORT_SYM) {
+            Elf64_Sym *sym = (Elf64_Sym *)(f->mem + shdr[i].sh_offset);
+            uint64_t str_size = shdr[shdr[i].sh_link].sh_size;
+            uint32_t *file = (uint32_t *)get_column(out, h, EXPORT_SYM, SYM_FILE) + r;
+            uint8_t *type = (uint8_t *)get_column(out, h, EXPORT_SYM, SYM_TABLE) + r;
+            uint64_t *value = (uint64_t *)get_column(out, h, EXPORT_SYM, SYM_VALUE) + r;
+            uint64_t *size = (uint64_t *)get_column(out, h, EXPORT_SYM, SYM_SIZE) + r;
+            uint8_t *stt = (uint8_t *)get_column(out, h, EXPORT_SYM, SYM_TYPE) + r;
+            uint8_t *bind = (uint8_t *)get_column(out, h, EXPORT_SYM, SYM_BIND) + r;
+            uint8_t *vis = (uint8_t *)get_column(out, h, EXPORT_SYM, SYM_VIS) + r;
+            uint16_t *shndx = (uint16_t *)get_column(out, h, EXPORT_SYM, SYM_SHNDX) + r;
+            uint32_t *name = (uint32_t *)get_column(out, h, EXPORT_SYM, SYM_NAME) + r;
+            for (uint64_t j = 0; j < n; j++) {
+                file[j] = index;
+                type[j] = shdr[i].sh_type;
+                value[j] = sym[j].st_value;
+                size[j] = sym[j].st_size;
+                stt[j] = ELF64_ST_TYPE(sym[j].st_info);
+                bind[j] = ELF64_ST_BIND(sym[j].st_info);
+                vis[j] = ELF64_ST_VISIBILITY(sym[j].st_other);
+                shndx[j] = sym[j].st_shndx;
+                name[j] = sym[j].st_name && sym[j].st_name < str_size ? str_base[i] + sym[j].st_name : 0;
+            }
+        } else {
+            Elf64_Shdr *symtab = &shdr[shdr[i].sh_link];
+            Elf64_Sym *sym = (Elf64_Sym *)(f->mem + symtab->sh_offset);
+            uint64_t sym_num = symtab->sh_size / sizeof(Elf64_Sym);
+            uint64_t str_size = 0;
+            int link_table;
+            size_t ent = shdr[i].sh_type == SHT_RELA ? sizeof(Elf64_Rela) : sizeof(Elf64_Rel);
+            uint8_t *rel = f->mem + shdr[i].sh_offset;
+            uint32_t *file = (uint32_t *)get_column(out, h, EXPORT_RELOC, RELOC_FILE) + r;
+            uint64_t *offset = (uint64_t *)get_column(out, h, EXPORT_RELOC, RELOC_OFFSET) + r;
+            uint32_t *type = (uint32_t *)get_column(out, h, EXPORT_RELOC, RELOC_TYPE) + r;
+            uint32_t *sym_index = (uint32_t *)get_column(out, h, EXPORT_RELOC, RELOC_SYM) + r;
+            int64_t *addend = (int64_t *)get_column(out, h, EXPORT_RELOC, RELOC_ADDEND) + r;
+            uint32_t *name = (uint32_t *)get_column(out, h, EXPORT_RELOC, RELOC_NAME) + r;
+            /* the names come from the string table of the linked symbol table */
+            if (get_rows64(f, shdr, ehdr->e_shnum, shdr[i].sh_link, &link_table) && link_table == EXPORT_SYM)
+                str_size = shdr[symtab->sh_link].sh_size;
+            for (uint64_t j = 0; j < n; j++) {
+                Elf64_Rela *rela = (Elf64_Rela *)(rel + j * ent);
+                uint64_t s = ELF64_R_SYM(rela->r_info);
+                file[j] = index;
+                offset[j] = rela->r_offset;
+                type[j] = ELF64_R_TYPE(rela->r_info);
+                sym_index[j] = s;
+                addend[j] = ent == sizeof(Elf64_Rela) ? rela->r_addend : 0;
+                name[j] = s && s < sym_num && sym[s].st_name && sym[s].st_name < str_size ? str_base[shdr[i].sh_link] + sym[s].st_name : 0;
+            }
+        }
+        rows[table] += n;
+    }
+    free(str_base);
+    return 0;
+}
+
+/**
+ * @brief 映射ELF并统计各表的行数
+ * map an ELF and count the rows of each table
+ */
+static int open_input(char *path, input_file_t *f) {
+    struct stat st;
+    int fd;
+
+    memset(f, 0, sizeof(input_file_t));
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+    if (fstat(fd, &st) < 0 || st.st_size < EI_NIDENT) {
+        close(fd);
+        return -1;
+    }
+    f->mem = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (f->mem == MAP_FAILED) {
+        perror("mmap");
+        f->mem = NULL;
+        return -1;
+    }
+    f->size = st.st_size;
+    f->path = strdup(path);
+    if (!f->path) {
+        return -1;
+    }
+
+    /* scripts and other files of the list are skipped quietly */
+    if (memcmp(f->mem, ELFMAG, SELFMAG)) {
+        return -1;
+    }
+    f->class = f->mem[EI_CLASS];
+    if (f->class == ELFCLASS32 ? scan_file32(f) : f->class == ELFCLASS64 ? scan_file64(f) : -1) {
+        WARNING("%s is not an ELF file with section headers\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static void close_input(input_file_t *f) {
+    if (f->mem) {
+        munmap(f->mem, f->size);
+    }
+    free(f->path);
+}
+
+static int add_input(char *path, input_file_t **files, size_t *num, size_t *cap) {
+    if (*num == *cap) {
+        size_t new_cap = *cap ? *cap * 2 : 64;
+        input_file_t *tmp = realloc(*files, new_cap * sizeof(input_file_t));
+        if (!tmp)
+            return -1;
+        *files = tmp;
+        *cap = new_cap;
+    }
+    /* the files that can not be parsed are skipped */
+    if (open_input(path, &(*files)[*num])) {
+        close_input(&(*files)[*num]);
+        return 0;
+    }
+    (*num)++;
+    return 0;
+}
+
+/**
+ * @brief 计算输出文件的布局：头、文件表、各列，最后是字符串池
+ * lay out the output file: header, file table, the columns, then the string pool
+ */
+static uint64_t layout_export(export_header_t *h, input_file_t *files, size_t num) {
+    uint64_t offset;
+
+    memset(h, 0, sizeof(export_header_t));
+    h->table_num = EXPORT_TABLE_NUM;
+    h->file_num = num;
+    h->str_size = 1;
+    for (size_t i = 0; i < num; i++) {
+        h->tables[EXPORT_SYM].row_num += files[i].row_num[EXPORT_SYM];
+        h->tables[EXPORT_RELOC].row_num += files[i].row_num[EXPORT_RELOC];
+        h->str_size += strlen(files[i].path) + 1 + files[i].str_size;
+    }
+
+    strcpy(h->tables[EXPORT_SYM].name, "symbol");
+    h->tables[EXPORT_SYM].column_num = SYM_COLUMN_NUM;
+    for (int i = 0; i < SYM_COLUMN_NUM; i++) {
+        strcpy(h->tables[EXPORT_SYM].columns[i].name, sym_columns[i].name);
+        h->tables[EXPORT_SYM].columns[i].type = sym_columns[i].type;
+    }
+    strcpy(h->tables[EXPORT_RELOC].name, "relocation");
+    h->tables[EXPORT_RELOC].column_num = RELOC_COLUMN_NUM;
+    for (int i = 0; i < RELOC_COLUMN_NUM; i++) {
+        strcpy(h->tables[EXPORT_RELOC].columns[i].name, reloc_columns[i].name);
+        h->tables[EXPORT_RELOC].columns[i].type = reloc_columns[i].type;
+    }
+
+    offset = ALIGN((uint64_t)sizeof(export_header_t), EXPORT_ALIGN);
+    h->file_off = offset;
+    offset = ALIGN(offset + num * sizeof(export_file_t), EXPORT_ALIGN);
+    for (int t = 0; t < EXPORT_TABLE_NUM; t++) {
+        for (int c = 0; c < h->tables[t].column_num; c++) {
+            export_column_t *col = &h->tables[t].columns[c];
+            col->width = get_width(col->type);
+            col->offset = offset;
+            offset = ALIGN(offset + h->tables[t].row_num * col->width, EXPORT_ALIGN);
+        }
+    }
+    h->str_off = offset;
+    return offset + h->str_size;
+}
+
+/**
+ * @brief 写入导出文件，先写临时文件，再重命名
+ * write the export to a temporary file, then rename it
+ */
+static int write_export(char *out_name, input_file_t *files, size_t num) {
+    char tmp_name[PATH_MAX];
+    export_header_t h;
+    export_file_t *entries;
+    uint64_t rows[EXPORT_TABLE_NUM] = {0};
+    uint64_t str = 1;
+    uint64_t size;
+    uint8_t *out;
+    int fd;
+
+    size = layout_export(&h, files, num);
+    if (h.str_size > UINT32_MAX) {
+        ERROR("string pool is larger than 4G, export less files at a time\n");
+        return -1;
+    }
+
+    if (snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", out_name) >= sizeof(tmp_name)) {
+        ERROR("%s is too long\n", out_name);
+        return -1;
+    }
+    fd = open(tmp_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+    if (ftruncate(fd, size) < 0) {
+        perror("ftruncate");
+        goto ERR_EXIT;
+    }
+    out = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (out == MAP_FAILED) {
+        perror("mmap");
+        goto ERR_EXIT;
+    }
+
+    /* the columns are filled in place, the file is still zero */
+    entries = (export_file_t *)(out + h.file_off);
+    for (size_t i = 0; i < num; i++) {
+        size_t len = strlen(files[i].path) + 1;
+        entries[i].path = str;
+        entries[i].class = files[i].class;
+        entries[i].machine = files[i].machine;
+        memcpy(out + h.str_off + str, files[i].path, len);
+        str += len;
+        for (int t = 0; t < EXPORT_TABLE_NUM; t++) {
+            entries[i].row_start[t] = rows[t];
+            entries[i].row_num[t] = files[i].row_num[t];
+        }
+        if ((files[i].class == ELFCLASS32 ? fill_file32 : fill_file64)(&files[i], i, out, &h, rows, &str)) {
+            munmap(out, size);
+            goto ERR_EXIT;
+        }
+    }
+
+    /* the header is written last, a torn file has no magic */
+    memcpy(h.magic, EXPORT_MAGIC, sizeof(h.magic));
+    memcpy(out, &h, sizeof(h));
+    if (msync(out, size, MS_SYNC) < 0) {
+        perror("msync");
+        munmap(out, size);
+        goto ERR_EXIT;
+    }
+    munmap(out, size);
+    close(fd);
+    if (rename(tmp_name, out_name) < 0) {
+        perror("rename");
+        unlink(tmp_name);
+        return -1;
+    }
+    INFO("%lu files, %lu symbols, %lu relocations, 0x%lx bytes of strings -> %s\n",
+        num, h.tables[EXPORT_SYM].row_num, h.tables[EXPORT_RELOC].row_num, h.str_size, out_name);
+    return 0;
+
+ERR_EXIT:
+    close(fd);
+    unlink(tmp_name);
+    return -1;
+}
+
+/**
+ * @brief 将ELF以及列表文件中所有ELF的符号表和重定位表导出为按列存储、可映射的文件，
+ * 各列直接从映射的符号和重定位数组中取值，不做格式化
+ * export the symbol and relocation tables of ELF and of every ELF in the list
+ * file as typed columns of a memory-mappable file. the columns are filled
+ * straight from the mapped symbol and relocation arrays without formatting
+ * @param out_name output file name (optional, default: ELF.col)
+ * @param list_name file with one ELF path per line (optional)
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int export_columns(char *out_name, char *list_name, char *elf_name) {
+    char default_name[PATH_MAX];
+    char line[PATH_MAX];
+    input_file_t *files = NULL;
+    size_t num = 0, cap = 0;
+    int ret = -1;
+    FILE *fp;
+
+    if (!out_name || !out_name[0]) {
+        if (snprintf(default_name, sizeof(default_name), "%s%s", elf_name, EXPORT_SUFFIX) >= sizeof(default_name)) {
+            ERROR("%s is too long\n", elf_name);
+            return -1;
+        }
+        out_name = default_name;
+    }
+
+    if (add_input(elf_name, &files, &num, &cap)) {
+        goto ERR_EXIT;
+    }
+    if (list_name && list_name[0]) {
+        fp = fopen(list_name, "r");
+        if (!fp) {
+            perror("fopen");
+            goto ERR_EXIT;
+        }
+        while (fgets(line, sizeof(line), fp)) {
+            char *name = strtok(line, "\r\n");
+            if (!name || name[0] == '#')
+                continue;
+            if (add_input(name, &files, &num, &cap)) {
+                fclose(fp);
+                goto ERR_EXIT;
+            }
+        }
+        fclose(fp);
+    }
+
+    ret = write_export(out_name, files, num);
+
+ERR_EXIT:
+    for (size_t i = 0; i < num; i++) {
+        close_input(&files[i]);
+    }
+    free(files);
+    return ret;
+}
@@ -0,0 +1,123 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#define EXPORT_MAGIC "ELFSCOL1"
+#define EXPORT_ALIGN 64             // arrays start at a cache line, ready for vector loads
+#define EXPORT_MAX_COLUMNS 12
+#define EXPORT_SUFFIX ".col"
+
+enum EXPORT_TABLE {
+    EXPORT_SYM = 0,                 // rows of .dynsym and .symtab
+    EXPORT_RELOC,                   // rows of SHT_REL and SHT_RELA sections
+    EXPORT_TABLE_NUM,
+};
+
+enum EXPORT_TYPE {
+    EXPORT_U8 = 1,
+    EXPORT_U16,
+    EXPORT_U32,
+    EXPORT_U64,
+    EXPORT_I64,
+};
+
+/* columns of EXPORT_SYM */
+enum EXPORT_SYM_COLUMN {
+    SYM_FILE = 0,                   // u32, index in the file table
+    SYM_TABLE,                      // u8, SHT_DYNSYM or SHT_SYMTAB
+    SYM_VALUE,                      // u64
+    SYM_SIZE,                       // u64
+    SYM_TYPE,                       // u8, STT_*
+    SYM_BIND,                       // u8, STB_*
+    SYM_VIS,                        // u8, STV_*
+    SYM_SHNDX,                      // u16
+    SYM_NAME,                       // u32, offset in the string pool
+    SYM_COLUMN_NUM,
+};
+
+/* columns of EXPORT_RELOC */
+enum EXPORT_RELOC_COLUMN {
+    RELOC_FILE = 0,                 // u32, index in the file table
+    RELOC_OFFSET,                   // u64, r_offset
+    RELOC_TYPE,                     // u32
+    RELOC_SYM,                      // u32, index in the linked symbol table
+    RELOC_ADDEND,                   // i64, 0 for SHT_REL
+    RELOC_NAME,                     // u32, symbol name, offset in the string pool
+    RELOC_COLUMN_NUM,
+};
+
+/*
+ * layout of the export file, all offsets are file offsets and every array
+ * starts at a multiple of EXPORT_ALIGN, little endian as written by the host:
+ * header, file table, the columns of each table, then the string pool.
+ * a column is a plain array of row_num values of its type. the rows of
+ * file f in table t are [files[f].row_start[t], + files[f].row_num[t]).
+ * names are offsets in the string pool, 0 is "". the string tables of each
+ * ELF are copied whole, so a name is the original st_name plus a base.
+ */
+typedef struct export_column {
+    char name[16];
+    uint32_t type;                  // EXPORT_TYPE
+    uint32_t width;                 // bytes per value
+    uint64_t offset;
+} export_column_t;
+
+typedef struct export_table {
+    char name[16];
+    uint64_t row_num;
+    uint32_t column_num;
+    uint32_t reserved;
+    export_column_t columns[EXPORT_MAX_COLUMNS];
+} export_table_t;
+
+typedef struct export_header {
+    char magic[8];
+    uint32_t table_num;
+    uint32_t reserved;
+    uint64_t file_off;              // export_file_t[file_num]
+    uint64_t file_num;
+    uint64_t str_off;               // string pool
+    uint64_t str_size;
+    export_table_t tables[EXPORT_TABLE_NUM];
+} export_header_t;
+
+typedef struct export_file {
+    uint32_t path;                  // offset in the string pool
+    uint16_t class;                 // ELFCLASS32 or ELFCLASS64
+    uint16_t machine;
+    uint64_t row_start[EXPORT_TABLE_NUM];
+    uint64_t row_num[EXPORT_TABLE_NUM];
+} export_file_t;
+
+/**
+ * @brief 将ELF以及列表文件中所有ELF的符号表和重定位表导出为按列存储、可映射的文件，
+ * 各列直接从映射的符号和重定位数组中取值，不做格式化
+ * export the symbol and relocation tables of ELF and of every ELF in the list
+ * file as typed columns of a memory-mappable file. the columns are filled
+ * straight from the mapped symbol and relocation arrays without formatting
+ * @param out_name output file name (optional, default: ELF.col)
+ * @param list_name file with one ELF path per line (optional)
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int export_columns(char *out_name, char *list_name, char *elf_name);
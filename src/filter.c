@@ -0,0 +1,244 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#define _GNU_SOURCE 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <fnmatch.h>
+#include <elf.h>
+#include "common.h"
+#include "filter.h"
+
+static const struct {
+    char *name;
+    int key;
+} s_keys[] = {
+    {"name", FILTER_NAME},
+    {"type", FILTER_TYPE},
+    {"bind", FILTER_BIND},
+    {"vis", FILTER_VIS},
+    {"rtype", FILTER_RTYPE},
+    {"ndx", FILTER_NDX},
+    {"addr", FILTER_ADDR},
+    {"size", FILTER_SIZE},
+};
+
+static int is_string_key(int key) {
+    return key == FILTER_NAME || key == FILTER_TYPE || key == FILTER_BIND ||
+           key == FILTER_VIS || key == FILTER_RTYPE;
+}
+
+/* section index may be given by name */
+static int parse_number(char *str, uint64_t *value) {
+    char *end;
+
+    if (!strcasecmp(str, "UND")) {
+        *value = SHN_UNDEF;
+        return 0;
+    }
+    if (!strcasecmp(str, "ABS")) {
+        *value = SHN_ABS;
+        return 0;
+    }
+    if (!strcasecmp(str, "COM") || !strcasecmp(str, "COMMON")) {
+        *value = SHN_COMMON;
+        return 0;
+    }
+    *value = strtoull(str, &end, 0);
+    return end == str || *end ? -1 : 0;
+}
+
+static int parse_term(char *str, filter_term_t *t) {
+    size_t len = strcspn(str, "=~<>");
+    char *value = str + len + 1;
+    char *dash;
+
+    memset(t, 0, sizeof(filter_term_t));
+    if (!str[len]) {
+        ERROR("filter %s has no operator\n", str);
+        return -1;
+    }
+    t->op = str[len];
+    for (int i = 0; i < sizeof(s_keys) / sizeof(s_keys[0]); i++) {
+        if (strlen(s_keys[i].name) == len && !strncmp(str, s_keys[i].name, len)) {
+            t->key = s_keys[i].key;
+        }
+    }
+    if (!t->key) {
+        ERROR("unknown filter key %.*s\n", (int)len, str);
+        return -1;
+    }
+
+    if (is_string_key(t->key)) {
+        if (t->op == '=') {
+            t->str = strdup(value);
+            return t->str ? 0 : -1;
+        }
+        if (t->op == '~') {
+            if (regcomp(&t->re, value, REG_EXTENDED | REG_NOSUB)) {
+                ERROR("invalid regex %s\n", value);
+                t->op = 0;
+                return -1;
+            }
+            return 0;
+        }
+        ERROR("%.*s only supports '=' and '~'\n", (int)len, str);
+        return -1;
+    }
+
+    if (t->op == '~') {
+        ERROR("%.*s does not support '~'\n", (int)len, str);
+        return -1;
+    }
+    /* lo-hi, the range excludes hi */
+    dash = strchr(value + 1, '-');
+    if (t->op == '=' && dash) {
+        *dash = '\0';
+        if (parse_number(value, &t->lo) || parse_number(dash + 1, &t->hi)) {
+            ERROR("invalid range %s-%s\n", value, dash + 1);
+            return -1;
+        }
+        return 0;
+    }
+    if (parse_number(value, &t->lo)) {
+        ERROR("invalid number %s\n", value);
+        return -1;
+    }
+    t->hi = t->lo + 1;
+    return 0;
+}
+
+/**
+ * @brief 解析过滤表达式，如"name=*alloc*,type=FUNC,size>0x100,addr=0x1000-0x2000"
+ * parse a filter, e.g. "name=*alloc*,type=FUNC,size>0x100,addr=0x1000-0x2000".
+ * keys are name, type, bind, vis, rtype, ndx, addr and size. strings use
+ * '=' for a glob and '~' for a regex, numbers use '=' for a value or a range,
+ * '<' and '>'
+ * @param spec terms separated by ','
+ * @param f output, free it with free_filter
+ * @return int error code {-1:error,0:sucess}
+ */
+int parse_filter(char *spec, filter_t *f) {
+    char *buf, *term, *saveptr = NULL;
+    int cap = 1;
+
+    memset(f, 0, sizeof(filter_t));
+    for (char *p = spec; *p; p++) {
+        if (*p == ',')
+            cap++;
+    }
+    buf = strdup(spec);
+    f->terms = calloc(cap, sizeof(filter_term_t));
+    if (!buf || !f->terms) {
+        free(buf);
+        free(f->terms);
+        f->terms = NULL;
+        return -1;
+    }
+
+    for (term = strtok_r(buf, ",", &saveptr); term; term = strtok_r(NULL, ",", &saveptr)) {
+        if (parse_term(term, &f->terms[f->count])) {
+            free(buf);
+            free_filter(f);
+            return -1;
+        }
+        f->count++;
+    }
+    free(buf);
+    return 0;
+}
+
+/**
+ * @brief 释放过滤器
+ * free a filter
+ * @param f filter
+ */
+void free_filter(filter_t *f) {
+    for (int i = 0; i < f->count; i++) {
+        free(f->terms[i].str);
+        if (f->terms[i].op == '~')
+            regfree(&f->terms[i].re);
+    }
+    free(f->terms);
+    memset(f, 0, sizeof(filter_t));
+}
+
+static int match_string(filter_term_t *t, char *str) {
+    if (!str) {
+        return 0;
+    }
+    if (t->op == '~') {
+        return !regexec(&t->re, str, 0, NULL, 0);
+    }
+    /* symbol names are case sensitive, the type names are not */
+    return !fnmatch(t->str, str, t->key == FILTER_NAME ? 0 : FNM_CASEFOLD);
+}
+
+static int match_number(filter_term_t *t, int has, uint64_t value) {
+    if (!has) {
+        return 0;
+    }
+    switch (t->op) {
+        case '<':   return value < t->lo;
+        case '>':   return value > t->lo;
+        default:    return value >= t->lo && value < t->hi;
+    }
+}
+
+/**
+ * @brief 判断表格的一行是否满足过滤器，表格中没有的字段不满足
+ * whether a table row matches the filter, a term on a field which the table
+ * does not have does not match
+ * @param f filter, NULL or empty matches all rows
+ * @param row table row
+ * @return int {0:no,1:yes}
+ */
+int match_filter(filter_t *f, filter_row_t *row) {
+    if (!f) {
+        return 1;
+    }
+    for (int i = 0; i < f->count; i++) {
+        filter_term_t *t = &f->terms[i];
+        int ok;
+
+        switch (t->key) {
+            case FILTER_NAME:   ok = match_string(t, row->name); break;
+            case FILTER_TYPE:   ok = match_string(t, row->type); break;
+            case FILTER_BIND:   ok = match_string(t, row->bind); break;
+            case FILTER_VIS:    ok = match_string(t, row->vis); break;
+            case FILTER_RTYPE:  ok = match_string(t, row->rtype); break;
+            case FILTER_NDX:    ok = match_number(t, row->fields & FILTER_HAS_NDX, row->ndx); break;
+            case FILTER_ADDR:   ok = match_number(t, row->fields & FILTER_HAS_ADDR, row->addr); break;
+            case FILTER_SIZE:   ok = match_number(t, row->fields & FILTER_HAS_SIZE, row->size); break;
+            default:            ok = 0; break;
+        }
+        if (!ok) {
+            return 0;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,99 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include <regex.h>
+
+/* fields of a table row which a filter term tests */
+enum FILTER_KEY {
+    FILTER_NAME = 1,    // symbol name
+    FILTER_TYPE,        // symbol type, e.g. FUNC
+    FILTER_BIND,        // symbol bind, e.g. GLOBAL
+    FILTER_VIS,         // symbol visibility, e.g. DEFAULT
+    FILTER_RTYPE,       // relocation type, e.g. R_X86_64_GLOB_DAT
+    FILTER_NDX,         // section index of a symbol
+    FILTER_ADDR,        // symbol value or relocation offset
+    FILTER_SIZE,        // symbol size
+};
+
+/* numeric fields which are set in filter_row_t.fields */
+#define FILTER_HAS_NDX  (1 << 0)
+#define FILTER_HAS_ADDR (1 << 1)
+#define FILTER_HAS_SIZE (1 << 2)
+
+typedef struct filter_term {
+    int key;
+    char op;            // '=' glob or range, '~' regex, '<' less, '>' greater
+    char *str;          // pattern of '='
+    regex_t re;         // pattern of '~'
+    uint64_t lo;        // numeric value, or [lo, hi) of a range
+    uint64_t hi;
+} filter_term_t;
+
+/* all terms must match */
+typedef struct filter {
+    filter_term_t *terms;
+    int count;
+} filter_t;
+
+/* a row of a symbol or relocation table, NULL strings are not in the table */
+typedef struct filter_row {
+    char *name;
+    char *type;
+    char *bind;
+    char *vis;
+    char *rtype;
+    uint64_t ndx;
+    uint64_t addr;
+    uint64_t size;
+    int fields;         // FILTER_HAS_*
+} filter_row_t;
+
+/**
+ * @brief 解析过滤表达式，如"name=*alloc*,type=FUNC,size>0x100,addr=0x1000-0x2000"
+ * parse a filter, e.g. "name=*alloc*,type=FUNC,size>0x100,addr=0x1000-0x2000".
+ * keys are name, type, bind, vis, rtype, ndx, addr and size. strings use
+ * '=' for a glob and '~' for a regex, numbers use '=' for a value or a range,
+ * '<' and '>'
+ * @param spec terms separated by ','
+ * @param f output, free it with free_filter
+ * @return int error code {-1:error,0:sucess}
+ */
+int parse_filter(char *spec, filter_t *f);
+
+/**
+ * @brief 释放过滤器
+ * free a filter
+ * @param f filter
+ */
+void free_filter(filter_t *f);
+
+/**
+ * @brief 判断表格的一行是否满足过滤器，表格中没有的字段不满足
+ * whether a table row matches the filter, a term on a field which the table
+ * does not have does not match
+ * @param f filter, NULL or empty matches all rows
+ * @param row table row
+ * @return int {0:no,1:yes}
+ */
+int match_filter(filter_t *f, filter_row_t *row);
@@ -1,5 +1,6 @@
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <ctype.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -8,6 +9,7 @@
 #include <elf.h>
 #include "common.h"
 #include "section.h"
+#include "relr.h"
 
 enum ELF_TYPE {
     ELF_STATIC,
@@ -99,7 +101,7 @@ int check_hook(handle_t32 *h32, handle_t64 *h64, uint64_t start, size_t size) {
         h32->sec_size = sizeof(Elf32_Rel);  // init
         for (int i = 0; i < h32->sec_size / sizeof(Elf32_Rel); i++) {
             offset = get_rel32_offset(h32, ".rel.plt", i);
-            if (offset == -1) {
+            if (offset == (uint32_t)-1) {
                 return -1;
             }
             uint32_t *p = (uint32_t *)(h32->mem + offset);
@@ -658,4 +660,431 @@ int checksec(char *elf_name) {
     printf("|--------------------------------------------------------------------------|\n");
     finit_elf(&h32, &h64);
     return 0;
-}
\ No newline at end of file
+}
+/* relative cost of the dynamic linker work, in units of one RELATIVE relocation */
+#define COST_RELATIVE   1
+#define COST_IRELATIVE  20      // call the ifunc resolver
+#define COST_BLOOM      2       // hash the name and test the bloom filter of one object
+#define COST_CHAIN      3       // compare one hash chain entry, strcmp on a hit
+#define COST_LAZY       1       // rebase one lazy .got.plt slot
+#define COST_RELR       0.5     // one bit of a RELR bitmap, no table entry to read
+
+/* number of distinct relocation types shown */
+#define LINK_TYPE_NUM   64
+
+typedef struct link_cost {
+    uint64_t rel, relsz, relent;
+    uint64_t jmprel, pltrelsz;
+    uint64_t relr, relrsz;
+    int is_rela;
+    uint64_t gnu_hash, hash;
+    int bind_now;
+    int needed;
+
+    uint32_t types[LINK_TYPE_NUM];
+    uint64_t type_count[LINK_TYPE_NUM];
+    int type_num;
+
+    uint64_t relative;      // relocations without symbol lookup
+    uint64_t packed;        // relocations in DT_RELR
+    uint64_t irelative;
+    uint64_t symbolic;      // relocations with symbol lookup
+    uint64_t lookups;       // lookups after the cache of the last symbol
+    uint64_t lazy;          // .got.plt slots bound on the first call
+
+    uint64_t nbuckets;
+    uint64_t empty_buckets;
+    uint64_t hashed_syms;
+    uint64_t max_chain;
+    uint64_t bloom_bits;
+    uint64_t bloom_set;
+} link_cost_t;
+
+/* relocation types which do not look up a symbol */
+static int is_relative_type(int machine, uint32_t type) {
+    switch (machine) {
+        case EM_386:        return type == R_386_RELATIVE;
+        case EM_X86_64:     return type == R_X86_64_RELATIVE;
+        case EM_ARM:        return type == R_ARM_RELATIVE;
+        case EM_AARCH64:    return type == R_AARCH64_RELATIVE;
+        default:            return 0;
+    }
+}
+
+static int is_irelative_type(int machine, uint32_t type) {
+    switch (machine) {
+        case EM_386:        return type == R_386_IRELATIVE;
+        case EM_X86_64:     return type == R_X86_64_IRELATIVE;
+        case EM_ARM:        return type == R_ARM_IRELATIVE;
+        case EM_AARCH64:    return type == R_AARCH64_IRELATIVE;
+        default:            return 0;
+    }
+}
+
+static char *get_rel_type_name(int machine, uint32_t type) {
+    if (machine == EM_X86_64) {
+        switch (type) {
+            case R_X86_64_NONE:         return "R_X86_64_NONE";
+            case R_X86_64_64:           return "R_X86_64_64";
+            case R_X86_64_COPY:         return "R_X86_64_COPY";
+            case R_X86_64_GLOB_DAT:     return "R_X86_64_GLOB_DAT";
+            case R_X86_64_JUMP_SLOT:    return "R_X86_64_JUMP_SLOT";
+            case R_X86_64_RELATIVE:     return "R_X86_64_RELATIVE";
+            case R_X86_64_DTPMOD64:     return "R_X86_64_DTPMOD64";
+            case R_X86_64_DTPOFF64:     return "R_X86_64_DTPOFF64";
+            case R_X86_64_TPOFF64:      return "R_X86_64_TPOFF64";
+            case R_X86_64_IRELATIVE:    return "R_X86_64_IRELATIVE";
+        }
+    }
+    if (machine == EM_386) {
+        switch (type) {
+            case R_386_NONE:            return "R_386_NONE";
+            case R_386_32:              return "R_386_32";
+            case R_386_PC32:            return "R_386_PC32";
+            case R_386_COPY:            return "R_386_COPY";
+            case R_386_GLOB_DAT:        return "R_386_GLOB_DAT";
+            case R_386_JMP_SLOT:        return "R_386_JMP_SLOT";
+            case R_386_RELATIVE:        return "R_386_RELATIVE";
+            case R_386_TLS_TPOFF:       return "R_386_TLS_TPOFF";
+            case R_386_TLS_DTPMOD32:    return "R_386_TLS_DTPMOD32";
+            case R_386_TLS_DTPOFF32:    return "R_386_TLS_DTPOFF32";
+            case R_386_IRELATIVE:       return "R_386_IRELATIVE";
+        }
+    }
+    if (machine == EM_AARCH64) {
+        switch (type) {
+            case R_AARCH64_ABS64:       return "R_AARCH64_ABS64";
+            case R_AARCH64_COPY:        return "R_AARCH64_COPY";
+            case R_AARCH64_GLOB_DAT:    return "R_AARCH64_GLOB_DAT";
+            case R_AARCH64_JUMP_SLOT:   return "R_AARCH64_JUMP_SLOT";
+            case R_AARCH64_RELATIVE:    return "R_AARCH64_RELATIVE";
+            case R_AARCH64_TLS_TPREL:   return "R_AARCH64_TLS_TPREL";
+            case R_AARCH64_IRELATIVE:   return "R_AARCH64_IRELATIVE";
+        }
+    }
+    if (machine == EM_ARM) {
+        switch (type) {
+            case R_ARM_ABS32:           return "R_ARM_ABS32";
+            case R_ARM_COPY:            return "R_ARM_COPY";
+            case R_ARM_GLOB_DAT:        return "R_ARM_GLOB_DAT";
+            case R_ARM_JUMP_SLOT:       return "R_ARM_JUMP_SLOT";
+            case R_ARM_RELATIVE:        return "R_ARM_RELATIVE";
+            case R_ARM_IRELATIVE:       return "R_ARM_IRELATIVE";
+        }
+    }
+    return "unknown";
+}
+
+/**
+ * @brief 根据LOAD段索引，将虚拟地址转换为文件偏移
+ * convert a virtual address to a file offset by the PT_LOAD index of the handle
+ * @param h32 elf file handle struct
+ * @param h64 elf file handle struct
+ * @param addr virtual address
+ * @return uint64_t file offset {-1:error}
+ */
+static uint64_t get_offset_by_addr(handle_t32 *h32, handle_t64 *h64, uint64_t addr) {
+    uint64_t offset;
+    if (load_addr_to_offset(MODE == ELFCLASS32 ? &h32->loads : &h64->loads, addr, 1, &offset)) {
+        return -1;
+    }
+    return offset;
+}
+
+/**
+ * @brief 读取dynamic条目，得到重定位表、哈希表和绑定方式
+ * read the dynamic entries: relocation tables, hash tables and binding
+ * @param h32 elf file handle struct
+ * @param h64 elf file handle struct
+ * @param lc output
+ * @return int error code {-1:error,0:sucess}
+ */
+static int get_link_info(handle_t32 *h32, handle_t64 *h64, link_cost_t *lc) {
+    int has_dynamic = 0;
+
+    if (MODE == ELFCLASS32) {
+        for (int i = 0; i < h32->ehdr->e_phnum; i++) {
+            if (h32->phdr[i].p_type != PT_DYNAMIC)
+                continue;
+            Elf32_Dyn *dyn = (Elf32_Dyn *)(h32->mem + h32->phdr[i].p_offset);
+            has_dynamic = 1;
+            for (int j = 0; j < h32->phdr[i].p_filesz / sizeof(Elf32_Dyn) && dyn[j].d_tag != DT_NULL; j++) {
+                switch (dyn[j].d_tag) {
+                    case DT_RELA:       lc->rel = dyn[j].d_un.d_ptr; lc->is_rela = 1; break;
+                    case DT_REL:        lc->rel = dyn[j].d_un.d_ptr; break;
+                    case DT_RELASZ:
+                    case DT_RELSZ:      lc->relsz = dyn[j].d_un.d_val; break;
+                    case DT_JMPREL:     lc->jmprel = dyn[j].d_un.d_ptr; break;
+                    case DT_PLTRELSZ:   lc->pltrelsz = dyn[j].d_un.d_val; break;
+                    case DT_RELR:       lc->relr = dyn[j].d_un.d_ptr; break;
+                    case DT_RELRSZ:     lc->relrsz = dyn[j].d_un.d_val; break;
+                    case DT_PLTREL:     lc->is_rela = dyn[j].d_un.d_val == DT_RELA; break;
+                    case DT_GNU_HASH:   lc->gnu_hash = dyn[j].d_un.d_ptr; break;
+                    case DT_HASH:       lc->hash = dyn[j].d_un.d_ptr; break;
+                    case DT_NEEDED:     lc->needed++; break;
+                    case DT_BIND_NOW:   lc->bind_now = 1; break;
+                    case DT_FLAGS:      lc->bind_now |= has_flag(dyn[j].d_un.d_val, DF_BIND_NOW); break;
+                    case DT_FLAGS_1:    lc->bind_now |= has_flag(dyn[j].d_un.d_val, DF_1_NOW); break;
+                }
+            }
+            break;
+        }
+        lc->relent = lc->is_rela ? sizeof(Elf32_Rela) : sizeof(Elf32_Rel);
+    }
+
+    if (MODE == ELFCLASS64) {
+        for (int i = 0; i < h64->ehdr->e_phnum; i++) {
+            if (h64->phdr[i].p_type != PT_DYNAMIC)
+                continue;
+            Elf64_Dyn *dyn = (Elf64_Dyn *)(h64->mem + h64->phdr[i].p_offset);
+            has_dynamic = 1;
+            for (int j = 0; j < h64->phdr[i].p_filesz / sizeof(Elf64_Dyn) && dyn[j].d_tag != DT_NULL; j++) {
+                switch (dyn[j].d_tag) {
+                    case DT_RELA:       lc->rel = dyn[j].d_un.d_ptr; lc->is_rela = 1; break;
+                    case DT_REL:        lc->rel = dyn[j].d_un.d_ptr; break;
+                    case DT_RELASZ:
+                    case DT_RELSZ:      lc->relsz = dyn[j].d_un.d_val; break;
+                    case DT_JMPREL:     lc->jmprel = dyn[j].d_un.d_ptr; break;
+                    case DT_PLTRELSZ:   lc->pltrelsz = dyn[j].d_un.d_val; break;
+                    case DT_RELR:       lc->relr = dyn[j].d_un.d_ptr; break;
+                    case DT_RELRSZ:     lc->relrsz = dyn[j].d_un.d_val; break;
+                    case DT_PLTREL:     lc->is_rela = dyn[j].d_un.d_val == DT_RELA; break;
+                    case DT_GNU_HASH:   lc->gnu_hash = dyn[j].d_un.d_ptr; break;
+                    case DT_HASH:       lc->hash = dyn[j].d_un.d_ptr; break;
+                    case DT_NEEDED:     lc->needed++; break;
+                    case DT_BIND_NOW:   lc->bind_now = 1; break;
+                    case DT_FLAGS:      lc->bind_now |= has_flag(dyn[j].d_un.d_val, DF_BIND_NOW); break;
+                    case DT_FLAGS_1:    lc->bind_now |= has_flag(dyn[j].d_un.d_val, DF_1_NOW); break;
+                }
+            }
+            break;
+        }
+        lc->relent = lc->is_rela ? sizeof(Elf64_Rela) : sizeof(Elf64_Rel);
+    }
+
+    return has_dynamic ? 0 : -1;
+}
+
+/**
+ * @brief 统计重定位表，按类型计数，并估计符号查找次数
+ * count the relocations by type and estimate the symbol lookups
+ * @param h32 elf file handle struct
+ * @param h64 elf file handle struct
+ * @param lc link cost
+ * @param addr relocation table address
+ * @param size relocation table size
+ * @param is_plt whether it is the DT_JMPREL table
+ */
+static void count_relocs(handle_t32 *h32, handle_t64 *h64, link_cost_t *lc, uint64_t addr, uint64_t size, int is_plt) {
+    uint8_t *mem = MODE == ELFCLASS32 ? h32->mem : h64->mem;
+    size_t file_size = MODE == ELFCLASS32 ? h32->size : h64->size;
+    int machine = MODE == ELFCLASS32 ? h32->ehdr->e_machine : h64->ehdr->e_machine;
+    uint64_t offset = get_offset_by_addr(h32, h64, addr);
+    uint64_t last_sym = 0;
+
+    if (!addr || !size || offset == -1 || offset + size > file_size) {
+        return;
+    }
+
+    for (uint64_t i = 0; i < size / lc->relent; i++) {
+        uint32_t type, sym;
+        int j;
+        /* r_info follows r_offset in both Rel and Rela */
+        if (MODE == ELFCLASS32) {
+            Elf32_Rel *rel = (Elf32_Rel *)(mem + offset + i * lc->relent);
+            type = ELF32_R_TYPE(rel->r_info);
+            sym = ELF32_R_SYM(rel->r_info);
+        } else {
+            Elf64_Rel *rel = (Elf64_Rel *)(mem + offset + i * lc->relent);
+            type = ELF64_R_TYPE(rel->r_info);
+            sym = ELF64_R_SYM(rel->r_info);
+        }
+
+        for (j = 0; j < lc->type_num && lc->types[j] != type; j++);
+        if (j == lc->type_num && j < LINK_TYPE_NUM) {
+            lc->types[lc->type_num++] = type;
+        }
+        if (j < LINK_TYPE_NUM) {
+            lc->type_count[j]++;
+        }
+
+        if (is_irelative_type(machine, type)) {
+            lc->irelative++;
+        } else if (is_plt && !lc->bind_now) {
+            lc->lazy++;
+        } else if (!sym || is_relative_type(machine, type)) {
+            lc->relative++;
+        } else {
+            /* ld.so reuses the result of the last lookup for the same symbol */
+            lc->symbolic++;
+            if (sym != last_sym)
+                lc->lookups++;
+            last_sym = sym;
+        }
+    }
+}
+
+/**
+ * @brief 统计DT_RELR中的重定位数量
+ * count the relocations packed in DT_RELR
+ * @param h32 elf file handle struct
+ * @param h64 elf file handle struct
+ * @param lc link cost
+ */
+static void count_relr(handle_t32 *h32, handle_t64 *h64, link_cost_t *lc) {
+    uint8_t *mem = MODE == ELFCLASS32 ? h32->mem : h64->mem;
+    size_t file_size = MODE == ELFCLASS32 ? h32->size : h64->size;
+    uint64_t offset = get_offset_by_addr(h32, h64, lc->relr);
+    uint64_t *addrs;
+    size_t count;
+
+    if (!lc->relr || offset == -1 || offset + lc->relrsz > file_size) {
+        return;
+    }
+    if (!decode_relr(mem + offset, lc->relrsz, MODE == ELFCLASS32 ? 4 : 8, &addrs, &count)) {
+        lc->packed = count;
+        free(addrs);
+    }
+}
+
+/**
+ * @brief 统计.gnu.hash的链长度和布隆过滤器密度
+ * measure the chain length and the bloom filter density of .gnu.hash
+ * @param h32 elf file handle struct
+ * @param h64 elf file handle struct
+ * @param lc link cost
+ * @return int error code {-1:error,0:sucess}
+ */
+static int measure_gnu_hash(handle_t32 *h32, handle_t64 *h64, link_cost_t *lc) {
+    uint8_t *mem = MODE == ELFCLASS32 ? h32->mem : h64->mem;
+    size_t file_size = MODE == ELFCLASS32 ? h32->size : h64->size;
+    size_t word_size = MODE == ELFCLASS32 ? 4 : 8;
+    uint64_t offset = get_offset_by_addr(h32, h64, lc->gnu_hash);
+    gnuhash_t *hash;
+    uint32_t *buckets, *chain;
+    uint32_t *end;
+
+    if (!lc->gnu_hash || offset == -1 || offset + sizeof(gnuhash_t) > file_size) {
+        return -1;
+    }
+    hash = (gnuhash_t *)(mem + offset);
+    if (offset + sizeof(gnuhash_t) + hash->maskbits * word_size + hash->nbuckets * 4 > file_size) {
+        return -1;
+    }
+
+    /* bloom filter */
+    lc->bloom_bits = hash->maskbits * word_size * 8;
+    for (uint32_t i = 0; i < hash->maskbits; i++) {
+        if (MODE == ELFCLASS32)
+            lc->bloom_set += __builtin_popcount(((uint32_t *)hash->buckets)[i]);
+        else
+            lc->bloom_set += __builtin_popcountll(((uint64_t *)hash->buckets)[i]);
+    }
+
+    /* chains end at the entry with the lowest bit set */
+    buckets = (uint32_t *)((uint8_t *)hash->buckets + hash->maskbits * word_size);
+    chain = buckets + hash->nbuckets;
+    end = (uint32_t *)(mem + file_size);
+    lc->nbuckets = hash->nbuckets;
+    for (uint32_t i = 0; i < hash->nbuckets; i++) {
+        uint64_t len = 0;
+        if (buckets[i] < hash->symndx) {
+            lc->empty_buckets++;
+            continue;
+        }
+        for (uint32_t *p = chain + buckets[i] - hash->symndx; p < end; p++) {
+            len++;
+            if (*p & 1)
+                break;
+        }
+        lc->hashed_syms += len;
+        if (len > lc->max_chain)
+            lc->max_chain = len;
+    }
+    return 0;
+}
+
+/**
+ * @brief 估计动态链接的启动开销：重定位数量、符号查找次数、哈希链长度和布隆过滤器密度
+ * estimate the dynamic linking cost at startup: relocations by type, symbol lookups,
+ * .gnu.hash chain length and bloom filter density
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int linkcost(char *elf_name) {
+    handle_t32 h32;
+    handle_t64 h64;
+    link_cost_t lc;
+    int machine;
+    double avg_chain = 1, density = 0, false_positive = 0;
+    double per_lookup, budget;
+    int ret = init_elf(elf_name, &h32, &h64);
+    if (ret) {
+        ERROR("init elf error\n");
+        return -1;
+    }
+
+    memset(&lc, 0, sizeof(link_cost_t));
+    if (get_link_info(&h32, &h64, &lc)) {
+        WARNING("%s is statically linked\n", elf_name);
+        finit_elf(&h32, &h64);
+        return -1;
+    }
+    machine = MODE == ELFCLASS32 ? h32.ehdr->e_machine : h64.ehdr->e_machine;
+    count_relocs(&h32, &h64, &lc, lc.rel, lc.relsz, 0);
+    count_relocs(&h32, &h64, &lc, lc.jmprel, lc.pltrelsz, 1);
+    count_relr(&h32, &h64, &lc);
+
+    INFO("relocations (%s)\n", lc.bind_now ? "bind now" : "bind lazy");
+    printf("|-----------------------------------------|\n");
+    printf("|%-24s|%16s|\n", "type", "count");
+    printf("|-----------------------------------------|\n");
+    for (int i = 0; i < lc.type_num; i++) {
+        printf("|%-24s|%16lu|\n", get_rel_type_name(machine, lc.types[i]), lc.type_count[i]);
+    }
+    printf("|-----------------------------------------|\n");
+    printf("|%-24s|%16lu|\n", "relative", lc.relative);
+    printf("|%-24s|%16lu|\n", "relr", lc.packed);
+    printf("|%-24s|%16lu|\n", "ifunc", lc.irelative);
+    printf("|%-24s|%16lu|\n", "symbolic", lc.symbolic);
+    printf("|%-24s|%16lu|\n", "symbol lookups", lc.lookups);
+    printf("|%-24s|%16lu|\n", "lazy slots", lc.lazy);
+    printf("|%-24s|%16d|\n", "DT_NEEDED", lc.needed);
+    printf("|-----------------------------------------|\n");
+
+    if (!measure_gnu_hash(&h32, &h64, &lc)) {
+        if (lc.nbuckets > lc.empty_buckets)
+            avg_chain = (double)lc.hashed_syms / (lc.nbuckets - lc.empty_buckets);
+        if (lc.bloom_bits)
+            density = (double)lc.bloom_set / lc.bloom_bits;
+        /* a miss passes the bloom filter only if both bits are set */
+        false_positive = density * density;
+        INFO(".gnu.hash\n");
+        printf("|-----------------------------------------|\n");
+        printf("|%-24s|%16lu|\n", "buckets", lc.nbuckets);
+        printf("|%-24s|%16lu|\n", "empty buckets", lc.empty_buckets);
+        printf("|%-24s|%16lu|\n", "hashed symbols", lc.hashed_syms);
+        printf("|%-24s|%16.2f|\n", "average chain", avg_chain);
+        printf("|%-24s|%16lu|\n", "max chain", lc.max_chain);
+        printf("|%-24s|%15.1f%%|\n", "bloom density", density * 100);
+        printf("|%-24s|%15.1f%%|\n", "bloom false positive", false_positive * 100);
+        printf("|-----------------------------------------|\n");
+        if (lc.max_chain > 4 * avg_chain + 4)
+            WARNING("the longest chain is %lu, refresh the hash table with --refresh-hash\n", lc.max_chain);
+    } else if (lc.hash) {
+        WARNING("only DT_HASH, every lookup walks a SysV hash chain\n");
+    }
+
+    /*
+     * each lookup tests the bloom filter of every object in the scope, on average
+     * half of them plus this one, and walks the chain of the object defining it.
+     * the chain of this file stands in for the unknown libraries.
+     */
+    per_lookup = ((lc.needed + 2) / 2.0) * COST_BLOOM + avg_chain * COST_CHAIN;
+    budget = lc.relative * COST_RELATIVE + lc.packed * COST_RELR + lc.irelative * COST_IRELATIVE +
+             lc.lookups * per_lookup + (lc.symbolic - lc.lookups) * COST_RELATIVE + lc.lazy * COST_LAZY;
+    INFO("estimated relocation budget: %.0f (%.1f per symbol lookup, in units of one RELATIVE relocation)\n", budget, per_lookup);
+
+    finit_elf(&h32, &h64);
+    return 0;
+}
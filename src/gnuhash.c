@@ -101,9 +101,13 @@ int set_hash_table32(char *elf_name) {
         int bucket = hash % raw_gnuhash->nbuckets;
 
         if (bucket < previous_bucket) {
-            ERROR("Previous bucket is greater than the current one (%s < %s)",
+            ERROR("Previous bucket is greater than the current one (%d < %d)\n",
                     bucket, previous_bucket);
-            return 0;
+            free(hash_chain);
+            free(buckets);
+            free(bloom_filters);
+            free(raw_gnuhash);
+            return -1;
         }
 
         if (bucket != previous_bucket) {
@@ -227,9 +231,13 @@ int set_hash_table64(char *elf_name) {
         int bucket = hash % raw_gnuhash->nbuckets;
 
         if (bucket < previous_bucket) {
-            ERROR("Previous bucket is greater than the current one (%s < %s)",
+            ERROR("Previous bucket is greater than the current one (%d < %d)\n",
                     bucket, previous_bucket);
-            return 0;
+            free(hash_chain);
+            free(buckets);
+            free(bloom_filters);
+            free(raw_gnuhash);
+            return -1;
         }
 
         if (bucket != previous_bucket) {
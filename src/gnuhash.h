@@ -1,3 +1,5 @@
+// compute symbol hash
+uint32_t dl_new_hash(const char* name);
 /* 重新计算hash表 */
 /* Mainly inspired from LIEF */
 int set_hash_table32(char *elf_name);
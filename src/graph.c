@@ -0,0 +1,487 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#define _GNU_SOURCE 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <ftw.h>
+#include <pthread.h>
+#include <elf.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "common.h"
+#include "hashmap.h"
+#include "version.h"
+#include "resolve.h"
+#include "graph.h"
+
+typedef struct parse_job {
+    resolve_obj_t **objs;
+    size_t num;
+    size_t *next;               // shared by the workers
+} parse_job_t;
+
+/* nftw has no user pointer */
+static char **s_paths;
+static size_t s_path_num;
+static size_t s_path_cap;
+
+static int collect_path(const char *path, const struct stat *st, int type, struct FTW *ftw) {
+    if (type != FTW_F || !S_ISREG(st->st_mode) || st->st_size < EI_NIDENT) {
+        return 0;
+    }
+    if (s_path_num == s_path_cap) {
+        size_t cap = s_path_cap ? s_path_cap * 2 : 1024;
+        char **tmp = realloc(s_paths, cap * sizeof(char *));
+        if (!tmp)
+            return -1;
+        s_paths = tmp;
+        s_path_cap = cap;
+    }
+    s_paths[s_path_num] = strdup(path);
+    if (!s_paths[s_path_num])
+        return -1;
+    s_path_num++;
+    return 0;
+}
+
+static void *parse_worker(void *arg) {
+    parse_job_t *job = (parse_job_t *)arg;
+    size_t i;
+
+    while ((i = __atomic_fetch_add(job->next, 1, __ATOMIC_RELAXED)) < job->num) {
+        resolve_parse_obj(job->objs[i]);
+    }
+    return NULL;
+}
+
+/**
+ * @brief 多线程解析同一字长的对象，解析期间MODE不变
+ * parse the objects of one class in parallel, MODE does not change meanwhile
+ */
+static void parse_objs(resolve_obj_t **objs, size_t num) {
+    pthread_t threads[GRAPH_MAX_THREADS];
+    parse_job_t job;
+    size_t next = 0;
+    int thread_num, created = 0;
+
+    thread_num = sysconf(_SC_NPROCESSORS_ONLN);
+    if (thread_num < 1)
+        thread_num = 1;
+    if (thread_num > GRAPH_MAX_THREADS)
+        thread_num = GRAPH_MAX_THREADS;
+
+    job.objs = objs;
+    job.num = num;
+    job.next = &next;
+    /* the main thread is a worker too */
+    for (int i = 1; i < thread_num; i++) {
+        if (pthread_create(&threads[i], NULL, parse_worker, &job))
+            break;
+        created = i;
+    }
+    parse_worker(&job);
+    for (int i = 1; i <= created; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+static int get_node(dep_graph_t *g, resolve_obj_t *o) {
+    uint64_t hash = hash_bytes(o->id, sizeof(o->id));
+    uint64_t value;
+
+    if (!hashmap_get(&g->map, hash, o->id, sizeof(o->id), &value)) {
+        return value;
+    }
+    if (g->num == g->cap) {
+        int cap = g->cap ? g->cap * 2 : 256;
+        graph_node_t *tmp = realloc(g->nodes, cap * sizeof(graph_node_t));
+        if (!tmp)
+            return -1;
+        g->nodes = tmp;
+        g->cap = cap;
+    }
+    if (hashmap_put(&g->map, hash, o->id, sizeof(o->id), g->num) == -1) {
+        return -1;
+    }
+    memset(&g->nodes[g->num], 0, sizeof(graph_node_t));
+    g->nodes[g->num].obj = o;
+    g->nodes[g->num].visit = -1;
+    return g->num++;
+}
+
+static int add_int(int **array, int *num, int *cap, int value) {
+    for (int i = 0; i < *num; i++) {
+        if ((*array)[i] == value)
+            return 0;
+    }
+    if (*num == *cap) {
+        int new_cap = *cap ? *cap * 2 : 8;
+        int *tmp = realloc(*array, new_cap * sizeof(int));
+        if (!tmp)
+            return -1;
+        *array = tmp;
+        *cap = new_cap;
+    }
+    (*array)[(*num)++] = value;
+    return 0;
+}
+
+static int add_missing(graph_node_t *n, uint32_t name) {
+    uint32_t *tmp;
+
+    for (int i = 0; i < n->missing_num; i++) {
+        if (n->missing[i] == name)
+            return 0;
+    }
+    tmp = realloc(n->missing, (n->missing_num + 1) * sizeof(uint32_t));
+    if (!tmp) {
+        return -1;
+    }
+    n->missing = tmp;
+    n->missing[n->missing_num++] = name;
+    return 0;
+}
+
+/**
+ * @brief 从一个入口程序开始，按照ld.so的广度优先顺序加载依赖
+ * load the dependencies of an entrypoint breadth-first, like ld.so
+ */
+static int walk_entry(dep_graph_t *g, int entry) {
+    resolve_obj_t *exe = g->nodes[entry].obj;
+    int *queue = NULL;
+    int num = 0, cap = 0;
+    int ret = -1;
+
+    MODE = exe->class;
+    g->nodes[entry].entry = 1;
+    g->nodes[entry].visit = entry;
+    if (add_int(&queue, &num, &cap, entry)) {
+        return -1;
+    }
+    for (int i = 0; i < num; i++) {
+        graph_node_t *n = &g->nodes[queue[i]];
+        resolve_obj_t *o = n->obj;
+        n->in_closure = 1;
+        for (int j = 0; j < o->needed_num; j++) {
+            char *name = resolve_get_str(o, o->needed[j]);
+            resolve_obj_t *dep = NULL;
+            int d;
+            /* a loaded object is reused if its DT_SONAME matches */
+            for (int k = 0; k < num && !dep; k++) {
+                resolve_obj_t *loaded = g->nodes[queue[k]].obj;
+                if (loaded->soname && !strcmp(loaded->soname, name))
+                    dep = loaded;
+            }
+            if (!dep) {
+                dep = resolve_find_needed(&g->ctx, exe, o, name);
+            }
+            if (!dep) {
+                if (add_missing(&g->nodes[queue[i]], o->needed[j]))
+                    goto ERR_EXIT;
+                continue;
+            }
+            d = get_node(g, dep);
+            if (d == -1 || add_int(&g->nodes[queue[i]].deps, &g->nodes[queue[i]].dep_num, &g->nodes[queue[i]].dep_cap, d))
+                goto ERR_EXIT;
+            if (g->nodes[d].visit != entry) {
+                g->nodes[d].visit = entry;
+                if (add_int(&queue, &num, &cap, d))
+                    goto ERR_EXIT;
+            }
+        }
+    }
+    ret = 0;
+
+ERR_EXIT:
+    free(queue);
+    return ret;
+}
+
+/* paths are shown inside the sysroot */
+static char *get_node_path(dep_graph_t *g, int i) {
+    char *path = g->nodes[i].obj->path;
+    size_t len = strlen(g->ctx.sysroot);
+    return len && !strncmp(path, g->ctx.sysroot, len) ? path + len : path;
+}
+
+static void print_json_str(char *s) {
+    putchar('"');
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\')
+            printf("\\%c", *s);
+        else if ((unsigned char)*s < 0x20)
+            printf("\\u%04x", *s);
+        else
+            putchar(*s);
+    }
+    putchar('"');
+}
+
+static void print_text(dep_graph_t *g, int entry_num) {
+    int closure = 0;
+
+    for (int i = 0; i < g->num; i++) {
+        closure += g->nodes[i].in_closure;
+    }
+    INFO("closure of %d entrypoints: %d objects\n", entry_num, closure);
+    for (int i = 0; i < g->num; i++) {
+        if (g->nodes[i].in_closure)
+            printf("%s\n", get_node_path(g, i));
+    }
+
+    INFO("reverse dependencies\n");
+    for (int i = 0; i < g->num; i++) {
+        if (!g->nodes[i].rdep_num)
+            continue;
+        printf("%s <-", get_node_path(g, i));
+        for (int j = 0; j < g->nodes[i].rdep_num; j++)
+            printf(" %s", get_node_path(g, g->nodes[i].rdeps[j]));
+        printf("\n");
+    }
+
+    for (int i = 0; i < g->num; i++) {
+        for (int j = 0; j < g->nodes[i].missing_num; j++)
+            WARNING("%s: %s not found\n", get_node_path(g, i),
+                resolve_get_str(g->nodes[i].obj, g->nodes[i].missing[j]));
+    }
+}
+
+static void print_dot(dep_graph_t *g) {
+    printf("digraph needed {\n");
+    for (int i = 0; i < g->num; i++) {
+        if (!g->nodes[i].in_closure)
+            continue;
+        printf("    n%d [label=\"%s\"%s];\n", i, get_node_path(g, i), g->nodes[i].entry ? ", shape=box" : "");
+        for (int j = 0; j < g->nodes[i].missing_num; j++)
+            printf("    m%d_%d [label=\"%s\", style=dashed];\n", i, j,
+                resolve_get_str(g->nodes[i].obj, g->nodes[i].missing[j]));
+    }
+    for (int i = 0; i < g->num; i++) {
+        for (int j = 0; j < g->nodes[i].dep_num; j++)
+            printf("    n%d -> n%d;\n", i, g->nodes[i].deps[j]);
+        for (int j = 0; j < g->nodes[i].missing_num; j++)
+            printf("    n%d -> m%d_%d [style=dashed];\n", i, i, j);
+    }
+    printf("}\n");
+}
+
+static void print_json(dep_graph_t *g) {
+    int first = 1;
+
+    printf("{\n  \"closure\": [");
+    for (int i = 0; i < g->num; i++) {
+        if (!g->nodes[i].in_closure)
+            continue;
+        printf(first ? "\n    " : ",\n    ");
+        print_json_str(get_node_path(g, i));
+        first = 0;
+    }
+    printf("\n  ],\n  \"nodes\": [");
+    for (int i = 0; i < g->num; i++) {
+        graph_node_t *n = &g->nodes[i];
+        printf(i ? ",\n    {\"path\": " : "\n    {\"path\": ");
+        print_json_str(get_node_path(g, i));
+        printf(", \"entry\": %s, \"needed\": [", n->entry ? "true" : "false");
+        for (int j = 0; j < n->dep_num; j++) {
+            printf(j ? ", " : "");
+            print_json_str(get_node_path(g, n->deps[j]));
+        }
+        printf("], \"needed_by\": [");
+        for (int j = 0; j < n->rdep_num; j++) {
+            printf(j ? ", " : "");
+            print_json_str(get_node_path(g, n->rdeps[j]));
+        }
+        printf("], \"missing\": [");
+        for (int j = 0; j < n->missing_num; j++) {
+            printf(j ? ", " : "");
+            print_json_str(resolve_get_str(n->obj, n->missing[j]));
+        }
+        printf("]}");
+    }
+    printf("\n  ]\n}\n");
+}
+
+/**
+ * @brief 并行解析目录中所有ELF的.dynamic，按照RPATH/RUNPATH/默认路径解析DT_NEEDED，
+ * 输出入口程序的依赖闭包、反向依赖以及DOT/JSON格式的依赖图
+ * parse .dynamic of every ELF of a tree in parallel, resolve DT_NEEDED with
+ * RPATH/RUNPATH/default paths, and emit the closure of the entrypoints, the
+ * reverse dependencies and a DOT/JSON graph
+ * @param dir directory, the sysroot of the search
+ * @param list_name file with one entrypoint per line, as a path in the sysroot
+ * (optional, default: every executable with PT_INTERP)
+ * @param format "text", "dot" or "json"
+ * @return int error code {-1:error,0:sucess}
+ */
+int build_dep_graph(char *dir, char *list_name, char *format) {
+    dep_graph_t g;
+    resolve_obj_t **objs = NULL;
+    size_t obj_num = 0;
+    int entry_num = 0;
+    int fmt = GRAPH_TEXT;
+    int ret = -1;
+
+    if (format && !strcmp(format, "dot")) {
+        fmt = GRAPH_DOT;
+    } else if (format && !strcmp(format, "json")) {
+        fmt = GRAPH_JSON;
+    } else if (format && format[0] && strcmp(format, "text")) {
+        ERROR("unknown format %s, expect text, dot or json\n", format);
+        return -1;
+    }
+
+    memset(&g, 0, sizeof(g));
+    if (init_resolve(dir, &g.ctx)) {
+        ERROR("init resolver error\n");
+        return -1;
+    }
+    if (hashmap_init(&g.map, 1024)) {
+        goto ERR_EXIT;
+    }
+
+    /* 1. map every file once, hard links and symbolic links share the object */
+    s_paths = NULL;
+    s_path_num = s_path_cap = 0;
+    if (nftw(dir, collect_path, 64, FTW_PHYS) < 0) {
+        perror("nftw");
+        goto ERR_EXIT;
+    }
+    for (size_t i = 0; i < s_path_num; i++) {
+        resolve_load_obj(&g.ctx, s_paths[i]);
+    }
+
+    /* 2. parse each object exactly once, in parallel, one class at a time */
+    objs = malloc((g.ctx.inodes.num + 1) * sizeof(resolve_obj_t *));
+    if (!objs) {
+        goto ERR_EXIT;
+    }
+    for (int class = ELFCLASS32; class <= ELFCLASS64; class++) {
+        obj_num = 0;
+        for (size_t i = 0; i < g.ctx.inodes.cap; i++) {
+            resolve_obj_t *o = (resolve_obj_t *)g.ctx.inodes.entries[i].value;
+            if (g.ctx.inodes.entries[i].key && o->class == class && !o->parsed)
+                objs[obj_num++] = o;
+        }
+        MODE = class;
+        parse_objs(objs, obj_num);
+    }
+
+    /* 3. the entrypoints, in the order of the list or of the tree */
+    if (list_name && list_name[0]) {
+        char line[PATH_MAX];
+        char path[PATH_MAX];
+        FILE *fp = fopen(list_name, "r");
+        if (!fp) {
+            perror("fopen");
+            goto ERR_EXIT;
+        }
+        while (fgets(line, sizeof(line), fp)) {
+            char *name = strtok(line, "\r\n");
+            resolve_obj_t *o;
+            int n;
+            if (!name || name[0] == '#')
+                continue;
+            if (snprintf(path, sizeof(path), "%s%s%s", g.ctx.sysroot, name[0] == '/' ? "" : "/", name) >= sizeof(path)) {
+                WARNING("%s is too long\n", name);
+                continue;
+            }
+            o = resolve_load_obj(&g.ctx, path);
+            if (o && o->class != MODE) {
+                MODE = o->class;
+            }
+            if (!o || resolve_parse_obj(o)) {
+                WARNING("%s is not a dynamically linked ELF\n", name);
+                continue;
+            }
+            n = get_node(&g, o);
+            if (n == -1 || walk_entry(&g, n)) {
+                fclose(fp);
+                goto ERR_EXIT;
+            }
+            entry_num++;
+        }
+        fclose(fp);
+    } else {
+        for (size_t i = 0; i < s_path_num; i++) {
+            resolve_obj_t *o = resolve_load_obj(&g.ctx, s_paths[i]);
+            int n;
+            if (!o || o->parsed != 1 || !o->interp)
+                continue;
+            n = get_node(&g, o);
+            if (n == -1)
+                goto ERR_EXIT;
+            if (g.nodes[n].entry)
+                continue;
+            if (walk_entry(&g, n))
+                goto ERR_EXIT;
+            entry_num++;
+        }
+    }
+
+    /* 4. reverse dependencies */
+    for (int i = 0; i < g.num; i++) {
+        for (int j = 0; j < g.nodes[i].dep_num; j++) {
+            graph_node_t *d = &g.nodes[g.nodes[i].deps[j]];
+            int *tmp = realloc(d->rdeps, (d->rdep_num + 1) * sizeof(int));
+            if (!tmp)
+                goto ERR_EXIT;
+            d->rdeps = tmp;
+            d->rdeps[d->rdep_num++] = i;
+        }
+    }
+
+    if (fmt == GRAPH_DOT)
+        print_dot(&g);
+    else if (fmt == GRAPH_JSON)
+        print_json(&g);
+    else
+        print_text(&g, entry_num);
+    ret = 0;
+
+ERR_EXIT:
+    if (ret) {
+        ERROR("build dependency graph error\n");
+    }
+    for (int i = 0; i < g.num; i++) {
+        free(g.nodes[i].deps);
+        free(g.nodes[i].rdeps);
+        free(g.nodes[i].missing);
+    }
+    free(g.nodes);
+    hashmap_free(&g.map);
+    for (size_t i = 0; i < s_path_num; i++) {
+        free(s_paths[i]);
+    }
+    free(s_paths);
+    s_paths = NULL;
+    s_path_num = s_path_cap = 0;
+    free(objs);
+    finit_resolve(&g.ctx);
+    return ret;
+}
@@ -0,0 +1,68 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#define GRAPH_MAX_THREADS 16
+
+enum GRAPH_FORMAT {
+    GRAPH_TEXT = 0,
+    GRAPH_DOT,
+    GRAPH_JSON,
+};
+
+/* an ELF of the tree, one node per inode */
+typedef struct graph_node {
+    resolve_obj_t *obj;
+    int entry;                  // an entrypoint
+    int in_closure;
+    int visit;                  // the last entrypoint that reached this node
+    int *deps;                  // resolved DT_NEEDED, node indexes
+    int dep_num;
+    int dep_cap;
+    int *rdeps;                 // nodes needing this one
+    int rdep_num;
+    uint32_t *missing;          // .dynstr offsets of the DT_NEEDED entries not found
+    int missing_num;
+} graph_node_t;
+
+typedef struct dep_graph {
+    resolve_ctx_t ctx;          // library search and the object cache
+    hashmap_t map;              // device and inode -> node index
+    graph_node_t *nodes;
+    int num;
+    int cap;
+} dep_graph_t;
+
+/**
+ * @brief 并行解析目录中所有ELF的.dynamic，按照RPATH/RUNPATH/默认路径解析DT_NEEDED，
+ * 输出入口程序的依赖闭包、反向依赖以及DOT/JSON格式的依赖图
+ * parse .dynamic of every ELF of a tree in parallel, resolve DT_NEEDED with
+ * RPATH/RUNPATH/default paths, and emit the closure of the entrypoints, the
+ * reverse dependencies and a DOT/JSON graph
+ * @param dir directory, the sysroot of the search
+ * @param list_name file with one entrypoint per line, as a path in the sysroot
+ * (optional, default: every executable with PT_INTERP)
+ * @param format "text", "dot" or "json"
+ * @return int error code {-1:error,0:sucess}
+ */
+int build_dep_graph(char *dir, char *list_name, char *format);
@@ -0,0 +1,164 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "hashmap.h"
+
+/**
+ * @brief 计算FNV-1a哈希值
+ * compute the FNV-1a hash
+ * @param data bytes
+ * @param len length of bytes
+ * @return hash value
+ */
+uint64_t hash_bytes(const void *data, size_t len) {
+    const uint8_t *p = data;
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief 初始化哈希表
+ * initialize the hash map
+ * @param map hash map
+ * @param num expected number of keys
+ * @return int error code {-1:error,0:sucess}
+ */
+int hashmap_init(hashmap_t *map, size_t num) {
+    size_t cap = 16;
+    /* keep the load factor under 1/2 */
+    while (cap < num * 2) {
+        cap <<= 1;
+    }
+    map->entries = calloc(cap, sizeof(hashmap_entry_t));
+    if (!map->entries) {
+        return -1;
+    }
+    map->cap = cap;
+    map->num = 0;
+    return 0;
+}
+
+/**
+ * @brief 释放哈希表，不释放key
+ * free the hash map, the keys are not freed
+ * @param map hash map
+ */
+void hashmap_free(hashmap_t *map) {
+    free(map->entries);
+    map->entries = NULL;
+    map->cap = 0;
+    map->num = 0;
+}
+
+static hashmap_entry_t *find_slot(hashmap_entry_t *entries, size_t cap, uint64_t hash, const void *key, size_t key_len) {
+    size_t i = hash & (cap - 1);
+    while (entries[i].key) {
+        if (entries[i].hash == hash && entries[i].key_len == key_len &&
+            !memcmp(entries[i].key, key, key_len)) {
+            break;
+        }
+        i = (i + 1) & (cap - 1);
+    }
+    return &entries[i];
+}
+
+static int grow(hashmap_t *map) {
+    size_t cap = map->cap << 1;
+    hashmap_entry_t *entries = calloc(cap, sizeof(hashmap_entry_t));
+    if (!entries) {
+        return -1;
+    }
+    for (size_t i = 0; i < map->cap; i++) {
+        hashmap_entry_t *e = &map->entries[i];
+        if (e->key) {
+            *find_slot(entries, cap, e->hash, e->key, e->key_len) = *e;
+        }
+    }
+    free(map->entries);
+    map->entries = entries;
+    map->cap = cap;
+    return 0;
+}
+
+/**
+ * @brief 插入key，如果key已存在，保留原有的值
+ * insert a key, keep the old value if the key exists
+ * @param map hash map
+ * @param hash hash of key, e.g. hash_bytes(key, key_len)
+ * @param key key bytes
+ * @param key_len length of key
+ * @param value value
+ * @return int {-1:error,0:inserted,1:exists}
+ */
+int hashmap_put(hashmap_t *map, uint64_t hash, const void *key, size_t key_len, uint64_t value) {
+    hashmap_entry_t *e;
+
+    if ((map->num + 1) * 2 > map->cap && grow(map)) {
+        return -1;
+    }
+    e = find_slot(map->entries, map->cap, hash, key, key_len);
+    if (e->key) {
+        return 1;
+    }
+    e->hash = hash;
+    e->key = key;
+    e->key_len = key_len;
+    e->value = value;
+    map->num++;
+    return 0;
+}
+
+/**
+ * @brief 查找key
+ * look up a key
+ * @param map hash map
+ * @param hash hash of key
+ * @param key key bytes
+ * @param key_len length of key
+ * @param value output, value of key (optional)
+ * @return int {-1:not found,0:found}
+ */
+int hashmap_get(hashmap_t *map, uint64_t hash, const void *key, size_t key_len, uint64_t *value) {
+    hashmap_entry_t *e;
+
+    if (!map->cap) {
+        return -1;
+    }
+    e = find_slot(map->entries, map->cap, hash, key, key_len);
+    if (!e->key) {
+        return -1;
+    }
+    if (value) {
+        *value = e->value;
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+/* FNV-1a */
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+/*
+ * open addressing hash map with linear probing. keys are byte strings owned
+ * by the caller, they must stay valid while the map is used.
+ */
+typedef struct hashmap_entry {
+    uint64_t hash;
+    const void *key;        // NULL means an empty slot
+    size_t key_len;
+    uint64_t value;
+} hashmap_entry_t;
+
+typedef struct hashmap {
+    hashmap_entry_t *entries;
+    size_t cap;             // power of 2
+    size_t num;
+} hashmap_t;
+
+/**
+ * @brief 计算FNV-1a哈希值
+ * compute the FNV-1a hash
+ * @param data bytes
+ * @param len length of bytes
+ * @return hash value
+ */
+uint64_t hash_bytes(const void *data, size_t len);
+
+/**
+ * @brief 初始化哈希表
+ * initialize the hash map
+ * @param map hash map
+ * @param num expected number of keys
+ * @return int error code {-1:error,0:sucess}
+ */
+int hashmap_init(hashmap_t *map, size_t num);
+
+/**
+ * @brief 释放哈希表，不释放key
+ * free the hash map, the keys are not freed
+ * @param map hash map
+ */
+void hashmap_free(hashmap_t *map);
+
+/**
+ * @brief 插入key，如果key已存在，保留原有的值
+ * insert a key, keep the old value if the key exists
+ * @param map hash map
+ * @param hash hash of key, e.g. hash_bytes(key, key_len)
+ * @param key key bytes
+ * @param key_len length of key
+ * @param value value
+ * @return int {-1:error,0:inserted,1:exists}
+ */
+int hashmap_put(hashmap_t *map, uint64_t hash, const void *key, size_t key_len, uint64_t value);
+
+/**
+ * @brief 查找key
+ * look up a key
+ * @param map hash map
+ * @param hash hash of key
+ * @param key key bytes
+ * @param key_len length of key
+ * @param value output, value of key (optional)
+ * @return int {-1:not found,0:found}
+ */
+int hashmap_get(hashmap_t *map, uint64_t hash, const void *key, size_t key_len, uint64_t *value);
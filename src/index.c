@@ -0,0 +1,903 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#define _GNU_SOURCE 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <unistd.h>
+#include <ftw.h>
+#include <time.h>
+#include <pthread.h>
+#include <elf.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "common.h"
+#include "hashmap.h"
+#include "index.h"
+
+/* strings are interned, a name used by many files is stored once */
+typedef struct str_pool {
+    char **chunks;
+    size_t *chunk_used;
+    size_t chunk_num;
+    uint64_t size;
+    hashmap_t map;                  // string -> offset
+} str_pool_t;
+
+/* a file found by the scan */
+typedef struct scan_file {
+    char *path;
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    int64_t old;                    // index in the old index, -1 if the file is parsed
+    uint32_t flags;
+    char *build_id;                 // hex
+    char *names;                    // exports, then imports, separated by '\0'
+    size_t names_size;
+    uint32_t export_num;
+    uint32_t import_num;
+} scan_file_t;
+
+typedef struct scan_job {
+    scan_file_t *files;
+    size_t num;
+    size_t *next;                   // shared by the workers
+} scan_job_t;
+
+/* the per-file entries of the old index */
+typedef struct old_list {
+    uint32_t *first;                // first[file] .. first[file + 1]
+    uint32_t *names;
+} old_list_t;
+
+typedef struct entry_list {
+    index_entry_t *entries;
+    size_t num;
+    size_t cap;
+} entry_list_t;
+
+/* nftw has no user pointer */
+static scan_file_t *s_files;
+static size_t s_file_num;
+static size_t s_file_cap;
+static char *s_index_name;
+static uint32_t s_mask;
+
+static int init_pool(str_pool_t *p) {
+    memset(p, 0, sizeof(str_pool_t));
+    return hashmap_init(&p->map, 0x10000);
+}
+
+static void finit_pool(str_pool_t *p) {
+    for (size_t i = 0; i < p->chunk_num; i++) {
+        free(p->chunks[i]);
+    }
+    free(p->chunks);
+    free(p->chunk_used);
+    hashmap_free(&p->map);
+    memset(p, 0, sizeof(str_pool_t));
+}
+
+/**
+ * @brief 将字符串加入字符串池，返回偏移
+ * add a string to the pool
+ * @return int64_t offset in the pool, -1 on error
+ */
+static int64_t pool_add(str_pool_t *p, const char *s) {
+    size_t len = strlen(s) + 1;
+    uint64_t hash = hash_bytes(s, len);
+    uint64_t value;
+    char *dst;
+
+    if (!hashmap_get(&p->map, hash, s, len, &value)) {
+        return value;
+    }
+    if (p->size + len > UINT32_MAX) {
+        return -1;
+    }
+
+    /* a new chunk if the string does not fit into the last one */
+    if (!p->chunk_num || p->chunk_used[p->chunk_num - 1] + len > INDEX_POOL_CHUNK) {
+        size_t chunk_size = len > INDEX_POOL_CHUNK ? len : INDEX_POOL_CHUNK;
+        char **chunks = realloc(p->chunks, (p->chunk_num + 1) * sizeof(char *));
+        size_t *used;
+        if (!chunks)
+            return -1;
+        p->chunks = chunks;
+        used = realloc(p->chunk_used, (p->chunk_num + 1) * sizeof(size_t));
+        if (!used)
+            return -1;
+        p->chunk_used = used;
+        p->chunks[p->chunk_num] = malloc(chunk_size);
+        if (!p->chunks[p->chunk_num])
+            return -1;
+        p->chunk_used[p->chunk_num] = 0;
+        p->chunk_num++;
+    }
+
+    dst = p->chunks[p->chunk_num - 1] + p->chunk_used[p->chunk_num - 1];
+    memcpy(dst, s, len);
+    if (hashmap_put(&p->map, hash, dst, len, p->size) == -1) {
+        return -1;
+    }
+    p->chunk_used[p->chunk_num - 1] += len;
+    p->size += len;
+    return p->size - len;
+}
+
+static int add_entry(entry_list_t *l, uint32_t name, const char *s, uint32_t file) {
+    if (l->num == l->cap) {
+        size_t cap = l->cap ? l->cap * 2 : 0x10000;
+        index_entry_t *tmp = realloc(l->entries, cap * sizeof(index_entry_t));
+        if (!tmp)
+            return -1;
+        l->entries = tmp;
+        l->cap = cap;
+    }
+    l->entries[l->num].hash = hash_bytes(s, strlen(s));
+    l->entries[l->num].name = name;
+    l->entries[l->num].file = file;
+    l->num++;
+    return 0;
+}
+
+static int collect_file(const char *path, const struct stat *st, int type, struct FTW *ftw) {
+    scan_file_t *f;
+
+    if (type != FTW_F || !S_ISREG(st->st_mode) || (s_index_name && !strcmp(path, s_index_name))) {
+        return 0;
+    }
+    if (s_file_num == s_file_cap) {
+        size_t cap = s_file_cap ? s_file_cap * 2 : 1024;
+        scan_file_t *tmp = realloc(s_files, cap * sizeof(scan_file_t));
+        if (!tmp)
+            return -1;
+        s_files = tmp;
+        s_file_cap = cap;
+    }
+    f = &s_files[s_file_num];
+    memset(f, 0, sizeof(scan_file_t));
+    f->path = strdup(path);
+    if (!f->path)
+        return -1;
+    f->dev = st->st_dev;
+    f->ino = st->st_ino;
+    f->size = st->st_size;
+    f->mtime_sec = st->st_mtim.tv_sec;
+    f->mtime_nsec = st->st_mtim.tv_nsec;
+    f->old = -1;
+    s_file_num++;
+    return 0;
+}
+
+static int compare_scan_file(const void *a, const void *b) {
+    return strcmp(((scan_file_t *)a)->path, ((scan_file_t *)b)->path);
+}
+
+static int add_name(scan_file_t *f, size_t *cap, const char *name) {
+    size_t len = strlen(name) + 1;
+    if (f->names_size + len > *cap) {
+        size_t new_cap = *cap ? *cap * 2 : 0x1000;
+        char *tmp;
+        while (new_cap < f->names_size + len)
+            new_cap *= 2;
+        tmp = realloc(f->names, new_cap);
+        if (!tmp)
+            return -1;
+        f->names = tmp;
+        *cap = new_cap;
+    }
+    memcpy(f->names + f->names_size, name, len);
+    f->names_size += len;
+    return 0;
+}
+
+/* NT_GNU_BUILD_ID in a PT_NOTE segment */
+static void get_build_id(scan_file_t *f, uint8_t *mem, size_t size, uint64_t offset, uint64_t filesz, uint64_t align) {
+    uint64_t pos = offset;
+    uint64_t end = offset + filesz;
+
+    align = align == 8 ? 8 : 4;
+    if (end > size || end < offset) {
+        return;
+    }
+    while (pos + sizeof(Elf64_Nhdr) <= end) {
+        /* Elf32_Nhdr and Elf64_Nhdr have the same layout */
+        Elf64_Nhdr *nhdr = (Elf64_Nhdr *)(mem + pos);
+        uint64_t name = pos + sizeof(Elf64_Nhdr);
+        uint64_t desc = name + ((nhdr->n_namesz + align - 1) & ~(align - 1));
+        if (desc + nhdr->n_descsz > end)
+            return;
+        if (nhdr->n_type == NT_GNU_BUILD_ID && nhdr->n_namesz == 4 && !memcmp(mem + name, "GNU", 4) &&
+            nhdr->n_descsz && !f->build_id) {
+            f->build_id = malloc(nhdr->n_descsz * 2 + 1);
+            if (!f->build_id)
+                return;
+            for (uint32_t i = 0; i < nhdr->n_descsz; i++)
+                sprintf(f->build_id + i * 2, "%02x", mem[desc + i]);
+            return;
+        }
+        pos = desc + ((nhdr->n_descsz + align - 1) & ~(align - 1));
+    }
+}
+
+/**
+ * @brief 解析一个文件的导出符号、导入符号和build id，不依赖全局的MODE
+ * parse the exports, imports and build id of a file, without the global MODE
+ */
+static void scan_elf(scan_file_t *f) {
+    size_t cap = 0;
+    struct stat st;
+    uint8_t *mem;
+    int fd;
+
+    f->flags = INDEX_NOT_ELF;
+    fd = open(f->path, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    if (fstat(fd, &st) < 0 || st.st_size < EI_NIDENT) {
+        close(fd);
+        return;
+    }
+    mem = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        return;
+    }
+    if (memcmp(mem, ELFMAG, SELFMAG)) {
+        goto EXIT;
+    }
+
+    if (mem[EI_CLASS] == ELFCLASS32 && st.st_size >= sizeof(Elf32_Ehdr)) {
+        Elf32_Ehdr *ehdr = (Elf32_Ehdr *)mem;
+        Elf32_Phdr *phdr = (Elf32_Phdr *)(mem + ehdr->e_phoff);
+        Elf32_Shdr *shdr = (Elf32_Shdr *)(mem + ehdr->e_shoff);
+        f->flags = 0;
+        if (ehdr->e_phoff + ehdr->e_phnum * sizeof(Elf32_Phdr) <= st.st_size) {
+            for (int i = 0; i < ehdr->e_phnum; i++) {
+                if (phdr[i].p_type == PT_NOTE)
+                    get_build_id(f, mem, st.st_size, phdr[i].p_offset, phdr[i].p_filesz, phdr[i].p_align);
+            }
+        }
+        if (ehdr->e_shoff + ehdr->e_shnum * sizeof(Elf32_Shdr) > st.st_size) {
+            goto EXIT;
+        }
+        /* exports first, then imports */
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i < ehdr->e_shnum; i++) {
+                Elf32_Sym *sym;
+                char *str;
+                size_t num, str_size;
+                if (shdr[i].sh_type != SHT_DYNSYM || shdr[i].sh_link >= ehdr->e_shnum)
+                    continue;
+                if (shdr[i].sh_offset + shdr[i].sh_size > st.st_size ||
+                    shdr[shdr[i].sh_link].sh_offset + shdr[shdr[i].sh_link].sh_size > st.st_size)
+                    continue;
+                sym = (Elf32_Sym *)(mem + shdr[i].sh_offset);
+                num = shdr[i].sh_size / sizeof(Elf32_Sym);
+                str = (char *)mem + shdr[shdr[i].sh_link].sh_offset;
+                str_size = shdr[shdr[i].sh_link].sh_size;
+                if (!str_size || str[str_size - 1])
+                    continue;
+                for (size_t j = 1; j < num; j++) {
+                    int bind = ELF32_ST_BIND(sym[j].st_info);
+                    int type = ELF32_ST_TYPE(sym[j].st_info);
+                    if (sym[j].st_name >= str_size || !str[sym[j].st_name] || bind == STB_LOCAL ||
+                        type == STT_SECTION || type == STT_FILE)
+                        continue;
+                    if ((sym[j].st_shndx != SHN_UNDEF) != !pass)
+                        continue;
+                    if (add_name(f, &cap, str + sym[j].st_name))
+                        goto EXIT;
+                    if (pass)
+                        f->import_num++;
+                    else
+                        f->export_num++;
+                }
+            }
+        }
+    }
+
+    if (mem[EI_CLASS] == ELFCLASS64 && st.st_size >= sizeof(Elf64_Ehdr)) {
+        Elf64_Ehdr *ehdr = (Elf64_Ehdr *)mem;
+        Elf64_Phdr *phdr = (Elf64_Phdr *)(mem + ehdr->e_phoff);
+        Elf64_Shdr *shdr = (Elf64_Shdr *)(mem + ehdr->e_shoff);
+        f->flags = 0;
+        if (ehdr->e_phoff + ehdr->e_phnum * sizeof(Elf64_Phdr) <= st.st_size) {
+            for (int i = 0; i < ehdr->e_phnum; i++) {
+                if (phdr[i].p_type == PT_NOTE)
+                    get_build_id(f, mem, st.st_size, phdr[i].p_offset, phdr[i].p_filesz, phdr[i].p_align);
+            }
+        }
+        if (ehdr->e_shoff + ehdr->e_shnum * sizeof(Elf64_Shdr) > st.st_size) {
+            goto EXIT;
+        }
+        /* exports first, then imports */
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i < ehdr->e_shnum; i++) {
+                Elf64_Sym *sym;
+                char *str;
+                size_t num, str_size;
+                if (shdr[i].sh_type != SHT_DYNSYM || shdr[i].sh_link >= ehdr->e_shnum)
+                    continue;
+                if (shdr[i].sh_offset + shdr[i].sh_size > st.st_size ||
+                    shdr[shdr[i].sh_link].sh_offset + shdr[shdr[i].sh_link].sh_size > st.st_size)
+                    continue;
+                sym = (Elf64_Sym *)(mem + shdr[i].sh_offset);
+                num = shdr[i].sh_size / sizeof(Elf64_Sym);
+                str = (char *)mem + shdr[shdr[i].sh_link].sh_offset;
+                str_size = shdr[shdr[i].sh_link].sh_size;
+                if (!str_size || str[str_size - 1])
+                    continue;
+                for (size_t j = 1; j < num; j++) {
+                    int bind = ELF64_ST_BIND(sym[j].st_info);
+                    int type = ELF64_ST_TYPE(sym[j].st_info);
+                    if (sym[j].st_name >= str_size || !str[sym[j].st_name] || bind == STB_LOCAL ||
+                        type == STT_SECTION || type == STT_FILE)
+                        continue;
+                    if ((sym[j].st_shndx != SHN_UNDEF) != !pass)
+                        continue;
+                    if (add_name(f, &cap, str + sym[j].st_name))
+                        goto EXIT;
+                    if (pass)
+                        f->import_num++;
+                    else
+                        f->export_num++;
+                }
+            }
+        }
+    }
+
+EXIT:
+    munmap(mem, st.st_size);
+}
+
+static void *scan_worker(void *arg) {
+    scan_job_t *job = (scan_job_t *)arg;
+    size_t i;
+
+    /* files differ in size, so each worker takes the next file */
+    while ((i = __atomic_fetch_add(job->next, 1, __ATOMIC_RELAXED)) < job->num) {
+        if (job->files[i].old == -1)
+            scan_elf(&job->files[i]);
+    }
+    return NULL;
+}
+
+static void scan_files(scan_file_t *files, size_t num) {
+    pthread_t threads[INDEX_MAX_THREADS];
+    scan_job_t job;
+    size_t next = 0;
+    int thread_num, created = 0;
+
+    thread_num = sysconf(_SC_NPROCESSORS_ONLN);
+    if (thread_num < 1)
+        thread_num = 1;
+    if (thread_num > INDEX_MAX_THREADS)
+        thread_num = INDEX_MAX_THREADS;
+
+    job.files = files;
+    job.num = num;
+    job.next = &next;
+    /* the main thread is a worker too */
+    for (int i = 1; i < thread_num; i++) {
+        if (pthread_create(&threads[i], NULL, scan_worker, &job))
+            break;
+        created = i;
+    }
+    scan_worker(&job);
+    for (int i = 1; i <= created; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+static char *get_index_str(index_map_t *m, uint64_t offset) {
+    return offset < m->header->str_size ? m->str + offset : "";
+}
+
+/**
+ * @brief 映射并检查索引文件
+ * map and check an index file
+ * @param index_name index file name
+ * @param m output, free it with finit_index
+ * @return int error code {-1:error,0:sucess}
+ */
+int init_index(char *index_name, index_map_t *m) {
+    index_header_t *h;
+    struct stat st;
+    int fd;
+
+    memset(m, 0, sizeof(index_map_t));
+    fd = open(index_name, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+    if (fstat(fd, &st) < 0 || st.st_size < sizeof(index_header_t)) {
+        ERROR("%s is not an elfspirit index\n", index_name);
+        close(fd);
+        return -1;
+    }
+    m->mem = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m->mem == MAP_FAILED) {
+        m->mem = NULL;
+        return -1;
+    }
+    m->size = st.st_size;
+
+    h = (index_header_t *)m->mem;
+    if (memcmp(h->magic, INDEX_MAGIC, sizeof(h->magic)) ||
+        !h->str_size || h->str_off + h->str_size > m->size ||
+        h->file_off + h->file_num * sizeof(index_file_t) > m->size) {
+        goto ERR_EXIT;
+    }
+    for (int i = 0; i < INDEX_TABLE_NUM; i++) {
+        index_table_t *t = &h->tables[i];
+        if (!t->bucket_num || (t->bucket_num & (t->bucket_num - 1)) ||
+            t->entry_off + t->entry_num * sizeof(index_entry_t) > m->size ||
+            t->bucket_off + (t->bucket_num + 1) * sizeof(uint32_t) > m->size) {
+            goto ERR_EXIT;
+        }
+    }
+    m->header = h;
+    m->str = (char *)m->mem + h->str_off;
+    m->files = (index_file_t *)(m->mem + h->file_off);
+    /* the pool ends with '\0', so every string in it is terminated */
+    if (m->str[h->str_size - 1]) {
+        goto ERR_EXIT;
+    }
+    return 0;
+
+ERR_EXIT:
+    ERROR("%s is not an elfspirit index\n", index_name);
+    finit_index(m);
+    return -1;
+}
+
+void finit_index(index_map_t *m) {
+    if (m->mem)
+        munmap(m->mem, m->size);
+    memset(m, 0, sizeof(index_map_t));
+}
+
+/* group the entries of an old table by file */
+static int init_old_list(index_map_t *m, int table, old_list_t *l) {
+    index_table_t *t = &m->header->tables[table];
+    index_entry_t *entries = (index_entry_t *)(m->mem + t->entry_off);
+    uint32_t *pos;
+
+    l->first = calloc(m->header->file_num + 1, sizeof(uint32_t));
+    l->names = malloc((t->entry_num + 1) * sizeof(uint32_t));
+    pos = calloc(m->header->file_num + 1, sizeof(uint32_t));
+    if (!l->first || !l->names || !pos) {
+        free(pos);
+        return -1;
+    }
+    for (uint64_t i = 0; i < t->entry_num; i++) {
+        if (entries[i].file < m->header->file_num)
+            l->first[entries[i].file + 1]++;
+    }
+    for (uint64_t i = 0; i < m->header->file_num; i++) {
+        l->first[i + 1] += l->first[i];
+        pos[i] = l->first[i];
+    }
+    for (uint64_t i = 0; i < t->entry_num; i++) {
+        if (entries[i].file < m->header->file_num)
+            l->names[pos[entries[i].file]++] = entries[i].name;
+    }
+    free(pos);
+    return 0;
+}
+
+static int compare_entry(const void *a, const void *b) {
+    const index_entry_t *x = (const index_entry_t *)a;
+    const index_entry_t *y = (const index_entry_t *)b;
+    /* names are interned, equal names have equal offsets */
+    if ((x->hash & s_mask) != (y->hash & s_mask))
+        return (x->hash & s_mask) < (y->hash & s_mask) ? -1 : 1;
+    if (x->name != y->name)
+        return x->name < y->name ? -1 : 1;
+    if (x->file != y->file)
+        return x->file < y->file ? -1 : 1;
+    return 0;
+}
+
+/**
+ * @brief 排序并去重，按照哈希值分桶
+ * sort and deduplicate the entries, and split them into hash buckets
+ */
+static uint32_t *sort_entries(entry_list_t *l, uint64_t *bucket_num) {
+    uint32_t *buckets;
+    size_t num = 0;
+
+    *bucket_num = 1;
+    while (*bucket_num < l->num / 4) {
+        *bucket_num <<= 1;
+    }
+    s_mask = *bucket_num - 1;
+    qsort(l->entries, l->num, sizeof(index_entry_t), compare_entry);
+    for (size_t i = 0; i < l->num; i++) {
+        if (num && !compare_entry(&l->entries[num - 1], &l->entries[i]))
+            continue;
+        l->entries[num++] = l->entries[i];
+    }
+    l->num = num;
+
+    buckets = calloc(*bucket_num + 1, sizeof(uint32_t));
+    if (!buckets) {
+        return NULL;
+    }
+    for (size_t i = 0; i < l->num; i++) {
+        buckets[(l->entries[i].hash & s_mask) + 1]++;
+    }
+    for (uint64_t i = 0; i < *bucket_num; i++) {
+        buckets[i + 1] += buckets[i];
+    }
+    return buckets;
+}
+
+static int write_all(int fd, const void *buf, size_t size, uint64_t *offset) {
+    const uint8_t *p = buf;
+    while (size) {
+        ssize_t n = write(fd, p, size);
+        if (n <= 0) {
+            perror("write");
+            return -1;
+        }
+        p += n;
+        size -= n;
+        *offset += n;
+    }
+    return 0;
+}
+
+static int write_align(int fd, uint64_t *offset) {
+    uint8_t zero[8] = {0};
+    return *offset % 8 ? write_all(fd, zero, 8 - *offset % 8, offset) : 0;
+}
+
+/**
+ * @brief 写入索引文件，先写临时文件，再重命名
+ * write the index to a temporary file, then rename it
+ */
+static int write_index(char *index_name, str_pool_t *pool, index_file_t *files, size_t file_num, entry_list_t *lists) {
+    char tmp_name[PATH_MAX];
+    index_header_t header;
+    uint64_t offset = 0;
+    int fd;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    if (snprintf(tmp_name, sizeof(tmp_name), "%s.tmp", index_name) >= sizeof(tmp_name)) {
+        ERROR("%s is too long\n", index_name);
+        return -1;
+    }
+    fd = open(tmp_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    if (write_all(fd, &header, sizeof(header), &offset)) {
+        goto ERR_EXIT;
+    }
+    header.str_off = offset;
+    header.str_size = pool->size;
+    for (size_t i = 0; i < pool->chunk_num; i++) {
+        if (write_all(fd, pool->chunks[i], pool->chunk_used[i], &offset))
+            goto ERR_EXIT;
+    }
+    if (write_align(fd, &offset)) {
+        goto ERR_EXIT;
+    }
+    header.file_off = offset;
+    header.file_num = file_num;
+    if (write_all(fd, files, file_num * sizeof(index_file_t), &offset)) {
+        goto ERR_EXIT;
+    }
+
+    for (int i = 0; i < INDEX_TABLE_NUM; i++) {
+        index_table_t *t = &header.tables[i];
+        uint32_t *buckets = sort_entries(&lists[i], &t->bucket_num);
+        if (!buckets)
+            goto ERR_EXIT;
+        t->entry_num = lists[i].num;
+        if (write_align(fd, &offset)) {
+            free(buckets);
+            goto ERR_EXIT;
+        }
+        t->entry_off = offset;
+        if (write_all(fd, lists[i].entries, lists[i].num * sizeof(index_entry_t), &offset)) {
+            free(buckets);
+            goto ERR_EXIT;
+        }
+        t->bucket_off = offset;
+        if (write_all(fd, buckets, (t->bucket_num + 1) * sizeof(uint32_t), &offset)) {
+            free(buckets);
+            goto ERR_EXIT;
+        }
+        free(buckets);
+    }
+
+    /* the header is written last, a torn file has no magic */
+    if (pwrite(fd, &header, sizeof(header), 0) != sizeof(header) || fsync(fd) < 0) {
+        perror("pwrite");
+        goto ERR_EXIT;
+    }
+    close(fd);
+    if (rename(tmp_name, index_name) < 0) {
+        perror("rename");
+        unlink(tmp_name);
+        return -1;
+    }
+    return 0;
+
+ERR_EXIT:
+    close(fd);
+    unlink(tmp_name);
+    return -1;
+}
+
+/**
+ * @brief 多线程扫描目录中的ELF，生成可映射的导出符号、导入符号和build id索引；
+ * 如果索引已存在，只重新解析inode、大小或mtime变化的文件
+ * scan the ELF files of a directory tree in parallel and write a memory-mappable
+ * index of exports, imports and build ids. if the index exists, only the files
+ * whose inode, size or mtime changed are parsed again
+ * @param dir directory, e.g. a sysroot
+ * @param index_name index file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int build_index(char *dir, char *index_name) {
+    index_map_t old;
+    old_list_t old_lists[2];
+    hashmap_t old_paths;
+    str_pool_t pool;
+    entry_list_t lists[INDEX_TABLE_NUM];
+    index_file_t *files = NULL;
+    size_t reused = 0;
+    int has_old = 0;
+    int ret = -1;
+
+    if (!index_name || !index_name[0]) {
+        ERROR("no index file, set it with -f\n");
+        return -1;
+    }
+
+    memset(old_lists, 0, sizeof(old_lists));
+    memset(lists, 0, sizeof(lists));
+    memset(&old_paths, 0, sizeof(old_paths));
+    if (init_pool(&pool) || pool_add(&pool, "") == -1) {
+        finit_pool(&pool);
+        return -1;
+    }
+
+    /* 1. collect the regular files, symbolic links are not followed */
+    s_files = NULL;
+    s_file_num = s_file_cap = 0;
+    s_index_name = index_name;
+    if (nftw(dir, collect_file, 64, FTW_PHYS) < 0) {
+        perror("nftw");
+        goto ERR_EXIT;
+    }
+    qsort(s_files, s_file_num, sizeof(scan_file_t), compare_scan_file);
+
+    /* 2. the unchanged files are taken from the old index */
+    has_old = !access(index_name, F_OK) && !init_index(index_name, &old);
+    if (has_old) {
+        if (init_old_list(&old, INDEX_EXPORT, &old_lists[0]) || init_old_list(&old, INDEX_IMPORT, &old_lists[1]) ||
+            hashmap_init(&old_paths, old.header->file_num)) {
+            goto ERR_EXIT;
+        }
+        for (uint64_t i = 0; i < old.header->file_num; i++) {
+            char *path = get_index_str(&old, old.files[i].path);
+            hashmap_put(&old_paths, hash_bytes(path, strlen(path)), path, strlen(path), i);
+        }
+        for (size_t i = 0; i < s_file_num; i++) {
+            scan_file_t *f = &s_files[i];
+            index_file_t *o;
+            uint64_t value;
+            if (hashmap_get(&old_paths, hash_bytes(f->path, strlen(f->path)), f->path, strlen(f->path), &value))
+                continue;
+            o = &old.files[value];
+            if (o->dev == f->dev && o->ino == f->ino && o->size == f->size &&
+                o->mtime_sec == f->mtime_sec && o->mtime_nsec == f->mtime_nsec) {
+                f->old = value;
+                f->flags = o->flags;
+                reused++;
+            }
+        }
+    }
+
+    /* 3. parse the new and changed files in parallel */
+    VERBOSE("scan %lu files, %lu unchanged\n", s_file_num, reused);
+    scan_files(s_files, s_file_num);
+
+    /* 4. intern the names and fill the tables in path order */
+    files = calloc(s_file_num + 1, sizeof(index_file_t));
+    if (!files) {
+        goto ERR_EXIT;
+    }
+    for (size_t i = 0; i < s_file_num; i++) {
+        scan_file_t *f = &s_files[i];
+        int64_t path = pool_add(&pool, f->path);
+        int64_t build_id = 0;
+        char *id = NULL;
+        if (path == -1)
+            goto ERR_EXIT;
+        files[i].path = path;
+        files[i].flags = f->flags;
+        files[i].dev = f->dev;
+        files[i].ino = f->ino;
+        files[i].size = f->size;
+        files[i].mtime_sec = f->mtime_sec;
+        files[i].mtime_nsec = f->mtime_nsec;
+
+        if (f->old != -1) {
+            id = get_index_str(&old, old.files[f->old].build_id);
+            if (*id && (build_id = pool_add(&pool, id)) == -1)
+                goto ERR_EXIT;
+            for (int t = 0; t < 2; t++) {
+                for (uint32_t j = old_lists[t].first[f->old]; j < old_lists[t].first[f->old + 1]; j++) {
+                    char *name = get_index_str(&old, old_lists[t].names[j]);
+                    int64_t off = pool_add(&pool, name);
+                    if (off == -1 || add_entry(&lists[t], off, name, i))
+                        goto ERR_EXIT;
+                }
+            }
+        } else {
+            char *name = f->names;
+            id = f->build_id;
+            if (id && (build_id = pool_add(&pool, id)) == -1)
+                goto ERR_EXIT;
+            for (uint32_t j = 0; j < f->export_num + f->import_num; j++) {
+                int64_t off = pool_add(&pool, name);
+                if (off == -1 || add_entry(&lists[j < f->export_num ? INDEX_EXPORT : INDEX_IMPORT], off, name, i))
+                    goto ERR_EXIT;
+                name += strlen(name) + 1;
+            }
+        }
+        files[i].build_id = build_id;
+        if (build_id && add_entry(&lists[INDEX_BUILD_ID], build_id, id, i))
+            goto ERR_EXIT;
+    }
+
+    /* 5. sort, hash and write */
+    if (write_index(index_name, &pool, files, s_file_num, lists)) {
+        goto ERR_EXIT;
+    }
+    INFO("%s: %lu files, %lu parsed, %lu exports, %lu imports, %lu build ids, %lu bytes of strings\n",
+        index_name, s_file_num, s_file_num - reused, lists[INDEX_EXPORT].num, lists[INDEX_IMPORT].num,
+        lists[INDEX_BUILD_ID].num, pool.size);
+    ret = 0;
+
+ERR_EXIT:
+    if (ret) {
+        ERROR("build index error\n");
+    }
+    if (has_old) {
+        for (int t = 0; t < 2; t++) {
+            free(old_lists[t].first);
+            free(old_lists[t].names);
+        }
+        hashmap_free(&old_paths);
+        finit_index(&old);
+    }
+    for (int t = 0; t < INDEX_TABLE_NUM; t++) {
+        free(lists[t].entries);
+    }
+    for (size_t i = 0; i < s_file_num; i++) {
+        free(s_files[i].path);
+        free(s_files[i].build_id);
+        free(s_files[i].names);
+    }
+    free(s_files);
+    s_files = NULL;
+    s_file_num = s_file_cap = 0;
+    free(files);
+    finit_pool(&pool);
+    return ret;
+}
+
+/**
+ * @brief 通过映射的索引查询，如"export=malloc"，"import=malloc"，"build-id=1a2b..."
+ * answer a query from the mapped index, e.g. "export=malloc", "import=malloc",
+ * "build-id=1a2b..."
+ * @param index_name index file name
+ * @param query query
+ * @return int error code {-1:error,0:sucess}
+ */
+int query_index(char *index_name, char *query) {
+    char *keys[INDEX_TABLE_NUM] = {"export", "import", "build-id"};
+    struct timespec begin, end;
+    index_map_t m;
+    index_table_t *t;
+    index_entry_t *entries;
+    uint32_t *buckets;
+    uint32_t hash, b;
+    uint64_t found = 0;
+    char value[PATH_MAX];
+    char *sep;
+    int table = -1;
+
+    sep = strchr(query, '=');
+    for (int i = 0; sep && i < INDEX_TABLE_NUM; i++) {
+        if (strlen(keys[i]) == sep - query && !strncmp(query, keys[i], sep - query))
+            table = i;
+    }
+    if (table == -1) {
+        ERROR("unknown query %s, expect export=NAME, import=NAME or build-id=HEX\n", query);
+        return -1;
+    }
+    snprintf(value, sizeof(value), "%s", sep + 1);
+    if (table == INDEX_BUILD_ID) {
+        for (char *p = value; *p; p++)
+            *p = tolower(*p);
+    }
+
+    if (init_index(index_name, &m)) {
+        return -1;
+    }
+
+    /* one bucket, then the adjacent entries with the same name */
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    t = &m.header->tables[table];
+    entries = (index_entry_t *)(m.mem + t->entry_off);
+    buckets = (uint32_t *)(m.mem + t->bucket_off);
+    hash = hash_bytes(value, strlen(value));
+    b = hash & (t->bucket_num - 1);
+    for (uint32_t i = buckets[b]; i < buckets[b + 1] && i < t->entry_num; i++) {
+        index_file_t *f;
+        struct stat st;
+        if (entries[i].hash != hash || strcmp(get_index_str(&m, entries[i].name), value) ||
+            entries[i].file >= m.header->file_num)
+            continue;
+        f = &m.files[entries[i].file];
+        /* the file changed after the index was built */
+        if (stat(get_index_str(&m, f->path), &st) < 0 || st.st_ino != f->ino || st.st_size != f->size ||
+            st.st_mtim.tv_sec != f->mtime_sec || st.st_mtim.tv_nsec != f->mtime_nsec) {
+            printf("%s (stale)\n", get_index_str(&m, f->path));
+        } else {
+            printf("%s\n", get_index_str(&m, f->path));
+        }
+        found++;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    INFO("%lu files, %.1f us\n", found,
+        (end.tv_sec - begin.tv_sec) * 1e6 + (end.tv_nsec - begin.tv_nsec) / 1e3);
+
+    finit_index(&m);
+    return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#define INDEX_MAGIC "ELFSIDX1"
+#define INDEX_MAX_THREADS 16
+#define INDEX_POOL_CHUNK 0x100000    // string pool chunk, strings never move
+
+enum INDEX_TABLE {
+    INDEX_EXPORT = 0,
+    INDEX_IMPORT,
+    INDEX_BUILD_ID,
+    INDEX_TABLE_NUM,
+};
+
+/* index file flags */
+#define INDEX_NOT_ELF   1           // scanned but skipped, kept for the incremental update
+
+/*
+ * layout of the index file, all offsets are file offsets:
+ * header, string pool, file table, then the entries and the buckets of each table.
+ * the entries of a table are sorted by bucket, so the entries of bucket b
+ * are [buckets[b], buckets[b + 1]), and equal names are adjacent.
+ */
+typedef struct index_table {
+    uint64_t entry_off;             // index_entry_t[entry_num]
+    uint64_t entry_num;
+    uint64_t bucket_off;            // uint32_t[bucket_num + 1]
+    uint64_t bucket_num;            // power of 2
+} index_table_t;
+
+typedef struct index_header {
+    char magic[8];
+    uint64_t str_off;               // string pool
+    uint64_t str_size;
+    uint64_t file_off;              // index_file_t[file_num], sorted by path
+    uint64_t file_num;
+    index_table_t tables[INDEX_TABLE_NUM];
+} index_header_t;
+
+typedef struct index_file {
+    uint32_t path;                  // offset in the string pool
+    uint32_t build_id;              // offset of the hex build id, 0 for none
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+} index_file_t;
+
+typedef struct index_entry {
+    uint32_t hash;                  // low 32 bits of hash_bytes(name)
+    uint32_t name;                  // offset in the string pool
+    uint32_t file;                  // index in the file table
+} index_entry_t;
+
+/* a mapped index file */
+typedef struct index_map {
+    uint8_t *mem;
+    size_t size;
+    index_header_t *header;
+    char *str;
+    index_file_t *files;
+} index_map_t;
+
+/**
+ * @brief 映射并检查索引文件
+ * map and check an index file
+ * @param index_name index file name
+ * @param m output, free it with finit_index
+ * @return int error code {-1:error,0:sucess}
+ */
+int init_index(char *index_name, index_map_t *m);
+void finit_index(index_map_t *m);
+
+/**
+ * @brief 多线程扫描目录中的ELF，生成可映射的导出符号、导入符号和build id索引；
+ * 如果索引已存在，只重新解析inode、大小或mtime变化的文件
+ * scan the ELF files of a directory tree in parallel and write a memory-mappable
+ * index of exports, imports and build ids. if the index exists, only the files
+ * whose inode, size or mtime changed are parsed again
+ * @param dir directory, e.g. a sysroot
+ * @param index_name index file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int build_index(char *dir, char *index_name);
+
+/**
+ * @brief 通过映射的索引查询，如"export=malloc"，"import=malloc"，"build-id=1a2b..."
+ * answer a query from the mapped index, e.g. "export=malloc", "import=malloc",
+ * "build-id=1a2b..."
+ * @param index_name index file name
+ * @param query query
+ * @return int error code {-1:error,0:sucess}
+ */
+int query_index(char *index_name, char *query);
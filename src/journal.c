@@ -0,0 +1,364 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <elf.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "common.h"
+#include "journal.h"
+
+int g_journal;
+
+/* journal of the current process */
+static char s_elf_name[PATH_MAX];
+static int s_fd = -1;
+static uint64_t s_orig_size;
+
+/* regions already recorded by this process */
+static journal_record_t *s_regions;
+static size_t s_region_num;
+static size_t s_region_cap;
+
+static void get_journal_name(char *elf_name, char *journal_name) {
+    snprintf(journal_name, PATH_MAX, "%s%s", elf_name, JOURNAL_SUFFIX);
+}
+
+/**
+ * @brief 打开日志文件，如果不存在，则创建并写入原始文件大小
+ * open the journal, create it with the original file size if it does not exist
+ */
+static int open_journal(char *elf_name) {
+    char journal_name[PATH_MAX];
+    journal_header_t header;
+    struct stat st;
+
+    if (s_fd >= 0 && !strcmp(s_elf_name, elf_name)) {
+        return 0;
+    }
+    if (s_fd >= 0) {
+        close(s_fd);
+        s_fd = -1;
+        s_region_num = 0;
+    }
+
+    get_journal_name(elf_name, journal_name);
+    s_fd = open(journal_name, O_RDWR | O_CREAT | O_APPEND, 0600);
+    if (s_fd < 0) {
+        perror("open journal");
+        return -1;
+    }
+
+    if (fstat(s_fd, &st) < 0) {
+        perror("fstat");
+        goto ERR_EXIT;
+    }
+
+    /* an existing journal continues the session */
+    if (st.st_size >= sizeof(header)) {
+        if (pread(s_fd, &header, sizeof(header), 0) != sizeof(header) ||
+            memcmp(header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC))) {
+            ERROR("%s is not an elfspirit journal\n", journal_name);
+            goto ERR_EXIT;
+        }
+        s_orig_size = header.orig_size;
+    } else {
+        if (stat(elf_name, &st) < 0) {
+            perror("stat");
+            goto ERR_EXIT;
+        }
+        ftruncate(s_fd, 0);
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        header.orig_size = st.st_size;
+        if (write(s_fd, &header, sizeof(header)) != sizeof(header) || fsync(s_fd) < 0) {
+            perror("write journal");
+            goto ERR_EXIT;
+        }
+        s_orig_size = header.orig_size;
+    }
+
+    strncpy(s_elf_name, elf_name, PATH_MAX - 1);
+    return 0;
+
+ERR_EXIT:
+    close(s_fd);
+    s_fd = -1;
+    return -1;
+}
+
+static int is_recorded(uint64_t offset, uint64_t size) {
+    for (size_t i = 0; i < s_region_num; i++) {
+        if (offset >= s_regions[i].offset && offset + size <= s_regions[i].offset + s_regions[i].size) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void add_recorded(uint64_t offset, uint64_t size) {
+    if (s_region_num == s_region_cap) {
+        size_t cap = s_region_cap ? s_region_cap * 2 : 64;
+        journal_record_t *tmp = realloc(s_regions, cap * sizeof(journal_record_t));
+        if (!tmp) {
+            return;
+        }
+        s_regions = tmp;
+        s_region_cap = cap;
+    }
+    s_regions[s_region_num].offset = offset;
+    s_regions[s_region_num].size = size;
+    s_region_num++;
+}
+
+/**
+ * @brief 修改文件之前，在日志中记录该区域的原始数据
+ * record the original bytes of a region in the journal before it is modified
+ * @param elf_name elf file name
+ * @param offset region offset
+ * @param size region size
+ * @return int error code {-1:error,0:sucess}
+ */
+int journal_region(char *elf_name, uint64_t offset, uint64_t size) {
+    journal_record_t record;
+    uint8_t *data;
+    int fd;
+
+    if (!g_journal || !size) {
+        return 0;
+    }
+    if (open_journal(elf_name)) {
+        return -1;
+    }
+
+    /* bytes beyond the original size are dropped by the rollback */
+    if (offset >= s_orig_size) {
+        return 0;
+    }
+    if (size > s_orig_size - offset) {
+        size = s_orig_size - offset;
+    }
+    if (is_recorded(offset, size)) {
+        return 0;
+    }
+
+    data = malloc(sizeof(record) + size);
+    if (!data) {
+        return -1;
+    }
+
+    fd = open(elf_name, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        free(data);
+        return -1;
+    }
+
+    /* the file may be shorter than the original one, keep zero */
+    memset(data, 0, sizeof(record) + size);
+    pread(fd, data + sizeof(record), size, offset);
+    close(fd);
+
+    /* one write per record, then sync before the caller modifies the region */
+    record.offset = offset;
+    record.size = size;
+    memcpy(data, &record, sizeof(record));
+    if (write(s_fd, data, sizeof(record) + size) != sizeof(record) + size || fdatasync(s_fd) < 0) {
+        perror("write journal");
+        free(data);
+        return -1;
+    }
+
+    add_recorded(offset, size);
+    free(data);
+    return 0;
+}
+
+/**
+ * @brief 记录ELF头、程序头表和节头表，用于会改变文件布局的操作
+ * record ELF header, program header table and section header table,
+ * used by the operations that change the file layout
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int journal_headers(char *elf_name) {
+    uint8_t ehdr[sizeof(Elf64_Ehdr)];
+    int fd;
+
+    if (!g_journal) {
+        return 0;
+    }
+
+    fd = open(elf_name, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+    memset(ehdr, 0, sizeof(ehdr));
+    pread(fd, ehdr, sizeof(ehdr), 0);
+    close(fd);
+
+    if (ehdr[EI_CLASS] == ELFCLASS32) {
+        Elf32_Ehdr *e = (Elf32_Ehdr *)ehdr;
+        if (journal_region(elf_name, 0, sizeof(Elf32_Ehdr)) ||
+            journal_region(elf_name, e->e_phoff, e->e_phnum * sizeof(Elf32_Phdr)) ||
+            journal_region(elf_name, e->e_shoff, e->e_shnum * sizeof(Elf32_Shdr))) {
+            return -1;
+        }
+    } else {
+        Elf64_Ehdr *e = (Elf64_Ehdr *)ehdr;
+        if (journal_region(elf_name, 0, sizeof(Elf64_Ehdr)) ||
+            journal_region(elf_name, e->e_phoff, e->e_phnum * sizeof(Elf64_Phdr)) ||
+            journal_region(elf_name, e->e_shoff, e->e_shnum * sizeof(Elf64_Shdr))) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 根据日志恢复文件，用于中断的修改
+ * restore the file from the journal, e.g. after an interrupted edit
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int rollback_journal(char *elf_name) {
+    char journal_name[PATH_MAX];
+    journal_header_t *header;
+    journal_record_t *record;
+    uint64_t *records = NULL;
+    size_t record_num = 0;
+    uint8_t *map;
+    struct stat st;
+    uint64_t pos;
+    int jfd, fd;
+    int err = -1;
+
+    get_journal_name(elf_name, journal_name);
+    jfd = open(journal_name, O_RDONLY);
+    if (jfd < 0) {
+        WARNING("%s has no journal\n", elf_name);
+        return -1;
+    }
+
+    if (fstat(jfd, &st) < 0 || st.st_size < sizeof(journal_header_t)) {
+        ERROR("%s is corrupted\n", journal_name);
+        close(jfd);
+        return -1;
+    }
+
+    map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, jfd, 0);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        close(jfd);
+        return -1;
+    }
+
+    header = (journal_header_t *)map;
+    if (memcmp(header->magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC))) {
+        ERROR("%s is not an elfspirit journal\n", journal_name);
+        goto ERR_EXIT;
+    }
+
+    /* index the complete records, a torn tail is ignored */
+    records = malloc((st.st_size / sizeof(journal_record_t) + 1) * sizeof(uint64_t));
+    if (!records) {
+        goto ERR_EXIT;
+    }
+    pos = sizeof(journal_header_t);
+    while (pos + sizeof(journal_record_t) <= st.st_size) {
+        record = (journal_record_t *)(map + pos);
+        if (record->size > st.st_size - pos - sizeof(journal_record_t)) {
+            break;
+        }
+        records[record_num++] = pos;
+        pos += sizeof(journal_record_t) + record->size;
+    }
+
+    fd = open(elf_name, O_RDWR);
+    if (fd < 0) {
+        perror("open");
+        goto ERR_EXIT;
+    }
+
+    /* newest first, the oldest copy of a region is written last */
+    while (record_num--) {
+        record = (journal_record_t *)(map + records[record_num]);
+        if (pwrite(fd, (uint8_t *)(record + 1), record->size, record->offset) != record->size) {
+            perror("pwrite");
+            close(fd);
+            goto ERR_EXIT;
+        }
+    }
+
+    if (ftruncate(fd, header->orig_size) < 0 || fsync(fd) < 0) {
+        perror("ftruncate");
+        close(fd);
+        goto ERR_EXIT;
+    }
+    close(fd);
+
+    unlink(journal_name);
+    INFO("rollback %s to 0x%lx bytes\n", elf_name, header->orig_size);
+    err = 0;
+
+ERR_EXIT:
+    free(records);
+    munmap(map, st.st_size);
+    close(jfd);
+    return err;
+}
+
+/**
+ * @brief 确认修改，删除日志
+ * accept the edits and remove the journal
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int commit_journal(char *elf_name) {
+    char journal_name[PATH_MAX];
+    int fd;
+
+    fd = open(elf_name, O_RDWR);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+    fsync(fd);
+    close(fd);
+
+    get_journal_name(elf_name, journal_name);
+    if (unlink(journal_name) < 0) {
+        WARNING("%s has no journal\n", elf_name);
+        return -1;
+    }
+    INFO("commit %s\n", elf_name);
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+/*
+ * elfspirit undo journal "<ELF>.journal":
+ *
+ *   +--------------------+
+ *   | journal_header_t   |  magic, original file size
+ *   +--------------------+
+ *   | journal_record_t   |  offset, size
+ *   | data[size]         |  original bytes
+ *   +--------------------+
+ *   | ...                |
+ *   +--------------------+
+ *
+ * Every record is synced before the region is modified. Rollback applies the
+ * records in reverse order, so the oldest copy of a region wins, and then
+ * truncates the file to the original size. A torn record at the end of the
+ * journal is ignored, because its region has not been modified yet.
+ */
+#define JOURNAL_MAGIC "ESJOURN"
+#define JOURNAL_SUFFIX ".journal"
+
+typedef struct journal_header {
+    char magic[8];
+    uint64_t orig_size;
+} journal_header_t;
+
+typedef struct journal_record {
+    uint64_t offset;
+    uint64_t size;
+} journal_record_t;
+
+/* --journal, record original bytes before in-place edits */
+extern int g_journal;
+
+/**
+ * @brief 修改文件之前，在日志中记录该区域的原始数据
+ * record the original bytes of a region in the journal before it is modified
+ * @param elf_name elf file name
+ * @param offset region offset
+ * @param size region size
+ * @return int error code {-1:error,0:sucess}
+ */
+int journal_region(char *elf_name, uint64_t offset, uint64_t size);
+
+/**
+ * @brief 记录ELF头、程序头表和节头表，用于会改变文件布局的操作
+ * record ELF header, program header table and section header table,
+ * used by the operations that change the file layout
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int journal_headers(char *elf_name);
+
+/**
+ * @brief 根据日志恢复文件，用于中断的修改
+ * restore the file from the journal, e.g. after an interrupted edit
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int rollback_journal(char *elf_name);
+
+/**
+ * @brief 确认修改，删除日志
+ * accept the edits and remove the journal
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int commit_journal(char *elf_name);
@@ -0,0 +1,979 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <elf.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "common.h"
+#include "journal.h"
+#include "segment.h"
+#include "layout.h"
+#include "relr.h"
+
+typedef struct seg_info {
+    uint32_t type;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t vaddr;
+    uint64_t filesz;
+    uint64_t memsz;
+    uint64_t align;
+} seg_info_t;
+
+typedef struct sec_info {
+    uint32_t type;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t addralign;
+} sec_info_t;
+
+/* class independent view of the headers */
+typedef struct elf_layout {
+    uint64_t file_size;
+    uint64_t entry;
+    uint64_t phoff;
+    uint64_t shoff;
+    int phnum;
+    int shnum;
+    size_t ehsize;
+    size_t phentsize;
+    size_t shentsize;
+    size_t word_size;       // 4 for ELF32, 8 for ELF64
+    seg_info_t *segs;
+    sec_info_t *secs;
+    load_index_t loads;
+    file_range_t *live;     // ranges referenced by a header or a dynamic entry
+    int live_num;
+    int live_cap;
+} elf_layout_t;
+
+/* dynamic entries pointing to tables, and the entry holding the table size */
+static const struct {
+    int64_t addr_tag;
+    int64_t size_tag;
+} dyn_tables[] = {
+    {DT_STRTAB, DT_STRSZ},
+    {DT_RELA, DT_RELASZ},
+    {DT_REL, DT_RELSZ},
+    {DT_RELR, DT_RELRSZ},
+    {DT_JMPREL, DT_PLTRELSZ},
+    {DT_INIT_ARRAY, DT_INIT_ARRAYSZ},
+    {DT_FINI_ARRAY, DT_FINI_ARRAYSZ},
+    {DT_PREINIT_ARRAY, DT_PREINIT_ARRAYSZ},
+    {DT_SYMTAB, DT_NULL},
+    {DT_HASH, DT_NULL},
+    {DT_GNU_HASH, DT_NULL},
+    {DT_VERSYM, DT_NULL},
+    {DT_VERNEED, DT_NULL},
+    {DT_VERDEF, DT_NULL},
+    {DT_PLTGOT, DT_NULL},
+    {DT_INIT, DT_NULL},
+    {DT_FINI, DT_NULL},
+};
+
+static int add_range(elf_layout_t *layout, uint64_t start, uint64_t end, uint64_t align) {
+    if (end <= start || start >= layout->file_size) {
+        return 0;
+    }
+    if (end > layout->file_size) {
+        end = layout->file_size;
+    }
+    if (layout->live_num == layout->live_cap) {
+        int cap = layout->live_cap ? layout->live_cap * 2 : 64;
+        file_range_t *tmp = realloc(layout->live, cap * sizeof(file_range_t));
+        if (!tmp) {
+            return -1;
+        }
+        layout->live = tmp;
+        layout->live_cap = cap;
+    }
+    layout->live[layout->live_num].start = start;
+    layout->live[layout->live_num].end = end;
+    layout->live[layout->live_num].align = align ? align : 1;
+    layout->live_num++;
+    return 0;
+}
+
+/**
+ * @brief 读取ELF头、程序头表和节头表，并收集被引用的文件区域
+ * read the ELF header, program headers and section headers, and collect the
+ * file ranges referenced by them and by the dynamic entries
+ * @param map elf file content
+ * @param size elf file size
+ * @param layout output
+ * @return int error code {-1:error,0:sucess}
+ */
+static int load_layout(uint8_t *map, uint64_t size, elf_layout_t *layout) {
+    uint64_t dyn_val[sizeof(dyn_tables) / sizeof(dyn_tables[0])][2];
+    uint64_t offset;
+
+    memset(layout, 0, sizeof(elf_layout_t));
+    memset(dyn_val, 0, sizeof(dyn_val));
+    layout->file_size = size;
+
+    if (MODE == ELFCLASS32) {
+        Elf32_Ehdr *ehdr = (Elf32_Ehdr *)map;
+        Elf32_Phdr *phdr = (Elf32_Phdr *)(map + ehdr->e_phoff);
+        Elf32_Shdr *shdr = (Elf32_Shdr *)(map + ehdr->e_shoff);
+        layout->entry = ehdr->e_entry;
+        layout->phoff = ehdr->e_phoff;
+        layout->shoff = ehdr->e_shoff;
+        layout->phnum = ehdr->e_phnum;
+        layout->shnum = ehdr->e_shoff ? ehdr->e_shnum : 0;
+        layout->ehsize = sizeof(Elf32_Ehdr);
+        layout->phentsize = sizeof(Elf32_Phdr);
+        layout->shentsize = sizeof(Elf32_Shdr);
+        layout->word_size = 4;
+        if (layout->phoff + layout->phnum * layout->phentsize > size ||
+            layout->shoff + layout->shnum * layout->shentsize > size) {
+            goto CORRUPT;
+        }
+
+        layout->segs = calloc(layout->phnum + 1, sizeof(seg_info_t));
+        layout->secs = calloc(layout->shnum + 1, sizeof(sec_info_t));
+        if (!layout->segs || !layout->secs) {
+            return -1;
+        }
+        for (int i = 0; i < layout->phnum; i++) {
+            layout->segs[i].type = phdr[i].p_type;
+            layout->segs[i].flags = phdr[i].p_flags;
+            layout->segs[i].offset = phdr[i].p_offset;
+            layout->segs[i].vaddr = phdr[i].p_vaddr;
+            layout->segs[i].filesz = phdr[i].p_filesz;
+            layout->segs[i].memsz = phdr[i].p_memsz;
+            layout->segs[i].align = phdr[i].p_align;
+            if (phdr[i].p_type == PT_DYNAMIC && phdr[i].p_offset + phdr[i].p_filesz <= size) {
+                Elf32_Dyn *dyn = (Elf32_Dyn *)(map + phdr[i].p_offset);
+                for (int j = 0; j < phdr[i].p_filesz / sizeof(Elf32_Dyn) && dyn[j].d_tag != DT_NULL; j++) {
+                    for (int k = 0; k < sizeof(dyn_tables) / sizeof(dyn_tables[0]); k++) {
+                        if (dyn[j].d_tag == dyn_tables[k].addr_tag)
+                            dyn_val[k][0] = dyn[j].d_un.d_val;
+                        if (dyn[j].d_tag == dyn_tables[k].size_tag)
+                            dyn_val[k][1] = dyn[j].d_un.d_val;
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < layout->shnum; i++) {
+            layout->secs[i].type = shdr[i].sh_type;
+            layout->secs[i].offset = shdr[i].sh_offset;
+            layout->secs[i].size = shdr[i].sh_size;
+            layout->secs[i].addralign = shdr[i].sh_addralign;
+        }
+    }
+
+    if (MODE == ELFCLASS64) {
+        Elf64_Ehdr *ehdr = (Elf64_Ehdr *)map;
+        Elf64_Phdr *phdr = (Elf64_Phdr *)(map + ehdr->e_phoff);
+        Elf64_Shdr *shdr = (Elf64_Shdr *)(map + ehdr->e_shoff);
+        layout->entry = ehdr->e_entry;
+        layout->phoff = ehdr->e_phoff;
+        layout->shoff = ehdr->e_shoff;
+        layout->phnum = ehdr->e_phnum;
+        layout->shnum = ehdr->e_shoff ? ehdr->e_shnum : 0;
+        layout->ehsize = sizeof(Elf64_Ehdr);
+        layout->phentsize = sizeof(Elf64_Phdr);
+        layout->shentsize = sizeof(Elf64_Shdr);
+        layout->word_size = 8;
+        if (layout->phoff + layout->phnum * layout->phentsize > size ||
+            layout->shoff + layout->shnum * layout->shentsize > size) {
+            goto CORRUPT;
+        }
+
+        layout->segs = calloc(layout->phnum + 1, sizeof(seg_info_t));
+        layout->secs = calloc(layout->shnum + 1, sizeof(sec_info_t));
+        if (!layout->segs || !layout->secs) {
+            return -1;
+        }
+        for (int i = 0; i < layout->phnum; i++) {
+            layout->segs[i].type = phdr[i].p_type;
+            layout->segs[i].flags = phdr[i].p_flags;
+            layout->segs[i].offset = phdr[i].p_offset;
+            layout->segs[i].vaddr = phdr[i].p_vaddr;
+            layout->segs[i].filesz = phdr[i].p_filesz;
+            layout->segs[i].memsz = phdr[i].p_memsz;
+            layout->segs[i].align = phdr[i].p_align;
+            if (phdr[i].p_type == PT_DYNAMIC && phdr[i].p_offset + phdr[i].p_filesz <= size) {
+                Elf64_Dyn *dyn = (Elf64_Dyn *)(map + phdr[i].p_offset);
+                for (int j = 0; j < phdr[i].p_filesz / sizeof(Elf64_Dyn) && dyn[j].d_tag != DT_NULL; j++) {
+                    for (int k = 0; k < sizeof(dyn_tables) / sizeof(dyn_tables[0]); k++) {
+                        if (dyn[j].d_tag == dyn_tables[k].addr_tag)
+                            dyn_val[k][0] = dyn[j].d_un.d_val;
+                        if (dyn[j].d_tag == dyn_tables[k].size_tag)
+                            dyn_val[k][1] = dyn[j].d_un.d_val;
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < layout->shnum; i++) {
+            layout->secs[i].type = shdr[i].sh_type;
+            layout->secs[i].offset = shdr[i].sh_offset;
+            layout->secs[i].size = shdr[i].sh_size;
+            layout->secs[i].addralign = shdr[i].sh_addralign;
+        }
+    }
+
+    if (init_load_index(map, size, &layout->loads)) {
+        return -1;
+    }
+
+    /* headers */
+    if (add_range(layout, 0, layout->ehsize, layout->word_size) ||
+        add_range(layout, layout->phoff, layout->phoff + layout->phnum * layout->phentsize, layout->word_size) ||
+        add_range(layout, layout->shoff, layout->shoff + layout->shnum * layout->shentsize, layout->word_size)) {
+        return -1;
+    }
+
+    /* sections and the segments which are not PT_LOAD */
+    for (int i = 1; i < layout->shnum; i++) {
+        sec_info_t *sec = &layout->secs[i];
+        if (sec->type != SHT_NOBITS && add_range(layout, sec->offset, sec->offset + sec->size, sec->addralign))
+            return -1;
+    }
+    for (int i = 0; i < layout->phnum; i++) {
+        seg_info_t *seg = &layout->segs[i];
+        if (seg->type != PT_LOAD && add_range(layout, seg->offset, seg->offset + seg->filesz, layout->word_size))
+            return -1;
+    }
+
+    /* tables of dynamic entries, a table with unknown size marks its first byte */
+    for (int k = 0; k < sizeof(dyn_tables) / sizeof(dyn_tables[0]); k++) {
+        if (dyn_val[k][0] && !load_addr_to_offset(&layout->loads, dyn_val[k][0], 1, &offset)) {
+            if (add_range(layout, offset, offset + (dyn_val[k][1] ? dyn_val[k][1] : 1), 1))
+                return -1;
+        }
+    }
+
+    /* entry point */
+    if (layout->entry && !load_addr_to_offset(&layout->loads, layout->entry, 1, &offset)) {
+        if (add_range(layout, offset, offset + 1, 1))
+            return -1;
+    }
+    return 0;
+
+CORRUPT:
+    ERROR("Corrupt file format\n");
+    return -1;
+}
+
+static void free_layout(elf_layout_t *layout) {
+    free(layout->segs);
+    free(layout->secs);
+    free(layout->live);
+    finit_load_index(&layout->loads);
+}
+
+/**
+ * @brief 判断LOAD段是否还在使用，只有没有被任何头或dynamic条目引用的只读LOAD段才会被删除
+ * whether a PT_LOAD segment is still used. only a read-only PT_LOAD which is not
+ * referenced by any header or dynamic entry is dead, such as the old copy of a
+ * table left by expand_segment
+ * @param layout elf layout
+ * @param i segment index
+ * @return {0:dead, 1:live}
+ */
+static int is_load_live(elf_layout_t *layout, int i) {
+    seg_info_t *seg = &layout->segs[i];
+    uint64_t start = seg->offset;
+    uint64_t end = seg->offset + seg->filesz;
+
+    /* without section headers nothing tells us what a segment holds */
+    if (seg->type != PT_LOAD || seg->flags != PF_R || !seg->filesz || !start || !layout->shnum) {
+        return 1;
+    }
+    for (int j = 0; j < layout->live_num; j++) {
+        if (layout->live[j].start < end && layout->live[j].end > start) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int compare_range(const void *a, const void *b) {
+    const file_range_t *x = a, *y = b;
+    if (x->start != y->start)
+        return x->start < y->start ? -1 : 1;
+    return 0;
+}
+
+/**
+ * @brief 合并重叠或相邻的区域，合并后的对齐取最大值
+ * merge the overlapping or adjacent ranges in place, a merged range takes the
+ * largest alignment of its members
+ * @param ranges file ranges
+ * @param num number of ranges
+ * @return int number of merged ranges
+ */
+static int merge_ranges(file_range_t *ranges, int num) {
+    int n = 0;
+
+    qsort(ranges, num, sizeof(file_range_t), compare_range);
+    for (int i = 0; i < num; i++) {
+        if (n && ranges[i].start <= ranges[n - 1].end) {
+            if (ranges[i].end > ranges[n - 1].end)
+                ranges[n - 1].end = ranges[i].end;
+            if (ranges[i].align > ranges[n - 1].align)
+                ranges[n - 1].align = ranges[i].align;
+        } else {
+            ranges[n++] = ranges[i];
+        }
+    }
+    return n;
+}
+
+/* a cluster of overlapping ranges is moved as a whole */
+typedef struct cluster {
+    uint64_t start;
+    uint64_t end;
+    uint64_t align;
+    uint64_t delta;         // new offset = old offset - delta
+} cluster_t;
+
+static uint64_t map_offset(cluster_t *clusters, int num, uint64_t offset) {
+    uint64_t delta = 0;
+    for (int i = 0; i < num && clusters[i].start <= offset; i++) {
+        delta = clusters[i].delta;
+    }
+    return offset - delta;
+}
+
+/**
+ * @brief 压缩文件，删除无用的区域，保持地址和偏移的同余关系。没有被引用的只读LOAD段默认只报告
+ * compact the file: drop the regions which are no longer referenced, keeping the
+ * congruence between virtual address and file offset. the unreferenced read-only
+ * PT_LOAD segments are only reported unless drop_loads is set, since a segment
+ * added by --add-segment is not referenced either
+ * @param elf_name elf file name
+ * @param drop_loads remove the unreferenced read-only PT_LOAD segments
+ * @return int error code {-1:error,0:sucess}
+ */
+int compact_elf(char *elf_name, int drop_loads) {
+    int fd;
+    struct stat st;
+    uint8_t *map;
+    uint8_t *new_map = NULL;
+    uint64_t new_size, cursor;
+    elf_layout_t layout;
+    file_range_t *keep = NULL;
+    cluster_t *clusters = NULL;
+    int keep_num = 0, cluster_num = 0;
+    int *live_load = NULL;
+    int dead_num = 0;
+    int orphan_num = 0;
+    int new_phnum;
+    int shrink_phdr = 0;
+    int err = -1;
+
+    fd = open(elf_name, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+
+    map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        close(fd);
+        return -1;
+    }
+    close(fd);
+
+    if (load_layout(map, st.st_size, &layout)) {
+        goto ERR_EXIT;
+    }
+
+    /* 1. live segments */
+    live_load = calloc(layout.phnum + 1, sizeof(int));
+    keep = malloc((layout.live_num + layout.phnum + 1) * sizeof(file_range_t));
+    if (!live_load || !keep) {
+        goto ERR_EXIT;
+    }
+    for (int i = 0; i < layout.phnum; i++) {
+        seg_info_t *seg = &layout.segs[i];
+        live_load[i] = is_load_live(&layout, i);
+        if (!live_load[i] && !drop_loads) {
+            WARNING("PT_LOAD [%d] offset: 0x%lx, size: 0x%lx is not referenced\n", i, seg->offset, seg->filesz);
+            live_load[i] = 1;
+            orphan_num++;
+        }
+        if (!live_load[i]) {
+            VERBOSE("drop PT_LOAD [%d] offset: 0x%lx, size: 0x%lx\n", i, seg->offset, seg->filesz);
+            dead_num++;
+        } else if (seg->type == PT_LOAD && seg->filesz && seg->offset < st.st_size) {
+            // vaddr % align == offset % align
+            keep[keep_num].start = seg->offset;
+            keep[keep_num].end = seg->offset + seg->filesz > st.st_size ? st.st_size : seg->offset + seg->filesz;
+            keep[keep_num].align = seg->align > PAGE_SIZE ? seg->align : PAGE_SIZE;
+            keep_num++;
+        }
+    }
+    memcpy(&keep[keep_num], layout.live, layout.live_num * sizeof(file_range_t));
+    keep_num += layout.live_num;
+    if (orphan_num) {
+        INFO("keep %d unreferenced PT_LOAD, use --drop-loads to remove them\n", orphan_num);
+    }
+
+    /* 2. interval sweep: merge the overlapping ranges */
+    keep_num = merge_ranges(keep, keep_num);
+    clusters = malloc((keep_num + 1) * sizeof(cluster_t));
+    if (!clusters) {
+        goto ERR_EXIT;
+    }
+    for (int i = 0; i < keep_num; i++) {
+        clusters[cluster_num].start = keep[i].start;
+        clusters[cluster_num].end = keep[i].end;
+        clusters[cluster_num].align = keep[i].align;
+        cluster_num++;
+    }
+
+    /* the program header table at the end of a cluster loses the dead entries */
+    for (int i = 0; i < cluster_num && dead_num; i++) {
+        if (clusters[i].end == layout.phoff + layout.phnum * layout.phentsize) {
+            clusters[i].end -= dead_num * layout.phentsize;
+            shrink_phdr = 1;
+            break;
+        }
+    }
+
+    /* 3. move each cluster down to the lowest offset congruent to the old one */
+    cursor = 0;
+    for (int i = 0; i < cluster_num; i++) {
+        cluster_t *c = &clusters[i];
+        uint64_t new_start = cursor + (c->start - cursor) % c->align;
+        c->delta = c->start - new_start;
+        cursor = new_start + c->end - c->start;
+    }
+    new_size = cursor;
+
+    if (new_size == st.st_size && !dead_num) {
+        INFO("%s is already compact\n", elf_name);
+        err = 0;
+        goto ERR_EXIT;
+    }
+
+    new_map = calloc(1, new_size);
+    if (!new_map) {
+        goto ERR_EXIT;
+    }
+    for (int i = 0; i < cluster_num; i++) {
+        memcpy(new_map + clusters[i].start - clusters[i].delta, map + clusters[i].start, clusters[i].end - clusters[i].start);
+    }
+
+    /* 4. update the offsets, and remove the dead segments */
+    new_phnum = layout.phnum - dead_num;
+    if (MODE == ELFCLASS32) {
+        Elf32_Ehdr *ehdr = (Elf32_Ehdr *)new_map;
+        Elf32_Phdr *old_phdr = (Elf32_Phdr *)(map + layout.phoff);
+        Elf32_Phdr *phdr;
+        Elf32_Shdr *shdr;
+        ehdr->e_phoff = map_offset(clusters, cluster_num, layout.phoff);
+        ehdr->e_phnum = new_phnum;
+        if (layout.shnum)
+            ehdr->e_shoff = map_offset(clusters, cluster_num, layout.shoff);
+        phdr = (Elf32_Phdr *)(new_map + ehdr->e_phoff);
+        shdr = (Elf32_Shdr *)(new_map + ehdr->e_shoff);
+
+        for (int i = 0, j = 0; i < layout.phnum; i++) {
+            if (!live_load[i])
+                continue;
+            phdr[j] = old_phdr[i];
+            phdr[j].p_offset = map_offset(clusters, cluster_num, old_phdr[i].p_offset);
+            /* the program header table and the PT_LOAD which maps it */
+            if (old_phdr[i].p_type == PT_PHDR || (old_phdr[i].p_type == PT_LOAD &&
+                old_phdr[i].p_offset == layout.phoff && old_phdr[i].p_filesz == layout.phnum * sizeof(Elf32_Phdr))) {
+                phdr[j].p_filesz = new_phnum * sizeof(Elf32_Phdr);
+                phdr[j].p_memsz = phdr[j].p_filesz;
+            }
+            j++;
+        }
+        if (!shrink_phdr)
+            memset(&phdr[new_phnum], 0, dead_num * sizeof(Elf32_Phdr));
+        for (int i = 0; i < layout.shnum; i++) {
+            shdr[i].sh_offset = map_offset(clusters, cluster_num, shdr[i].sh_offset);
+        }
+    }
+
+    if (MODE == ELFCLASS64) {
+        Elf64_Ehdr *ehdr = (Elf64_Ehdr *)new_map;
+        Elf64_Phdr *old_phdr = (Elf64_Phdr *)(map + layout.phoff);
+        Elf64_Phdr *phdr;
+        Elf64_Shdr *shdr;
+        ehdr->e_phoff = map_offset(clusters, cluster_num, layout.phoff);
+        ehdr->e_phnum = new_phnum;
+        if (layout.shnum)
+            ehdr->e_shoff = map_offset(clusters, cluster_num, layout.shoff);
+        phdr = (Elf64_Phdr *)(new_map + ehdr->e_phoff);
+        shdr = (Elf64_Shdr *)(new_map + ehdr->e_shoff);
+
+        for (int i = 0, j = 0; i < layout.phnum; i++) {
+            if (!live_load[i])
+                continue;
+            phdr[j] = old_phdr[i];
+            phdr[j].p_offset = map_offset(clusters, cluster_num, old_phdr[i].p_offset);
+            /* the program header table and the PT_LOAD which maps it */
+            if (old_phdr[i].p_type == PT_PHDR || (old_phdr[i].p_type == PT_LOAD &&
+                old_phdr[i].p_offset == layout.phoff && old_phdr[i].p_filesz == layout.phnum * sizeof(Elf64_Phdr))) {
+                phdr[j].p_filesz = new_phnum * sizeof(Elf64_Phdr);
+                phdr[j].p_memsz = phdr[j].p_filesz;
+            }
+            j++;
+        }
+        if (!shrink_phdr)
+            memset(&phdr[new_phnum], 0, dead_num * sizeof(Elf64_Phdr));
+        for (int i = 0; i < layout.shnum; i++) {
+            shdr[i].sh_offset = map_offset(clusters, cluster_num, shdr[i].sh_offset);
+        }
+    }
+
+    /* 5. rewrite the file */
+    if (journal_region(elf_name, 0, st.st_size)) {
+        goto ERR_EXIT;
+    }
+    if (create_file(elf_name, (char *)new_map, new_size, 0)) {
+        goto ERR_EXIT;
+    }
+    INFO("compact %s: 0x%lx -> 0x%lx bytes, %d PT_LOAD dropped\n", elf_name, st.st_size, new_size, dead_num);
+    err = 0;
+
+ERR_EXIT:
+    free(new_map);
+    free(clusters);
+    free(keep);
+    free(live_load);
+    free_layout(&layout);
+    munmap(map, st.st_size);
+    return err;
+}
+
+/**
+ * @brief 对齐可执行LOAD段，使其文件偏移和虚拟地址模大页大小同余，并设置p_align，之后的内容整体后移
+ * align the executable PT_LOAD segments for huge pages: move them in the file so
+ * that offset and virtual address are congruent modulo the huge page size, and
+ * raise p_align. the following contents are moved by whole pages
+ * @param elf_name elf file name
+ * @param align huge page size, 0 for HUGE_PAGE_SIZE
+ * @return int error code {-1:error,0:sucess}
+ */
+int align_hugepage(char *elf_name, uint64_t align) {
+    int fd;
+    struct stat st;
+    uint8_t *map;
+    uint8_t *new_map = NULL;
+    uint64_t new_size, shift, piece_end;
+    elf_layout_t layout;
+    file_range_t *keep = NULL;
+    cluster_t *clusters = NULL;
+    int keep_num = 0, cluster_num = 0;
+    int *aligned = NULL;
+    int exec_num = 0, aligned_num = 0, raise_num = 0, huge_num = 0;
+    int err = -1;
+
+    if (!align) {
+        align = HUGE_PAGE_SIZE;
+    }
+    if (align < PAGE_SIZE || (align & (align - 1))) {
+        ERROR("alignment 0x%lx is not a power of two of at least one page\n", align);
+        return -1;
+    }
+
+    fd = open(elf_name, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+
+    map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        close(fd);
+        return -1;
+    }
+    close(fd);
+
+    if (load_layout(map, st.st_size, &layout)) {
+        goto ERR_EXIT;
+    }
+
+    /* 1. the segments and the referenced ranges are not split */
+    aligned = calloc(layout.phnum + 1, sizeof(int));
+    keep = malloc((layout.live_num + layout.phnum + 1) * sizeof(file_range_t));
+    if (!aligned || !keep) {
+        goto ERR_EXIT;
+    }
+    for (int i = 0; i < layout.phnum; i++) {
+        seg_info_t *seg = &layout.segs[i];
+        if (seg->type != PT_LOAD || !seg->filesz || seg->offset >= st.st_size)
+            continue;
+        keep[keep_num].start = seg->offset;
+        keep[keep_num].end = seg->offset + seg->filesz > st.st_size ? st.st_size : seg->offset + seg->filesz;
+        keep[keep_num].align = seg->align > PAGE_SIZE ? seg->align : PAGE_SIZE;
+        keep_num++;
+        if (seg->flags & PF_X)
+            exec_num++;
+    }
+    if (!exec_num) {
+        WARNING("%s has no executable PT_LOAD\n", elf_name);
+        goto ERR_EXIT;
+    }
+    memcpy(&keep[keep_num], layout.live, layout.live_num * sizeof(file_range_t));
+    keep_num += layout.live_num;
+
+    keep_num = merge_ranges(keep, keep_num);
+    clusters = malloc((keep_num + 1) * sizeof(cluster_t));
+    if (!clusters) {
+        goto ERR_EXIT;
+    }
+    for (int i = 0; i < keep_num; i++) {
+        clusters[cluster_num].start = keep[i].start;
+        clusters[cluster_num].end = keep[i].end;
+        clusters[cluster_num].align = keep[i].align;
+        cluster_num++;
+    }
+
+    /* 2. move each cluster up, never down, by whole pages */
+    shift = 0;
+    for (int i = 0; i < cluster_num; i++) {
+        cluster_t *c = &clusters[i];
+        int fixed = 0;
+        uint64_t need = 0;
+
+        /* an executable segment needs offset + shift == vaddr (mod align) */
+        for (int j = 0; j < layout.phnum; j++) {
+            seg_info_t *seg = &layout.segs[j];
+            uint64_t residue;
+            if (seg->type != PT_LOAD || !(seg->flags & PF_X) || !seg->filesz ||
+                seg->offset < c->start || seg->offset >= c->end)
+                continue;
+            residue = (seg->vaddr - seg->offset) & (align - 1);
+            if (!fixed) {
+                need = shift + ((residue - shift) & (align - 1));
+                fixed = 1;
+            }
+            /* the ELF header can not move, and a cluster moves as a whole */
+            if ((i == 0 && need) || ((seg->offset + need - seg->vaddr) & (align - 1))) {
+                WARNING("PT_LOAD [%d] at offset 0x%lx can not be aligned to 0x%lx\n", j, seg->offset, align);
+                continue;
+            }
+            aligned[j] = 1;
+            aligned_num++;
+        }
+        if (fixed && !(i == 0 && need))
+            shift = need;
+        else
+            shift = ALIGN(shift, c->align);
+        c->delta = -shift;
+    }
+    if (!aligned_num) {
+        goto ERR_EXIT;
+    }
+    for (int i = 0; i < layout.phnum; i++) {
+        if (aligned[i] && layout.segs[i].align < align)
+            raise_num++;
+    }
+    if (!shift && !raise_num) {
+        INFO("%s is already aligned to 0x%lx\n", elf_name, align);
+        err = 0;
+        goto ERR_EXIT;
+    }
+    new_size = st.st_size + shift;
+
+    /* 3. copy the file piece by piece, a piece runs to the next cluster */
+    new_map = calloc(1, new_size);
+    if (!new_map) {
+        goto ERR_EXIT;
+    }
+    memcpy(new_map, map, clusters[0].start);
+    for (int i = 0; i < cluster_num; i++) {
+        piece_end = i + 1 < cluster_num ? clusters[i + 1].start : st.st_size;
+        memcpy(new_map + clusters[i].start - clusters[i].delta, map + clusters[i].start, piece_end - clusters[i].start);
+    }
+
+    /* 4. update the offsets and the alignment */
+    if (MODE == ELFCLASS32) {
+        Elf32_Ehdr *ehdr = (Elf32_Ehdr *)new_map;
+        Elf32_Phdr *phdr;
+        Elf32_Shdr *shdr;
+        ehdr->e_phoff = map_offset(clusters, cluster_num, layout.phoff);
+        if (layout.shnum)
+            ehdr->e_shoff = map_offset(clusters, cluster_num, layout.shoff);
+        phdr = (Elf32_Phdr *)(new_map + ehdr->e_phoff);
+        shdr = (Elf32_Shdr *)(new_map + ehdr->e_shoff);
+        for (int i = 0; i < layout.phnum; i++) {
+            phdr[i].p_offset = map_offset(clusters, cluster_num, phdr[i].p_offset);
+            if (aligned[i] && phdr[i].p_align < align)
+                phdr[i].p_align = align;
+        }
+        for (int i = 0; i < layout.shnum; i++) {
+            shdr[i].sh_offset = map_offset(clusters, cluster_num, shdr[i].sh_offset);
+        }
+    }
+
+    if (MODE == ELFCLASS64) {
+        Elf64_Ehdr *ehdr = (Elf64_Ehdr *)new_map;
+        Elf64_Phdr *phdr;
+        Elf64_Shdr *shdr;
+        ehdr->e_phoff = map_offset(clusters, cluster_num, layout.phoff);
+        if (layout.shnum)
+            ehdr->e_shoff = map_offset(clusters, cluster_num, layout.shoff);
+        phdr = (Elf64_Phdr *)(new_map + ehdr->e_phoff);
+        shdr = (Elf64_Shdr *)(new_map + ehdr->e_shoff);
+        for (int i = 0; i < layout.phnum; i++) {
+            phdr[i].p_offset = map_offset(clusters, cluster_num, phdr[i].p_offset);
+            if (aligned[i] && phdr[i].p_align < align)
+                phdr[i].p_align = align;
+        }
+        for (int i = 0; i < layout.shnum; i++) {
+            shdr[i].sh_offset = map_offset(clusters, cluster_num, shdr[i].sh_offset);
+        }
+    }
+
+    /* huge pages fully covered by the aligned segments */
+    for (int i = 0; i < layout.phnum; i++) {
+        seg_info_t *seg = &layout.segs[i];
+        if (aligned[i] && ALIGN(seg->vaddr, align) + align <= seg->vaddr + seg->filesz)
+            huge_num += (seg->vaddr + seg->filesz - ALIGN(seg->vaddr, align)) / align;
+    }
+
+    /* 5. rewrite the file */
+    if (journal_region(elf_name, 0, st.st_size)) {
+        goto ERR_EXIT;
+    }
+    if (create_file(elf_name, (char *)new_map, new_size, 0)) {
+        goto ERR_EXIT;
+    }
+    INFO("align %d executable PT_LOAD to 0x%lx: 0x%lx -> 0x%lx bytes, %d huge pages\n", aligned_num, align, st.st_size, new_size, huge_num);
+    if (!huge_num)
+        WARNING("no executable PT_LOAD covers an aligned huge page\n");
+    err = 0;
+
+ERR_EXIT:
+    free(new_map);
+    free(clusters);
+    free(keep);
+    free(aligned);
+    free_layout(&layout);
+    munmap(map, st.st_size);
+    return err;
+}
+
+/* load cost of a file */
+typedef struct layout_stat {
+    uint64_t file_size;
+    int load_num;
+    uint64_t mapped_pages;  // pages mapped by PT_LOAD segments
+    uint64_t file_pages;    // pages backed by the file
+    uint64_t span_pages;    // pages between the lowest and the highest PT_LOAD address
+    uint64_t padding;       // bytes between the ranges, kept by the alignment
+    uint64_t orphan;        // bytes not covered by any header, section or segment, and not padding
+    uint64_t dead;          // bytes of the PT_LOAD segments dropped by --compact
+    int rwx_num;
+    uint64_t rwx_size;
+} layout_stat_t;
+
+/**
+ * @brief 统计文件的加载开销
+ * collect the load cost of a file
+ * @param elf_name elf file name
+ * @param stat output
+ * @return int error code {-1:error,0:sucess}
+ */
+static int get_layout_stat(char *elf_name, layout_stat_t *stat) {
+    int fd;
+    struct stat st;
+    uint8_t *map;
+    elf_layout_t layout;
+    file_range_t *ranges = NULL;
+    int range_num;
+    uint64_t start, end;
+    int err = -1;
+
+    fd = open(elf_name, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+
+    map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        close(fd);
+        return -1;
+    }
+    close(fd);
+
+    memset(stat, 0, sizeof(layout_stat_t));
+    stat->file_size = st.st_size;
+    if (load_layout(map, st.st_size, &layout)) {
+        goto ERR_EXIT;
+    }
+
+    ranges = malloc((layout.live_num + layout.phnum + 1) * sizeof(file_range_t));
+    if (!ranges) {
+        goto ERR_EXIT;
+    }
+    memcpy(ranges, layout.live, layout.live_num * sizeof(file_range_t));
+    range_num = layout.live_num;
+
+    for (int i = 0; i < layout.phnum; i++) {
+        seg_info_t *seg = &layout.segs[i];
+        uint64_t page_start = seg->vaddr & ~(uint64_t)(PAGE_SIZE - 1);
+        if (seg->type != PT_LOAD) {
+            continue;
+        }
+
+        stat->load_num++;
+        stat->mapped_pages += (ALIGN(seg->vaddr + seg->memsz, PAGE_SIZE) - page_start) / PAGE_SIZE;
+        if (seg->filesz) {
+            stat->file_pages += (ALIGN(seg->vaddr + seg->filesz, PAGE_SIZE) - page_start) / PAGE_SIZE;
+        }
+        if ((seg->flags & PF_W) && (seg->flags & PF_X)) {
+            WARNING("RWX PT_LOAD [%d] addr: 0x%lx, size: 0x%lx\n", i, seg->vaddr, seg->memsz);
+            stat->rwx_num++;
+            stat->rwx_size += seg->memsz;
+        }
+        if (!is_load_live(&layout, i)) {
+            stat->dead += seg->filesz;
+        }
+        if (seg->filesz && seg->offset < st.st_size) {
+            ranges[range_num].start = seg->offset;
+            ranges[range_num].end = seg->offset + seg->filesz > st.st_size ? st.st_size : seg->offset + seg->filesz;
+            ranges[range_num].align = seg->align > PAGE_SIZE ? seg->align : PAGE_SIZE;
+            range_num++;
+        }
+    }
+
+    /* a gap before a range is padding up to the range alignment, the rest is orphaned */
+    range_num = merge_ranges(ranges, range_num);
+    start = 0;
+    for (int i = 0; i < range_num; i++) {
+        uint64_t gap = ranges[i].start - start;
+        stat->padding += gap % ranges[i].align;
+        stat->orphan += gap - gap % ranges[i].align;
+        start = ranges[i].end;
+    }
+    stat->orphan += st.st_size - start;
+
+    if (stat->load_num && !get_segment_range(elf_name, PT_LOAD, &start, &end)) {
+        stat->span_pages = (ALIGN(end, PAGE_SIZE) - (start & ~(uint64_t)(PAGE_SIZE - 1))) / PAGE_SIZE;
+    }
+    err = 0;
+
+ERR_EXIT:
+    free(ranges);
+    free_layout(&layout);
+    munmap(map, st.st_size);
+    return err;
+}
+
+static void print_stat_row(char *name, uint64_t old_val, uint64_t new_val, int compare) {
+    int64_t delta = new_val - old_val;
+    if (!compare) {
+        CHECK_COMMON("|%-20s|%16lu|\n", name, new_val);
+    } else if (delta > 0) {
+        CHECK_WARNING("|%-20s|%16lu|%16lu|%+16ld|\n", name, old_val, new_val, delta);
+    } else if (delta < 0) {
+        CHECK_INFO("|%-20s|%16lu|%16lu|%+16ld|\n", name, old_val, new_val, delta);
+    } else {
+        CHECK_COMMON("|%-20s|%16lu|%16lu|%16s|\n", name, old_val, new_val, "0");
+    }
+}
+
+/**
+ * @brief 显示文件的加载开销，如LOAD段数量、页数、对齐填充和孤立字节，给定原文件时比较修改前后的差异
+ * show the load cost of a file, such as the number of PT_LOAD mappings, pages,
+ * alignment padding and orphaned bytes. compare it with the original file if given
+ * @param elf_name elf file name
+ * @param old_name the file before the edits, or NULL
+ * @return int error code {-1:error,0:sucess}
+ */
+int layout_report(char *elf_name, char *old_name) {
+    layout_stat_t old_stat, new_stat;
+    int compare = old_name && old_name[0];
+    int mode = MODE;
+
+    if (compare) {
+        MODE = get_elf_class(old_name);
+        if (get_layout_stat(old_name, &old_stat)) {
+            MODE = mode;
+            return -1;
+        }
+        MODE = mode;
+    }
+    if (get_layout_stat(elf_name, &new_stat)) {
+        return -1;
+    }
+    if (!compare) {
+        memcpy(&old_stat, &new_stat, sizeof(layout_stat_t));
+    }
+
+    if (compare) {
+        printf("|---------------------------------------------------------------------|\n");
+        printf("|%-20s|%16s|%16s|%16s|\n", "layout", "before", "after", "delta");
+        printf("|---------------------------------------------------------------------|\n");
+    } else {
+        printf("|-------------------------------------|\n");
+        printf("|%-20s|%16s|\n", "layout", "value");
+        printf("|-------------------------------------|\n");
+    }
+    print_stat_row("file size", old_stat.file_size, new_stat.file_size, compare);
+    print_stat_row("PT_LOAD", old_stat.load_num, new_stat.load_num, compare);
+    print_stat_row("mapped pages", old_stat.mapped_pages, new_stat.mapped_pages, compare);
+    print_stat_row("file backed pages", old_stat.file_pages, new_stat.file_pages, compare);
+    print_stat_row("address span pages", old_stat.span_pages, new_stat.span_pages, compare);
+    print_stat_row("padding bytes", old_stat.padding, new_stat.padding, compare);
+    print_stat_row("orphaned bytes", old_stat.orphan, new_stat.orphan, compare);
+    print_stat_row("dead PT_LOAD bytes", old_stat.dead, new_stat.dead, compare);
+    print_stat_row("RWX PT_LOAD", old_stat.rwx_num, new_stat.rwx_num, compare);
+    print_stat_row("RWX bytes", old_stat.rwx_size, new_stat.rwx_size, compare);
+    if (compare) {
+        printf("|---------------------------------------------------------------------|\n");
+    } else {
+        printf("|-------------------------------------|\n");
+    }
+    return 0;
+}
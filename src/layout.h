@@ -0,0 +1,66 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+/* the size of a PMD huge page on x86_64 and aarch64 with 4K pages */
+#define HUGE_PAGE_SIZE 0x200000
+
+/* a file range [start, end) */
+typedef struct file_range {
+    uint64_t start;
+    uint64_t end;
+    uint64_t align;         // the range can be moved by a multiple of align
+} file_range_t;
+
+/**
+ * @brief 压缩文件，删除无用的区域，保持地址和偏移的同余关系。没有被引用的只读LOAD段默认只报告
+ * compact the file: drop the regions which are no longer referenced, keeping the
+ * congruence between virtual address and file offset. the unreferenced read-only
+ * PT_LOAD segments are only reported unless drop_loads is set, since a segment
+ * added by --add-segment is not referenced either
+ * @param elf_name elf file name
+ * @param drop_loads remove the unreferenced read-only PT_LOAD segments
+ * @return int error code {-1:error,0:sucess}
+ */
+int compact_elf(char *elf_name, int drop_loads);
+
+/**
+ * @brief 对齐可执行LOAD段，使其文件偏移和虚拟地址模大页大小同余，并设置p_align，之后的内容整体后移
+ * align the executable PT_LOAD segments for huge pages: move them in the file so
+ * that offset and virtual address are congruent modulo the huge page size, and
+ * raise p_align. the following contents are moved by whole pages
+ * @param elf_name elf file name
+ * @param align huge page size, 0 for HUGE_PAGE_SIZE
+ * @return int error code {-1:error,0:sucess}
+ */
+int align_hugepage(char *elf_name, uint64_t align);
+
+/**
+ * @brief 显示文件的加载开销，如LOAD段数量、页数、对齐填充和孤立字节，给定原文件时比较修改前后的差异
+ * show the load cost of a file, such as the number of PT_LOAD mappings, pages,
+ * alignment padding and orphaned bytes. compare it with the original file if given
+ * @param elf_name elf file name
+ * @param old_name the file before the edits, or NULL
+ * @return int error code {-1:error,0:sucess}
+ */
+int layout_report(char *elf_name, char *old_name);
@@ -41,6 +41,20 @@
 #include "edit.h"
 #include "segment.h"
 #include "rel.h"
+#include "mutate.h"
+#include "patch.h"
+#include "journal.h"
+#include "dynamic.h"
+#include "layout.h"
+#include "relr.h"
+#include "render.h"
+#include "hashmap.h"
+#include "version.h"
+#include "resolve.h"
+#include "index.h"
+#include "graph.h"
+#include "diff.h"
+#include "export.h"
 
 #define VERSION "1.10.0"
 #define CONTENT_LENGTH 1024 * 1024
@@ -49,6 +63,7 @@ char section_name[LENGTH];
 char string[PAGE_SIZE];
 char file[PAGE_SIZE];
 char config_name[PAGE_SIZE];
+char out_name[PAGE_SIZE];
 char arch[LENGTH];
 char endian[LENGTH];
 char ver[LENGTH];
@@ -67,6 +82,8 @@ uint32_t length;
 parser_opt_t po;
 /* Additional long parameters */
 static int g_long_option;
+/* --compact removes the unreferenced PT_LOAD segments only if asked */
+static int g_drop_loads;
 enum LONG_OPTION {
     EDIT_SECTION_FLAGS = 1,
     EDIT_SEGMENT_FLAGS,
@@ -86,6 +103,11 @@ enum LONG_OPTION {
     INFECT_DATA,
     SET_RPATH,
     SET_RUNPATH,
+    EDIT_DYNAMIC,
+    COMPACT,
+    PACK_RELR,
+    SORT_RELOC,
+    ALIGN_HUGEPAGE,
 };
 
 /**
@@ -114,20 +136,61 @@ static void init() {
     memset(string, 0, PAGE_SIZE);
     memset(file, 0, PAGE_SIZE);
     memset(config_name, 0, LENGTH);
+    memset(out_name, 0, PAGE_SIZE);
     memset(elf_name, 0, LENGTH);
     memset(function, 0, LENGTH);
     size = 0;
     off = 0;
     get_version(ver_elfspirt, LENGTH);
     po.index = 0;
+    po.base = 0;
+    po.filter = NULL;
+    po.ranged = 0;
+    po.range_start = 0;
+    po.range_count = 0;
+    po.demangle = 0;
     memset(po.options, 0, sizeof(po.options));
 }
-static const char *shortopts = "n:z:s:f:c:a:m:e:b:o:v:i:j:l:h::AHSPBDLRIG";
+/**
+ * @brief 克隆ELF到输出文件（reflink写时复制），之后的修改都作用于输出文件
+ * clone ELF to the output file (reflink copy-on-write), then edit the output file
+ * @param elf_name elf file name, replaced by output file name
+ * @param out_name output file name
+ */
+static void set_output(char *elf_name, char *out_name) {
+    if (!strlen(out_name) || !strcmp(elf_name, out_name)) {
+        return;
+    }
+    if (copy_file(elf_name, out_name)) {
+        ERROR("copy %s to %s\n", elf_name, out_name);
+        exit(-1);
+    }
+    memset(elf_name, 0, LENGTH);
+    strncpy(elf_name, out_name, LENGTH - 1);
+}
+
+/**
+ * @brief 判断功能是否修改ELF，只有这些功能需要输出文件
+ * determine whether the function modifies ELF, only these functions need the output file
+ * @param function function name
+ * @return int {0:false, 1:true}
+ */
+static int is_edit_function(char *function) {
+    static const char *edits[] = {"addsec", "injectso", "edit", "hook", "exe2so", "replay"};
+    for (size_t i = 0; i < sizeof(edits) / sizeof(edits[0]); i++) {
+        if (!strcmp(function, edits[i]))
+            return 1;
+    }
+    return 0;
+}
+
+static const char *shortopts = "n:z:s:f:c:a:m:e:b:o:v:i:j:l:r:O:h::AHSPBDLRIGC";
 
 static const struct option longopts[] = {
     {"section-name", required_argument, NULL, 'n'},
     {"section-size", required_argument, NULL, 'z'},
     {"string", required_argument, NULL, 's'},
+    {"filter", required_argument, NULL, 's'},
     {"file-name", required_argument, NULL, 'f'},
     {"configure-name", required_argument, NULL, 'c'},
     {"architcture", required_argument, NULL, 'a'},
@@ -142,6 +205,11 @@ static const struct option longopts[] = {
     {"row", required_argument, NULL, 'i'},
     {"column", required_argument, NULL, 'j'},
     {"length", required_argument, NULL, 'l'},
+    {"range", required_argument, NULL, 'r'},
+    {"demangle", no_argument, NULL, 'C'},
+    {"output", required_argument, NULL, 'O'},
+    {"journal", no_argument, &g_journal, 1},
+    {"drop-loads", no_argument, &g_drop_loads, 1},
     {"edit-section-flags", no_argument, &g_long_option, EDIT_SECTION_FLAGS},
     {"edit-segment-flags", no_argument, &g_long_option, EDIT_SEGMENT_FLAGS},
     {"edit-pointer", no_argument, &g_long_option, EDIT_POINTER},
@@ -160,6 +228,11 @@ static const struct option longopts[] = {
     {"infect-data", no_argument, &g_long_option, INFECT_DATA},
     {"set-rpath", no_argument, &g_long_option, SET_RPATH},
     {"set-runpath", no_argument, &g_long_option, SET_RUNPATH},
+    {"edit-dynamic", no_argument, &g_long_option, EDIT_DYNAMIC},
+    {"compact", no_argument, &g_long_option, COMPACT},
+    {"pack-relr", no_argument, &g_long_option, PACK_RELR},
+    {"sort-reloc", no_argument, &g_long_option, SORT_RELOC},
+    {"align-hugepage", no_argument, &g_long_option, ALIGN_HUGEPAGE},
     {0, 0, 0, 0}
 };
 
@@ -173,10 +246,11 @@ static const char *help =
     "  edit         Modify ELF file information freely\n"
     "  shellcode    Extract binary fragments and convert shellcode. [extract, hex2bin]\n"
     "  firmware     Add ELF info to firmware or join mutli bin file. [bin2elf, joinelf]\n"
-    "  patch        Patch ELF. [--set-interpreter, --set-rpath, --set-runpath]\n"
+    "  patch        Patch ELF. [--set-interpreter, --set-rpath, --set-runpath, --edit-dynamic, --compact, --pack-relr, --sort-reloc, --align-hugepage, record, replay, rollback, commit]\n"
     "  confuse      Obfuscate ELF symbols. [--rm-section, --rm-shdr, --rm-strip, confuse]\n"
     "  infect       Infect ELF like virus. [--infect-silvio, --infect-skeksi, --infect-data, exe2so]\n"
-    "  forensic     Analyze the Legitimacy of ELF File Structure. [checksec]\n"
+    "  forensic     Analyze the Legitimacy of ELF File Structure. [checksec, layout, linkcost, resolve, index-build, query, graph, diff, export]\n"
+    "  fuzz         Generate mutated ELF seeds for fuzzing. [seed]\n"
     "  other        Deprecated cmd. [addsec, injectso(deprecate)]\n"
     "Currently defined options:\n"
     "  -n, --section-name=<section name>         Set section name\n"
@@ -193,6 +267,10 @@ static const char *help =
     "  -i, --row=<object index>                  Index of the object to be read or written\n"
     "  -j, --column=<vertical axis>              The vertical axis of the object to be read or written\n"
     "  -l, --length=<string length>              Display the maximum length of the string\n"
+    "  -r, --range=<start[:count]>               Display the rows [start, start + count) of each table\n"
+    "  -O, --output=<file name>                  Edit a copy-on-write clone instead of ELF\n"
+    "      --journal                             Record original bytes in ELF.journal before editing\n"
+    "      --drop-loads                          Let --compact remove the unreferenced read-only PT_LOAD\n"
     "  -v, --version-libc=<libc version>         Libc.so or ld.so version\n"
     "  -h, --help[={none|English|Chinese}]       Display this output\n"
     "  -A, (no argument)                         Display all ELF file infomation\n"
@@ -205,8 +283,10 @@ static const char *help =
     "  -R, (no argument)                         Display | Edit relocation section\n"
     "  -I, (no argument)                         Display | Edit pointer(e.g. .init_array, etc.)\n"
     "  -G, (no argument)                         Display hash table\n"
+    "  -C, --demangle                            Demangle C++ symbol names\n"
     "Detailed Usage: \n"
-    "  elfspirit parse    [-A|H|S|P|B|D|R|I|G] ELF\n"
+    "  elfspirit parse    [-A|H|S|P|B|D|R|I|G] [-C] [-b]<base address> [-s]<filter> [-r]<start[:count]> ELF\n"
+    "                     filter: name=*alloc*,type=FUNC,bind=GLOBAL,vis=DEFAULT,ndx=UND,addr=0x1000-0x2000,size>0x100,rtype~GLOB_DAT\n"
     "  elfspirit edit     [-H|S|P|B|D|R|I] [-i]<row> [-j]<column> [-m|-s]<int|string value> ELF\n" 
     "  elfspirit bin2elf  [-a]<arm|x86> [-m]<32|64> [-e]<little|big> [-b]<base address> ELF\n"
     "  elfspirit joinelf  [-a]<arm|x86> [-m]<32|64> [-e]<little|big> [-c]<configuration file> OUT_ELF\n"
@@ -215,10 +295,24 @@ static const char *help =
     "                     [-o]<file offset> [-z]<size> ELF\n"
     "  elfspirit hook [-s]<hook symbol> [-f]<new function bin> [-o]<new function start offset> ELF\n"
     "  elfspirit exe2so   [-s]<symbol> [-m]<function offset> [-z]<function size> ELF\n"
+    "  elfspirit exe2so   [-c]<symbol list file, name,offset,size[,type] per line> ELF\n"
     "  elfspirit addsec   [-n]<section name> [-z]<section size> [-o]<offset(optional)> ELF\n"
     "  elfspirit injectso [-n]<section name> [-f]<so name> [-c]<configure file>\n"
     "                     [-v]<libc version> ELF\n" 
     "  elfspirit checksec ELF\n"
+    "  elfspirit layout   [-f]<file before edits(optional)> ELF\n"
+    "  elfspirit linkcost ELF\n"
+    "  elfspirit resolve  [-f]<sysroot(optional)> [-c]<ELF list file(optional)> ELF\n"
+    "  elfspirit index-build [-f]<index file> DIR\n"
+    "  elfspirit query    [-s]<export=NAME|import=NAME|build-id=HEX> INDEX\n"
+    "  elfspirit graph    [-c]<entrypoint list(optional)> [-s]<text|dot|json> DIR\n"
+    "  elfspirit diff     [-A|H|S|P|B|D|R|L] [-f]<original ELF> ELF\n"
+    "  elfspirit export   [-f]<output file(optional)> [-c]<ELF list file(optional)> ELF\n"
+    "  elfspirit seed     [-A|H|S|P|B|D|R|L] [-z]<seed number> [-f]<output directory(optional)> ELF\n"
+    "  elfspirit record   [-f]<original ELF> [-c]<patch file> ELF\n"
+    "  elfspirit replay   [-c]<patch file> ELF\n"
+    "  elfspirit rollback ELF\n"
+    "  elfspirit commit   ELF\n"
     "  elfspirit --edit-section-flags [-i]<row of section> [-m]<permission> ELF\n"
     "  elfspirit --edit-segment-flags [-i]<row of segment> [-m]<permission> ELF\n"
     "  elfspirit --edit-hex     [-o]<offset> [-s]<hex string> [-z]<size> ELF\n"
@@ -227,6 +321,11 @@ static const char *help =
     "  elfspirit --set-interpreter [-s]<new interpreter> ELF\n"
     "  elfspirit --set-rpath [-s]<rpath> ELF\n"
     "  elfspirit --set-runpath [-s]<runpath> ELF\n"
+    "  elfspirit --edit-dynamic [-s]<+TAG=VALUE,=TAG=VALUE,-TAG[=VALUE],^TAG[=VALUE]> ELF\n"
+    "  elfspirit --compact [--drop-loads] ELF\n"
+    "  elfspirit --pack-relr ELF\n"
+    "  elfspirit --sort-reloc ELF\n"
+    "  elfspirit --align-hugepage [-z]<huge page size, default 0x200000> ELF\n"
     "  elfspirit --add-section [-z]<size> ELF\n"
     "  elfspirit --add-segment [-z]<size> ELF\n"
     "  elfspirit --rm-section  [-n]<section name> ELF\n"
@@ -246,10 +345,11 @@ static const char *help_chinese =
     "  edit         自由修改ELF每个字节\n"
     "  shellcode    从目标文件中提取二进制片段，将shellcode转化为二进制. [extract, hex2bin]\n"
     "  firmware     用于IOT固件，比如将二进制转换为elf文件，连接多个bin文件. [bin2elf, joinelf]\n"
-    "  patch        修补ELF. [--set-interpreter, --set-rpath, --set-runpath]\n"
+    "  patch        修补ELF. [--set-interpreter, --set-rpath, --set-runpath, --edit-dynamic, --compact, --pack-relr, --sort-reloc, --align-hugepage, record, replay, rollback, commit]\n"
     "  confuse      删除节、过滤符号表、删除节头表，混淆ELF符号. [--rm-section, --rm-shdr, --rm-strip, confuse]\n"
     "  infect       ELF文件感染. [--infect-silvio, --infect-skeksi, --infect-data, exe2so]\n"
-    "  forensic     分析ELF文件结构的合法性. [checksec]\n"
+    "  forensic     分析ELF文件结构的合法性. [checksec, layout, linkcost, resolve, index-build, query, graph, diff, export]\n"
+    "  fuzz         生成用于模糊测试的ELF变异种子. [seed]\n"
     "  other        即将弃用的功能. [addsec, injectso(deprecate)]\n"
     "支持的选项:\n"
     "  -n, --section-name=<section name>         设置节名\n"
@@ -266,6 +366,10 @@ static const char *help_chinese =
     "  -i, --row=<object index>                  待读出或者写入的对象的下标\n"
     "  -j, --column=<vertical axis>              待读出或者写入的对象的纵坐标\n"
     "  -l, --length=<string length>              解析ELF文件时，显示字符串的最大长度\n"
+    "  -r, --range=<start[:count]>               解析ELF文件时，只显示每个表格的第start行开始的count行\n"
+    "  -O, --output=<file name>                  修改ELF的写时复制副本，而不是ELF本身\n"
+    "      --journal                             修改之前，将原始数据记录到ELF.journal\n"
+    "      --drop-loads                          --compact时删除没有被引用的只读LOAD段\n"
     "  -v, --version-libc=<libc version>         libc或者ld的版本\n"
     "  -h, --help[={none|English|Chinese}]       帮助\n"
     "  -A, 不需要参数                    显示ELF解析器解析的所有信息\n"
@@ -278,8 +382,10 @@ static const char *help_chinese =
     "  -R, 不需要参数                    显示|编辑ELF: 重定位表\n"
     "  -R, 不需要参数                    显示|编辑ELF: 指针(e.g. .init_array, etc.)\n"
     "  -G, 不需要参数                    显示hash表\n"
+    "  -C, --demangle                    还原C++符号名\n"
     "细节: \n"
-    "  elfspirit parse    [-A|H|S|P|B|D|R|I|G] ELF\n"
+    "  elfspirit parse    [-A|H|S|P|B|D|R|I|G] [-C] [-b]<基地址> [-s]<过滤条件> [-r]<start[:count]> ELF\n"
+    "                     过滤条件: name=*alloc*,type=FUNC,bind=GLOBAL,vis=DEFAULT,ndx=UND,addr=0x1000-0x2000,size>0x100,rtype~GLOB_DAT\n"
     "  elfspirit edit     [-H|S|P|B|D|R] [-i]<第几行> [-j]<第几列> [-m|-s]<int|str修改值> ELF\n"
     "  elfspirit bin2elf  [-a]<arm|x86> [-m]<32|64> [-e]<little|big> [-b]<基地址> ELF\n"
     "  elfspirit joinelf  [-a]<arm|x86> [-m]<32|64> [-e]<little|big> [-c]<配置文件> OUT_ELF\n"
@@ -288,10 +394,24 @@ static const char *help_chinese =
     "                     [-o]<节的偏移> [-z]<size> ELF\n"
     "  elfspirit hook [-s]<hook函数名> [-f]<新的函数二进制> [-o]<新函数偏移> ELF\n"
     "  elfspirit exe2so   [-s]<函数名> [-m]<函数偏移> [-z]<函数大小> ELF\n"
+    "  elfspirit exe2so   [-c]<符号列表文件, 每行格式为 名称,偏移,大小[,类型]> ELF\n"
     "  elfspirit addsec   [-n]<节的名字> [-z]<节的大小> [-o]<节的偏移(可选项)> ELF\n"
     "  elfspirit injectso [-n]<节的名字> [-f]<so的名字> [-c]<配置文件>\n"
     "                     [-v]<libc的版本> ELF\n"
     "  elfspirit checksec ELF\n"
+    "  elfspirit layout   [-f]<修改前的文件(可选项)> ELF\n"
+    "  elfspirit linkcost ELF\n"
+    "  elfspirit resolve  [-f]<sysroot(可选项)> [-c]<ELF列表文件(可选项)> ELF\n"
+    "  elfspirit index-build [-f]<索引文件> 目录\n"
+    "  elfspirit query    [-s]<export=符号名|import=符号名|build-id=HEX> 索引文件\n"
+    "  elfspirit graph    [-c]<入口程序列表(可选项)> [-s]<text|dot|json> 目录\n"
+    "  elfspirit diff     [-A|H|S|P|B|D|R|L] [-f]<原始文件> ELF\n"
+    "  elfspirit export   [-f]<输出文件(可选项)> [-c]<ELF列表文件(可选项)> ELF\n"
+    "  elfspirit seed     [-A|H|S|P|B|D|R|L] [-z]<种子数量> [-f]<输出目录(可选项)> ELF\n"
+    "  elfspirit record   [-f]<原始ELF> [-c]<补丁文件> ELF\n"
+    "  elfspirit replay   [-c]<补丁文件> ELF\n"
+    "  elfspirit rollback ELF\n"
+    "  elfspirit commit   ELF\n"
     "  elfspirit --edit-section-flags [-i]<第几个节> [-m]<权限值> ELF\n"
     "  elfspirit --edit-segment-flags [-i]<第几个段> [-m]<权限值> ELF\n"
     "  elfspirit --edit-hex     [-o]<偏移> [-s]<hex string> [-z]<size> ELF\n"
@@ -300,6 +420,11 @@ static const char *help_chinese =
     "  elfspirit --set-interpreter [-s]<新的链接器> ELF\n"
     "  elfspirit --set-rpath [-s]<rpath> ELF\n"
     "  elfspirit --set-runpath [-s]<runpath> ELF\n"
+    "  elfspirit --edit-dynamic [-s]<+TAG=值(增加),=TAG=值(替换),-TAG[=值](删除),^TAG[=值](前移)> ELF\n"
+    "  elfspirit --compact [--drop-loads] ELF\n"
+    "  elfspirit --pack-relr ELF\n"
+    "  elfspirit --sort-reloc ELF\n"
+    "  elfspirit --align-hugepage [-z]<大页大小, 默认0x200000> ELF\n"
     "  elfspirit --add-section [-z]<size> ELF\n"
     "  elfspirit --add-segment [-z]<size> ELF\n"
     "  elfspirit --rm-section  [-n]<节的名字> ELF\n"
@@ -379,11 +504,12 @@ static void readcmdline(int argc, char *argv[]) {
             // set base address
             case 'b':
                 if (optarg[0] == '0' && optarg[1] == 'x') {
-                    base_addr = hex2int(optarg);
+                    base_addr = strtoull(optarg, NULL, 16);
                 }
                 else{
                     base_addr = atoi(optarg);
                 }                
+                po.base = base_addr;
                 break;
             /***** add elf info to firmware for IDA - END *****/
 
@@ -441,6 +567,24 @@ static void readcmdline(int argc, char *argv[]) {
                 }                
                 break;
 
+            // set rows of the parsed tables, start[:count]
+            case 'r': {
+                char *end;
+                po.ranged = 1;
+                po.range_start = strtoull(optarg, &end, 0);
+                po.range_count = *end == ':' ? strtoull(end + 1, NULL, 0) : 0;
+                break;
+            }
+
+            // set output file
+            case 'O':
+                /* the output name replaces elf_name, it must fit in LENGTH */
+                if (snprintf(out_name, LENGTH, "%s", optarg) >= LENGTH) {
+                    ERROR("output name %s is too long\n", optarg);
+                    exit(-1);
+                }
+                break;
+
             /* ELF parser's options */
             case 'A':
                 po.options[po.index++] = ALL;
@@ -480,6 +624,10 @@ static void readcmdline(int argc, char *argv[]) {
             case 'G':
                 po.options[po.index++] = GNUHASH;
                 break;
+
+            case 'C':
+                po.demangle = 1;
+                break;
             
             default:
                 break;
@@ -498,6 +646,7 @@ static void readcmdline(int argc, char *argv[]) {
     /* handle additional long parameters */
     if (optind == argc - 1) {
         memcpy(elf_name, argv[optind], LENGTH);
+        set_output(elf_name, out_name);
         MODE = get_elf_class(elf_name);
         if (g_long_option) {
             switch (g_long_option)
@@ -545,6 +694,38 @@ static void readcmdline(int argc, char *argv[]) {
                     set_runpath(elf_name, string);
                     break;
 
+                case EDIT_DYNAMIC:
+                    /* add, remove and reorder dynamic items */
+                    {
+                        dyn_op_t *ops;
+                        int count;
+                        if (!parse_dyn_ops(string, &ops, &count)) {
+                            edit_dynamic(elf_name, ops, count);
+                            free_dyn_ops(ops, count);
+                        }
+                    }
+                    break;
+
+                case COMPACT:
+                    /* drop the orphaned regions left by the edits */
+                    compact_elf(elf_name, g_drop_loads);
+                    break;
+
+                case PACK_RELR:
+                    /* pack RELATIVE relocations into DT_RELR */
+                    pack_relr(elf_name);
+                    break;
+
+                case SORT_RELOC:
+                    /* sort dynamic relocations like -z combreloc */
+                    sort_reloc(elf_name);
+                    break;
+
+                case ALIGN_HUGEPAGE:
+                    /* align the text segment for huge pages */
+                    align_hugepage(elf_name, size);
+                    break;
+
                 case ADD_SEGMENT:
                     /* add a segment */
                     add_segment(elf_name, PT_LOAD, size);
@@ -617,7 +798,11 @@ static void readcmdline(int argc, char *argv[]) {
     else {
         memcpy(function, argv[optind], LENGTH);
         memcpy(elf_name, argv[++optind], LENGTH);
-        MODE = get_elf_class(elf_name);
+        if (is_edit_function(function))
+            set_output(elf_name, out_name);
+        /* the index and graph functions take a directory or an index file */
+        if (strcmp(function, "index-build") && strcmp(function, "query") && strcmp(function, "graph"))
+            MODE = get_elf_class(elf_name);
     }
 
     /* add a section */
@@ -633,6 +818,7 @@ static void readcmdline(int argc, char *argv[]) {
 
     /* ELF parser */
     if (!strcmp(function, "parse")) {
+        po.filter = strlen(string) ? string : NULL;
         parse(elf_name, &po, length);
     }
 
@@ -669,16 +855,91 @@ static void readcmdline(int argc, char *argv[]) {
 
     /* change bin to so */
     if (!strcmp(function, "exe2so")) {
-        add_dynsym_entry(elf_name, string, value, size);
+        if (config_name[0]) {
+            sym_entry_t *entries;
+            int count;
+            if (!parse_sym_list(config_name, &entries, &count)) {
+                add_dynsym_entries(elf_name, entries, count);
+                free_sym_list(entries, count);
+            }
+        } else {
+            add_dynsym_entry(elf_name, string, value, size);
+        }
     }
 
     /* change bin to so */
     if (!strcmp(function, "checksec")) {
         checksec(elf_name);
     }
+
+    /* show the load cost, compare it with the file before edits */
+    if (!strcmp(function, "layout")) {
+        layout_report(elf_name, file);
+    }
+
+    /* estimate the dynamic linking cost */
+    if (!strcmp(function, "linkcost")) {
+        linkcost(elf_name);
+    }
+
+    /* find the library defining each import without running ELF */
+    if (!strcmp(function, "resolve")) {
+        resolve(file, config_name, elf_name);
+    }
+
+    /* index the exports, imports and build ids of a directory */
+    if (!strcmp(function, "index-build")) {
+        build_index(elf_name, file);
+    }
+
+    /* look up the index */
+    if (!strcmp(function, "query")) {
+        query_index(elf_name, string);
+    }
+
+    /* build the DT_NEEDED dependency graph of a sysroot */
+    if (!strcmp(function, "graph")) {
+        build_dep_graph(elf_name, config_name, string);
+    }
+
+    /* compare the headers and tables of two ELF files */
+    if (!strcmp(function, "diff")) {
+        diff_elf(file, elf_name, &po);
+    }
+
+    /* export the symbol and relocation tables as columns */
+    if (!strcmp(function, "export")) {
+        export_columns(file, config_name, elf_name);
+    }
+
+    /* generate fuzzing seeds */
+    if (!strcmp(function, "seed")) {
+        gen_seeds(elf_name, &po, size, file);
+    }
+
+    /* record the edits as a patch */
+    if (!strcmp(function, "record")) {
+        record_patch(file, elf_name, config_name);
+    }
+
+    /* replay the patch */
+    if (!strcmp(function, "replay")) {
+        replay_patch(config_name, elf_name);
+    }
+
+    /* restore ELF from the journal */
+    if (!strcmp(function, "rollback")) {
+        rollback_journal(elf_name);
+    }
+
+    /* accept the journaled edits */
+    if (!strcmp(function, "commit")) {
+        commit_journal(elf_name);
+    }
 }
 
 int main(int argc, char *argv[]) {
+    init_render();
     init();
     readcmdline(argc, argv);
     return 0;
@@ -0,0 +1,535 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <limits.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <elf.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "common.h"
+#include "parse.h"
+#include "mutate.h"
+
+#define SEED_MAX_THREADS 64
+#define SEED_MAX_TABLES 64
+/* "_X_" and the seed number appended to the base name */
+#define SEED_SUFFIX_LEN 16
+
+/*
+ * 字段描述，与edit()的行列坐标一一对应
+ * field descriptor, same row/column layout as edit()
+ */
+typedef struct field {
+    uint16_t off32;
+    uint16_t size32;
+    uint64_t mask32;        // 0 means the whole field
+    uint16_t off64;
+    uint16_t size64;
+    uint64_t mask64;
+} field_t;
+
+#define FIELD(t32, t64, m) \
+    {offsetof(t32, m), sizeof(((t32 *)0)->m), 0, offsetof(t64, m), sizeof(((t64 *)0)->m), 0}
+#define FIELD_MASK(t32, t64, m, mask32, mask64) \
+    {offsetof(t32, m), sizeof(((t32 *)0)->m), mask32, offsetof(t64, m), sizeof(((t64 *)0)->m), mask64}
+
+/* elfspirit edit -H -i<row> */
+static const field_t header_fields[] = {
+    FIELD(Elf32_Ehdr, Elf64_Ehdr, e_type),
+    FIELD(Elf32_Ehdr, Elf64_Ehdr, e_machine),
+    FIELD(Elf32_Ehdr, Elf64_Ehdr, e_version),
+    FIELD(Elf32_Ehdr, Elf64_Ehdr, e_entry),
+    FIELD(Elf32_Ehdr, Elf64_Ehdr, e_phoff),
+    FIELD(Elf32_Ehdr, Elf64_Ehdr, e_shoff),
+    FIELD(Elf32_Ehdr, Elf64_Ehdr, e_flags),
+    FIELD(Elf32_Ehdr, Elf64_Ehdr, e_ehsize),
+    FIELD(Elf32_Ehdr, Elf64_Ehdr, e_phentsize),
+    FIELD(Elf32_Ehdr, Elf64_Ehdr, e_phnum),
+    FIELD(Elf32_Ehdr, Elf64_Ehdr, e_shentsize),
+    FIELD(Elf32_Ehdr, Elf64_Ehdr, e_shnum),
+    FIELD(Elf32_Ehdr, Elf64_Ehdr, e_shstrndx),
+};
+
+/* elfspirit edit -S -i<row> -j<column> */
+static const field_t section_fields[] = {
+    FIELD(Elf32_Shdr, Elf64_Shdr, sh_name),
+    FIELD(Elf32_Shdr, Elf64_Shdr, sh_type),
+    FIELD(Elf32_Shdr, Elf64_Shdr, sh_addr),
+    FIELD(Elf32_Shdr, Elf64_Shdr, sh_offset),
+    FIELD(Elf32_Shdr, Elf64_Shdr, sh_size),
+    FIELD(Elf32_Shdr, Elf64_Shdr, sh_entsize),
+    FIELD(Elf32_Shdr, Elf64_Shdr, sh_flags),
+    FIELD(Elf32_Shdr, Elf64_Shdr, sh_link),
+    FIELD(Elf32_Shdr, Elf64_Shdr, sh_info),
+    FIELD(Elf32_Shdr, Elf64_Shdr, sh_addralign),
+};
+
+/* elfspirit edit -P -i<row> -j<column> */
+static const field_t segment_fields[] = {
+    FIELD(Elf32_Phdr, Elf64_Phdr, p_type),
+    FIELD(Elf32_Phdr, Elf64_Phdr, p_offset),
+    FIELD(Elf32_Phdr, Elf64_Phdr, p_vaddr),
+    FIELD(Elf32_Phdr, Elf64_Phdr, p_paddr),
+    FIELD(Elf32_Phdr, Elf64_Phdr, p_filesz),
+    FIELD(Elf32_Phdr, Elf64_Phdr, p_memsz),
+    FIELD(Elf32_Phdr, Elf64_Phdr, p_flags),
+    FIELD(Elf32_Phdr, Elf64_Phdr, p_align),
+};
+
+/* elfspirit edit -B|D -i<row> -j<column> */
+static const field_t symbol_fields[] = {
+    FIELD(Elf32_Sym, Elf64_Sym, st_value),
+    FIELD(Elf32_Sym, Elf64_Sym, st_size),
+    FIELD_MASK(Elf32_Sym, Elf64_Sym, st_info, 0x0f, 0x0f),     // type
+    FIELD_MASK(Elf32_Sym, Elf64_Sym, st_info, 0xf0, 0xf0),     // bind
+    FIELD(Elf32_Sym, Elf64_Sym, st_other),
+    FIELD(Elf32_Sym, Elf64_Sym, st_shndx),
+    FIELD(Elf32_Sym, Elf64_Sym, st_name),
+};
+
+/* elfspirit edit -R -n<.rel*|.rela*> -i<row> -j<column>, .rel uses the first 4 columns */
+static const field_t rela_fields[] = {
+    FIELD(Elf32_Rela, Elf64_Rela, r_offset),
+    FIELD(Elf32_Rela, Elf64_Rela, r_info),
+    FIELD_MASK(Elf32_Rela, Elf64_Rela, r_info, 0xff, 0xffffffffULL),                          // type
+    FIELD_MASK(Elf32_Rela, Elf64_Rela, r_info, 0xffffff00, 0xffffffff00000000ULL),            // index
+    FIELD(Elf32_Rela, Elf64_Rela, r_addend),
+};
+
+/* elfspirit edit -L -i<row> -j<column> */
+static const field_t dynamic_fields[] = {
+    FIELD(Elf32_Dyn, Elf64_Dyn, d_tag),
+    FIELD(Elf32_Dyn, Elf64_Dyn, d_un),
+};
+
+#define FIELD_NUM(f) (sizeof(f) / sizeof(f[0]))
+
+/*
+ * 一个可变异的表：ELF头、节头表、程序头表、符号表、重定位表、动态链接表
+ * a mutable table: ELF header, shdr, phdr, symbol, relocation or dynamic table
+ */
+typedef struct seed_table {
+    char option;            // parser option letter, used in the seed name
+    const field_t *fields;
+    int field_num;
+    uint64_t offset;        // table file offset
+    uint64_t entsize;
+    uint64_t count;         // number of rows
+} seed_table_t;
+
+typedef struct seed_ctx {
+    char *elf_name;
+    char *out_dir;
+    char base_name[PATH_MAX];   // output path of the seeds without the suffix
+    uint8_t *tmpl;          // template mapped once
+    size_t size;
+    int tmpl_fd;
+    int class;
+    int reflink;            // 1: seeds share extents with the template
+    seed_table_t tables[SEED_MAX_TABLES];
+    int table_num;
+    uint32_t count;
+    uint32_t next;          // next seed number, shared by all workers
+    uint32_t failed;        // seeds which could not be written
+    pthread_mutex_t lock;
+} seed_ctx_t;
+
+/* interesting values, the same idea as AFL's boundary values */
+static const uint64_t boundary_values[] = {
+    0, 1, 0x7f, 0x80, 0xff, 0x100, 0x7fff, 0x8000, 0xffff, 0x10000,
+    0x7fffffff, 0x80000000, 0xffffffff, 0x100000000ULL, 0x7fffffffffffffffULL, 0xffffffffffffffffULL,
+};
+
+static int add_table(seed_ctx_t *ctx, char option, const field_t *fields, int field_num,
+                     uint64_t offset, uint64_t entsize, uint64_t count) {
+    if (ctx->table_num >= SEED_MAX_TABLES || !count) {
+        return -1;
+    }
+    /* skip tables which are out of the file */
+    if (offset > ctx->size || entsize * count > ctx->size - offset) {
+        WARNING("table %c at 0x%lx is out of the file, skip it\n", option, offset);
+        return -1;
+    }
+    seed_table_t *t = &ctx->tables[ctx->table_num++];
+    t->option = option;
+    t->fields = fields;
+    t->field_num = field_num;
+    t->offset = offset;
+    t->entsize = entsize;
+    t->count = count;
+    return 0;
+}
+
+/**
+ * @brief 从模板中收集需要变异的表
+ * collect the tables to be mutated from the template
+ * @param ctx seed context
+ * @param po parser option, which tables
+ * @return int table number
+ */
+static int collect_tables(seed_ctx_t *ctx, parser_opt_t *po) {
+    int all = !get_option(po, ALL) || po->index == 0;
+    int i;
+
+    if (ctx->class == ELFCLASS32) {
+        Elf32_Ehdr *ehdr = (Elf32_Ehdr *)ctx->tmpl;
+        Elf32_Shdr *shdr = (Elf32_Shdr *)(ctx->tmpl + ehdr->e_shoff);
+        if (all || !get_option(po, HEADERS))
+            add_table(ctx, 'H', header_fields, FIELD_NUM(header_fields), 0, sizeof(Elf32_Ehdr), 1);
+        if (all || !get_option(po, SECTIONS))
+            add_table(ctx, 'S', section_fields, FIELD_NUM(section_fields), ehdr->e_shoff, sizeof(Elf32_Shdr), ehdr->e_shnum);
+        if (all || !get_option(po, SEGMENTS))
+            add_table(ctx, 'P', segment_fields, FIELD_NUM(segment_fields), ehdr->e_phoff, sizeof(Elf32_Phdr), ehdr->e_phnum);
+        if (ehdr->e_shoff + ehdr->e_shnum * sizeof(Elf32_Shdr) > ctx->size) {
+            return ctx->table_num;
+        }
+        for (i = 0; i < ehdr->e_shnum; i++) {
+            switch (shdr[i].sh_type) {
+                case SHT_SYMTAB:
+                    if (all || !get_option(po, SYMTAB))
+                        add_table(ctx, 'B', symbol_fields, FIELD_NUM(symbol_fields), shdr[i].sh_offset, sizeof(Elf32_Sym), shdr[i].sh_size / sizeof(Elf32_Sym));
+                    break;
+                case SHT_DYNSYM:
+                    if (all || !get_option(po, DYNSYM))
+                        add_table(ctx, 'D', symbol_fields, FIELD_NUM(symbol_fields), shdr[i].sh_offset, sizeof(Elf32_Sym), shdr[i].sh_size / sizeof(Elf32_Sym));
+                    break;
+                case SHT_REL:
+                    if (all || !get_option(po, RELA))
+                        add_table(ctx, 'R', rela_fields, 4, shdr[i].sh_offset, sizeof(Elf32_Rel), shdr[i].sh_size / sizeof(Elf32_Rel));
+                    break;
+                case SHT_RELA:
+                    if (all || !get_option(po, RELA))
+                        add_table(ctx, 'R', rela_fields, FIELD_NUM(rela_fields), shdr[i].sh_offset, sizeof(Elf32_Rela), shdr[i].sh_size / sizeof(Elf32_Rela));
+                    break;
+                case SHT_DYNAMIC:
+                    if (all || !get_option(po, LINK))
+                        add_table(ctx, 'L', dynamic_fields, FIELD_NUM(dynamic_fields), shdr[i].sh_offset, sizeof(Elf32_Dyn), shdr[i].sh_size / sizeof(Elf32_Dyn));
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    if (ctx->class == ELFCLASS64) {
+        Elf64_Ehdr *ehdr = (Elf64_Ehdr *)ctx->tmpl;
+        Elf64_Shdr *shdr = (Elf64_Shdr *)(ctx->tmpl + ehdr->e_shoff);
+        if (all || !get_option(po, HEADERS))
+            add_table(ctx, 'H', header_fields, FIELD_NUM(header_fields), 0, sizeof(Elf64_Ehdr), 1);
+        if (all || !get_option(po, SECTIONS))
+            add_table(ctx, 'S', section_fields, FIELD_NUM(section_fields), ehdr->e_shoff, sizeof(Elf64_Shdr), ehdr->e_shnum);
+        if (all || !get_option(po, SEGMENTS))
+            add_table(ctx, 'P', segment_fields, FIELD_NUM(segment_fields), ehdr->e_phoff, sizeof(Elf64_Phdr), ehdr->e_phnum);
+        if (ehdr->e_shoff + ehdr->e_shnum * sizeof(Elf64_Shdr) > ctx->size) {
+            return ctx->table_num;
+        }
+        for (i = 0; i < ehdr->e_shnum; i++) {
+            switch (shdr[i].sh_type) {
+                case SHT_SYMTAB:
+                    if (all || !get_option(po, SYMTAB))
+                        add_table(ctx, 'B', symbol_fields, FIELD_NUM(symbol_fields), shdr[i].sh_offset, sizeof(Elf64_Sym), shdr[i].sh_size / sizeof(Elf64_Sym));
+                    break;
+                case SHT_DYNSYM:
+                    if (all || !get_option(po, DYNSYM))
+                        add_table(ctx, 'D', symbol_fields, FIELD_NUM(symbol_fields), shdr[i].sh_offset, sizeof(Elf64_Sym), shdr[i].sh_size / sizeof(Elf64_Sym));
+                    break;
+                case SHT_REL:
+                    if (all || !get_option(po, RELA))
+                        add_table(ctx, 'R', rela_fields, 4, shdr[i].sh_offset, sizeof(Elf64_Rel), shdr[i].sh_size / sizeof(Elf64_Rel));
+                    break;
+                case SHT_RELA:
+                    if (all || !get_option(po, RELA))
+                        add_table(ctx, 'R', rela_fields, FIELD_NUM(rela_fields), shdr[i].sh_offset, sizeof(Elf64_Rela), shdr[i].sh_size / sizeof(Elf64_Rela));
+                    break;
+                case SHT_DYNAMIC:
+                    if (all || !get_option(po, LINK))
+                        add_table(ctx, 'L', dynamic_fields, FIELD_NUM(dynamic_fields), shdr[i].sh_offset, sizeof(Elf64_Dyn), shdr[i].sh_size / sizeof(Elf64_Dyn));
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    return ctx->table_num;
+}
+
+/**
+ * @brief 生成一个变异值
+ * generate a mutated value from the original one
+ * @param old original field value
+ * @param state rand_r state
+ * @return uint64_t new value
+ */
+static uint64_t mutate_value(uint64_t old, unsigned int *state) {
+    switch (rand_r(state) % 4) {
+        case 0:
+            /* the same as seeds.py */
+            return rand_r(state) % 65535 + 1;
+        case 1:
+            return boundary_values[rand_r(state) % FIELD_NUM(boundary_values)];
+        case 2:
+            return old ^ (1ULL << (rand_r(state) % 64));
+        default:
+            return old + (rand_r(state) % 33) - 16;
+    }
+}
+
+/**
+ * @brief 在缓冲区中变异一个字段，返回字段的偏移和长度，用于恢复模板
+ * mutate one field in the buffer, return the field offset and size to restore the template
+ * @param ctx seed context
+ * @param buf template copy
+ * @param state rand_r state
+ * @param off output field offset
+ * @param len output field size
+ * @return char table option letter
+ */
+static char mutate_field(seed_ctx_t *ctx, uint8_t *buf, unsigned int *state, uint64_t *off, size_t *len) {
+    seed_table_t *t = &ctx->tables[rand_r(state) % ctx->table_num];
+    const field_t *f = &t->fields[rand_r(state) % t->field_num];
+    uint64_t row = rand_r(state) % t->count;
+    uint64_t mask, old = 0, new;
+    size_t size;
+
+    if (ctx->class == ELFCLASS32) {
+        *off = t->offset + row * t->entsize + f->off32;
+        size = f->size32;
+        mask = f->mask32;
+    } else {
+        *off = t->offset + row * t->entsize + f->off64;
+        size = f->size64;
+        mask = f->mask64;
+    }
+    if (!mask) {
+        mask = size == 8 ? ~0ULL : (1ULL << (size * 8)) - 1;
+    }
+
+    memcpy(&old, buf + *off, size);
+    new = mutate_value((old & mask) >> __builtin_ctzll(mask), state);
+    new = (old & ~mask) | ((new << __builtin_ctzll(mask)) & mask);
+    memcpy(buf + *off, &new, size);
+    *len = size;
+    return t->option;
+}
+
+/**
+ * @brief 写入一个种子文件。如果文件系统支持reflink，只写入变异的字节
+ * write a seed file. if the file system supports reflink, only the mutated bytes are written
+ */
+static int write_seed(seed_ctx_t *ctx, char *seed_name, uint8_t *buf, uint64_t off, size_t len) {
+    int fd = open(seed_name, O_RDWR | O_CREAT | O_TRUNC, 0777);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    if (ctx->reflink && !reflink_file(ctx->tmpl_fd, fd)) {
+        if (pwrite(fd, buf + off, len, off) != len) {
+            goto ERR_EXIT;
+        }
+    } else {
+        if (pwrite(fd, buf, ctx->size, 0) != ctx->size) {
+            goto ERR_EXIT;
+        }
+    }
+
+    close(fd);
+    return 0;
+
+ERR_EXIT:
+    perror("pwrite");
+    close(fd);
+    return -1;
+}
+
+static void *seed_worker(void *arg) {
+    seed_ctx_t *ctx = (seed_ctx_t *)arg;
+    char seed_name[PATH_MAX];
+    unsigned int state;
+    uint32_t num;
+    uint64_t off;
+    size_t len;
+    uint8_t saved[8];
+    char option;
+
+    /* every worker owns a private copy of the template */
+    uint8_t *buf = malloc(ctx->size);
+    if (!buf) {
+        return NULL;
+    }
+    memcpy(buf, ctx->tmpl, ctx->size);
+    state = time(NULL) ^ (uintptr_t)&state;
+
+    while (1) {
+        pthread_mutex_lock(&ctx->lock);
+        num = ctx->next++;
+        pthread_mutex_unlock(&ctx->lock);
+        if (num >= ctx->count) {
+            break;
+        }
+
+        /* mutate, write, and then restore the template bytes */
+        option = mutate_field(ctx, buf, &state, &off, &len);
+        memcpy(saved, ctx->tmpl + off, len);
+        /* the length of base_name is checked by gen_seeds */
+        if (snprintf(seed_name, sizeof(seed_name), "%s_%c_%05u", ctx->base_name, option, num) >= sizeof(seed_name) ||
+            write_seed(ctx, seed_name, buf, off, len)) {
+            pthread_mutex_lock(&ctx->lock);
+            ctx->failed++;
+            pthread_mutex_unlock(&ctx->lock);
+        }
+        memcpy(buf + off, saved, len);
+    }
+
+    free(buf);
+    return NULL;
+}
+
+/**
+ * @brief 生成ELF变异种子，模板只映射一次，变异在内存中完成，多线程写出
+ * generate ELF seeds for fuzzing. the template is mapped once,
+ * fields are mutated in memory and the seeds are written by multiple threads
+ * @param elf_name template elf file name
+ * @param po which tables to mutate [-H|S|P|B|D|R|L], all tables by default
+ * @param count seed number
+ * @param out_dir output directory, NULL means the directory of template
+ * @return int error code {-1:error,0:sucess}
+ */
+int gen_seeds(char *elf_name, parser_opt_t *po, uint32_t count, char *out_dir) {
+    seed_ctx_t ctx;
+    pthread_t threads[SEED_MAX_THREADS];
+    struct stat st;
+    int thread_num;
+    int i;
+    int probe_fd;
+    int len;
+    char probe_name[PATH_MAX];
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.elf_name = elf_name;
+    ctx.out_dir = (out_dir && strlen(out_dir)) ? out_dir : NULL;
+    ctx.count = count ? count : SEED_DEFAULT_NUM;
+
+    /* reject output paths that leave no room for the seed suffix */
+    if (ctx.out_dir) {
+        char *p = strrchr(elf_name, '/');
+        len = snprintf(ctx.base_name, sizeof(ctx.base_name), "%s/%s", ctx.out_dir, p ? p + 1 : elf_name);
+    } else {
+        len = snprintf(ctx.base_name, sizeof(ctx.base_name), "%s", elf_name);
+    }
+    if (len < 0 || len + SEED_SUFFIX_LEN >= sizeof(ctx.base_name)) {
+        ERROR("output path is too long\n");
+        return -1;
+    }
+    pthread_mutex_init(&ctx.lock, NULL);
+
+    ctx.tmpl_fd = open(elf_name, O_RDONLY);
+    if (ctx.tmpl_fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    if (fstat(ctx.tmpl_fd, &st) < 0) {
+        perror("fstat");
+        close(ctx.tmpl_fd);
+        return -1;
+    }
+
+    ctx.size = st.st_size;
+    ctx.tmpl = mmap(0, ctx.size, PROT_READ, MAP_PRIVATE, ctx.tmpl_fd, 0);
+    if (ctx.tmpl == MAP_FAILED) {
+        perror("mmap");
+        close(ctx.tmpl_fd);
+        return -1;
+    }
+
+    ctx.class = ctx.size > EI_CLASS ? ctx.tmpl[EI_CLASS] : ELFCLASSNONE;
+    if ((ctx.class != ELFCLASS32 || ctx.size < sizeof(Elf32_Ehdr)) &&
+        (ctx.class != ELFCLASS64 || ctx.size < sizeof(Elf64_Ehdr))) {
+        ERROR("invalid ELF class\n");
+        goto ERR_EXIT;
+    }
+
+    if (!collect_tables(&ctx, po)) {
+        ERROR("no table to mutate\n");
+        goto ERR_EXIT;
+    }
+
+    /* probe reflink support once, then every seed uses the same path */
+    if (ctx.out_dir)
+        len = snprintf(probe_name, sizeof(probe_name), "%s/.elfspirit_reflink", ctx.out_dir);
+    else
+        len = snprintf(probe_name, sizeof(probe_name), "%s.reflink", elf_name);
+    probe_fd = len < sizeof(probe_name) ? open(probe_name, O_RDWR | O_CREAT | O_TRUNC, 0600) : -1;
+    if (probe_fd >= 0) {
+        ctx.reflink = !reflink_file(ctx.tmpl_fd, probe_fd);
+        close(probe_fd);
+        unlink(probe_name);
+    }
+
+    thread_num = sysconf(_SC_NPROCESSORS_ONLN);
+    if (thread_num < 1)
+        thread_num = 1;
+    if (thread_num > SEED_MAX_THREADS)
+        thread_num = SEED_MAX_THREADS;
+    if (thread_num > ctx.count)
+        thread_num = ctx.count;
+
+    for (i = 0; i < thread_num; i++) {
+        if (pthread_create(&threads[i], NULL, seed_worker, &ctx)) {
+            thread_num = i;
+            break;
+        }
+    }
+    /* the main thread always works, even if no thread was created */
+    seed_worker(&ctx);
+    for (i = 0; i < thread_num; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    INFO("generate %u seeds from %d tables (%s)\n", ctx.count - ctx.failed, ctx.table_num, ctx.reflink ? "reflink" : "copy");
+    if (ctx.failed) {
+        ERROR("%u seeds could not be written\n", ctx.failed);
+        goto ERR_EXIT;
+    }
+    munmap(ctx.tmpl, ctx.size);
+    close(ctx.tmpl_fd);
+    pthread_mutex_destroy(&ctx.lock);
+    return 0;
+
+ERR_EXIT:
+    munmap(ctx.tmpl, ctx.size);
+    close(ctx.tmpl_fd);
+    pthread_mutex_destroy(&ctx.lock);
+    return -1;
+}
@@ -0,0 +1,38 @@
+/*
+ MIT License
+ 
+ Copyright (c) 2025 SecNotes
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+/* default seed number, the same as seeds.py */
+#define SEED_DEFAULT_NUM 100
+
+/**
+ * @brief 生成ELF变异种子，模板只映射一次，变异在内存中完成，多线程写出
+ * generate ELF seeds for fuzzing. the template is mapped once,
+ * fields are mutated in memory and the seeds are written by multiple threads
+ * @param elf_name template elf file name
+ * @param po which tables to mutate [-H|S|P|B|D|R|L], all tables by default
+ * @param count seed number
+ * @param out_dir output directory, NULL means the directory of template
+ * @return int error code {-1:error,0:sucess}
+ */
+int gen_seeds(char *elf_name, parser_opt_t *po, uint32_t count, char *out_dir);
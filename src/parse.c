@@ -23,6 +23,7 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <elf.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -31,13 +32,24 @@
 #include <stdarg.h>
 #include "common.h"
 #include "parse.h"
+#include "relr.h"
+#include "vimage.h"
+#include "render.h"
+#include "filter.h"
+#include "hashmap.h"
+#include "demangle.h"
+#include "version.h"
 
 #define PRINT_HEADER_EXP(Nr, key, value, explain) printf ("    [%2d] %-20s %10p (%s)\n", Nr, key, value, explain)
 #define PRINT_HEADER(Nr, key, value) printf ("    [%2d] %-20s %10p\n", Nr, key, value)
 /* print section header table */
-#define PRINT_SECTION(Nr, name, type, addr, off, size, es, flg, lk, inf, al) \
-    printf("    [%2d] %-15s %-15s %08x %06x %06x %02x %4s %3u %3u %3u\n", \
-    Nr, name, type, addr, off, size, es, flg, lk, inf, al)
+#define PRINT_SECTION(Nr, name, type, addr, off, size, es, flg, lk, inf, al) do { \
+    render_nr(Nr); render_str(name, -15); render_str(" ", 0); render_str(type, -15); \
+    render_str(" ", 0); render_hex(addr, 8); render_str(" ", 0); render_hex(off, 6); \
+    render_str(" ", 0); render_hex(size, 6); render_str(" ", 0); render_hex(es, 2); \
+    render_str(" ", 0); render_str(flg, 4); render_str(" ", 0); render_num(lk, 10, 3); \
+    render_str(" ", 0); render_num(inf, 10, 3); render_str(" ", 0); render_num(al, 10, 3); \
+    render_str("\n", 0); } while (0)
 #define PRINT_SECTION_TITLE(Nr, name, type, addr, off, size, es, flg, lk, inf, al) \
     printf("    [%2s] %-15s %-15s %8s %6s %6s %2s %4s %3s %3s %3s\n", \
     Nr, name, type, addr, off, size, es, flg, lk, inf, al)
@@ -51,9 +63,11 @@
     Nr, type, offset, virtaddr, physaddr, filesiz, memsiz, flg, align)
 
 /* print dynamic symbol table*/
-#define PRINT_DYNSYM(Nr, value, size, type, bind, vis, ndx, name) \
-    printf("    [%2d] %08x %4d %-8s %-8s %-8s %4d %-20s\n", \
-    Nr, value, size, type, bind, vis, ndx, name)
+#define PRINT_DYNSYM(Nr, value, size, type, bind, vis, ndx, name) do { \
+    render_nr(Nr); render_hex(value, 8); render_str(" ", 0); render_num(size, 10, 4); \
+    render_str(" ", 0); render_str(type, -8); render_str(" ", 0); render_str(bind, -8); \
+    render_str(" ", 0); render_str(vis, -8); render_str(" ", 0); render_num(ndx, 10, 4); \
+    render_str(" ", 0); render_str(name, -20); render_str("\n", 0); } while (0)
 #define PRINT_DYNSYM_TITLE(Nr, value, size, type, bind, vis, ndx, name) \
     printf("    [%2s] %8s %4s %-8s %-8s %-8s %4s %-20s\n", \
     Nr, value, size, type, bind, vis, ndx, name)
@@ -67,9 +81,10 @@
     Nr, tag, type, value);
 
 /* print .rela */
-#define PRINT_RELA(Nr, offset, info, type, value, name) \
-    printf("    [%2d] %016x %016x %-18s %-10x %-16s\n", \
-    Nr, offset, info, type, value, name);
+#define PRINT_RELA(Nr, offset, info, type, value, name) do { \
+    render_nr(Nr); render_hex(offset, 16); render_str(" ", 0); render_hex(info, 16); \
+    render_str(" ", 0); render_str(type, -18); render_str(" ", 0); render_num(value, 16, -10); \
+    render_str(" ", 0); render_str(name, -16); render_str("\n", 0); } while (0)
 #define PRINT_RELA_TITLE(Nr, offset, info, type, value, name) \
     printf("    [%2s] %-16s %-16s %-18s %-10s %-16s\n", \
     Nr, offset, info, type, value, name);
@@ -83,7 +98,7 @@
     Nr, value, name);
 
 #define PRINT_POINTER64(Nr, value, name) \
-    printf("    [%2d] %016x %-16s\n", \
+    printf("    [%2d] %016lx %-16s\n", \
     Nr, value, name);
 #define PRINT_POINTER64_TITLE(Nr, value, name) \
     printf("    [%2s] %-016s %-16s\n", \
@@ -138,6 +153,17 @@ struct ElfData g_symtab;
 struct ElfData g_secname;
 struct ElfData g_relplt;
 uint32_t g_strlength;
+uint64_t g_base;
+/* row filter of the symbol and relocation tables, NULL shows all rows */
+static filter_t *g_filter;
+static filter_t s_filter;
+/* cache of demangled C++ names, NULL shows mangled names */
+static demangle_cache_t *g_demangle;
+static demangle_cache_t s_demangle;
+/* rows shown by --range */
+static int g_ranged;
+static uint64_t g_range_start;
+static uint64_t g_range_count;
 
 void static init() {
     memset(&g_dynsym, 0, sizeof(struct ElfData));
@@ -145,6 +171,50 @@ void static init() {
     memset(&g_secname, 0, sizeof(struct ElfData));
     memset(&g_relplt, 0, sizeof(struct ElfData));
     g_strlength = 0;
+    g_base = 0;
+}
+
+/* a name filter matches the mangled or the demangled name */
+static int filter_symbol(char *name, char *demangled, char *type, char *bind, char *vis, uint64_t ndx, uint64_t value, uint64_t size) {
+    filter_row_t row = {name, type, bind, vis, NULL, ndx, value, size,
+                        FILTER_HAS_NDX | FILTER_HAS_ADDR | FILTER_HAS_SIZE};
+    if (match_filter(g_filter, &row)) {
+        return 1;
+    }
+    row.name = demangled;
+    return demangled && match_filter(g_filter, &row);
+}
+
+static int filter_reloc(char *name, char *type, uint64_t offset) {
+    filter_row_t row = {name, NULL, NULL, NULL, type, 0, offset, 0, FILTER_HAS_ADDR};
+    return match_filter(g_filter, &row);
+}
+
+/**
+ * @brief 得到--range指定的表格行[first, last)，表项大小固定，直接定位到起始行
+ * get the rows [first, last) of a table given by --range. the records have a
+ * fixed size, so the scan starts at the first row
+ * @param count number of rows
+ * @param is_display the table is shown, otherwise all rows are scanned
+ * @param first output, first row
+ * @param last output, end of the rows
+ * @return int {0:all rows,1:sliced}
+ */
+static int get_range(size_t count, int is_display, size_t *first, size_t *last) {
+    *first = 0;
+    *last = count;
+    if (!is_display || !g_ranged) {
+        return 0;
+    }
+    *first = g_range_start < count ? g_range_start : count;
+    if (g_range_count && g_range_count < count - *first)
+        *last = *first + g_range_count;
+    return 1;
+}
+
+/* symbol of a relocation, .o files only have .symtab */
+static char *get_reloc_sym_name(int index) {
+    return strlen(g_dynsym.name[index]) ? g_dynsym.name[index] : g_symtab.name[index];
 }
 
 /**
@@ -1740,14 +1810,16 @@ static void display_section32(handle_t32 *h, int is_display) {
         PRINT_SECTION_TITLE("Nr", "Name", "Type", "Addr", "Off", "Size", "Es", "Flg", "Lk", "Inf", "Al");
     }
 
-    for (int i = 0; i < h->ehdr->e_shnum; i++) {
+    size_t first, last;
+    int sliced = get_range(h->ehdr->e_shnum, is_display, &first, &last);
+    for (int i = first; i < last; i++) {
         name = h->mem + h->shstrtab->sh_offset + h->shdr[i].sh_name;
         if (validated_offset(name, h->mem, h->mem + h->size)) {
             ERROR("Corrupt file format\n");
             exit(-1);
         }
         /* store section name */
-        if (i < STR_NUM && strlen(name) < STR_LENGTH){
+        if (!sliced && i < STR_NUM && strlen(name) < STR_LENGTH){
             g_secname.count++;
             strcpy(g_secname.name[i], name);
         }
@@ -1842,14 +1914,16 @@ static void display_section64(handle_t64 *h, int is_display) {
         PRINT_SECTION_TITLE("Nr", "Name", "Type", "Addr", "Off", "Size", "Es", "Flg", "Lk", "Inf", "Al");
     }
     
-    for (int i = 0; i < h->ehdr->e_shnum; i++) {
+    size_t first, last;
+    int sliced = get_range(h->ehdr->e_shnum, is_display, &first, &last);
+    for (int i = first; i < last; i++) {
         name = h->mem + h->shstrtab->sh_offset + h->shdr[i].sh_name;
         if (validated_offset(name, h->mem, h->mem + h->size)) {
             ERROR("Corrupt file format\n");
             exit(-1);
         }
         /* store section name */
-        if (i < STR_NUM && strlen(name) < STR_LENGTH){
+        if (!sliced && i < STR_NUM && strlen(name) < STR_LENGTH){
             g_secname.count++;
             strcpy(g_secname.name[i], name);
         }
@@ -1946,7 +2020,9 @@ static void display_segment32(handle_t32 *h) {
     char flag[4];
     INFO("Program Header Table\n");
     PRINT_PROGRAM_TITLE("Nr", "Type", "Offset", "Virtaddr", "Physaddr", "Filesiz", "Memsiz", "Flg", "Align");
-    for (int i = 0; i < h->ehdr->e_phnum; i++) {
+    size_t first, last;
+    get_range(h->ehdr->e_phnum, 1, &first, &last);
+    for (int i = first; i < last; i++) {
         switch (h->phdr[i].p_type) {
             case PT_NULL:
                 tmp = "PT_NULL";
@@ -1999,7 +2075,7 @@ static void display_segment32(handle_t32 *h) {
     }
 
     INFO("Section to segment mapping\n");
-    for (int i = 0; i < h->ehdr->e_phnum; i++) {
+    for (int i = first; i < last; i++) {
         printf("    [%2d]", i);
         for (int j = 0; j < h->ehdr->e_shnum; j++) {
             name = h->mem + h->shstrtab->sh_offset + h->shdr[j].sh_name;
@@ -2021,7 +2097,9 @@ static void display_segment64(handle_t64 *h) {
     char flag[4];
     INFO("Program Header Table\n");
     PRINT_PROGRAM_TITLE("Nr", "Type", "Offset", "Virtaddr", "Physaddr", "Filesiz", "Memsiz", "Flg", "Align");
-    for (int i = 0; i < h->ehdr->e_phnum; i++) {
+    size_t first, last;
+    get_range(h->ehdr->e_phnum, 1, &first, &last);
+    for (int i = first; i < last; i++) {
         switch (h->phdr[i].p_type) {
             case PT_NULL:
                 tmp = "PT_NULL";
@@ -2074,7 +2152,7 @@ static void display_segment64(handle_t64 *h) {
     }
 
     INFO("Section to segment mapping\n");
-    for (int i = 0; i < h->ehdr->e_phnum; i++) {
+    for (int i = first; i < last; i++) {
         printf("    [%2d]", i);
         for (int j = 0; j < h->ehdr->e_shnum; j++) {
             name = h->mem + h->shstrtab->sh_offset + h->shdr[j].sh_name;
@@ -2107,6 +2185,13 @@ void display_dynsym32(handle_t32 *h, char *section_name, char *str_tab, int is_d
     int dynsym_index = 0;
     size_t count;
     Elf32_Sym *sym;
+    char *demangled = NULL;
+    char demangled_buf[STR_LENGTH];
+    version_index_t vers;
+    int has_version = 0;
+    int hidden;
+    char *version;
+    char version_buf[STR_LENGTH];
 
     for (int i = 0; i < h->ehdr->e_shnum; i++) {
         name = h->mem + h->shstrtab->sh_offset + h->shdr[i].sh_name;
@@ -2148,8 +2233,26 @@ void display_dynsym32(handle_t32 *h, char *section_name, char *str_tab, int is_d
 
     if (!strcmp(section_name, name)) {
         sym = (Elf32_Sym *)&h->mem[h->shdr[dynsym_index].sh_offset];
+        /* only .dynsym is covered by .gnu.version */
+        if (is_display && !strcmp(".dynsym", section_name))
+            has_version = !init_version_index(h->mem, h->size, &vers);
         count = h->shdr[dynsym_index].sh_size / sizeof(Elf32_Sym);
-        for(int i = 0; i < count; i++) {
+        /* only the names of the first STR_NUM symbols are stored */
+        size_t first, last;
+        int sliced = get_range(count, is_display, &first, &last);
+        if (!is_display && last > STR_NUM)
+            last = STR_NUM;
+        /* demangle the shown names in parallel before the rows are printed */
+        if (is_display && g_demangle && last > first) {
+            uint64_t *offsets = malloc((last - first) * sizeof(uint64_t));
+            if (offsets) {
+                for (size_t i = first; i < last; i++)
+                    offsets[i - first] = h->shdr[dynstr_index].sh_offset + sym[i].st_name;
+                demangle_prefetch(g_demangle, h->mem, h->size, offsets, last - first);
+                free(offsets);
+            }
+        }
+        for(int i = first; i < last; i++) {
             switch (ELF32_ST_TYPE(sym[i].st_info))
             {
                 case STT_NOTYPE:
@@ -2268,24 +2371,46 @@ void display_dynsym32(handle_t32 *h, char *section_name, char *str_tab, int is_d
             }
             name = h->mem + h->shdr[dynstr_index].sh_offset + sym[i].st_name;
             /* store */
-            if (!strcmp(".symtab", section_name) && i < STR_NUM && strlen(name) < STR_LENGTH) {
+            if (!sliced && !strcmp(".symtab", section_name) && i < STR_NUM && strlen(name) < STR_LENGTH) {
                 g_symtab.count++;
                 g_symtab.value[i] = sym[i].st_value;
                 strcpy(g_symtab.name[i], name);
             } 
-            else if (!strcmp(".dynsym", section_name) &&  i < STR_NUM && strlen(name) < STR_LENGTH){
+            else if (!sliced && !strcmp(".dynsym", section_name) && i < STR_NUM && strlen(name) < STR_LENGTH){
                 g_dynsym.count++;
                 g_dynsym.value[i] = sym[i].st_value;
                 strcpy(g_dynsym.name[i], name);
             }
+            if (!is_display) {
+                continue;
+            }
+            if (g_demangle) {
+                demangled = demangle_get(g_demangle, h->mem, h->size, h->shdr[dynstr_index].sh_offset + sym[i].st_name);
+            }
+            /* filter before the row is formatted */
+            if (!filter_symbol(name, demangled, type, bind, other, sym[i].st_shndx, sym[i].st_value, sym[i].st_size)) {
+                continue;
+            }
+            /* the cached name is not truncated in place */
+            if (demangled) {
+                snprintf(demangled_buf, sizeof(demangled_buf), "%s", demangled);
+                name = demangled_buf;
+            }
+            /* append the version like readelf, e.g. memcpy@GLIBC_2.14 */
+            if (has_version && (version = get_symbol_version(&vers, i, &hidden))) {
+                snprintf(version_buf, sizeof(version_buf), "%s%s%s", name, \
+                    hidden || sym[i].st_shndx == SHN_UNDEF ? "@" : "@@", version);
+                name = version_buf;
+            }
             /* hide long strings */
             if (strlen(name) > g_strlength) {
                 strcpy(&name[g_strlength - 6], "[...]");
             }
-            if (is_display)
             PRINT_DYNSYM(i, sym[i].st_value, sym[i].st_size, type, bind, \
                 other, sym[i].st_shndx, name);
         }
+        if (has_version)
+            finit_version_index(&vers);
     }
 }
 
@@ -2306,6 +2431,13 @@ void display_dynsym64(handle_t64 *h, char *section_name, char *str_tab, int is_d
     int dynsym_index = 0;
     size_t count;
     Elf64_Sym *sym;
+    char *demangled = NULL;
+    char demangled_buf[STR_LENGTH];
+    version_index_t vers;
+    int has_version = 0;
+    int hidden;
+    char *version;
+    char version_buf[STR_LENGTH];
 
     for (int i = 0; i < h->ehdr->e_shnum; i++) {
         name = h->mem + h->shstrtab->sh_offset + h->shdr[i].sh_name;
@@ -2347,8 +2479,26 @@ void display_dynsym64(handle_t64 *h, char *section_name, char *str_tab, int is_d
 
     if (!strcmp(section_name, name)) {
         sym = (Elf64_Sym *)&h->mem[h->shdr[dynsym_index].sh_offset];
+        /* only .dynsym is covered by .gnu.version */
+        if (is_display && !strcmp(".dynsym", section_name))
+            has_version = !init_version_index(h->mem, h->size, &vers);
         count = h->shdr[dynsym_index].sh_size / sizeof(Elf64_Sym);
-        for(int i = 0; i < count; i++) {
+        /* only the names of the first STR_NUM symbols are stored */
+        size_t first, last;
+        int sliced = get_range(count, is_display, &first, &last);
+        if (!is_display && last > STR_NUM)
+            last = STR_NUM;
+        /* demangle the shown names in parallel before the rows are printed */
+        if (is_display && g_demangle && last > first) {
+            uint64_t *offsets = malloc((last - first) * sizeof(uint64_t));
+            if (offsets) {
+                for (size_t i = first; i < last; i++)
+                    offsets[i - first] = h->shdr[dynstr_index].sh_offset + sym[i].st_name;
+                demangle_prefetch(g_demangle, h->mem, h->size, offsets, last - first);
+                free(offsets);
+            }
+        }
+        for(int i = first; i < last; i++) {
             switch (ELF64_ST_TYPE(sym[i].st_info))
             {
                 case STT_NOTYPE:
@@ -2467,24 +2617,46 @@ void display_dynsym64(handle_t64 *h, char *section_name, char *str_tab, int is_d
             }
             name = h->mem + h->shdr[dynstr_index].sh_offset + sym[i].st_name;
             /* store */
-            if (!strcmp(".symtab", section_name) && i < STR_NUM && strlen(name) < STR_LENGTH) {
+            if (!sliced && !strcmp(".symtab", section_name) && i < STR_NUM && strlen(name) < STR_LENGTH) {
                 g_symtab.count++;
                 g_symtab.value[i] = sym[i].st_value;
                 strcpy(g_symtab.name[i], name);
             } 
-            else if (!strcmp(".dynsym", section_name) &&  i < STR_NUM && strlen(name) < STR_LENGTH){
+            else if (!sliced && !strcmp(".dynsym", section_name) && i < STR_NUM && strlen(name) < STR_LENGTH){
                 g_dynsym.count++;
                 g_dynsym.value[i] = sym[i].st_value;
                 strcpy(g_dynsym.name[i], name);
             }
+            if (!is_display) {
+                continue;
+            }
+            if (g_demangle) {
+                demangled = demangle_get(g_demangle, h->mem, h->size, h->shdr[dynstr_index].sh_offset + sym[i].st_name);
+            }
+            /* filter before the row is formatted */
+            if (!filter_symbol(name, demangled, type, bind, other, sym[i].st_shndx, sym[i].st_value, sym[i].st_size)) {
+                continue;
+            }
+            /* the cached name is not truncated in place */
+            if (demangled) {
+                snprintf(demangled_buf, sizeof(demangled_buf), "%s", demangled);
+                name = demangled_buf;
+            }
+            /* append the version like readelf, e.g. memcpy@GLIBC_2.14 */
+            if (has_version && (version = get_symbol_version(&vers, i, &hidden))) {
+                snprintf(version_buf, sizeof(version_buf), "%s%s%s", name, \
+                    hidden || sym[i].st_shndx == SHN_UNDEF ? "@" : "@@", version);
+                name = version_buf;
+            }
             /* hide long strings */
             if (strlen(name) > g_strlength) {
                 strcpy(&name[g_strlength - 6], "[...]");
             }
-            if (is_display)
             PRINT_DYNSYM(i, sym[i].st_value, sym[i].st_size, type, bind, \
                 other, sym[i].st_shndx, name);
         }
+        if (has_version)
+            finit_version_index(&vers);
     }
 }
 
@@ -2711,6 +2883,18 @@ static void display_dyninfo32(handle_t32 *h) {
             case DT_SYMTAB_SHNDX:
                 tmp = "DT_SYMTAB_SHNDX";
                 break;
+
+            case DT_RELRSZ:
+                tmp = "DT_RELRSZ";
+                break;
+
+            case DT_RELR:
+                tmp = "DT_RELR";
+                break;
+
+            case DT_RELRENT:
+                tmp = "DT_RELRENT";
+                break;
             
             case DT_NUM:
                 tmp = "DT_NUM";
@@ -3111,6 +3295,18 @@ static void display_dyninfo64(handle_t64 *h) {
             case DT_SYMTAB_SHNDX:
                 tmp = "DT_SYMTAB_SHNDX";
                 break;
+
+            case DT_RELRSZ:
+                tmp = "DT_RELRSZ";
+                break;
+
+            case DT_RELR:
+                tmp = "DT_RELR";
+                break;
+
+            case DT_RELRENT:
+                tmp = "DT_RELRENT";
+                break;
             
             case DT_NUM:
                 tmp = "DT_NUM";
@@ -3342,7 +3538,9 @@ static int display_rel32(handle_t32 *h, char *section_name, int is_display) {
         PRINT_RELA_TITLE("Nr", "Addr", "Info", "Type", "Sym.Index", "Sym.Name");
     }
 
-    for (int i = 0; i < count; i++) {
+    size_t first, last;
+    int sliced = get_range(count, is_display, &first, &last);
+    for (int i = first; i < last; i++) {
         switch (ELF32_R_TYPE(rel_section[i].r_info))
         {
             case R_X86_64_NONE:
@@ -3518,7 +3716,7 @@ static int display_rel32(handle_t32 *h, char *section_name, int is_display) {
         }
         
         str_index = ELF32_R_SYM(rel_section[i].r_info);
-        if (is_display) {
+        if (is_display && filter_reloc(get_reloc_sym_name(str_index), type, rel_section[i].r_offset)) {
             if (strlen(g_dynsym.name[str_index]) == 0) {
                 /* .o file .rel.text */
                 PRINT_RELA(i, rel_section[i].r_offset, rel_section[i].r_info, type, str_index, g_symtab.name[str_index]);
@@ -3526,7 +3724,7 @@ static int display_rel32(handle_t32 *h, char *section_name, int is_display) {
                 PRINT_RELA(i, rel_section[i].r_offset, rel_section[i].r_info, type, str_index, g_dynsym.name[str_index]); 
         }
 
-        if (i < STR_NUM && !strcmp(section_name, ".rel.plt")){
+        if (!sliced && i < STR_NUM && !strcmp(section_name, ".rel.plt")){
             g_relplt.count++;
             g_relplt.value[i] = rel_section[i].r_offset;
         }
@@ -3577,7 +3775,9 @@ static int display_rel64(handle_t64 *h, char *section_name) {
     count = h->shdr[rela_dyn_index].sh_size / sizeof(Elf64_Rel);
     INFO("Relocation section '%s' at offset 0x%x contains %d entries:\n", section_name, h->shdr[rela_dyn_index].sh_offset, count);
     PRINT_RELA_TITLE("Nr", "Addr", "Info", "Type", "Sym.Index", "Sym.Name");
-    for (int i = 0; i < count; i++) {
+    size_t first, last;
+    get_range(count, 1, &first, &last);
+    for (int i = first; i < last; i++) {
         switch (ELF64_R_TYPE(rel_section[i].r_info))
         {
             case R_X86_64_NONE:
@@ -3753,6 +3953,9 @@ static int display_rel64(handle_t64 *h, char *section_name) {
         }
         
         str_index = ELF64_R_SYM(rel_section[i].r_info);
+        if (!filter_reloc(get_reloc_sym_name(str_index), type, rel_section[i].r_offset)) {
+            continue;
+        }
         if (strlen(g_dynsym.name[str_index]) == 0) {
             /* .o file .rel.text */
             PRINT_RELA(i, rel_section[i].r_offset, rel_section[i].r_info, type, str_index, g_symtab.name[str_index]);
@@ -3805,7 +4008,9 @@ static int display_rela32(handle_t32 *h, char *section_name) {
     count = h->shdr[rela_dyn_index].sh_size / sizeof(Elf32_Rela);
     INFO("Relocation section '%s' at offset 0x%x contains %d entries:\n", section_name, h->shdr[rela_dyn_index].sh_offset, count);
     PRINT_RELA_TITLE("Nr", "Addr", "Info", "Type", "Sym.Index", "Sym.Name + Addend");
-    for (int i = 0; i < count; i++) {
+    size_t first, last;
+    get_range(count, 1, &first, &last);
+    for (int i = first; i < last; i++) {
         switch (ELF32_R_TYPE(rela_dyn[i].r_info))
         {
             case R_X86_64_NONE:
@@ -3981,6 +4186,9 @@ static int display_rela32(handle_t32 *h, char *section_name) {
         }
         
         str_index = ELF32_R_SYM(rela_dyn[i].r_info);
+        if (!filter_reloc(get_reloc_sym_name(str_index), type, rela_dyn[i].r_offset)) {
+            continue;
+        }
         if (strlen(g_dynsym.name[str_index]) == 0) {
             /* .rela.dyn */
             if (str_index == 0) {
@@ -4047,7 +4255,9 @@ static int display_rela64(handle_t64 *h, char *section_name, int is_display) {
         PRINT_RELA_TITLE("Nr", "Addr", "Info", "Type", "Sym.Index", "Sym.Name + Addend");
     }
 
-    for (int i = 0; i < count; i++) {
+    size_t first, last;
+    int sliced = get_range(count, is_display, &first, &last);
+    for (int i = first; i < last; i++) {
         switch (ELF64_R_TYPE(rela_dyn[i].r_info))
         {
             case R_X86_64_NONE:
@@ -4223,31 +4433,138 @@ static int display_rela64(handle_t64 *h, char *section_name, int is_display) {
         }
         
         str_index = ELF64_R_SYM(rela_dyn[i].r_info);
-        if (strlen(g_dynsym.name[str_index]) == 0) {
-            /* .rela.dyn */
-            if (str_index == 0) {
-                snprintf(name, STR_LENGTH, "%x", rela_dyn[i].r_addend);
-            } 
-            /* .o file .rela.text */
-            else {
-                snprintf(name, STR_LENGTH, "%s %d", g_symtab.name[str_index], rela_dyn[i].r_addend);
+        if (is_display && filter_reloc(get_reloc_sym_name(str_index), type, rela_dyn[i].r_offset)) {
+            if (strlen(g_dynsym.name[str_index]) == 0) {
+                /* .rela.dyn */
+                if (str_index == 0) {
+                    snprintf(name, STR_LENGTH, "%x", rela_dyn[i].r_addend);
+                } 
+                /* .o file .rela.text */
+                else {
+                    snprintf(name, STR_LENGTH, "%s %d", g_symtab.name[str_index], rela_dyn[i].r_addend);
+                }
             }
-        }
-        /* .rela.plt */
-        else if (rela_dyn[i].r_addend >= 0)
-            snprintf(name, STR_LENGTH, "%s + %d", g_dynsym.name[str_index], rela_dyn[i].r_addend);
-        else
-            snprintf(name, STR_LENGTH, "%s %d", g_dynsym.name[str_index], rela_dyn[i].r_addend);
-        if (is_display)
+            /* .rela.plt */
+            else if (rela_dyn[i].r_addend >= 0)
+                snprintf(name, STR_LENGTH, "%s + %d", g_dynsym.name[str_index], rela_dyn[i].r_addend);
+            else
+                snprintf(name, STR_LENGTH, "%s %d", g_dynsym.name[str_index], rela_dyn[i].r_addend);
             PRINT_RELA(i, rela_dyn[i].r_offset, rela_dyn[i].r_info, type, str_index, name);
+        }
     
-        if (i < STR_NUM && !strcmp(section_name, ".rela.plt")){
+        if (!sliced && i < STR_NUM && !strcmp(section_name, ".rela.plt")){
             g_relplt.count++;
             g_relplt.value[i] = rela_dyn[i].r_offset;
         }
     }
 }
 
+/**
+ * @brief 显示DT_RELR表中的重定位，RELR没有对应的节，通过dynamic段查找
+ * show the relocations packed in DT_RELR, which is found by the dynamic segment
+ * because no section describes it
+ * @param h elf file handle struct
+ * @return int error code {-1:error,0:sucess}
+ */
+static int display_relr32(handle_t32 *h) {
+    Elf32_Dyn *dyn = NULL;
+    size_t dyn_c = 0;
+    uint64_t relr = 0, relrsz = 0, offset;
+    uint64_t *addrs;
+    size_t count;
+    char value[32];
+
+    for (int i = 0; i < h->ehdr->e_phnum; i++) {
+        if (h->phdr[i].p_type == PT_DYNAMIC) {
+            dyn = (Elf32_Dyn *)(h->mem + h->phdr[i].p_offset);
+            dyn_c = h->phdr[i].p_filesz / sizeof(Elf32_Dyn);
+        }
+    }
+    for (int i = 0; i < dyn_c && dyn[i].d_tag != DT_NULL; i++) {
+        if (dyn[i].d_tag == DT_RELR)
+            relr = dyn[i].d_un.d_ptr;
+        if (dyn[i].d_tag == DT_RELRSZ)
+            relrsz = dyn[i].d_un.d_val;
+    }
+    if (!relr) {
+        return -1;
+    }
+    if (load_addr_to_offset(&h->loads, relr, relrsz, &offset) || decode_relr(h->mem + offset, relrsz, 4, &addrs, &count)) {
+        ERROR("Corrupt file format\n");
+        return -1;
+    }
+
+    INFO("Relocation table DT_RELR at offset 0x%x contains %d entries:\n", offset, count);
+    PRINT_POINTER32_TITLE("Nr", "Addr", "Addend");
+    size_t first, last;
+    get_range(count, 1, &first, &last);
+    for (int i = first; i < last; i++) {
+        uint64_t target;
+        if (!filter_reloc(NULL, NULL, addrs[i]))
+            continue;
+        if (load_addr_to_offset(&h->loads, addrs[i], 4, &target))
+            snprintf(value, sizeof(value), "-");
+        else
+            snprintf(value, sizeof(value), "0x%x", *(uint32_t *)(h->mem + target));
+        PRINT_POINTER32(i, addrs[i], value);
+    }
+    free(addrs);
+    return 0;
+}
+
+/**
+ * @brief 显示DT_RELR表中的重定位，RELR没有对应的节，通过dynamic段查找
+ * show the relocations packed in DT_RELR, which is found by the dynamic segment
+ * because no section describes it
+ * @param h elf file handle struct
+ * @return int error code {-1:error,0:sucess}
+ */
+static int display_relr64(handle_t64 *h) {
+    Elf64_Dyn *dyn = NULL;
+    size_t dyn_c = 0;
+    uint64_t relr = 0, relrsz = 0, offset;
+    uint64_t *addrs;
+    size_t count;
+    char value[32];
+
+    for (int i = 0; i < h->ehdr->e_phnum; i++) {
+        if (h->phdr[i].p_type == PT_DYNAMIC) {
+            dyn = (Elf64_Dyn *)(h->mem + h->phdr[i].p_offset);
+            dyn_c = h->phdr[i].p_filesz / sizeof(Elf64_Dyn);
+        }
+    }
+    for (int i = 0; i < dyn_c && dyn[i].d_tag != DT_NULL; i++) {
+        if (dyn[i].d_tag == DT_RELR)
+            relr = dyn[i].d_un.d_ptr;
+        if (dyn[i].d_tag == DT_RELRSZ)
+            relrsz = dyn[i].d_un.d_val;
+    }
+    if (!relr) {
+        return -1;
+    }
+    if (load_addr_to_offset(&h->loads, relr, relrsz, &offset) || decode_relr(h->mem + offset, relrsz, 8, &addrs, &count)) {
+        ERROR("Corrupt file format\n");
+        return -1;
+    }
+
+    INFO("Relocation table DT_RELR at offset 0x%x contains %d entries:\n", offset, count);
+    PRINT_POINTER64_TITLE("Nr", "Addr", "Addend");
+    size_t first, last;
+    get_range(count, 1, &first, &last);
+    for (int i = first; i < last; i++) {
+        uint64_t target;
+        if (!filter_reloc(NULL, NULL, addrs[i]))
+            continue;
+        if (load_addr_to_offset(&h->loads, addrs[i], 8, &target))
+            snprintf(value, sizeof(value), "-");
+        else
+            snprintf(value, sizeof(value), "0x%lx", *(uint64_t *)(h->mem + target));
+        PRINT_POINTER64(i, addrs[i], value);
+    }
+    free(addrs);
+    return 0;
+}
+
 /** 
  * @brief 显示ELF相关节包含的指针
  * display .init_array .finit_array .ctors .dtors	
@@ -4260,6 +4577,8 @@ static int display_pointer32(handle_t32 *h, int num, ...) {
     int index[10];
     int strtab_index = 0;
     size_t count = 0;
+    vimage_t v;
+    int has_view;
 
     for (int i = 0; i < 10; i++) {
         index[i] = 0;
@@ -4291,6 +4610,8 @@ static int display_pointer32(handle_t32 *h, int num, ...) {
         }
     }
 
+    has_view = !init_vimage(h->mem, h->size, g_base, VIMAGE_SYMBOL, &v);
+
     va_list args;
     va_start(args, num);
 
@@ -4306,26 +4627,35 @@ static int display_pointer32(handle_t32 *h, int num, ...) {
             INFO("%s section at offset 0x%x contains %d pointers:\n", section_name, offset, count);
             PRINT_POINTER32_TITLE("Nr", "Pointer", "Symbol");
             for (int i = 0; i < count; i++) {
-                if (strtab_index) {
-                    int find_sym = 0;
+                uint64_t value = addr[i];
+                char *sym_name = NULL;
+
+                // PIE的指针由重定位填写，从重定位后的视图中读取
+                // pointers of PIE are written by relocations, read them from the relocated view
+                if (has_view && h->shdr[index[j]].sh_flags & SHF_ALLOC) {
+                    vimage_read_word(&v, h->shdr[index[j]].sh_addr + i * sizeof(uint32_t), &value);
+                }
+                if (has_view) {
+                    sym_name = vimage_get_symbol(&v, h->shdr[index[j]].sh_addr + i * sizeof(uint32_t));
+                }
+                if (!sym_name && strtab_index) {
                     for (int k = 0; k < g_symtab.count; k++) {
-                        if (addr[i] == g_symtab.value[k]) {
-                            PRINT_POINTER32(i, addr[i], g_symtab.name[k]);
-                            find_sym = 1;
+                        if (value - g_base == g_symtab.value[k]) {
+                            sym_name = g_symtab.name[k];
                             break;
                         }
                     }
-                    if (!find_sym) {
-                        PRINT_POINTER32(i, addr[i], "0");
-                    }
-                } else {
-                    PRINT_POINTER32(i, addr[i], "0");
                 }
+                PRINT_POINTER32(i, (uint32_t)value, sym_name ? sym_name : "0");
             }
         }
     }
 
     va_end(args);
+    if (has_view) {
+        finit_vimage(&v);
+    }
+    return 0;
 }
 
 /** 
@@ -4340,6 +4670,8 @@ static int display_pointer64(handle_t64 *h, int num, ...) {
     int index[10];
     int strtab_index = 0;
     size_t count = 0;
+    vimage_t v;
+    int has_view;
 
     for (int i = 0; i < 10; i++) {
         index[i] = 0;
@@ -4371,6 +4703,8 @@ static int display_pointer64(handle_t64 *h, int num, ...) {
         }
     }
 
+    has_view = !init_vimage(h->mem, h->size, g_base, VIMAGE_SYMBOL, &v);
+
     va_list args;
     va_start(args, num);
 
@@ -4386,26 +4720,35 @@ static int display_pointer64(handle_t64 *h, int num, ...) {
             INFO("%s section at offset 0x%x contains %d pointers:\n", section_name, offset, count);
             PRINT_POINTER64_TITLE("Nr", "Pointer", "Symbol");
             for (int i = 0; i < count; i++) {
-                if (strtab_index) {
-                    int find_sym = 0;
+                uint64_t value = addr[i];
+                char *sym_name = NULL;
+
+                // PIE的指针由重定位填写，从重定位后的视图中读取
+                // pointers of PIE are written by relocations, read them from the relocated view
+                if (has_view && h->shdr[index[j]].sh_flags & SHF_ALLOC) {
+                    vimage_read_word(&v, h->shdr[index[j]].sh_addr + i * sizeof(uint64_t), &value);
+                }
+                if (has_view) {
+                    sym_name = vimage_get_symbol(&v, h->shdr[index[j]].sh_addr + i * sizeof(uint64_t));
+                }
+                if (!sym_name && strtab_index) {
                     for (int k = 0; k < g_symtab.count; k++) {
-                        if (addr[i] == g_symtab.value[k]) {
-                            PRINT_POINTER64(i, addr[i], g_symtab.name[k]);
-                            find_sym = 1;
+                        if (value - g_base == g_symtab.value[k]) {
+                            sym_name = g_symtab.name[k];
                             break;
                         }
                     }
-                    if (!find_sym) {
-                        PRINT_POINTER64(i, addr[i], "0");
-                    }
-                } else {
-                    PRINT_POINTER64(i, addr[i], "0");
                 }
+                PRINT_POINTER64(i, value, sym_name ? sym_name : "0");
             }
         }
     }
 
     va_end(args);
+    if (has_view) {
+        finit_vimage(&v);
+    }
+    return 0;
 }
 
 /**
@@ -4452,20 +4795,24 @@ int display_hash32(handle_t32 *h) {
     
     printf("    |-----------Bloom filter---------|\n");
     uint32_t *bloomfilter = hash->buckets;
+    size_t first, last;
     int i;
-    for (i = 0; i < hash->maskbits; i++) {
+    get_range(hash->maskbits, 1, &first, &last);
+    for (i = first; i < last; i++) {
         printf("    |           0x%08x           |\n", bloomfilter[i]);
     }
 
     printf("    |-----------Hash Buckets---------|\n");
-    uint32_t *buckets = &bloomfilter[i];
-    for (i = 0; i < hash->nbuckets; i++) {
+    uint32_t *buckets = &bloomfilter[hash->maskbits];
+    get_range(hash->nbuckets, 1, &first, &last);
+    for (i = first; i < last; i++) {
         printf("    |           0x%08x           |\n", buckets[i]);
     }
 
     printf("    |-----------Hash Chain-----------|\n");
-    uint32_t *value = &buckets[i];
-    for (i = 0; i < g_dynsym.count - hash->symndx; i++) {
+    uint32_t *value = &buckets[hash->nbuckets];
+    get_range(g_dynsym.count - hash->symndx, 1, &first, &last);
+    for (i = first; i < last; i++) {
         printf("    |           0x%08x           |\n", value[i]);
     }
     printf("    |--------------------------------|\n");
@@ -4515,21 +4862,31 @@ int display_hash64(handle_t64 *h) {
     
     printf("    |-----------Bloom filter---------|\n");
     uint64_t *bloomfilter = hash->buckets;
+    size_t first, last;
     int i;
-    for (i = 0; i < hash->maskbits; i++) {
-        printf("    |       0x%016x       |\n", bloomfilter[i]);
+    get_range(hash->maskbits, 1, &first, &last);
+    for (i = first; i < last; i++) {
+        render_str("    |       0x", 0);
+        render_hex(bloomfilter[i], 16);
+        render_str("       |\n", 0);
     }
 
     printf("    |-----------Hash Buckets---------|\n");
-    uint32_t *buckets = &bloomfilter[i];
-    for (i = 0; i < hash->nbuckets; i++) {
-        printf("    |           0x%08x           |\n", buckets[i]);
+    uint32_t *buckets = &bloomfilter[hash->maskbits];
+    get_range(hash->nbuckets, 1, &first, &last);
+    for (i = first; i < last; i++) {
+        render_str("    |           0x", 0);
+        render_hex(buckets[i], 8);
+        render_str("           |\n", 0);
     }
 
     printf("    |-----------Hash Chain-----------|\n");
-    uint32_t *value = &buckets[i];
-    for (i = 0; i < g_dynsym.count - hash->symndx; i++) {
-        printf("    |           0x%08x           |\n", value[i]);
+    uint32_t *value = &buckets[hash->nbuckets];
+    get_range(g_dynsym.count - hash->symndx, 1, &first, &last);
+    for (i = first; i < last; i++) {
+        render_str("    |           0x", 0);
+        render_hex(value[i], 8);
+        render_str("           |\n", 0);
     }
     printf("    |--------------------------------|\n");
 }
@@ -4550,6 +4907,10 @@ int parse(char *elf, parser_opt_t *po, uint32_t length) {
     } else {
         g_strlength = length;
     }
+    g_base = po->base;
+    g_ranged = po->ranged;
+    g_range_start = po->range_start;
+    g_range_count = po->range_count;
 
     if (MODE == -1) {
         return -1;
@@ -4572,6 +4933,25 @@ int parse(char *elf, parser_opt_t *po, uint32_t length) {
         return -1;
     }
 
+    g_filter = NULL;
+    if (po->filter) {
+        if (parse_filter(po->filter, &s_filter)) {
+            munmap(elf_map, st.st_size);
+            close(fd);
+            return -1;
+        }
+        g_filter = &s_filter;
+    }
+
+    g_demangle = NULL;
+    if (po->demangle) {
+        if (init_demangle(&s_demangle)) {
+            WARNING("__cxa_demangle is not available, show mangled names\n");
+        } else {
+            g_demangle = &s_demangle;
+        }
+    }
+
     /* 32bit */
     if (MODE == ELFCLASS32) {
         handle_t32 h;
@@ -4581,6 +4961,7 @@ int parse(char *elf, parser_opt_t *po, uint32_t length) {
         h.phdr = (Elf32_Phdr *)&h.mem[h.ehdr->e_phoff];
         h.shstrtab = (Elf32_Shdr *)&h.shdr[h.ehdr->e_shstrndx];
         h.size = st.st_size;
+        init_load_index(h.mem, h.size, &h.loads);
 
         /* ELF Header Information */
         if (!get_option(po, HEADERS) || !get_option(po, ALL))    
@@ -4623,13 +5004,14 @@ int parse(char *elf, parser_opt_t *po, uint32_t length) {
                     display_rel32(&h, g_secname.name[i], 1);
                 }
             }
+            display_relr32(&h);
         } 
 
         /* elf pointer */
         if (!get_option(po, POINTER) || !get_option(po, ALL)) {
             if (g_symtab.count == 0)
                 display_dynsym32(&h, ".symtab", ".strtab", 0);  // get symbol name
-            display_pointer32(&h, 5, ".init_array", ".fini_array", ".ctors", ".dtors", ".eh_frame_hdr");  
+            display_pointer32(&h, 8, ".init_array", ".fini_array", ".ctors", ".dtors", ".eh_frame_hdr", ".data.rel.ro", ".got", ".got.plt");  
         }
 
             /* elf .gnu.hash */
@@ -4646,6 +5028,7 @@ int parse(char *elf, parser_opt_t *po, uint32_t length) {
             display_section32(&h, 0);
             display_rel32(&h, ".rel.plt", 0);
         }        
+        finit_load_index(&h.loads);
     }
 
     /* 64bit */
@@ -4657,6 +5040,7 @@ int parse(char *elf, parser_opt_t *po, uint32_t length) {
         h.phdr = (Elf64_Phdr *)&h.mem[h.ehdr->e_phoff];
         h.shstrtab = (Elf64_Shdr *)&h.shdr[h.ehdr->e_shstrndx];
         h.size = st.st_size;
+        init_load_index(h.mem, h.size, &h.loads);
 
         /* ELF Header Information */
         if (!get_option(po, HEADERS) || !get_option(po, ALL)) 
@@ -4699,13 +5083,14 @@ int parse(char *elf, parser_opt_t *po, uint32_t length) {
                     display_rel64(&h, g_secname.name[i]);
                 }
             }
+            display_relr64(&h);
         }
         
         /* elf pointer */
         if (!get_option(po, POINTER) || !get_option(po, ALL)) {
             if (g_symtab.count == 0)
                 display_dynsym64(&h, ".symtab", ".strtab", 0);  // get symbol name
-            display_pointer64(&h, 5, ".init_array", ".fini_array", ".ctors", ".dtors", ".eh_frame_hdr");
+            display_pointer64(&h, 8, ".init_array", ".fini_array", ".ctors", ".dtors", ".eh_frame_hdr", ".data.rel.ro", ".got", ".got.plt");
         }
 
         /* elf .gnu.hash */
@@ -4722,9 +5107,18 @@ int parse(char *elf, parser_opt_t *po, uint32_t length) {
             display_section64(&h, 0);
             display_rela64(&h, ".rela.plt", 0);
         }   
+        finit_load_index(&h.loads);
     }
 
     munmap(elf_map, st.st_size);
     close(fd);
+    if (g_filter) {
+        free_filter(g_filter);
+        g_filter = NULL;
+    }
+    if (g_demangle) {
+        finit_demangle(g_demangle);
+        g_demangle = NULL;
+    }
     return 0;
 }
@@ -42,6 +42,12 @@ typedef enum PARSE_OPT {
 typedef struct parser_opt {
     char options[END];
     int index;
+    uint64_t base;      // load base address of the relocated view, -b
+    char *filter;       // row filter of the symbol and relocation tables, -s
+    int ranged;         // only show the rows of --range
+    uint64_t range_start;
+    uint64_t range_count; // 0 shows the rows to the end
+    int demangle;       // demangle C++ symbol names, -C
 } parser_opt_t;
 #endif
 
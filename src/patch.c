@@ -0,0 +1,424 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#define _GNU_SOURCE 1
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <elf.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "common.h"
+#include "patch.h"
+
+/* ranges larger than this are copied in kernel with copy_file_range */
+#define PATCH_COPY_THRESHOLD PAGE_SIZE
+
+static uint64_t fnv1a64(uint64_t hash, uint8_t *data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief 在PT_NOTE段中查找build-id
+ * find build-id in PT_NOTE segments
+ * @param map elf map
+ * @param size file size
+ * @param guard output build-id
+ * @return int build-id size, 0 means not found
+ */
+static int get_build_id(uint8_t *map, size_t size, uint8_t *guard) {
+    uint64_t phoff, note_off, note_size;
+    int phnum, i;
+
+    if (map[EI_CLASS] == ELFCLASS32) {
+        Elf32_Ehdr *ehdr = (Elf32_Ehdr *)map;
+        phoff = ehdr->e_phoff;
+        phnum = ehdr->e_phnum;
+    } else {
+        Elf64_Ehdr *ehdr = (Elf64_Ehdr *)map;
+        phoff = ehdr->e_phoff;
+        phnum = ehdr->e_phnum;
+    }
+
+    for (i = 0; i < phnum; i++) {
+        if (map[EI_CLASS] == ELFCLASS32) {
+            Elf32_Phdr *phdr = (Elf32_Phdr *)(map + phoff) + i;
+            if ((uint8_t *)(phdr + 1) > map + size || phdr->p_type != PT_NOTE)
+                continue;
+            note_off = phdr->p_offset;
+            note_size = phdr->p_filesz;
+        } else {
+            Elf64_Phdr *phdr = (Elf64_Phdr *)(map + phoff) + i;
+            if ((uint8_t *)(phdr + 1) > map + size || phdr->p_type != PT_NOTE)
+                continue;
+            note_off = phdr->p_offset;
+            note_size = phdr->p_filesz;
+        }
+        if (note_off > size || note_size > size - note_off)
+            continue;
+
+        /* Elf32_Nhdr and Elf64_Nhdr have the same layout */
+        uint64_t pos = 0;
+        while (pos + sizeof(Elf64_Nhdr) <= note_size) {
+            Elf64_Nhdr *nhdr = (Elf64_Nhdr *)(map + note_off + pos);
+            uint64_t name_off = pos + sizeof(Elf64_Nhdr);
+            uint64_t desc_off = name_off + ALIGN(nhdr->n_namesz, 4);
+            if (desc_off + nhdr->n_descsz > note_size)
+                break;
+            if (nhdr->n_type == NT_GNU_BUILD_ID && nhdr->n_namesz == 4 &&
+                !memcmp(map + note_off + name_off, "GNU", 4) &&
+                nhdr->n_descsz <= PATCH_GUARD_LENGTH) {
+                memcpy(guard, map + note_off + desc_off, nhdr->n_descsz);
+                return nhdr->n_descsz;
+            }
+            pos = desc_off + ALIGN(nhdr->n_descsz, 4);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 计算ELF头、程序头表和节头表的哈希值
+ * hash ELF header, program header table and section header table
+ * @param map elf map
+ * @param size file size
+ * @param guard output hash
+ * @return int hash size, 0 means error
+ */
+static int get_layout_hash(uint8_t *map, size_t size, uint8_t *guard) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    uint64_t ehsize, phoff, phsize, shoff, shsize;
+
+    if (map[EI_CLASS] == ELFCLASS32) {
+        Elf32_Ehdr *ehdr = (Elf32_Ehdr *)map;
+        ehsize = sizeof(Elf32_Ehdr);
+        phoff = ehdr->e_phoff;
+        phsize = ehdr->e_phnum * sizeof(Elf32_Phdr);
+        shoff = ehdr->e_shoff;
+        shsize = ehdr->e_shnum * sizeof(Elf32_Shdr);
+    } else {
+        Elf64_Ehdr *ehdr = (Elf64_Ehdr *)map;
+        ehsize = sizeof(Elf64_Ehdr);
+        phoff = ehdr->e_phoff;
+        phsize = ehdr->e_phnum * sizeof(Elf64_Phdr);
+        shoff = ehdr->e_shoff;
+        shsize = ehdr->e_shnum * sizeof(Elf64_Shdr);
+    }
+
+    if (phoff > size || phsize > size - phoff || shoff > size || shsize > size - shoff) {
+        return 0;
+    }
+
+    hash = fnv1a64(hash, map, ehsize);
+    hash = fnv1a64(hash, map + phoff, phsize);
+    hash = fnv1a64(hash, map + shoff, shsize);
+    memcpy(guard, &hash, sizeof(hash));
+    return sizeof(hash);
+}
+
+/**
+ * @brief 计算文件的保护值，优先使用build-id
+ * compute the guard of a file, build-id is preferred
+ */
+static int get_guard(uint8_t *map, size_t size, int type, uint8_t *guard) {
+    if (type == GUARD_BUILD_ID)
+        return get_build_id(map, size, guard);
+    if (type == GUARD_LAYOUT)
+        return get_layout_hash(map, size, guard);
+    return 0;
+}
+
+static uint8_t *map_file(char *name, int flags, int *fd, size_t *size) {
+    struct stat st;
+    uint8_t *map;
+
+    *fd = open(name, flags);
+    if (*fd < 0) {
+        perror("open");
+        return NULL;
+    }
+
+    if (fstat(*fd, &st) < 0) {
+        perror("fstat");
+        close(*fd);
+        return NULL;
+    }
+
+    *size = st.st_size;
+    if (*size < sizeof(Elf64_Ehdr)) {
+        ERROR("%s is too small\n", name);
+        close(*fd);
+        return NULL;
+    }
+
+    map = mmap(0, *size, PROT_READ, MAP_PRIVATE, *fd, 0);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        close(*fd);
+        return NULL;
+    }
+    return map;
+}
+
+static int write_range(FILE *fp, uint64_t offset, uint8_t *data, uint64_t size) {
+    patch_range_t range = {offset, size};
+    static const uint8_t zero[8] = {0};
+
+    if (fwrite(&range, sizeof(range), 1, fp) != 1 || fwrite(data, 1, size, fp) != size) {
+        return -1;
+    }
+    /* keep the next range header aligned */
+    if (ALIGN(size, 8) != size) {
+        fwrite(zero, 1, ALIGN(size, 8) - size, fp);
+    }
+    return 0;
+}
+
+/**
+ * @brief 对比原始文件和修改后的文件，记录为补丁文件
+ * record the difference between the original file and the edited file as a patch
+ * @param orig_name original elf file name
+ * @param elf_name edited elf file name
+ * @param patch_name output patch file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int record_patch(char *orig_name, char *elf_name, char *patch_name) {
+    int orig_fd, new_fd;
+    size_t orig_size, new_size, common;
+    uint8_t *orig_map, *new_map;
+    patch_header_t header;
+    FILE *fp = NULL;
+    uint64_t i, start, end;
+    int err = -1;
+
+    orig_map = map_file(orig_name, O_RDONLY, &orig_fd, &orig_size);
+    if (!orig_map) {
+        return -1;
+    }
+    new_map = map_file(elf_name, O_RDONLY, &new_fd, &new_size);
+    if (!new_map) {
+        munmap(orig_map, orig_size);
+        close(orig_fd);
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PATCH_MAGIC, sizeof(PATCH_MAGIC));
+    header.version = PATCH_VERSION;
+    header.orig_size = orig_size;
+    header.new_size = new_size;
+    header.guard_type = GUARD_BUILD_ID;
+    header.guard_size = get_guard(orig_map, orig_size, GUARD_BUILD_ID, header.guard);
+    if (!header.guard_size) {
+        header.guard_type = GUARD_LAYOUT;
+        header.guard_size = get_guard(orig_map, orig_size, GUARD_LAYOUT, header.guard);
+    }
+    if (!header.guard_size) {
+        ERROR("invalid ELF layout\n");
+        goto ERR_EXIT;
+    }
+
+    fp = fopen(patch_name, "wb");
+    if (!fp) {
+        perror("fopen");
+        goto ERR_EXIT;
+    }
+    /* the range number is rewritten at the end */
+    fwrite(&header, sizeof(header), 1, fp);
+
+    /* modified byte ranges */
+    common = orig_size < new_size ? orig_size : new_size;
+    i = 0;
+    while (i < common) {
+        /* skip equal words quickly */
+        while (i + 8 <= common && *(uint64_t *)(orig_map + i) == *(uint64_t *)(new_map + i))
+            i += 8;
+        while (i < common && orig_map[i] == new_map[i])
+            i++;
+        if (i >= common)
+            break;
+
+        start = i;
+        end = i + 1;
+        /* extend the range, small equal gaps are merged */
+        for (i = end; i < common && i < end + PATCH_MERGE_GAP; i++) {
+            if (orig_map[i] != new_map[i])
+                end = i + 1;
+        }
+        i = end;
+        if (write_range(fp, start, new_map + start, end - start)) {
+            perror("fwrite");
+            goto ERR_EXIT;
+        }
+        header.range_num++;
+    }
+
+    /* appended extent */
+    if (new_size > orig_size) {
+        if (write_range(fp, orig_size, new_map + orig_size, new_size - orig_size)) {
+            perror("fwrite");
+            goto ERR_EXIT;
+        }
+        header.range_num++;
+    }
+
+    fseek(fp, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, fp);
+    INFO("record %d ranges into %s (%s guard)\n", header.range_num, patch_name,
+         header.guard_type == GUARD_BUILD_ID ? "build-id" : "layout");
+    err = 0;
+
+ERR_EXIT:
+    if (fp)
+        fclose(fp);
+    munmap(orig_map, orig_size);
+    munmap(new_map, new_size);
+    close(orig_fd);
+    close(new_fd);
+    return err;
+}
+
+/**
+ * @brief 检查补丁中所有区间的头、偏移和长度
+ * check the header, offset and size of every range of the patch
+ */
+static int check_ranges(uint8_t *patch_map, size_t patch_size, patch_header_t *header) {
+    patch_range_t *range;
+    uint64_t pos = sizeof(patch_header_t);
+
+    for (uint32_t i = 0; i < header->range_num; i++) {
+        if (pos > patch_size || sizeof(patch_range_t) > patch_size - pos) {
+            return -1;
+        }
+        range = (patch_range_t *)(patch_map + pos);
+        pos += sizeof(patch_range_t);
+        if (range->size > patch_size - pos || range->offset > header->new_size ||
+            range->size > header->new_size - range->offset) {
+            return -1;
+        }
+        pos += ALIGN(range->size, 8);
+    }
+    return 0;
+}
+
+/**
+ * @brief 将补丁应用到匹配的文件
+ * replay the patch on a matching file
+ * @param patch_name patch file name
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int replay_patch(char *patch_name, char *elf_name) {
+    int patch_fd, elf_fd;
+    size_t patch_size, elf_size;
+    uint8_t *patch_map, *elf_map;
+    uint8_t guard[PATCH_GUARD_LENGTH];
+    patch_header_t *header;
+    patch_range_t *range;
+    uint64_t pos;
+    uint32_t i;
+    int err = -1;
+
+    patch_map = map_file(patch_name, O_RDONLY, &patch_fd, &patch_size);
+    if (!patch_map) {
+        return -1;
+    }
+    header = (patch_header_t *)patch_map;
+    if (patch_size < sizeof(patch_header_t) || memcmp(header->magic, PATCH_MAGIC, sizeof(PATCH_MAGIC)) ||
+        header->version != PATCH_VERSION || header->guard_size > PATCH_GUARD_LENGTH) {
+        ERROR("%s is not an elfspirit patch\n", patch_name);
+        munmap(patch_map, patch_size);
+        close(patch_fd);
+        return -1;
+    }
+
+    elf_map = map_file(elf_name, O_RDWR, &elf_fd, &elf_size);
+    if (!elf_map) {
+        munmap(patch_map, patch_size);
+        close(patch_fd);
+        return -1;
+    }
+
+    /* only identical builds are patched */
+    memset(guard, 0, sizeof(guard));
+    if (elf_size != header->orig_size ||
+        get_guard(elf_map, elf_size, header->guard_type, guard) != header->guard_size ||
+        memcmp(guard, header->guard, header->guard_size)) {
+        ERROR("%s does not match the patch\n", elf_name);
+        goto ERR_EXIT;
+    }
+
+    /* a corrupted patch must not leave the file truncated or half patched */
+    if (check_ranges(patch_map, patch_size, header)) {
+        ERROR("%s is corrupted\n", patch_name);
+        goto ERR_EXIT;
+    }
+
+    if (header->new_size != elf_size && ftruncate(elf_fd, header->new_size) < 0) {
+        perror("ftruncate");
+        goto ERR_EXIT;
+    }
+
+    pos = sizeof(patch_header_t);
+    for (i = 0; i < header->range_num; i++) {
+        range = (patch_range_t *)(patch_map + pos);
+        pos += sizeof(patch_range_t);
+        if (range->size >= PATCH_COPY_THRESHOLD) {
+            loff_t in = pos, out = range->offset;
+            size_t left = range->size;
+            while (left) {
+                ssize_t n = copy_file_range(patch_fd, &in, elf_fd, &out, left, 0);
+                if (n <= 0)
+                    break;
+                left -= n;
+            }
+            /* fall back to pwrite, e.g. cross-filesystem on old kernels */
+            if (left && pwrite(elf_fd, patch_map + pos + range->size - left, left, range->offset + range->size - left) != left) {
+                perror("pwrite");
+                goto ERR_EXIT;
+            }
+        } else if (pwrite(elf_fd, patch_map + pos, range->size, range->offset) != range->size) {
+            perror("pwrite");
+            goto ERR_EXIT;
+        }
+        pos += ALIGN(range->size, 8);
+    }
+
+    INFO("replay %d ranges on %s\n", header->range_num, elf_name);
+    err = 0;
+
+ERR_EXIT:
+    munmap(patch_map, patch_size);
+    munmap(elf_map, elf_size);
+    close(patch_fd);
+    close(elf_fd);
+    return err;
+}
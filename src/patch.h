@@ -0,0 +1,84 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+/*
+ * elfspirit patch file, all fields are little endian:
+ *
+ *   +--------------------+
+ *   | patch_header_t     |
+ *   +--------------------+
+ *   | patch_range_t      |  offset, size
+ *   | data[size]         |  new bytes, 8-byte aligned
+ *   +--------------------+
+ *   | ...                |  range_num times
+ *   +--------------------+
+ *
+ * Ranges which start at or beyond orig_size are the extents appended to the
+ * file, such as a new segment or a moved section header table.
+ */
+#define PATCH_MAGIC "ESPATCH"
+#define PATCH_VERSION 1
+/* merge two different ranges when the gap is smaller than a range header */
+#define PATCH_MERGE_GAP 32
+#define PATCH_GUARD_LENGTH 32
+
+enum PATCH_GUARD {
+    GUARD_BUILD_ID = 1,     // NT_GNU_BUILD_ID note
+    GUARD_LAYOUT,           // hash of ELF header, program header table and section header table
+};
+
+typedef struct patch_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t guard_type;
+    uint32_t guard_size;
+    uint32_t range_num;
+    uint8_t guard[PATCH_GUARD_LENGTH];
+    uint64_t orig_size;
+    uint64_t new_size;
+} patch_header_t;
+
+typedef struct patch_range {
+    uint64_t offset;
+    uint64_t size;
+} patch_range_t;
+
+/**
+ * @brief 对比原始文件和修改后的文件，记录为补丁文件
+ * record the difference between the original file and the edited file as a patch
+ * @param orig_name original elf file name
+ * @param elf_name edited elf file name
+ * @param patch_name output patch file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int record_patch(char *orig_name, char *elf_name, char *patch_name);
+
+/**
+ * @brief 将补丁应用到匹配的文件
+ * replay the patch on a matching file
+ * @param patch_name patch file name
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int replay_patch(char *patch_name, char *elf_name);
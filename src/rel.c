@@ -58,6 +58,7 @@ int init_elf(char *elf, handle_t32 *h32, handle_t64 *h64) {
         h32->phdr = (Elf32_Phdr *)&h32->mem[h32->ehdr->e_phoff];
         h32->shstrtab = (Elf32_Shdr *)&h32->shdr[h32->ehdr->e_shstrndx];
         h32->size = st.st_size;
+        init_load_index(h32->mem, h32->size, &h32->loads);
     }
 
     /* 64bit */
@@ -68,6 +69,7 @@ int init_elf(char *elf, handle_t32 *h32, handle_t64 *h64) {
         h64->phdr = (Elf64_Phdr *)&h64->mem[h64->ehdr->e_phoff];
         h64->shstrtab = (Elf64_Shdr *)&h64->shdr[h64->ehdr->e_shstrndx];
         h64->size = st.st_size;
+        init_load_index(h64->mem, h64->size, &h64->loads);
     }
 
     /* init symbol string table*/
@@ -78,8 +80,10 @@ int init_elf(char *elf, handle_t32 *h32, handle_t64 *h64) {
 int finit_elf(handle_t32 *h32, handle_t64 *h64) {
     close(h32->fd);
     munmap(h32->mem, h32->size);
+    finit_load_index(&h32->loads);
     close(h64->fd);
     munmap(h64->mem, h64->size);
+    finit_load_index(&h64->loads);
 }
 
 /**
@@ -301,51 +305,39 @@ int get_rela64_name(handle_t64 *h, char *sec_name, int index, char **name) {
  * @return item file offset {-1:error, 0:success}
  */
 uint32_t get_rel32_offset(handle_t32 *h, char *sec_name, int index) {
-    uint32_t addr = get_rel32_addr(h, sec_name, index);
-    int ret = get_sec_index32(h, ".got.plt");
-    if (ret < 0) {
+    uint64_t addr = get_rel32_addr(h, sec_name, index);
+    uint64_t offset;
+    if (addr == (uint32_t)-1 || load_addr_to_offset(&h->loads, addr, 4, &offset)) {
         return -1;
     }
-    int diff = h->shdr[h->sec_index].sh_addr - h->shdr[h->sec_index].sh_offset;
-    // refresh .rela.plt size
-    get_rel32_addr(h, sec_name, index);
-    return addr - diff;
+    return offset;
 }
 
 uint64_t get_rel64_offset(handle_t64 *h, char *sec_name, int index) {
     uint64_t addr = get_rel64_addr(h, sec_name, index);
-    int ret = get_sec_index64(h, ".got.plt");
-    if (ret < 0) {
+    uint64_t offset;
+    if (addr == (uint64_t)-1 || load_addr_to_offset(&h->loads, addr, 8, &offset)) {
         return -1;
     }
-    int diff = h->shdr[h->sec_index].sh_addr - h->shdr[h->sec_index].sh_offset;
-    // refresh .rela.plt size
-    get_rel64_addr(h, sec_name, index);
-    return addr - diff;
+    return offset;
 }
 
 uint32_t get_rela32_offset(handle_t32 *h, char *sec_name, int index) {
-    uint32_t addr = get_rela32_addr(h, sec_name, index);
-    int ret = get_sec_index32(h, ".got.plt");
-    if (ret < 0) {
+    uint64_t addr = get_rela32_addr(h, sec_name, index);
+    uint64_t offset;
+    if (addr == (uint32_t)-1 || load_addr_to_offset(&h->loads, addr, 4, &offset)) {
         return -1;
     }
-    int diff = h->shdr[h->sec_index].sh_addr - h->shdr[h->sec_index].sh_offset;
-    // refresh .rela.plt size
-    get_rela32_addr(h, sec_name, index);
-    return addr - diff;
+    return offset;
 }
 
 uint64_t get_rela64_offset(handle_t64 *h, char *sec_name, int index) {
     uint64_t addr = get_rela64_addr(h, sec_name, index);
-    int ret = get_sec_index64(h, ".got.plt");
-    if (ret < 0) {
+    uint64_t offset;
+    if (addr == (uint64_t)-1 || load_addr_to_offset(&h->loads, addr, 8, &offset)) {
         return -1;
     }
-    int diff = h->shdr[h->sec_index].sh_addr - h->shdr[h->sec_index].sh_offset;
-    // refresh .rela.plt size
-    get_rela64_addr(h, sec_name, index);
-    return addr - diff;
+    return offset;
 }
 
 // /**
@@ -0,0 +1,943 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <elf.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "common.h"
+#include "segment.h"
+#include "journal.h"
+#include "dynamic.h"
+#include "relr.h"
+
+/* dynamic entries used by the packer */
+typedef struct relr_info {
+    uint64_t rel;           // DT_RELA or DT_REL
+    uint64_t relsz;
+    int is_rela;
+    int has_count;          // DT_RELACOUNT or DT_RELCOUNT exists
+    uint64_t count;
+    uint64_t jmprel;
+    uint64_t strtab;
+    uint64_t verneed;
+    uint64_t verneednum;
+    uint64_t verdef;
+    uint64_t verdefnum;
+    int has_relr;
+    int need_libc;          // DT_NEEDED libc.so.6
+    load_index_t loads;     // free it with finit_load_index
+} relr_info_t;
+
+/* sort key of a dynamic relocation */
+typedef struct reloc_key {
+    int rank;               // 0:RELATIVE, 1:symbolic, 2:IRELATIVE
+    uint64_t sym;
+    uint64_t offset;
+    size_t index;           // index in the relocation table
+} reloc_key_t;
+
+/* one RELATIVE relocation moved into the RELR table */
+typedef struct relr_entry {
+    uint64_t addr;
+    uint64_t addend;
+    uint64_t target;        // file offset of addr
+    size_t index;           // index in the relocation table
+} relr_entry_t;
+
+/* walk a RELR table, store the addresses if out is not NULL, return the number of them */
+static size_t walk_relr(uint8_t *relr, uint64_t size, int word_size, uint64_t *out) {
+    size_t n = 0;
+    uint64_t where = 0;
+
+    for (size_t i = 0; i < size / word_size; i++) {
+        uint64_t entry = word_size == 4 ? ((uint32_t *)relr)[i] : ((uint64_t *)relr)[i];
+        /* an even entry is an address, an odd one is a bitmap of the next words */
+        if (!(entry & 1)) {
+            if (out)
+                out[n] = entry;
+            n++;
+            where = entry + word_size;
+            continue;
+        }
+        for (int j = 0; (entry >>= 1) != 0; j++) {
+            if (entry & 1) {
+                if (out)
+                    out[n] = where + j * word_size;
+                n++;
+            }
+        }
+        where += (word_size * 8 - 1) * word_size;
+    }
+    return n;
+}
+
+/**
+ * @brief 解码RELR表，得到所有需要重定位的地址
+ * decode a RELR table into the addresses to relocate
+ * @param relr RELR table
+ * @param size table size
+ * @param word_size 4 for ELF32, 8 for ELF64
+ * @param addrs output, addresses, free it after use
+ * @param count output, number of addresses
+ * @return int error code {-1:error,0:sucess}
+ */
+int decode_relr(uint8_t *relr, uint64_t size, int word_size, uint64_t **addrs, size_t *count) {
+    *count = walk_relr(relr, size, word_size, NULL);
+    *addrs = malloc((*count + 1) * sizeof(uint64_t));
+    if (!*addrs) {
+        return -1;
+    }
+    walk_relr(relr, size, word_size, *addrs);
+    return 0;
+}
+
+/**
+ * @brief 将排序后的地址编码为RELR表
+ * encode the sorted addresses into a RELR table
+ * @param addrs sorted addresses, aligned to word_size
+ * @param count number of addresses
+ * @param word_size 4 for ELF32, 8 for ELF64
+ * @param relr output, RELR table, free it after use
+ * @param size output, table size
+ * @return int error code {-1:error,0:sucess}
+ */
+int encode_relr(uint64_t *addrs, size_t count, int word_size, uint8_t **relr, uint64_t *size) {
+    uint64_t bits = word_size * 8 - 1;     // addresses covered by one bitmap
+    size_t n = 0;
+    size_t i = 0;
+
+    /* never larger than one entry per address */
+    *relr = malloc((count + 1) * word_size);
+    if (!*relr) {
+        return -1;
+    }
+
+    while (i < count) {
+        uint64_t where = addrs[i] + word_size;
+        if (word_size == 4)
+            ((uint32_t *)*relr)[n++] = addrs[i];
+        else
+            ((uint64_t *)*relr)[n++] = addrs[i];
+        i++;
+
+        for (;;) {
+            uint64_t bitmap = 0;
+            while (i < count && addrs[i] >= where && addrs[i] - where < bits * word_size) {
+                bitmap |= (uint64_t)1 << ((addrs[i] - where) / word_size);
+                i++;
+            }
+            if (!bitmap) {
+                break;
+            }
+            if (word_size == 4)
+                ((uint32_t *)*relr)[n++] = (bitmap << 1) | 1;
+            else
+                ((uint64_t *)*relr)[n++] = (bitmap << 1) | 1;
+            where += bits * word_size;
+        }
+    }
+
+    *size = n * word_size;
+    return 0;
+}
+
+/**
+ * @brief 得到架构的RELATIVE重定位类型
+ * get the RELATIVE relocation type of an architecture
+ * @param machine e_machine
+ * @return int relocation type {-1:unsupported}
+ */
+int get_relative_type(int machine) {
+    switch (machine) {
+        case EM_386:        return R_386_RELATIVE;
+        case EM_X86_64:     return R_X86_64_RELATIVE;
+        case EM_ARM:        return R_ARM_RELATIVE;
+        case EM_AARCH64:    return R_AARCH64_RELATIVE;
+        default:            return -1;
+    }
+}
+
+/**
+ * @brief 得到架构的IRELATIVE重定位类型
+ * get the IRELATIVE relocation type of an architecture
+ * @param machine e_machine
+ * @return int relocation type {-1:unsupported}
+ */
+int get_irelative_type(int machine) {
+    switch (machine) {
+        case EM_386:        return R_386_IRELATIVE;
+        case EM_X86_64:     return R_X86_64_IRELATIVE;
+        case EM_ARM:        return R_ARM_IRELATIVE;
+        case EM_AARCH64:    return R_AARCH64_IRELATIVE;
+        default:            return -1;
+    }
+}
+
+/**
+ * @brief 读取打包需要的dynamic条目
+ * read the dynamic entries used by the packer
+ * @param mapped elf file content
+ * @param size file size
+ * @param info output
+ * @return int error code {-1:error,0:sucess}
+ */
+static int get_relr_info(uint8_t *mapped, size_t size, relr_info_t *info) {
+    int64_t tags[512];
+    uint64_t vals[512];
+    int num = 0;
+    uint64_t offset;
+
+    memset(info, 0, sizeof(relr_info_t));
+    if (init_load_index(mapped, size, &info->loads)) {
+        return -1;
+    }
+    if (MODE == ELFCLASS32) {
+        Elf32_Ehdr *ehdr = (Elf32_Ehdr *)mapped;
+        Elf32_Phdr *phdr = (Elf32_Phdr *)&mapped[ehdr->e_phoff];
+        for (int i = 0; i < ehdr->e_phnum; i++) {
+            if (phdr[i].p_type != PT_DYNAMIC || phdr[i].p_offset + phdr[i].p_filesz > size)
+                continue;
+            Elf32_Dyn *dyn = (Elf32_Dyn *)(mapped + phdr[i].p_offset);
+            for (int j = 0; j < phdr[i].p_filesz / sizeof(Elf32_Dyn) && dyn[j].d_tag != DT_NULL && num < 512; j++) {
+                tags[num] = dyn[j].d_tag;
+                vals[num++] = dyn[j].d_un.d_val;
+            }
+            break;
+        }
+    }
+    if (MODE == ELFCLASS64) {
+        Elf64_Ehdr *ehdr = (Elf64_Ehdr *)mapped;
+        Elf64_Phdr *phdr = (Elf64_Phdr *)&mapped[ehdr->e_phoff];
+        for (int i = 0; i < ehdr->e_phnum; i++) {
+            if (phdr[i].p_type != PT_DYNAMIC || phdr[i].p_offset + phdr[i].p_filesz > size)
+                continue;
+            Elf64_Dyn *dyn = (Elf64_Dyn *)(mapped + phdr[i].p_offset);
+            for (int j = 0; j < phdr[i].p_filesz / sizeof(Elf64_Dyn) && dyn[j].d_tag != DT_NULL && num < 512; j++) {
+                tags[num] = dyn[j].d_tag;
+                vals[num++] = dyn[j].d_un.d_val;
+            }
+            break;
+        }
+    }
+    if (!num) {
+        return -1;
+    }
+
+    for (int i = 0; i < num; i++) {
+        switch (tags[i]) {
+            case DT_RELA:       info->rel = vals[i]; info->is_rela = 1; break;
+            case DT_REL:        info->rel = vals[i]; break;
+            case DT_RELASZ:
+            case DT_RELSZ:      info->relsz = vals[i]; break;
+            case DT_RELACOUNT:
+            case DT_RELCOUNT:   info->has_count = 1; info->count = vals[i]; break;
+            case DT_JMPREL:     info->jmprel = vals[i]; break;
+            case DT_STRTAB:     info->strtab = vals[i]; break;
+            case DT_VERNEED:    info->verneed = vals[i]; break;
+            case DT_VERNEEDNUM: info->verneednum = vals[i]; break;
+            case DT_VERDEF:     info->verdef = vals[i]; break;
+            case DT_VERDEFNUM:  info->verdefnum = vals[i]; break;
+            case DT_RELR:       info->has_relr = 1; break;
+        }
+    }
+
+    /* ld.so of glibc requires GLIBC_ABI_DT_RELR */
+    if (!load_addr_to_offset(&info->loads, info->strtab, 1, &offset)) {
+        for (int i = 0; i < num; i++) {
+            if (tags[i] == DT_NEEDED && offset + vals[i] < size && !strcmp((char *)mapped + offset + vals[i], "libc.so.6"))
+                info->need_libc = 1;
+        }
+    }
+    return 0;
+}
+
+static int compare_relr_entry(const void *a, const void *b) {
+    const relr_entry_t *x = a, *y = b;
+    if (x->addr != y->addr)
+        return x->addr < y->addr ? -1 : 1;
+    return x->index < y->index ? -1 : 1;
+}
+
+static int compare_reloc_key(const void *a, const void *b) {
+    const reloc_key_t *x = a, *y = b;
+    if (x->rank != y->rank)
+        return x->rank < y->rank ? -1 : 1;
+    if (x->sym != y->sym)
+        return x->sym < y->sym ? -1 : 1;
+    if (x->offset != y->offset)
+        return x->offset < y->offset ? -1 : 1;
+    return x->index < y->index ? -1 : 1;
+}
+
+/* SysV hash of a version name */
+static uint32_t get_elf_hash(const char *name) {
+    uint32_t h = 0, g;
+    while (*name) {
+        h = (h << 4) + (uint8_t)*name++;
+        g = h & 0xf0000000;
+        if (g)
+            h ^= g >> 24;
+        h &= ~g;
+    }
+    return h;
+}
+
+/**
+ * @brief 更新节头，用于.rela.dyn缩小和.gnu.version_r移动之后
+ * update a section header after .rela.dyn is shrunk or .gnu.version_r is moved
+ * @param elf_name elf file name
+ * @param type section type
+ * @param old_addr old section address
+ * @param offset new file offset
+ * @param addr new address
+ * @param size new size
+ * @param info new sh_info, -1 to keep it
+ * @return int error code {-1:error,0:sucess}
+ */
+static int update_section(char *elf_name, uint32_t type, uint64_t old_addr, uint64_t offset, uint64_t addr, uint64_t size, int64_t info) {
+    int fd;
+    struct stat st;
+    uint8_t *mapped;
+
+    fd = open(elf_name, O_RDWR);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+
+    if (journal_headers(elf_name)) {
+        close(fd);
+        return -1;
+    }
+    mapped = mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+
+    if (MODE == ELFCLASS32) {
+        Elf32_Ehdr *ehdr = (Elf32_Ehdr *)mapped;
+        Elf32_Shdr *shdr = (Elf32_Shdr *)&mapped[ehdr->e_shoff];
+        for (int i = 0; ehdr->e_shoff && i < ehdr->e_shnum; i++) {
+            if (shdr[i].sh_type == type && shdr[i].sh_addr == old_addr) {
+                shdr[i].sh_offset = offset;
+                shdr[i].sh_addr = addr;
+                shdr[i].sh_size = size;
+                if (info != -1)
+                    shdr[i].sh_info = info;
+            }
+        }
+    }
+
+    if (MODE == ELFCLASS64) {
+        Elf64_Ehdr *ehdr = (Elf64_Ehdr *)mapped;
+        Elf64_Shdr *shdr = (Elf64_Shdr *)&mapped[ehdr->e_shoff];
+        for (int i = 0; ehdr->e_shoff && i < ehdr->e_shnum; i++) {
+            if (shdr[i].sh_type == type && shdr[i].sh_addr == old_addr) {
+                shdr[i].sh_offset = offset;
+                shdr[i].sh_addr = addr;
+                shdr[i].sh_size = size;
+                if (info != -1)
+                    shdr[i].sh_info = info;
+            }
+        }
+    }
+
+    munmap(mapped, st.st_size);
+    return 0;
+}
+
+/**
+ * @brief 在libc.so.6的版本需求中增加GLIBC_ABI_DT_RELR，新的.gnu.version_r保存在新的段中
+ * add GLIBC_ABI_DT_RELR to the version needs of libc.so.6, the new .gnu.version_r
+ * is stored in a new segment
+ * @param elf_name elf file name
+ * @param ops output, dynamic operations for DT_VERNEED and DT_VERNEEDNUM
+ * @param op_num input and output, number of operations
+ * @return int error code {-1:error,0:sucess}
+ */
+static int add_relr_version(char *elf_name, dyn_op_t *ops, int *op_num) {
+    char *strs[2] = {RELR_VERSION, "libc.so.6"};
+    uint64_t str_offsets[2];
+    int fd;
+    struct stat st;
+    uint8_t *mapped;
+    relr_info_t info;
+    uint64_t strtab_off, verneed_off = 0, offset;
+    char *buf = NULL;
+    size_t buf_size, pos = 0;
+    int libc_i = -1, vn_num = 0, max_index = 1;
+    int seg_i, err = -1;
+
+    if (expand_dynstr_segment_multi(elf_name, strs, 2, str_offsets) == -1) {
+        ERROR("expand .dynstr section error!\n");
+        return -1;
+    }
+
+    fd = open(elf_name, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+    mapped = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+
+    if (get_relr_info(mapped, st.st_size, &info) || load_addr_to_offset(&info.loads, info.strtab, 1, &strtab_off)) {
+        goto ERR_EXIT;
+    }
+
+    /* Elf32_Verneed and Elf64_Verneed have the same layout */
+    if (info.verneed && load_addr_to_offset(&info.loads, info.verneed, sizeof(Elf64_Verneed), &verneed_off)) {
+        goto ERR_EXIT;
+    }
+    buf_size = sizeof(Elf64_Verneed) + sizeof(Elf64_Vernaux);
+    offset = verneed_off;
+    for (int i = 0; info.verneed && i < info.verneednum; i++) {
+        Elf64_Verneed *vn = (Elf64_Verneed *)(mapped + offset);
+        uint64_t aux_off = offset + vn->vn_aux;
+        if (offset + sizeof(Elf64_Verneed) > st.st_size)
+            goto CORRUPT;
+        if (!strcmp((char *)mapped + strtab_off + vn->vn_file, "libc.so.6"))
+            libc_i = i;
+        for (int j = 0; j < vn->vn_cnt; j++) {
+            Elf64_Vernaux *aux = (Elf64_Vernaux *)(mapped + aux_off);
+            if (aux_off + sizeof(Elf64_Vernaux) > st.st_size)
+                goto CORRUPT;
+            if (libc_i == i && !strcmp((char *)mapped + strtab_off + aux->vna_name, RELR_VERSION)) {
+                err = 0;
+                goto ERR_EXIT;
+            }
+            if ((aux->vna_other & 0x7fff) > max_index)
+                max_index = aux->vna_other & 0x7fff;
+            aux_off += aux->vna_next;
+        }
+        buf_size += sizeof(Elf64_Verneed) + vn->vn_cnt * sizeof(Elf64_Vernaux);
+        vn_num++;
+        offset += vn->vn_next;
+        if (!vn->vn_next)
+            break;
+    }
+
+    /* version indexes of the definitions */
+    if (info.verdef && !load_addr_to_offset(&info.loads, info.verdef, sizeof(Elf64_Verdef), &offset)) {
+        for (int i = 0; i < info.verdefnum && offset + sizeof(Elf64_Verdef) <= st.st_size; i++) {
+            Elf64_Verdef *vd = (Elf64_Verdef *)(mapped + offset);
+            if ((vd->vd_ndx & 0x7fff) > max_index)
+                max_index = vd->vd_ndx & 0x7fff;
+            if (!vd->vd_next)
+                break;
+            offset += vd->vd_next;
+        }
+    }
+
+    /* 1. copy the chain, the new auxiliary entry goes to the end of libc.so.6 */
+    buf = calloc(1, buf_size);
+    if (!buf) {
+        goto ERR_EXIT;
+    }
+    offset = verneed_off;
+    for (int i = 0; i < vn_num; i++) {
+        Elf64_Verneed *vn = (Elf64_Verneed *)(mapped + offset);
+        Elf64_Verneed *new_vn = (Elf64_Verneed *)(buf + pos);
+        uint64_t aux_off = offset + vn->vn_aux;
+        int cnt = vn->vn_cnt + (i == libc_i);
+
+        *new_vn = *vn;
+        new_vn->vn_cnt = cnt;
+        new_vn->vn_aux = sizeof(Elf64_Verneed);
+        new_vn->vn_next = (i == vn_num - 1 && libc_i != -1) ? 0 : sizeof(Elf64_Verneed) + cnt * sizeof(Elf64_Vernaux);
+        pos += sizeof(Elf64_Verneed);
+        for (int j = 0; j < vn->vn_cnt; j++) {
+            Elf64_Vernaux *aux = (Elf64_Vernaux *)(mapped + aux_off);
+            memcpy(buf + pos, aux, sizeof(Elf64_Vernaux));
+            ((Elf64_Vernaux *)(buf + pos))->vna_next = j == cnt - 1 ? 0 : sizeof(Elf64_Vernaux);
+            pos += sizeof(Elf64_Vernaux);
+            aux_off += aux->vna_next;
+        }
+        if (i == libc_i) {
+            Elf64_Vernaux *aux = (Elf64_Vernaux *)(buf + pos);
+            aux->vna_hash = get_elf_hash(RELR_VERSION);
+            aux->vna_flags = 0;
+            aux->vna_other = ++max_index;
+            aux->vna_name = str_offsets[0];
+            aux->vna_next = 0;
+            pos += sizeof(Elf64_Vernaux);
+        }
+        offset += vn->vn_next;
+    }
+
+    /* 2. no version of libc.so.6 is needed yet */
+    if (libc_i == -1) {
+        Elf64_Verneed *vn = (Elf64_Verneed *)(buf + pos);
+        Elf64_Vernaux *aux = (Elf64_Vernaux *)(vn + 1);
+        vn->vn_version = VER_NEED_CURRENT;
+        vn->vn_cnt = 1;
+        vn->vn_file = str_offsets[1];
+        vn->vn_aux = sizeof(Elf64_Verneed);
+        vn->vn_next = 0;
+        aux->vna_hash = get_elf_hash(RELR_VERSION);
+        aux->vna_other = ++max_index;
+        aux->vna_name = str_offsets[0];
+        pos += sizeof(Elf64_Verneed) + sizeof(Elf64_Vernaux);
+        vn_num++;
+    }
+    munmap(mapped, st.st_size);
+    mapped = NULL;
+
+    /* 3. store it in a new segment */
+    VERBOSE("add %s to the version needs of libc.so.6\n", RELR_VERSION);
+    seg_i = add_segment_content(elf_name, PT_LOAD, buf, pos);
+    if (seg_i == -1) {
+        goto ERR_EXIT;
+    }
+    if (update_section(elf_name, SHT_GNU_verneed, info.verneed, get_segment_offset(elf_name, seg_i), get_segment_vaddr(elf_name, seg_i), pos, vn_num)) {
+        goto ERR_EXIT;
+    }
+
+    ops[*op_num].op = DYN_SET;
+    ops[*op_num].tag = DT_VERNEED;
+    ops[*op_num].val = get_segment_vaddr(elf_name, seg_i);
+    ops[*op_num].has_val = 1;
+    (*op_num)++;
+    ops[*op_num].op = DYN_SET;
+    ops[*op_num].tag = DT_VERNEEDNUM;
+    ops[*op_num].val = vn_num;
+    ops[*op_num].has_val = 1;
+    (*op_num)++;
+    err = 0;
+    goto ERR_EXIT;
+
+CORRUPT:
+    ERROR("Corrupt file format\n");
+ERR_EXIT:
+    free(buf);
+    finit_load_index(&info.loads);
+    if (mapped)
+        munmap(mapped, st.st_size);
+    return err;
+}
+
+/**
+ * @brief 将RELATIVE重定位压缩为DT_RELR表，缩小.rela.dyn并更新DT_RELACOUNT
+ * pack the RELATIVE relocations into a DT_RELR table, shrink .rela.dyn and
+ * update DT_RELACOUNT
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int pack_relr(char *elf_name) {
+    int fd;
+    struct stat st;
+    uint8_t *mapped;
+    relr_info_t info;
+    relr_entry_t *entries = NULL;
+    uint8_t *packed = NULL;
+    uint8_t *table = NULL;
+    uint8_t *saved_rel = NULL;
+    uint64_t *saved_words = NULL;
+    uint64_t *addrs = NULL;
+    uint8_t *relr = NULL;
+    uint64_t relr_size = 0;
+    uint64_t rel_off, new_relsz, min_target = -1, max_target = 0;
+    size_t ent_size, word_size, num, entry_num = 0, addr_num = 0, kept = 0, relative_num = 0;
+    dyn_op_t ops[8];
+    int op_num = 0;
+    int relative_type;
+    int err = -1;
+
+    memset(ops, 0, sizeof(ops));
+    fd = open(elf_name, O_RDWR);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+
+    mapped = mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+
+    if (get_relr_info(mapped, st.st_size, &info)) {
+        WARNING("%s has no dynamic segment\n", elf_name);
+        goto ERR_EXIT;
+    }
+    if (info.has_relr) {
+        WARNING("%s already has DT_RELR\n", elf_name);
+        goto ERR_EXIT;
+    }
+    relative_type = get_relative_type(((Elf32_Ehdr *)mapped)->e_machine);
+    if (relative_type == -1) {
+        ERROR("unsupported architecture\n");
+        goto ERR_EXIT;
+    }
+    /* some linkers count DT_JMPREL in DT_RELASZ */
+    if (info.jmprel > info.rel && info.jmprel < info.rel + info.relsz) {
+        ERROR("DT_JMPREL is inside DT_RELA\n");
+        goto ERR_EXIT;
+    }
+
+    word_size = MODE == ELFCLASS32 ? 4 : 8;
+    if (MODE == ELFCLASS32)
+        ent_size = info.is_rela ? sizeof(Elf32_Rela) : sizeof(Elf32_Rel);
+    else
+        ent_size = info.is_rela ? sizeof(Elf64_Rela) : sizeof(Elf64_Rel);
+    num = info.relsz / ent_size;
+    if (!info.rel || !num || load_addr_to_offset(&info.loads, info.rel, info.relsz, &rel_off)) {
+        WARNING("%s has no relocation table\n", elf_name);
+        goto ERR_EXIT;
+    }
+
+    entries = malloc(num * sizeof(relr_entry_t));
+    packed = calloc(num, 1);
+    table = calloc(1, info.relsz);
+    addrs = malloc(num * sizeof(uint64_t));
+    if (!entries || !packed || !table || !addrs) {
+        goto ERR_EXIT;
+    }
+
+    /* 1. RELATIVE relocations of aligned words stored in the file */
+    for (size_t i = 0; i < num; i++) {
+        uint8_t *p = mapped + rel_off + i * ent_size;
+        uint64_t r_offset, r_info, target;
+        int64_t r_addend = 0;
+        if (MODE == ELFCLASS32) {
+            r_offset = ((Elf32_Rela *)p)->r_offset;
+            r_info = ELF32_R_TYPE(((Elf32_Rela *)p)->r_info);
+            if (info.is_rela)
+                r_addend = ((Elf32_Rela *)p)->r_addend;
+        } else {
+            r_offset = ((Elf64_Rela *)p)->r_offset;
+            r_info = ELF64_R_TYPE(((Elf64_Rela *)p)->r_info);
+            if (info.is_rela)
+                r_addend = ((Elf64_Rela *)p)->r_addend;
+        }
+        if (r_info != relative_type || r_offset % word_size ||
+            load_addr_to_offset(&info.loads, r_offset, word_size, &target)) {
+            continue;
+        }
+        entries[entry_num].addr = r_offset;
+        entries[entry_num].addend = r_addend;
+        entries[entry_num].target = target;
+        entries[entry_num].index = i;
+        entry_num++;
+    }
+
+    /* 2. a RELR table holds an address once, the others stay in .rela.dyn */
+    qsort(entries, entry_num, sizeof(relr_entry_t), compare_relr_entry);
+    for (size_t i = 0; i < entry_num; i++) {
+        if (addr_num && addrs[addr_num - 1] == entries[i].addr) {
+            continue;
+        }
+        addrs[addr_num++] = entries[i].addr;
+        packed[entries[i].index] = 1;
+        if (entries[i].target < min_target)
+            min_target = entries[i].target;
+        if (entries[i].target + word_size > max_target)
+            max_target = entries[i].target + word_size;
+    }
+    if (!addr_num) {
+        WARNING("no RELATIVE relocation can be packed\n");
+        goto ERR_EXIT;
+    }
+    if (encode_relr(addrs, addr_num, word_size, &relr, &relr_size)) {
+        goto ERR_EXIT;
+    }
+
+    /* 3. the remaining RELATIVE relocations come first for DT_RELACOUNT */
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t i = 0; i < num; i++) {
+            uint8_t *p = mapped + rel_off + i * ent_size;
+            uint64_t type = MODE == ELFCLASS32 ? ELF32_R_TYPE(((Elf32_Rel *)p)->r_info) : ELF64_R_TYPE(((Elf64_Rel *)p)->r_info);
+            if (packed[i] || (pass == 0) != (type == relative_type))
+                continue;
+            memcpy(table + kept * ent_size, p, ent_size);
+            kept++;
+            if (pass == 0)
+                relative_num++;
+        }
+    }
+    new_relsz = kept * ent_size;
+    /* RELR never takes more than a word per relocation */
+    memcpy(table + new_relsz, relr, relr_size);
+
+    /* 4. dynamic entries and .gnu.version_r, prepared before .rela.dyn is touched */
+    ops[op_num].op = DYN_SET;
+    ops[op_num].tag = info.is_rela ? DT_RELASZ : DT_RELSZ;
+    ops[op_num].val = new_relsz;
+    ops[op_num++].has_val = 1;
+    ops[op_num].op = DYN_SET;
+    ops[op_num].tag = DT_RELR;
+    ops[op_num].val = info.rel + new_relsz;
+    ops[op_num++].has_val = 1;
+    ops[op_num].op = DYN_SET;
+    ops[op_num].tag = DT_RELRSZ;
+    ops[op_num].val = relr_size;
+    ops[op_num++].has_val = 1;
+    ops[op_num].op = DYN_SET;
+    ops[op_num].tag = DT_RELRENT;
+    ops[op_num].val = word_size;
+    ops[op_num++].has_val = 1;
+    if (info.has_count || relative_num) {
+        ops[op_num].op = DYN_SET;
+        ops[op_num].tag = info.is_rela ? DT_RELACOUNT : DT_RELCOUNT;
+        ops[op_num].val = relative_num;
+        ops[op_num++].has_val = 1;
+    }
+    if (info.need_libc && add_relr_version(elf_name, ops, &op_num)) {
+        goto ERR_EXIT;
+    }
+
+    /* keep the original bytes until the dynamic entries are written */
+    saved_rel = malloc(info.relsz);
+    saved_words = malloc(entry_num * sizeof(uint64_t));
+    if (!saved_rel || !saved_words) {
+        goto ERR_EXIT;
+    }
+    memcpy(saved_rel, mapped + rel_off, info.relsz);
+    if (info.is_rela && journal_region(elf_name, min_target, max_target - min_target)) {
+        goto ERR_EXIT;
+    }
+    if (journal_region(elf_name, rel_off, info.relsz)) {
+        goto ERR_EXIT;
+    }
+
+    /* 5. the addends of RELA go to the relocated words */
+    if (info.is_rela) {
+        for (size_t i = 0; i < entry_num; i++) {
+            if (!packed[entries[i].index])
+                continue;
+            if (word_size == 4) {
+                saved_words[i] = *(uint32_t *)(mapped + entries[i].target);
+                *(uint32_t *)(mapped + entries[i].target) = entries[i].addend;
+            } else {
+                saved_words[i] = *(uint64_t *)(mapped + entries[i].target);
+                *(uint64_t *)(mapped + entries[i].target) = entries[i].addend;
+            }
+        }
+    }
+    memcpy(mapped + rel_off, table, info.relsz);
+
+    /* 6. switch to the new table, or put the old one back */
+    if (edit_dynamic(elf_name, ops, op_num)) {
+        memcpy(mapped + rel_off, saved_rel, info.relsz);
+        for (size_t i = 0; info.is_rela && i < entry_num; i++) {
+            if (!packed[entries[i].index])
+                continue;
+            if (word_size == 4)
+                *(uint32_t *)(mapped + entries[i].target) = saved_words[i];
+            else
+                *(uint64_t *)(mapped + entries[i].target) = saved_words[i];
+        }
+        ERROR("edit dynamic error, restore the relocation table\n");
+        goto ERR_EXIT;
+    }
+    munmap(mapped, st.st_size);
+    mapped = NULL;
+
+    if (update_section(elf_name, info.is_rela ? SHT_RELA : SHT_REL, info.rel, rel_off, info.rel, new_relsz, -1)) {
+        goto ERR_EXIT;
+    }
+    INFO("pack %lu RELATIVE relocations into DT_RELR: 0x%lx -> 0x%lx bytes\n", addr_num, info.relsz, new_relsz + relr_size);
+    err = 0;
+
+ERR_EXIT:
+    free(entries);
+    free(packed);
+    free(table);
+    free(saved_rel);
+    free(saved_words);
+    free(addrs);
+    free(relr);
+    finit_load_index(&info.loads);
+    if (mapped)
+        munmap(mapped, st.st_size);
+    return err;
+}
+
+/**
+ * @brief 排序动态重定位，RELATIVE在前，其余按符号和偏移排序，IRELATIVE在最后，同-z combreloc
+ * sort the dynamic relocations like -z combreloc, RELATIVE first, then the
+ * others by symbol and offset, IRELATIVE last, and update DT_RELACOUNT
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int sort_reloc(char *elf_name) {
+    int fd;
+    struct stat st;
+    uint8_t *mapped;
+    relr_info_t info;
+    reloc_key_t *keys = NULL;
+    uint8_t *table = NULL;
+    uint64_t rel_off, relsz;
+    size_t ent_size, num, relative_num = 0, moved = 0, lookup_num = 0;
+    dyn_op_t op;
+    int relative_type, irelative_type;
+    int err = -1;
+
+    memset(&op, 0, sizeof(op));
+    fd = open(elf_name, O_RDWR);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+
+    mapped = mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+
+    if (get_relr_info(mapped, st.st_size, &info)) {
+        WARNING("%s has no dynamic segment\n", elf_name);
+        goto ERR_EXIT;
+    }
+    relative_type = get_relative_type(((Elf32_Ehdr *)mapped)->e_machine);
+    irelative_type = get_irelative_type(((Elf32_Ehdr *)mapped)->e_machine);
+    if (relative_type == -1) {
+        ERROR("unsupported architecture\n");
+        goto ERR_EXIT;
+    }
+
+    if (MODE == ELFCLASS32)
+        ent_size = info.is_rela ? sizeof(Elf32_Rela) : sizeof(Elf32_Rel);
+    else
+        ent_size = info.is_rela ? sizeof(Elf64_Rela) : sizeof(Elf64_Rel);
+    relsz = info.relsz;
+    /* some linkers count DT_JMPREL in DT_RELASZ, the PLT relocations keep their order */
+    if (info.jmprel > info.rel && info.jmprel < info.rel + relsz) {
+        relsz = info.jmprel - info.rel;
+    }
+    num = relsz / ent_size;
+    if (!info.rel || !num || load_addr_to_offset(&info.loads, info.rel, relsz, &rel_off)) {
+        WARNING("%s has no relocation table\n", elf_name);
+        goto ERR_EXIT;
+    }
+
+    keys = malloc(num * sizeof(reloc_key_t));
+    table = malloc(num * ent_size);
+    if (!keys || !table) {
+        goto ERR_EXIT;
+    }
+
+    for (size_t i = 0; i < num; i++) {
+        uint8_t *p = mapped + rel_off + i * ent_size;
+        uint64_t type;
+        if (MODE == ELFCLASS32) {
+            type = ELF32_R_TYPE(((Elf32_Rel *)p)->r_info);
+            keys[i].sym = ELF32_R_SYM(((Elf32_Rel *)p)->r_info);
+            keys[i].offset = ((Elf32_Rel *)p)->r_offset;
+        } else {
+            type = ELF64_R_TYPE(((Elf64_Rel *)p)->r_info);
+            keys[i].sym = ELF64_R_SYM(((Elf64_Rel *)p)->r_info);
+            keys[i].offset = ((Elf64_Rel *)p)->r_offset;
+        }
+        /* IFUNC resolvers may use the data fixed up by the other relocations */
+        if (type == relative_type) {
+            keys[i].rank = 0;
+            relative_num++;
+        } else if (type == irelative_type) {
+            keys[i].rank = 2;
+        } else {
+            keys[i].rank = 1;
+        }
+        keys[i].index = i;
+    }
+    qsort(keys, num, sizeof(reloc_key_t), compare_reloc_key);
+
+    for (size_t i = 0; i < num; i++) {
+        memcpy(table + i * ent_size, mapped + rel_off + keys[i].index * ent_size, ent_size);
+        if (keys[i].index != i)
+            moved++;
+        /* ld.so caches the last looked up symbol */
+        if (keys[i].rank == 1 && (i == 0 || keys[i - 1].rank != 1 || keys[i - 1].sym != keys[i].sym))
+            lookup_num++;
+    }
+
+    if (moved) {
+        if (journal_region(elf_name, rel_off, num * ent_size)) {
+            goto ERR_EXIT;
+        }
+        memcpy(mapped + rel_off, table, num * ent_size);
+        INFO("sort %lu relocations, %lu moved, %lu RELATIVE, %lu symbol lookups\n", num, moved, relative_num, lookup_num);
+    } else {
+        INFO("%s relocations are already sorted\n", elf_name);
+    }
+    munmap(mapped, st.st_size);
+    mapped = NULL;
+
+    /* ld.so applies the first DT_RELACOUNT relocations without checking the type */
+    if ((info.has_count || relative_num) && info.count != relative_num) {
+        op.op = DYN_SET;
+        op.tag = info.is_rela ? DT_RELACOUNT : DT_RELCOUNT;
+        op.val = relative_num;
+        op.has_val = 1;
+        err = edit_dynamic(elf_name, &op, 1);
+    } else {
+        err = 0;
+    }
+
+ERR_EXIT:
+    free(keys);
+    free(table);
+    finit_load_index(&info.loads);
+    if (mapped)
+        munmap(mapped, st.st_size);
+    return err;
+}
@@ -0,0 +1,94 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+/* RELR relative relocations, defined since glibc 2.36 */
+#ifndef DT_RELR
+#define DT_RELRSZ   35
+#define DT_RELR     36
+#define DT_RELRENT  37
+#endif
+#ifndef SHT_RELR
+#define SHT_RELR    19
+#endif
+
+/* the version which ld.so requires for DT_RELR */
+#define RELR_VERSION "GLIBC_ABI_DT_RELR"
+
+/**
+ * @brief 得到架构的RELATIVE重定位类型
+ * get the RELATIVE relocation type of an architecture
+ * @param machine e_machine
+ * @return int relocation type {-1:unsupported}
+ */
+int get_relative_type(int machine);
+
+/**
+ * @brief 得到架构的IRELATIVE重定位类型
+ * get the IRELATIVE relocation type of an architecture
+ * @param machine e_machine
+ * @return int relocation type {-1:unsupported}
+ */
+int get_irelative_type(int machine);
+
+/**
+ * @brief 解码RELR表，得到所有需要重定位的地址
+ * decode a RELR table into the addresses to relocate
+ * @param relr RELR table
+ * @param size table size
+ * @param word_size 4 for ELF32, 8 for ELF64
+ * @param addrs output, addresses, free it after use
+ * @param count output, number of addresses
+ * @return int error code {-1:error,0:sucess}
+ */
+int decode_relr(uint8_t *relr, uint64_t size, int word_size, uint64_t **addrs, size_t *count);
+
+/**
+ * @brief 将排序后的地址编码为RELR表
+ * encode the sorted addresses into a RELR table
+ * @param addrs sorted addresses, aligned to word_size
+ * @param count number of addresses
+ * @param word_size 4 for ELF32, 8 for ELF64
+ * @param relr output, RELR table, free it after use
+ * @param size output, table size
+ * @return int error code {-1:error,0:sucess}
+ */
+int encode_relr(uint64_t *addrs, size_t count, int word_size, uint8_t **relr, uint64_t *size);
+
+/**
+ * @brief 将RELATIVE重定位压缩为DT_RELR表，缩小.rela.dyn并更新DT_RELACOUNT
+ * pack the RELATIVE relocations into a DT_RELR table, shrink .rela.dyn and
+ * update DT_RELACOUNT
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int pack_relr(char *elf_name);
+
+/**
+ * @brief 排序动态重定位，RELATIVE在前，其余按符号和偏移排序，IRELATIVE在最后，同-z combreloc
+ * sort the dynamic relocations like -z combreloc, RELATIVE first, then the
+ * others by symbol and offset, IRELATIVE last, and update DT_RELACOUNT
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int sort_reloc(char *elf_name);
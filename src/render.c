@@ -0,0 +1,130 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "render.h"
+
+int g_color = 1;
+
+static char s_buf[RENDER_BUF_SIZE];
+static const char s_digits[] = "0123456789abcdef";
+
+/**
+ * @brief 初始化输出，终端按行输出并显示颜色，管道或文件使用大缓冲区且不输出颜色
+ * initialize the output. a terminal is line buffered with colours, a pipe or a
+ * file gets a large buffer and no colour escapes
+ */
+void init_render(void) {
+    g_color = isatty(STDOUT_FILENO);
+    if (!g_color) {
+        setvbuf(stdout, s_buf, _IOFBF, sizeof(s_buf));
+    }
+}
+
+/* write the field, padded to |width| */
+static void render_field(const char *s, size_t len, int width) {
+    size_t pad = 0;
+
+    if (width < 0 && len < (size_t)-width)
+        pad = -width - len;
+    else if (width > 0 && len < (size_t)width)
+        pad = width - len;
+
+    if (width > 0) {
+        while (pad--)
+            putchar_unlocked(' ');
+    }
+    fwrite_unlocked(s, 1, len, stdout);
+    if (width < 0) {
+        while (pad--)
+            putchar_unlocked(' ');
+    }
+}
+
+/**
+ * @brief 输出字符串，宽度的含义同printf，负数左对齐
+ * print a string, width works as printf, a negative width aligns left
+ * @param s string
+ * @param width field width
+ */
+void render_str(const char *s, int width) {
+    render_field(s, strlen(s), width);
+}
+
+/**
+ * @brief 输出以0补齐的十六进制数，同printf的"%0*lx"
+ * print a zero padded hexadecimal number, as "%0*lx" of printf
+ * @param value number
+ * @param width minimum digits
+ */
+void render_hex(uint64_t value, int width) {
+    char buf[16];
+    int len = 0;
+
+    do {
+        buf[sizeof(buf) - 1 - len++] = s_digits[value & 0xf];
+        value >>= 4;
+    } while (value);
+    for (; len < width; width--)
+        putchar_unlocked('0');
+    fwrite_unlocked(buf + sizeof(buf) - len, 1, len, stdout);
+}
+
+/**
+ * @brief 输出以空格补齐的数字，宽度的含义同printf，负数左对齐
+ * print a space padded number, width works as printf, a negative width aligns left
+ * @param value number
+ * @param base 10 or 16
+ * @param width field width
+ */
+void render_num(int64_t value, int base, int width) {
+    char buf[24];
+    int len = 0;
+    uint64_t v = value;
+
+    /* hexadecimal is unsigned, as "%x" */
+    if (base == 10 && value < 0)
+        v = -(uint64_t)value;
+    do {
+        buf[sizeof(buf) - 1 - len++] = s_digits[v % base];
+        v /= base;
+    } while (v);
+    if (base == 10 && value < 0)
+        buf[sizeof(buf) - 1 - len++] = '-';
+    render_field(buf + sizeof(buf) - len, len, width);
+}
+
+/**
+ * @brief 输出表格行的序号，同printf的"    [%2d] "
+ * print the index of a table row, as "    [%2d] " of printf
+ * @param nr index
+ */
+void render_nr(int nr) {
+    fwrite_unlocked("    [", 1, 5, stdout);
+    render_num(nr, 10, 2);
+    fwrite_unlocked("] ", 1, 2, stdout);
+}
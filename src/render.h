@@ -0,0 +1,68 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+/* stdout buffer used when the output is not a terminal */
+#define RENDER_BUF_SIZE 0x100000
+
+/* colour escapes are only printed to a terminal */
+extern int g_color;
+
+/**
+ * @brief 初始化输出，终端按行输出并显示颜色，管道或文件使用大缓冲区且不输出颜色
+ * initialize the output. a terminal is line buffered with colours, a pipe or a
+ * file gets a large buffer and no colour escapes
+ */
+void init_render(void);
+
+/**
+ * @brief 输出字符串，宽度的含义同printf，负数左对齐
+ * print a string, width works as printf, a negative width aligns left
+ * @param s string
+ * @param width field width
+ */
+void render_str(const char *s, int width);
+
+/**
+ * @brief 输出以0补齐的十六进制数，同printf的"%0*lx"
+ * print a zero padded hexadecimal number, as "%0*lx" of printf
+ * @param value number
+ * @param width minimum digits
+ */
+void render_hex(uint64_t value, int width);
+
+/**
+ * @brief 输出以空格补齐的数字，宽度的含义同printf，负数左对齐
+ * print a space padded number, width works as printf, a negative width aligns left
+ * @param value number
+ * @param base 10 or 16
+ * @param width field width
+ */
+void render_num(int64_t value, int base, int width);
+
+/**
+ * @brief 输出表格行的序号，同printf的"    [%2d] "
+ * print the index of a table row, as "    [%2d] " of printf
+ * @param nr index
+ */
+void render_nr(int nr);
@@ -0,0 +1,917 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <glob.h>
+#include <elf.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "common.h"
+#include "gnuhash.h"
+#include "hashmap.h"
+#include "version.h"
+#include "resolve.h"
+
+#define RESOLVE_CONF_DEPTH  8
+#define VERSYM_HIDDEN       0x8000
+#define VERSYM_VERSION      0x7fff
+
+typedef struct resolve_sym {
+    uint32_t name;
+    uint64_t value;
+    uint16_t shndx;
+    uint8_t info;
+} resolve_sym_t;
+
+static void get_sym(resolve_obj_t *o, size_t i, resolve_sym_t *s) {
+    if (o->class == ELFCLASS32) {
+        Elf32_Sym *sym = (Elf32_Sym *)o->sym + i;
+        s->name = sym->st_name;
+        s->value = sym->st_value;
+        s->shndx = sym->st_shndx;
+        s->info = sym->st_info;
+    } else {
+        Elf64_Sym *sym = (Elf64_Sym *)o->sym + i;
+        s->name = sym->st_name;
+        s->value = sym->st_value;
+        s->shndx = sym->st_shndx;
+        s->info = sym->st_info;
+    }
+}
+
+/**
+ * @brief 得到.dynstr中的字符串
+ * get a string of .dynstr
+ * @param o parsed object
+ * @param offset offset in .dynstr
+ * @return char* string, "" if the offset is out of .dynstr
+ */
+char *resolve_get_str(resolve_obj_t *o, uint64_t offset) {
+    return offset < o->str_size ? o->str + offset : "";
+}
+
+/* SysV hash of DT_HASH */
+static uint32_t elf_hash(const char *name) {
+    uint32_t h = 0, g;
+    for (unsigned char c = *name; c != '\0'; c = *++name) {
+        h = (h << 4) + c;
+        g = h & 0xf0000000;
+        if (g)
+            h ^= g >> 24;
+        h &= ~g;
+    }
+    return h;
+}
+
+/**
+ * @brief 映射文件，每个路径只打开一次，每个inode只映射一次
+ * map a file, each path is opened once and each inode is mapped once
+ * @param ctx resolver
+ * @param path file path
+ * @return resolve_obj_t* object, NULL if the file is not an ELF
+ */
+resolve_obj_t *resolve_load_obj(resolve_ctx_t *ctx, char *path) {
+    size_t len = strlen(path);
+    uint64_t hash = hash_bytes(path, len);
+    uint64_t value;
+    resolve_obj_t *o = NULL;
+    uint64_t id[2];
+    struct stat st;
+    uint8_t *mem;
+    char *key;
+    int fd;
+
+    if (!hashmap_get(&ctx->objs, hash, path, len, &value)) {
+        return (resolve_obj_t *)value;
+    }
+
+    key = strdup(path);
+    if (!key) {
+        return NULL;
+    }
+
+    fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        if (!fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size >= EI_NIDENT) {
+            /* another path of the same file, e.g. a symbolic link of the soname */
+            id[0] = st.st_dev;
+            id[1] = st.st_ino;
+            if (!hashmap_get(&ctx->inodes, hash_bytes(id, sizeof(id)), id, sizeof(id), &value)) {
+                o = (resolve_obj_t *)value;
+            } else {
+                mem = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mem != MAP_FAILED && !memcmp(mem, ELFMAG, SELFMAG) &&
+                    (mem[EI_CLASS] == ELFCLASS32 || mem[EI_CLASS] == ELFCLASS64)) {
+                    o = calloc(1, sizeof(resolve_obj_t));
+                }
+                if (o) {
+                    o->path = key;
+                    o->id[0] = st.st_dev;
+                    o->id[1] = st.st_ino;
+                    o->mem = mem;
+                    o->size = st.st_size;
+                    o->class = mem[EI_CLASS];
+                    if (hashmap_put(&ctx->inodes, hash_bytes(o->id, sizeof(o->id)), o->id, sizeof(o->id), (uint64_t)o) == -1) {
+                        munmap(o->mem, o->size);
+                        free(o);
+                        o = NULL;
+                    }
+                } else if (mem != MAP_FAILED) {
+                    munmap(mem, st.st_size);
+                }
+            }
+        }
+        close(fd);
+    }
+
+    /* a path that is not an ELF is cached too */
+    if (hashmap_put(&ctx->objs, hash, key, len, (uint64_t)o) == -1) {
+        free(key);
+        return NULL;
+    }
+    return o;
+}
+
+/* the number of symbols is the end of the last .gnu.hash chain */
+static size_t get_gnu_sym_num(resolve_obj_t *o) {
+    gnuhash_t *gh = o->gnu_hash;
+    size_t word = o->class == ELFCLASS32 ? 4 : 8;
+    uint32_t *buckets = (uint32_t *)((uint8_t *)gh->buckets + gh->maskbits * word);
+    uint32_t *chain = buckets + gh->nbuckets;
+    uint32_t max = 0;
+
+    for (uint32_t i = 0; i < gh->nbuckets; i++) {
+        if (buckets[i] > max)
+            max = buckets[i];
+    }
+    if (max < gh->symndx) {
+        return gh->symndx;
+    }
+    for (uint32_t *p = chain + max - gh->symndx; (uint8_t *)(p + 1) <= o->mem + o->size; p++, max++) {
+        if (*p & 1)
+            return max + 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 解析.dynamic，建立导出符号索引。MODE必须与文件一致，不同的对象可以并行解析
+ * parse .dynamic and set up the export index. MODE must match the file, different
+ * objects can be parsed in parallel
+ * @param o object
+ * @return int error code {-1:error,0:sucess}
+ */
+int resolve_parse_obj(resolve_obj_t *o) {
+    load_index_t loads;
+    uint64_t dyn_off = 0, dyn_num = 0;
+    uint64_t strtab = 0, symtab = 0, gnu_hash = 0, hash = 0;
+    uint64_t soname = -1, rpath = -1, runpath = -1;
+    uint64_t offset;
+    size_t sym_size = o->class == ELFCLASS32 ? sizeof(Elf32_Sym) : sizeof(Elf64_Sym);
+    size_t word = o->class == ELFCLASS32 ? 4 : 8;
+
+    if (o->parsed) {
+        return o->parsed == 1 ? 0 : -1;
+    }
+    o->parsed = -1;
+
+    if (MODE == ELFCLASS32) {
+        Elf32_Ehdr *ehdr = (Elf32_Ehdr *)o->mem;
+        Elf32_Phdr *phdr = (Elf32_Phdr *)(o->mem + ehdr->e_phoff);
+        if (o->size < sizeof(Elf32_Ehdr) || ehdr->e_phoff + ehdr->e_phnum * sizeof(Elf32_Phdr) > o->size)
+            return -1;
+        o->machine = ehdr->e_machine;
+        for (int i = 0; i < ehdr->e_phnum; i++) {
+            if (phdr[i].p_type == PT_INTERP)
+                o->interp = 1;
+            if (phdr[i].p_type == PT_DYNAMIC && !dyn_num) {
+                dyn_off = phdr[i].p_offset;
+                dyn_num = phdr[i].p_filesz / sizeof(Elf32_Dyn);
+            }
+        }
+        if (!dyn_num || dyn_off + dyn_num * sizeof(Elf32_Dyn) > o->size)
+            return -1;
+        o->needed = malloc(dyn_num * sizeof(uint32_t));
+        if (!o->needed)
+            return -1;
+        Elf32_Dyn *dyn = (Elf32_Dyn *)(o->mem + dyn_off);
+        for (int i = 0; i < dyn_num && dyn[i].d_tag != DT_NULL; i++) {
+            switch (dyn[i].d_tag) {
+                case DT_NEEDED:
+                    o->needed[o->needed_num++] = dyn[i].d_un.d_val;
+                    break;
+                case DT_STRTAB:
+                    strtab = dyn[i].d_un.d_ptr;
+                    break;
+                case DT_STRSZ:
+                    o->str_size = dyn[i].d_un.d_val;
+                    break;
+                case DT_SYMTAB:
+                    symtab = dyn[i].d_un.d_ptr;
+                    break;
+                case DT_GNU_HASH:
+                    gnu_hash = dyn[i].d_un.d_ptr;
+                    break;
+                case DT_HASH:
+                    hash = dyn[i].d_un.d_ptr;
+                    break;
+                case DT_SONAME:
+                    soname = dyn[i].d_un.d_val;
+                    break;
+                case DT_RPATH:
+                    rpath = dyn[i].d_un.d_val;
+                    break;
+                case DT_RUNPATH:
+                    runpath = dyn[i].d_un.d_val;
+                    break;
+            }
+        }
+    }
+
+    if (MODE == ELFCLASS64) {
+        Elf64_Ehdr *ehdr = (Elf64_Ehdr *)o->mem;
+        Elf64_Phdr *phdr = (Elf64_Phdr *)(o->mem + ehdr->e_phoff);
+        if (o->size < sizeof(Elf64_Ehdr) || ehdr->e_phoff + ehdr->e_phnum * sizeof(Elf64_Phdr) > o->size)
+            return -1;
+        o->machine = ehdr->e_machine;
+        for (int i = 0; i < ehdr->e_phnum; i++) {
+            if (phdr[i].p_type == PT_INTERP)
+                o->interp = 1;
+            if (phdr[i].p_type == PT_DYNAMIC && !dyn_num) {
+                dyn_off = phdr[i].p_offset;
+                dyn_num = phdr[i].p_filesz / sizeof(Elf64_Dyn);
+            }
+        }
+        if (!dyn_num || dyn_off + dyn_num * sizeof(Elf64_Dyn) > o->size)
+            return -1;
+        o->needed = malloc(dyn_num * sizeof(uint32_t));
+        if (!o->needed)
+            return -1;
+        Elf64_Dyn *dyn = (Elf64_Dyn *)(o->mem + dyn_off);
+        for (int i = 0; i < dyn_num && dyn[i].d_tag != DT_NULL; i++) {
+            switch (dyn[i].d_tag) {
+                case DT_NEEDED:
+                    o->needed[o->needed_num++] = dyn[i].d_un.d_val;
+                    break;
+                case DT_STRTAB:
+                    strtab = dyn[i].d_un.d_ptr;
+                    break;
+                case DT_STRSZ:
+                    o->str_size = dyn[i].d_un.d_val;
+                    break;
+                case DT_SYMTAB:
+                    symtab = dyn[i].d_un.d_ptr;
+                    break;
+                case DT_GNU_HASH:
+                    gnu_hash = dyn[i].d_un.d_ptr;
+                    break;
+                case DT_HASH:
+                    hash = dyn[i].d_un.d_ptr;
+                    break;
+                case DT_SONAME:
+                    soname = dyn[i].d_un.d_val;
+                    break;
+                case DT_RPATH:
+                    rpath = dyn[i].d_un.d_val;
+                    break;
+                case DT_RUNPATH:
+                    runpath = dyn[i].d_un.d_val;
+                    break;
+            }
+        }
+    }
+
+    if (init_load_index(o->mem, o->size, &loads)) {
+        return -1;
+    }
+
+    /* .dynstr must end with '\0' */
+    if (!o->str_size || load_addr_to_offset(&loads, strtab, o->str_size, &offset) ||
+        o->mem[offset + o->str_size - 1]) {
+        goto ERR_EXIT;
+    }
+    o->str = (char *)o->mem + offset;
+    if (load_addr_to_offset(&loads, symtab, sym_size, &offset)) {
+        goto ERR_EXIT;
+    }
+    o->sym = o->mem + offset;
+
+    if (gnu_hash && !load_addr_to_offset(&loads, gnu_hash, sizeof(gnuhash_t), &offset)) {
+        gnuhash_t *gh = (gnuhash_t *)(o->mem + offset);
+        if (gh->nbuckets && gh->maskbits &&
+            offset + sizeof(gnuhash_t) + (uint64_t)gh->maskbits * word + (uint64_t)gh->nbuckets * 4 <= o->size) {
+            o->gnu_hash = gh;
+            o->sym_num = get_gnu_sym_num(o);
+        }
+    }
+    if (hash && !load_addr_to_offset(&loads, hash, 8, &offset)) {
+        uint32_t *h = (uint32_t *)(o->mem + offset);
+        if (h[0] && offset + 8 + ((uint64_t)h[0] + h[1]) * 4 <= o->size) {
+            o->hash = h;
+            o->sym_num = h[1];
+        }
+    }
+    if ((o->sym - o->mem) + o->sym_num * sym_size > o->size) {
+        o->sym_num = (o->size - (o->sym - o->mem)) / sym_size;
+    }
+
+    o->soname = soname < o->str_size ? o->str + soname : NULL;
+    o->rpath = rpath < o->str_size ? o->str + rpath : NULL;
+    o->runpath = runpath < o->str_size ? o->str + runpath : NULL;
+    o->has_vers = !init_version_index(o->mem, o->size, &o->vers);
+    finit_load_index(&loads);
+    o->parsed = 1;
+    return 0;
+
+ERR_EXIT:
+    finit_load_index(&loads);
+    return -1;
+}
+
+static resolve_obj_t *open_compatible(resolve_ctx_t *ctx, char *path, int machine) {
+    resolve_obj_t *o = resolve_load_obj(ctx, path);
+    /* ld.so skips the files of another class or machine and keeps searching */
+    if (!o || o->class != MODE || resolve_parse_obj(o) || o->machine != machine) {
+        return NULL;
+    }
+    return o;
+}
+
+/**
+ * @brief 展开$ORIGIN和$LIB，绝对路径加上sysroot
+ * expand $ORIGIN and $LIB, absolute directories are prefixed with sysroot
+ */
+static int expand_dir(resolve_ctx_t *ctx, char *dir, resolve_obj_t *origin, char *out) {
+    char tmp[PATH_MAX];
+    char *slash;
+    size_t len = 0;
+    char *p = dir;
+
+    if (dir[0] == '/') {
+        len = snprintf(out, PATH_MAX, "%s", ctx->sysroot);
+    }
+    while (*p && len < PATH_MAX - 1) {
+        char *value = NULL;
+        if (*p != '$') {
+            out[len++] = *p++;
+            continue;
+        }
+        if (!strncmp(p, "$ORIGIN", 7) || !strncmp(p, "${ORIGIN}", 9)) {
+            p += p[1] == '{' ? 9 : 7;
+            /* the origin is a path of the file, the sysroot is already in it */
+            if (snprintf(tmp, sizeof(tmp), "%s", origin->path) >= sizeof(tmp))
+                return -1;
+            slash = strrchr(tmp, '/');
+            if (slash)
+                *slash = '\0';
+            else
+                strcpy(tmp, ".");
+            value = tmp;
+        } else if (!strncmp(p, "$LIB", 4) || !strncmp(p, "${LIB}", 6)) {
+            p += p[1] == '{' ? 6 : 4;
+            value = MODE == ELFCLASS64 ? "lib64" : "lib";
+        } else {
+            /* $PLATFORM depends on the running CPU */
+            return -1;
+        }
+        len += snprintf(out + len, PATH_MAX - len, "%s", value);
+    }
+    if (len >= PATH_MAX) {
+        return -1;
+    }
+    out[len] = '\0';
+    return 0;
+}
+
+static resolve_obj_t *search_list(resolve_ctx_t *ctx, char *list, resolve_obj_t *origin, char *name, int machine) {
+    char buf[PATH_MAX];
+    char dir[PATH_MAX];
+    char path[PATH_MAX];
+    char *save, *tok;
+    resolve_obj_t *o;
+
+    if (snprintf(buf, sizeof(buf), "%s", list) >= sizeof(buf)) {
+        WARNING("search path %s is too long\n", list);
+        return NULL;
+    }
+    for (tok = strtok_r(buf, ":", &save); tok; tok = strtok_r(NULL, ":", &save)) {
+        if (expand_dir(ctx, tok, origin, dir))
+            continue;
+        /* a truncated path may name another file */
+        if (snprintf(path, sizeof(path), "%s/%s", dir, name) >= sizeof(path))
+            continue;
+        o = open_compatible(ctx, path, machine);
+        if (o)
+            return o;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 按照ld.so的顺序查找DT_NEEDED：DT_RPATH，DT_RUNPATH，ld.so.conf，默认目录
+ * search a DT_NEEDED entry in the order of ld.so: DT_RPATH, DT_RUNPATH,
+ * ld.so.conf and the default directories
+ * @param ctx resolver
+ * @param exe executable, its DT_RPATH is inherited
+ * @param o object with the DT_NEEDED entry
+ * @param name DT_NEEDED entry
+ * @return resolve_obj_t* parsed object, NULL if it is not found
+ */
+resolve_obj_t *resolve_find_needed(resolve_ctx_t *ctx, resolve_obj_t *exe, resolve_obj_t *o, char *name) {
+    char path[PATH_MAX];
+    char key[PATH_MAX];
+    uint64_t hash, value;
+    resolve_obj_t *found = NULL;
+    size_t len;
+    char *copy;
+
+    if (strchr(name, '/')) {
+        if (snprintf(path, sizeof(path), "%s%s", name[0] == '/' ? ctx->sysroot : "", name) >= sizeof(path))
+            return NULL;
+        return open_compatible(ctx, path, exe->machine);
+    }
+
+    /* DT_RPATH is ignored if DT_RUNPATH exists, the one of the executable is inherited */
+    if (o->rpath && !o->runpath) {
+        found = search_list(ctx, o->rpath, o, name, exe->machine);
+        if (!found && o != exe && exe->rpath && !exe->runpath)
+            found = search_list(ctx, exe->rpath, exe, name, exe->machine);
+    }
+    if (!found && o->runpath) {
+        found = search_list(ctx, o->runpath, o, name, exe->machine);
+    }
+    if (found) {
+        return found;
+    }
+
+    /* the default directories give the same answer for every binary */
+    len = snprintf(key, sizeof(key), "%d/%d/%s", MODE, exe->machine, name);
+    if (len >= sizeof(key)) {
+        return NULL;
+    }
+    hash = hash_bytes(key, len);
+    if (!hashmap_get(&ctx->names, hash, key, len, &value)) {
+        return (resolve_obj_t *)value;
+    }
+    for (int i = 0; i < ctx->dir_num && !found; i++) {
+        if (snprintf(path, sizeof(path), "%s%s/%s", ctx->sysroot, ctx->dirs[i], name) >= sizeof(path))
+            continue;
+        found = open_compatible(ctx, path, exe->machine);
+    }
+    copy = strdup(key);
+    if (copy && hashmap_put(&ctx->names, hash, copy, len, (uint64_t)found) == -1) {
+        free(copy);
+    }
+    return found;
+}
+
+static int add_dir(resolve_ctx_t *ctx, char *dir) {
+    size_t len = strlen(dir);
+    char **tmp;
+
+    while (len > 1 && dir[len - 1] == '/') {
+        dir[--len] = '\0';
+    }
+    for (int i = 0; i < ctx->dir_num; i++) {
+        if (!strcmp(ctx->dirs[i], dir))
+            return 0;
+    }
+    tmp = realloc(ctx->dirs, (ctx->dir_num + 1) * sizeof(char *));
+    if (!tmp) {
+        return -1;
+    }
+    ctx->dirs = tmp;
+    ctx->dirs[ctx->dir_num] = strdup(dir);
+    if (!ctx->dirs[ctx->dir_num]) {
+        return -1;
+    }
+    ctx->dir_num++;
+    return 0;
+}
+
+/**
+ * @brief 读取ld.so.conf，ldconfig用它生成ld.so.cache
+ * read ld.so.conf, the source of ld.so.cache
+ */
+static void read_ld_so_conf(resolve_ctx_t *ctx, char *conf, int depth) {
+    char path[PATH_MAX];
+    char line[PATH_MAX];
+    char *tok;
+    glob_t g;
+    FILE *fp;
+
+    if (depth > RESOLVE_CONF_DEPTH) {
+        return;
+    }
+    if (snprintf(path, sizeof(path), "%s%s", ctx->sysroot, conf) >= sizeof(path)) {
+        return;
+    }
+    fp = fopen(path, "r");
+    if (!fp) {
+        return;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        tok = strtok(line, " \t\r\n");
+        if (!tok || !strcmp(tok, "hwcap")) {
+            continue;
+        }
+        if (!strcmp(tok, "include")) {
+            while ((tok = strtok(NULL, " \t\r\n"))) {
+                /* relative patterns are relative to the directory of ld.so.conf */
+                if (snprintf(path, sizeof(path), "%s%s%s", ctx->sysroot, tok[0] == '/' ? "" : "/etc/", tok) >= sizeof(path) ||
+                    glob(path, 0, NULL, &g))
+                    continue;
+                for (size_t i = 0; i < g.gl_pathc; i++) {
+                    read_ld_so_conf(ctx, g.gl_pathv[i] + strlen(ctx->sysroot), depth + 1);
+                }
+                globfree(&g);
+            }
+            continue;
+        }
+        for (; tok; tok = strtok(NULL, " \t\r\n:,")) {
+            if (tok[0] == '/')
+                add_dir(ctx, tok);
+        }
+    }
+    fclose(fp);
+}
+
+/**
+ * @brief 初始化符号解析上下文，读取sysroot中的ld.so.conf
+ * initialize the resolver, read ld.so.conf of the sysroot
+ * @param sysroot root directory of the libraries, NULL or "" for /
+ * @param ctx output, free it with finit_resolve
+ * @return int error code {-1:error,0:sucess}
+ */
+int init_resolve(char *sysroot, resolve_ctx_t *ctx) {
+    char *defaults[] = {"/lib64", "/usr/lib64", "/lib", "/usr/lib"};
+    size_t len;
+
+    memset(ctx, 0, sizeof(resolve_ctx_t));
+    ctx->sysroot = strdup(sysroot ? sysroot : "");
+    if (!ctx->sysroot) {
+        return -1;
+    }
+    len = strlen(ctx->sysroot);
+    while (len && ctx->sysroot[len - 1] == '/') {
+        ctx->sysroot[--len] = '\0';
+    }
+
+    if (hashmap_init(&ctx->objs, 1024) || hashmap_init(&ctx->inodes, 1024) || hashmap_init(&ctx->names, 1024)) {
+        finit_resolve(ctx);
+        return -1;
+    }
+
+    read_ld_so_conf(ctx, "/etc/ld.so.conf", 0);
+    for (int i = 0; i < sizeof(defaults) / sizeof(defaults[0]); i++) {
+        char dir[PATH_MAX];
+        snprintf(dir, sizeof(dir), "%s", defaults[i]);
+        add_dir(ctx, dir);
+    }
+    return 0;
+}
+
+void finit_resolve(resolve_ctx_t *ctx) {
+    /* an object may have several paths, but only one inode */
+    for (size_t i = 0; i < ctx->inodes.cap; i++) {
+        resolve_obj_t *o = (resolve_obj_t *)ctx->inodes.entries[i].value;
+        if (!ctx->inodes.entries[i].key)
+            continue;
+        if (o->has_vers)
+            finit_version_index(&o->vers);
+        free(o->needed);
+        munmap(o->mem, o->size);
+        free(o);
+    }
+    for (size_t i = 0; i < ctx->objs.cap; i++) {
+        free((void *)ctx->objs.entries[i].key);
+    }
+    for (size_t i = 0; i < ctx->names.cap; i++) {
+        free((void *)ctx->names.entries[i].key);
+    }
+    hashmap_free(&ctx->objs);
+    hashmap_free(&ctx->inodes);
+    hashmap_free(&ctx->names);
+    for (int i = 0; i < ctx->dir_num; i++) {
+        free(ctx->dirs[i]);
+    }
+    free(ctx->dirs);
+    free(ctx->sysroot);
+    memset(ctx, 0, sizeof(resolve_ctx_t));
+}
+
+/**
+ * @brief 检查符号版本，与ld.so的check_match一致
+ * check the version of a definition like check_match of ld.so
+ * @return int {0:reject,1:accept,2:accept if it is the only versioned definition}
+ */
+static int match_version(resolve_obj_t *o, size_t index, char *version) {
+    uint16_t versym;
+    char *def;
+
+    if (!o->has_vers || index >= o->vers.sym_num) {
+        return 1;
+    }
+    versym = o->vers.versym[index];
+    def = get_symbol_version(&o->vers, index, NULL);
+    if (version) {
+        if (def && !strcmp(def, version))
+            return 1;
+        /* an unversioned definition satisfies a versioned reference */
+        return !def && (versym & VERSYM_VERSION) <= VER_NDX_GLOBAL && !(versym & VERSYM_HIDDEN);
+    }
+    /* an unversioned reference takes the base version, or the only default version */
+    if ((versym & VERSYM_VERSION) < 3) {
+        return 1;
+    }
+    return versym & VERSYM_HIDDEN ? 0 : 2;
+}
+
+static int check_sym(resolve_obj_t *o, size_t index, char *name, char *version, size_t *candidate, int *candidates) {
+    resolve_sym_t s;
+    int type;
+    int ret;
+
+    get_sym(o, index, &s);
+    type = ELF64_ST_TYPE(s.info);
+    if (s.shndx == SHN_UNDEF || (!s.value && type != STT_TLS) || ELF64_ST_BIND(s.info) == STB_LOCAL) {
+        return 0;
+    }
+    if (type != STT_NOTYPE && type != STT_OBJECT && type != STT_FUNC && type != STT_COMMON &&
+        type != STT_TLS && type != STT_GNU_IFUNC) {
+        return 0;
+    }
+    if (strcmp(resolve_get_str(o, s.name), name)) {
+        return 0;
+    }
+    ret = match_version(o, index, version);
+    if (ret == 2) {
+        if (!(*candidates)++)
+            *candidate = index;
+        return 0;
+    }
+    if (ret == 1) {
+        *candidate = index;
+    }
+    return ret;
+}
+
+/**
+ * @brief 在一个对象的导出符号中查找，优先使用磁盘上的.gnu.hash
+ * look up a symbol in the exports of an object, with the .gnu.hash on disk if any
+ * @return int {-1:not found,0:found}
+ */
+static int lookup_obj(resolve_obj_t *o, char *name, uint32_t gnu, uint32_t sysv, char *version, size_t *index) {
+    size_t candidate = 0;
+    int candidates = 0;
+
+    if (o->gnu_hash) {
+        gnuhash_t *gh = o->gnu_hash;
+        size_t word = o->class == ELFCLASS32 ? 4 : 8;
+        uint32_t bits = word * 8;
+        uint32_t *buckets = (uint32_t *)((uint8_t *)gh->buckets + gh->maskbits * word);
+        uint32_t *chain = buckets + gh->nbuckets;
+        uint64_t bloom, mask;
+
+        /* a miss usually stops at the bloom filter */
+        if (o->class == ELFCLASS32)
+            bloom = ((uint32_t *)gh->buckets)[(gnu / bits) % gh->maskbits];
+        else
+            bloom = ((uint64_t *)gh->buckets)[(gnu / bits) % gh->maskbits];
+        mask = (1ULL << (gnu % bits)) | (1ULL << ((gnu >> gh->shift) % bits));
+        if ((bloom & mask) != mask) {
+            return -1;
+        }
+
+        for (uint32_t i = buckets[gnu % gh->nbuckets]; i >= gh->symndx && i < o->sym_num; i++) {
+            uint32_t h = chain[i - gh->symndx];
+            if ((h | 1) == (gnu | 1) && check_sym(o, i, name, version, &candidate, &candidates) == 1) {
+                *index = candidate;
+                return 0;
+            }
+            if (h & 1)
+                break;
+        }
+    } else if (o->hash) {
+        uint32_t nbucket = o->hash[0];
+        uint32_t nchain = o->hash[1];
+        uint32_t *bucket = o->hash + 2;
+        uint32_t *chain = bucket + nbucket;
+        uint32_t n = 0;
+
+        for (uint32_t i = bucket[sysv % nbucket]; i && i < nchain && n < nchain; i = chain[i], n++) {
+            if (check_sym(o, i, name, version, &candidate, &candidates) == 1) {
+                *index = candidate;
+                return 0;
+            }
+        }
+    }
+
+    if (candidates == 1) {
+        *index = candidate;
+        return 0;
+    }
+    return -1;
+}
+
+static int add_scope(resolve_obj_t ***scope, int *num, int *cap, resolve_obj_t *o) {
+    for (int i = 0; i < *num; i++) {
+        if ((*scope)[i] == o)
+            return 0;
+    }
+    if (*num == *cap) {
+        int new_cap = *cap ? *cap * 2 : 16;
+        resolve_obj_t **tmp = realloc(*scope, new_cap * sizeof(resolve_obj_t *));
+        if (!tmp)
+            return -1;
+        *scope = tmp;
+        *cap = new_cap;
+    }
+    (*scope)[(*num)++] = o;
+    return 1;
+}
+
+/**
+ * @brief 模拟ld.so，不运行程序，找到每个导入符号所在的DT_NEEDED库
+ * emulate the lookup of ld.so without running the binary: find the DT_NEEDED
+ * library defining each import, report undefined imports and interpositions
+ * @param ctx resolver, the libraries are cached across calls
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int resolve_imports(resolve_ctx_t *ctx, char *elf_name) {
+    resolve_obj_t **scope = NULL;
+    resolve_obj_t *exe, *o;
+    int num = 0, cap = 0;
+    char display[PATH_MAX];
+    resolve_sym_t s;
+    size_t index;
+
+    exe = resolve_load_obj(ctx, elf_name);
+    if (!exe) {
+        ERROR("%s is not an ELF file\n", elf_name);
+        return -1;
+    }
+    MODE = exe->class;
+    if (resolve_parse_obj(exe)) {
+        WARNING("%s is statically linked\n", elf_name);
+        return -1;
+    }
+
+    /* the global scope is the breadth-first order of DT_NEEDED */
+    INFO("%s\n", elf_name);
+    if (add_scope(&scope, &num, &cap, exe) == -1) {
+        return -1;
+    }
+    for (int i = 0; i < num; i++) {
+        for (int j = 0; j < scope[i]->needed_num; j++) {
+            char *name = resolve_get_str(scope[i], scope[i]->needed[j]);
+            int loaded = 0;
+            /* a loaded object is reused if its DT_SONAME matches */
+            for (int k = 0; k < num && !loaded; k++) {
+                loaded = scope[k]->soname && !strcmp(scope[k]->soname, name);
+            }
+            if (loaded) {
+                continue;
+            }
+            o = resolve_find_needed(ctx, exe, scope[i], name);
+            if (!o) {
+                printf("    %s => not found\n", name);
+                continue;
+            }
+            if (add_scope(&scope, &num, &cap, o) == 1) {
+                printf("    %s => %s\n", name, o->path);
+            }
+        }
+    }
+
+    printf("    [%2s] %-40s %s\n", "Nr", "Symbol", "Object");
+    for (size_t i = 1; i < exe->sym_num; i++) {
+        char *name, *version;
+        int hidden, winner = -1;
+
+        get_sym(exe, i, &s);
+        name = resolve_get_str(exe, s.name);
+        if (!*name || ELF64_ST_BIND(s.info) == STB_LOCAL) {
+            continue;
+        }
+        version = exe->has_vers ? get_symbol_version(&exe->vers, i, &hidden) : NULL;
+        if (version) {
+            snprintf(display, sizeof(display), "%s%s%s", name,
+                s.shndx == SHN_UNDEF || hidden ? "@" : "@@", version);
+        } else {
+            snprintf(display, sizeof(display), "%s", name);
+        }
+
+        uint32_t gnu = dl_new_hash(name);
+        uint32_t sysv = elf_hash(name);
+
+        /* an import is bound to the first definition in the scope */
+        if (s.shndx == SHN_UNDEF) {
+            for (int j = 1; j < num; j++) {
+                if (lookup_obj(scope[j], name, gnu, sysv, version, &index))
+                    continue;
+                if (winner == -1) {
+                    winner = j;
+                    ctx->bindings++;
+                    printf("    [%2lu] %-40s %s\n", i, display, scope[j]->path);
+                } else {
+                    ctx->interposed++;
+                    printf("    [%2lu] %-40s %s (interposed by %s)\n", i, display, scope[j]->path, scope[winner]->path);
+                }
+            }
+            if (winner == -1) {
+                ctx->undefined++;
+                printf("    [%2lu] %-40s %s\n", i, display, ELF64_ST_BIND(s.info) == STB_WEAK ? "UNDEF (weak)" : "UNDEF");
+            }
+            continue;
+        }
+
+        /* an exported definition, e.g. a copy relocation, interposes the libraries */
+        for (int j = 1; j < num; j++) {
+            if (lookup_obj(scope[j], name, gnu, sysv, version, &index))
+                continue;
+            ctx->interposed++;
+            printf("    [%2lu] %-40s %s (interposed by %s)\n", i, display, scope[j]->path, elf_name);
+        }
+    }
+
+    free(scope);
+    return 0;
+}
+
+/**
+ * @brief 解析ELF以及列表文件中所有ELF的导入符号
+ * resolve the imports of ELF and of every ELF in the list file
+ * @param sysroot root directory of the libraries, NULL or "" for /
+ * @param list_name file with one ELF path per line (optional)
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int resolve(char *sysroot, char *list_name, char *elf_name) {
+    resolve_ctx_t ctx;
+    char line[PATH_MAX];
+    int count = 1;
+    FILE *fp;
+
+    if (init_resolve(sysroot, &ctx)) {
+        ERROR("init resolver error\n");
+        return -1;
+    }
+
+    resolve_imports(&ctx, elf_name);
+    if (list_name && list_name[0]) {
+        fp = fopen(list_name, "r");
+        if (!fp) {
+            perror("fopen");
+            finit_resolve(&ctx);
+            return -1;
+        }
+        while (fgets(line, sizeof(line), fp)) {
+            char *name = strtok(line, "\r\n");
+            if (!name || name[0] == '#')
+                continue;
+            resolve_imports(&ctx, name);
+            count++;
+        }
+        fclose(fp);
+    }
+
+    INFO("%d binaries, %lu bindings, %lu undefined, %lu interposed, %lu paths cached\n",
+        count, ctx.bindings, ctx.undefined, ctx.interposed, ctx.objs.num);
+    finit_resolve(&ctx);
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+/* a shared object of the sysroot, mapped once and shared by all binaries of a batch */
+typedef struct resolve_obj {
+    char *path;             // the first path of the file
+    uint64_t id[2];         // device and inode, key of the inode cache
+    uint8_t *mem;
+    size_t size;
+    int class;
+    int machine;
+    int parsed;             // {-1:error,0:not parsed,1:parsed}
+    uint8_t *sym;           // .dynsym
+    size_t sym_num;
+    char *str;              // .dynstr
+    size_t str_size;
+    gnuhash_t *gnu_hash;    // export index, NULL if the object has no DT_GNU_HASH
+    uint32_t *hash;         // DT_HASH
+    version_index_t vers;
+    int has_vers;
+    char *soname;
+    char *rpath;
+    char *runpath;
+    uint32_t *needed;       // .dynstr offsets of DT_NEEDED
+    int needed_num;
+    int interp;             // has PT_INTERP
+} resolve_obj_t;
+
+typedef struct resolve_ctx {
+    char *sysroot;
+    hashmap_t objs;         // path -> resolve_obj_t *, 0 if the path is not an ELF
+    hashmap_t inodes;       // device and inode -> resolve_obj_t *, owns the objects
+    hashmap_t names;        // "class/DT_NEEDED" -> resolve_obj_t * found in the default directories
+    char **dirs;            // ld.so.conf and the default directories
+    int dir_num;
+    uint64_t bindings;
+    uint64_t undefined;
+    uint64_t interposed;
+} resolve_ctx_t;
+
+/**
+ * @brief 初始化符号解析上下文，读取sysroot中的ld.so.conf
+ * initialize the resolver, read ld.so.conf of the sysroot
+ * @param sysroot root directory of the libraries, NULL or "" for /
+ * @param ctx output, free it with finit_resolve
+ * @return int error code {-1:error,0:sucess}
+ */
+int init_resolve(char *sysroot, resolve_ctx_t *ctx);
+void finit_resolve(resolve_ctx_t *ctx);
+
+/**
+ * @brief 映射文件，每个路径只打开一次，每个inode只映射一次
+ * map a file, each path is opened once and each inode is mapped once
+ * @param ctx resolver
+ * @param path file path
+ * @return resolve_obj_t* object, NULL if the file is not an ELF
+ */
+resolve_obj_t *resolve_load_obj(resolve_ctx_t *ctx, char *path);
+
+/**
+ * @brief 解析.dynamic，建立导出符号索引。MODE必须与文件一致，不同的对象可以并行解析
+ * parse .dynamic and set up the export index. MODE must match the file, different
+ * objects can be parsed in parallel
+ * @param o object
+ * @return int error code {-1:error,0:sucess}
+ */
+int resolve_parse_obj(resolve_obj_t *o);
+
+/**
+ * @brief 按照ld.so的顺序查找DT_NEEDED：DT_RPATH，DT_RUNPATH，ld.so.conf，默认目录
+ * search a DT_NEEDED entry in the order of ld.so: DT_RPATH, DT_RUNPATH,
+ * ld.so.conf and the default directories
+ * @param ctx resolver
+ * @param exe executable, its DT_RPATH is inherited
+ * @param o object with the DT_NEEDED entry
+ * @param name DT_NEEDED entry
+ * @return resolve_obj_t* parsed object, NULL if it is not found
+ */
+resolve_obj_t *resolve_find_needed(resolve_ctx_t *ctx, resolve_obj_t *exe, resolve_obj_t *o, char *name);
+
+/**
+ * @brief 得到.dynstr中的字符串
+ * get a string of .dynstr
+ * @param o parsed object
+ * @param offset offset in .dynstr
+ * @return char* string, "" if the offset is out of .dynstr
+ */
+char *resolve_get_str(resolve_obj_t *o, uint64_t offset);
+
+/**
+ * @brief 模拟ld.so，不运行程序，找到每个导入符号所在的DT_NEEDED库
+ * emulate the lookup of ld.so without running the binary: find the DT_NEEDED
+ * library defining each import, report undefined imports and interpositions
+ * @param ctx resolver, the libraries are cached across calls
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int resolve_imports(resolve_ctx_t *ctx, char *elf_name);
+
+/**
+ * @brief 解析ELF以及列表文件中所有ELF的导入符号
+ * resolve the imports of ELF and of every ELF in the list file
+ * @param sysroot root directory of the libraries, NULL or "" for /
+ * @param list_name file with one ELF path per line (optional)
+ * @param elf_name elf file name
+ * @return int error code {-1:error,0:sucess}
+ */
+int resolve(char *sysroot, char *list_name, char *elf_name);
@@ -32,6 +32,7 @@
 #include <sys/mman.h>
 #include <elf.h>
 #include "common.h"
+#include "journal.h"
 #include "cJSON/cJSON.h"
 
 /**
@@ -122,6 +123,14 @@ static int mov_shdr(char *elf_name, uint64_t offset) {
 
     file_size = st.st_size;
 
+    /* the headers and everything behind offset will be overwritten */
+    if (journal_headers(elf_name)) {
+        goto ERR_EXIT;
+    }
+    if (offset < st.st_size && journal_region(elf_name, offset, st.st_size - offset)) {
+        goto ERR_EXIT;
+    }
+
     /* 32bit */
     if (MODE == ELFCLASS32) {
         Elf32_Ehdr *ehdr = (Elf32_Ehdr *)mapped;
@@ -204,6 +213,10 @@ int add_shdr(char *elfname) {
         return -1;
     }
 
+    if (journal_headers(elfname)) {
+        close(fd);
+        return -1;
+    }
     if (MODE == ELFCLASS32) {
         tmpsize = st.st_size + sizeof(Elf32_Shdr);
     }
@@ -260,7 +273,9 @@ int add_section(char *elfname, size_t size) {
     if(is_shdr_end(elfname) != 1) {
         VERBOSE("section header table is not at the end of the file\n");
         VERBOSE("move section header table\n");
-        mov_shdr(elfname, get_file_size(elfname));
+        if (mov_shdr(elfname, get_file_size(elfname))) {
+            return -1;
+        }
     } else {
         VERBOSE("section header table is at the end of the file\n");
     }
@@ -268,14 +283,17 @@ int add_section(char *elfname, size_t size) {
     // 节头表往后移size
     // move the section header table back size
     secoffset = get_shdr_offset(elfname);
-    if (size) {
-        mov_shdr(elfname, secoffset + size);
+    if (size && mov_shdr(elfname, secoffset + size)) {
+        return -1;
     }
     VERBOSE("move the shdr: %d\n", size);
 
     // 如果节头表在ELF文件末尾处，直接增加一个节头
     // if section header is at the end of elf
     index = add_shdr(elfname);
+    if (index == -1) {
+        return -1;
+    }
     VERBOSE("add a shdr: [%d]\n", index);
 
     // 设置新增的节的参数
@@ -291,6 +309,10 @@ int add_section(char *elfname, size_t size) {
         return -1;
     }
 
+    if (journal_headers(elfname)) {
+        close(fd);
+        return -1;
+    }
     mapped = mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
     if (mapped == MAP_FAILED) {
         perror("mmap");
@@ -23,9 +23,11 @@
 */
 
 #define _GNU_SOURCE 1
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -33,6 +35,8 @@
 #include <elf.h>
 #include "common.h"
 #include "segment.h"
+#include "hashmap.h"
+#include "journal.h"
 #include "cJSON/cJSON.h"
 
 /**
@@ -231,7 +235,7 @@ static int mov_phdr(char *elf_name, uint64_t offset, int need_load) {
     int fd;
     struct stat st;
     void *mapped;
-    uint64_t phdr_start;
+    uint64_t phdr_start = 0;
     uint64_t phdr_end;
     size_t phdr_size;
     size_t file_size;
@@ -265,6 +269,14 @@ static int mov_phdr(char *elf_name, uint64_t offset, int need_load) {
 
     file_size = st.st_size;
 
+    /* the headers and everything behind offset will be overwritten */
+    if (journal_headers(elf_name)) {
+        goto ERR_EXIT;
+    }
+    if (offset < st.st_size && journal_region(elf_name, offset, st.st_size - offset)) {
+        goto ERR_EXIT;
+    }
+
     /* 32bit */
     if (MODE == ELFCLASS32) {
         Elf32_Ehdr *ehdr;
@@ -428,6 +440,10 @@ int add_phdr_entry(char *elf_name) {
         return -1;
     }
 
+    if (journal_headers(elf_name)) {
+        close(fd);
+        return -1;
+    }
     if (MODE == ELFCLASS32) {
         tmpsize = st.st_size + sizeof(Elf32_Phdr);
     }
@@ -491,20 +507,27 @@ int add_segment(char *elf_name, int type, size_t size) {
     if(is_phdr_end(elf_name) != 1) {
         VERBOSE("program header table is not at the end of the file\n");
         VERBOSE("move program header table\n");
-        mov_phdr(elf_name, get_file_size(elf_name), 1);
+        if (mov_phdr(elf_name, get_file_size(elf_name), 1) == -1) {
+            return -1;
+        }
     } else {
         VERBOSE("program header table is at the end of the file\n");
     }
 
-    // 程序头往后移size
-    // move the program header table back size
-    segoffset = get_phdr_offset(elf_name);
-    mov_phdr(elf_name, segoffset + size, 0);
+    // 程序头往后移size，段和程序头都按8字节对齐，保证符号表、版本表等可以直接访问
+    // move the program header table back size, both of them are aligned to 8 bytes
+    // for the tables stored in the new segment, such as .dynsym and .gnu.version_r
+    segoffset = ALIGN(get_phdr_offset(elf_name), 8);
+    if (mov_phdr(elf_name, ALIGN(segoffset + size, 8), 0) == -1) {
+        return -1;
+    }
     VERBOSE("move the phdr: %d\n", size);
 
     // 如果程序头在ELF文件末尾处，直接增加一个程序头表项
     // if program header is at the end of elf
-    add_phdr_entry(elf_name);
+    if (add_phdr_entry(elf_name)) {
+        return -1;
+    }
     VERBOSE("add a phdr\n");
 
     // 计算LOAD段的地址空间范围
@@ -525,6 +548,10 @@ int add_segment(char *elf_name, int type, size_t size) {
         return -1;
     }
 
+    if (journal_headers(elf_name)) {
+        close(fd);
+        return -1;
+    }
     mapped = mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
     if (mapped == MAP_FAILED) {
         perror("mmap");
@@ -578,6 +605,9 @@ int add_segment(char *elf_name, int type, size_t size) {
  */
 int add_segment_content(char *elf_name, int type, char *content, size_t size) {
     int i = add_segment(elf_name, type, size);
+    if (i == -1) {
+        return -1;
+    }
     uint64_t offset = get_segment_offset(elf_name, i);
     if (set_content(elf_name, offset, content, size)) {
         return -1;
@@ -877,6 +907,9 @@ static int opt_dynamic_segment(char *elfname, int tag, uint64_t *value, enum OPT
                                 break;
                             
                             case SET_SEG:
+                                if (journal_region(elfname, (uint8_t *)&dyn[j] - mapped, sizeof(dyn[j]))) {
+                                    break;
+                                }
                                 printf("%x->%x\n", dyn[j].d_un.d_val, *value);
                                 dyn[j].d_un.d_val = *value;
                                 result = 0;
@@ -920,6 +953,9 @@ static int opt_dynamic_segment(char *elfname, int tag, uint64_t *value, enum OPT
                                 break;
                             
                             case SET_SEG:
+                                if (journal_region(elfname, (uint8_t *)&dyn[j] - mapped, sizeof(dyn[j]))) {
+                                    break;
+                                }
                                 printf("%x->%x\n", dyn[j].d_un.d_val, *value);
                                 dyn[j].d_un.d_val = *value;
                                 result = 0;
@@ -1055,25 +1091,151 @@ int expand_segment(char *elfname, uint64_t offset, size_t org_size, char *add_co
 }
 
 /**
- * @brief 扩充dynstr段，通过将节或者段移动到文件末尾实现。
- * expand dynstr segment by moving it to the end of the file.
+ * @brief 为字符串表中的每个字符串及其后缀建立索引
+ * index every string of the string table and its suffixes
+ * @param map hash map, suffix -> offset
+ * @param buf string table
+ * @param start first offset to index
+ * @param end end offset to index
+ * @return int error code {-1:error,0:sucess}
+ */
+static int index_strtab(hashmap_t *map, char *buf, uint64_t start, uint64_t end) {
+    uint64_t p, q, i;
+    uint64_t hash;
+
+    for (p = start; p < end; p = q + 1) {
+        for (q = p; q < end && buf[q]; q++);
+        // FNV-1a from the last byte to the first one,
+        // so that the hash of a suffix extends the hash of the shorter one
+        hash = FNV_OFFSET_BASIS;
+        for (i = q; i > p; i--) {
+            hash = (hash ^ (uint8_t)buf[i - 1]) * FNV_PRIME;
+            if (hashmap_put(map, hash, buf + i - 1, q - i + 1, i - 1) == -1)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 将新的字符串合并到字符串表，已存在的字符串或后缀复用原有偏移，只追加新的字节
+ * merge new strings into the string table. a string which exists, or is a suffix
+ * of an existing one, reuses its offset, only new bytes are appended
  * @param elfname 
- * @param str new dynstr item
- * @return segment index {-1:error}
+ * @param offset string table offset
+ * @param size string table size
+ * @param strs new strings
+ * @param count number of new strings
+ * @param offsets output, offset of each new string (optional)
+ * @param new_size output, size of the merged string table
+ * @return merged string table, NULL if error
  */
-int expand_dynstr_segment(char *elfname, char *str) {
+static char *merge_strtab(char *elfname, uint64_t offset, size_t size, char **strs, int count, uint64_t *offsets, size_t *new_size) {
+    hashmap_t map;
+    uint64_t hash, str_off;
+    size_t add_size = 0;
+    size_t end, len;
+    char *buf;
+    int fd;
+
+    for (int i = 0; i < count; i++) {
+        add_size += strlen(strs[i]) + 1;
+    }
+    buf = malloc(size + add_size);
+    if (!buf) {
+        return NULL;
+    }
+
+    fd = open(elfname, O_RDONLY);
+    if (fd == -1) {
+        perror("Failed to open file");
+        free(buf);
+        return NULL;
+    }
+    if (pread(fd, buf, size, offset) != size) {
+        perror("Failed to read from file");
+        close(fd);
+        free(buf);
+        return NULL;
+    }
+    close(fd);
+
+    if (hashmap_init(&map, size + add_size) || index_strtab(&map, buf, 0, size)) {
+        hashmap_free(&map);
+        free(buf);
+        return NULL;
+    }
+
+    end = size;
+    for (int i = 0; i < count; i++) {
+        len = strlen(strs[i]);
+        hash = FNV_OFFSET_BASIS;
+        for (size_t j = len; j > 0; j--) {
+            hash = (hash ^ (uint8_t)strs[i][j - 1]) * FNV_PRIME;
+        }
+
+        if (len && !hashmap_get(&map, hash, strs[i], len, &str_off)) {
+            VERBOSE("reuse string %s at 0x%x\n", strs[i], str_off);
+        } else {
+            // the new string and its suffixes are reused by the following strings too
+            str_off = end;
+            memcpy(buf + end, strs[i], len + 1);
+            end += len + 1;
+            if (index_strtab(&map, buf, str_off, end - 1)) {
+                hashmap_free(&map);
+                free(buf);
+                return NULL;
+            }
+        }
+        if (offsets) {
+            offsets[i] = str_off;
+        }
+    }
+
+    hashmap_free(&map);
+    *new_size = end;
+    return buf;
+}
+
+/**
+ * @brief 扩充dynstr段，一次添加多个字符串，通过将节或者段移动到文件末尾实现。
+ * expand dynstr segment with several strings at once by moving it to the end of the file.
+ * existing strings and suffixes are reused.
+ * @param elfname 
+ * @param strs new dynstr items
+ * @param count number of new dynstr items
+ * @param offsets output, offset of each new item in the new dynstr (optional)
+ * @return segment index, 0 if all items exist {-1:error}
+ */
+int expand_dynstr_segment_multi(char *elfname, char **strs, int count, uint64_t *offsets) {
     // get offset and size
     uint64_t addr, offset;
-    size_t size;
+    size_t size, new_size;
     int seg_i, sec_i;
+    char *buf;
     get_dynamic_value_by_tag(elfname, DT_STRTAB, &addr);
     get_dynamic_value_by_tag(elfname, DT_STRSZ, &size);
     VERBOSE("dynamic strtab addr: 0x%x, size: 0x%x\n", addr, size);
 
-    // copy
-    // fix error in expanding segment if addr != offset
-    offset = get_section_offset(elfname, ".dynstr");
-    seg_i = expand_segment(elfname, offset, size, str, strlen(str) + 1);
+    // merge
+    // DT_STRTAB is an address, and addr != offset in most files
+    if (addr_to_offset(elfname, addr, &offset)) {
+        offset = get_section_offset(elfname, ".dynstr");
+    }
+    buf = merge_strtab(elfname, offset, size, strs, count, offsets, &new_size);
+    if (!buf) {
+        return -1;
+    }
+    if (new_size == size) {
+        VERBOSE("all strings exist in .dynstr\n");
+        free(buf);
+        return 0;
+    }
+    seg_i = add_segment_content(elfname, PT_LOAD, buf, new_size);
+    free(buf);
+    if (seg_i == -1) {
+        return -1;
+    }
 
     // set phdr
     VERBOSE("set phdr\n");
@@ -1093,24 +1255,52 @@ int expand_dynstr_segment(char *elfname, char *str) {
 }
 
 /**
- * @brief 扩充strtab，通过将节移动到文件末尾实现。
- * expand strtab section by moving it to the end of the file.
+ * @brief 扩充dynstr段，通过将节或者段移动到文件末尾实现。
+ * expand dynstr segment by moving it to the end of the file.
  * @param elfname 
- * @param str new strtab item
- * @return section index {-1:error}
+ * @param str new dynstr item
+ * @return segment index, 0 if the item exists {-1:error}
  */
-int expand_strtab_section(char *elfname, char *str) {
+int expand_dynstr_segment(char *elfname, char *str) {
+    return expand_dynstr_segment_multi(elfname, &str, 1, NULL);
+}
+
+/**
+ * @brief 扩充strtab，一次添加多个字符串，通过将节移动到文件末尾实现。
+ * expand strtab section with several strings at once by moving it to the end of the file.
+ * existing strings and suffixes are reused.
+ * @param elfname 
+ * @param strs new strtab items
+ * @param count number of new strtab items
+ * @param offsets output, offset of each new item in the new strtab (optional)
+ * @return segment index, 0 if all items exist {-1:error}
+ */
+int expand_strtab_section_multi(char *elfname, char **strs, int count, uint64_t *offsets) {
     uint64_t offset,addr;
-    size_t size;
+    size_t size, new_size;
     int sec_i, seg_i;
+    char *buf;
 
-    // copy
+    // merge
     offset = get_section_offset(elfname, ".strtab");
     size = get_section_size(elfname, ".strtab");
     VERBOSE("strtab offset: 0x%x, size: 0x%x\n", offset, size);
+    buf = merge_strtab(elfname, offset, size, strs, count, offsets, &new_size);
+    if (!buf) {
+        return -1;
+    }
+    if (new_size == size) {
+        VERBOSE("all strings exist in .strtab\n");
+        free(buf);
+        return 0;
+    }
 
     // expand section
-    seg_i = expand_segment(elfname, offset, size, str, strlen(str) + 1);
+    seg_i = add_segment_content(elfname, PT_LOAD, buf, new_size);
+    free(buf);
+    if (seg_i == -1) {
+        return -1;
+    }
     addr = get_segment_vaddr(elfname, seg_i);
     offset = get_segment_offset(elfname, seg_i);
     size = get_segment_memsz(elfname, seg_i);
@@ -1124,6 +1314,17 @@ int expand_strtab_section(char *elfname, char *str) {
     return seg_i;
 }
 
+/**
+ * @brief 扩充strtab，通过将节移动到文件末尾实现。
+ * expand strtab section by moving it to the end of the file.
+ * @param elfname 
+ * @param str new strtab item
+ * @return segment index, 0 if the item exists {-1:error}
+ */
+int expand_strtab_section(char *elfname, char *str) {
+    return expand_strtab_section_multi(elfname, &str, 1, NULL);
+}
+
 /**
  * @brief 添加新的hash节，通过将节移动到文件末尾实现。
  * add a new hash section by moving it to the end of the file.
@@ -62,21 +62,45 @@ int add_segment_content(char *elf_name, int type, char *content, size_t size);
  */
 int expand_segment(char *elfname, uint64_t offset, size_t org_size, char *add_content, size_t content_size);
 
+/**
+ * @brief 扩充dynstr段，一次添加多个字符串，通过将节或者段移动到文件末尾实现。
+ * expand dynstr segment with several strings at once by moving it to the end of the file.
+ * existing strings and suffixes are reused.
+ * @param elfname 
+ * @param strs new dynstr items
+ * @param count number of new dynstr items
+ * @param offsets output, offset of each new item in the new dynstr (optional)
+ * @return segment index, 0 if all items exist {-1:error}
+ */
+int expand_dynstr_segment_multi(char *elfname, char **strs, int count, uint64_t *offsets);
+
 /**
  * @brief 扩充dynstr段，通过将节或者段移动到文件末尾实现。
  * expand dynstr segment by moving it to the end of the file.
  * @param elfname 
  * @param str new dynstr item
- * @return segment index {-1:error}
+ * @return segment index, 0 if the item exists {-1:error}
  */
 int expand_dynstr_segment(char *elfname, char *str);
 
+/**
+ * @brief 扩充strtab，一次添加多个字符串，通过将节移动到文件末尾实现。
+ * expand strtab section with several strings at once by moving it to the end of the file.
+ * existing strings and suffixes are reused.
+ * @param elfname 
+ * @param strs new strtab items
+ * @param count number of new strtab items
+ * @param offsets output, offset of each new item in the new strtab (optional)
+ * @return segment index, 0 if all items exist {-1:error}
+ */
+int expand_strtab_section_multi(char *elfname, char **strs, int count, uint64_t *offsets);
+
 /**
  * @brief 扩充strtab，通过将节移动到文件末尾实现。
  * expand strtab section by moving it to the end of the file.
  * @param elfname 
  * @param str new strtab item
- * @return section index {-1:error}
+ * @return segment index, 0 if the item exists {-1:error}
  */
 int expand_strtab_section(char *elfname, char *str);
 
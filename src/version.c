@@ -0,0 +1,210 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <elf.h>
+#include "common.h"
+#include "version.h"
+
+#define VERSYM_HIDDEN   0x8000
+#define VERSYM_VERSION  0x7fff
+
+typedef struct version_sections {
+    uint64_t versym;
+    uint64_t versym_size;
+    uint64_t verdef;
+    uint64_t verdef_size;
+    uint64_t verdef_str;    // string table of .gnu.version_d
+    uint64_t verneed;
+    uint64_t verneed_size;
+    uint64_t verneed_str;   // string table of .gnu.version_r
+} version_sections_t;
+
+static int get_version_sections(uint8_t *mem, size_t size, version_sections_t *s) {
+    memset(s, 0, sizeof(version_sections_t));
+    if (MODE == ELFCLASS32) {
+        Elf32_Ehdr *ehdr = (Elf32_Ehdr *)mem;
+        Elf32_Shdr *shdr = (Elf32_Shdr *)(mem + ehdr->e_shoff);
+        if (ehdr->e_shoff + ehdr->e_shnum * sizeof(Elf32_Shdr) > size)
+            return -1;
+        for (int i = 0; i < ehdr->e_shnum; i++) {
+            uint64_t str = shdr[i].sh_link < ehdr->e_shnum ? shdr[shdr[i].sh_link].sh_offset : 0;
+            switch (shdr[i].sh_type) {
+                case SHT_GNU_versym:
+                    s->versym = shdr[i].sh_offset;
+                    s->versym_size = shdr[i].sh_size;
+                    break;
+                case SHT_GNU_verdef:
+                    s->verdef = shdr[i].sh_offset;
+                    s->verdef_size = shdr[i].sh_size;
+                    s->verdef_str = str;
+                    break;
+                case SHT_GNU_verneed:
+                    s->verneed = shdr[i].sh_offset;
+                    s->verneed_size = shdr[i].sh_size;
+                    s->verneed_str = str;
+                    break;
+            }
+        }
+    }
+
+    if (MODE == ELFCLASS64) {
+        Elf64_Ehdr *ehdr = (Elf64_Ehdr *)mem;
+        Elf64_Shdr *shdr = (Elf64_Shdr *)(mem + ehdr->e_shoff);
+        if (ehdr->e_shoff + ehdr->e_shnum * sizeof(Elf64_Shdr) > size)
+            return -1;
+        for (int i = 0; i < ehdr->e_shnum; i++) {
+            uint64_t str = shdr[i].sh_link < ehdr->e_shnum ? shdr[shdr[i].sh_link].sh_offset : 0;
+            switch (shdr[i].sh_type) {
+                case SHT_GNU_versym:
+                    s->versym = shdr[i].sh_offset;
+                    s->versym_size = shdr[i].sh_size;
+                    break;
+                case SHT_GNU_verdef:
+                    s->verdef = shdr[i].sh_offset;
+                    s->verdef_size = shdr[i].sh_size;
+                    s->verdef_str = str;
+                    break;
+                case SHT_GNU_verneed:
+                    s->verneed = shdr[i].sh_offset;
+                    s->verneed_size = shdr[i].sh_size;
+                    s->verneed_str = str;
+                    break;
+            }
+        }
+    }
+
+    if (!s->versym || s->versym + s->versym_size > size ||
+        s->verdef + s->verdef_size > size || s->verneed + s->verneed_size > size) {
+        return -1;
+    }
+    return 0;
+}
+
+static int set_version_name(version_index_t *v, uint16_t ndx, uint8_t *mem, size_t size, uint64_t str, uint32_t name) {
+    ndx &= VERSYM_VERSION;
+    if (!str || str + name >= size) {
+        return 0;
+    }
+    if (ndx >= v->name_num) {
+        size_t num = ndx + 1;
+        char **tmp = realloc(v->names, num * sizeof(char *));
+        if (!tmp) {
+            return -1;
+        }
+        memset(tmp + v->name_num, 0, (num - v->name_num) * sizeof(char *));
+        v->names = tmp;
+        v->name_num = num;
+    }
+    v->names[ndx] = (char *)mem + str + name;
+    return 0;
+}
+
+/**
+ * @brief 解析.gnu.version、.gnu.version_d和.gnu.version_r，建立符号版本索引
+ * decode .gnu.version, .gnu.version_d and .gnu.version_r into a version index
+ * of the dynamic symbols
+ * @param mem elf file content
+ * @param size elf file size
+ * @param v output, free it with finit_version_index
+ * @return int error code {-1:error or no version,0:sucess}
+ */
+int init_version_index(uint8_t *mem, size_t size, version_index_t *v) {
+    version_sections_t s;
+    uint64_t pos;
+
+    memset(v, 0, sizeof(version_index_t));
+    if (get_version_sections(mem, size, &s)) {
+        return -1;
+    }
+    v->versym = (uint16_t *)(mem + s.versym);
+    v->sym_num = s.versym_size / sizeof(uint16_t);
+
+    /* Elf32_Verdef and Elf64_Verdef have the same layout, so do the others */
+    pos = s.verdef;
+    while (s.verdef && pos + sizeof(Elf64_Verdef) <= s.verdef + s.verdef_size) {
+        Elf64_Verdef *vd = (Elf64_Verdef *)(mem + pos);
+        if (vd->vd_aux && pos + vd->vd_aux + sizeof(Elf64_Verdaux) <= s.verdef + s.verdef_size) {
+            Elf64_Verdaux *vda = (Elf64_Verdaux *)(mem + pos + vd->vd_aux);
+            if (set_version_name(v, vd->vd_ndx, mem, size, s.verdef_str, vda->vda_name))
+                goto ERR_EXIT;
+        }
+        if (!vd->vd_next)
+            break;
+        pos += vd->vd_next;
+    }
+
+    pos = s.verneed;
+    while (s.verneed && pos + sizeof(Elf64_Verneed) <= s.verneed + s.verneed_size) {
+        Elf64_Verneed *vn = (Elf64_Verneed *)(mem + pos);
+        uint64_t aux = pos + vn->vn_aux;
+        for (int i = 0; i < vn->vn_cnt && vn->vn_aux && aux + sizeof(Elf64_Vernaux) <= s.verneed + s.verneed_size; i++) {
+            Elf64_Vernaux *vna = (Elf64_Vernaux *)(mem + aux);
+            if (set_version_name(v, vna->vna_other, mem, size, s.verneed_str, vna->vna_name))
+                goto ERR_EXIT;
+            if (!vna->vna_next)
+                break;
+            aux += vna->vna_next;
+        }
+        if (!vn->vn_next)
+            break;
+        pos += vn->vn_next;
+    }
+    return 0;
+
+ERR_EXIT:
+    finit_version_index(v);
+    return -1;
+}
+
+void finit_version_index(version_index_t *v) {
+    free(v->names);
+    memset(v, 0, sizeof(version_index_t));
+}
+
+/**
+ * @brief 通过符号下标得到版本名，O(1)
+ * get the version name of a dynamic symbol by its index in O(1)
+ * @param v version index
+ * @param index dynamic symbol index
+ * @param hidden output, the version is hidden (optional)
+ * @return char* version name, NULL for local, global and unknown versions
+ */
+char *get_symbol_version(version_index_t *v, size_t index, int *hidden) {
+    uint16_t ndx;
+
+    if (index >= v->sym_num) {
+        return NULL;
+    }
+    ndx = v->versym[index] & VERSYM_VERSION;
+    if (hidden)
+        *hidden = !!(v->versym[index] & VERSYM_HIDDEN);
+    if (ndx <= VER_NDX_GLOBAL || ndx >= v->name_num) {
+        return NULL;
+    }
+    return v->names[ndx];
+}
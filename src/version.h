@@ -0,0 +1,53 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+/* version names of the dynamic symbols, decoded from .gnu.version_d and .gnu.version_r */
+typedef struct version_index {
+    char **names;           // name of each version index, NULL if it is not defined
+    size_t name_num;
+    uint16_t *versym;       // .gnu.version, one entry per dynamic symbol
+    size_t sym_num;
+} version_index_t;
+
+/**
+ * @brief 解析.gnu.version、.gnu.version_d和.gnu.version_r，建立符号版本索引
+ * decode .gnu.version, .gnu.version_d and .gnu.version_r into a version index
+ * of the dynamic symbols
+ * @param mem elf file content
+ * @param size elf file size
+ * @param v output, free it with finit_version_index
+ * @return int error code {-1:error or no version,0:sucess}
+ */
+int init_version_index(uint8_t *mem, size_t size, version_index_t *v);
+void finit_version_index(version_index_t *v);
+
+/**
+ * @brief 通过符号下标得到版本名，O(1)
+ * get the version name of a dynamic symbol by its index in O(1)
+ * @param v version index
+ * @param index dynamic symbol index
+ * @param hidden output, the version is hidden (optional)
+ * @return char* version name, NULL for local, global and unknown versions
+ */
+char *get_symbol_version(version_index_t *v, size_t index, int *hidden);
@@ -0,0 +1,525 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <elf.h>
+#include "common.h"
+#include "relr.h"
+#include "vimage.h"
+
+/* dynamic entries used by the view */
+typedef struct vimage_dyn {
+    uint64_t rela;
+    uint64_t relasz;
+    uint64_t rel;
+    uint64_t relsz;
+    uint64_t jmprel;
+    uint64_t pltrelsz;
+    uint64_t pltrel;
+    uint64_t relr;
+    uint64_t relrsz;
+    uint64_t symtab;
+    uint64_t strtab;
+    uint64_t strsz;
+} vimage_dyn_t;
+
+/* absolute relocations of a symbol, REL takes the addend from the word */
+static int is_abs_type(int machine, uint32_t type) {
+    switch (machine) {
+        case EM_386:        return type == R_386_32;
+        case EM_X86_64:     return type == R_X86_64_64;
+        case EM_ARM:        return type == R_ARM_ABS32;
+        case EM_AARCH64:    return type == R_AARCH64_ABS64;
+        default:            return 0;
+    }
+}
+
+static int is_glob_dat_type(int machine, uint32_t type) {
+    switch (machine) {
+        case EM_386:        return type == R_386_GLOB_DAT;
+        case EM_X86_64:     return type == R_X86_64_GLOB_DAT;
+        case EM_ARM:        return type == R_ARM_GLOB_DAT;
+        case EM_AARCH64:    return type == R_AARCH64_GLOB_DAT;
+        default:            return 0;
+    }
+}
+
+static int is_slot_type(int machine, uint32_t type) {
+    switch (machine) {
+        case EM_386:        return type == R_386_JMP_SLOT;
+        case EM_X86_64:     return type == R_X86_64_JUMP_SLOT;
+        case EM_ARM:        return type == R_ARM_JUMP_SLOT;
+        case EM_AARCH64:    return type == R_AARCH64_JUMP_SLOT;
+        default:            return 0;
+    }
+}
+
+static int compare_vreloc(const void *a, const void *b) {
+    const vreloc_t *x = a, *y = b;
+    if (x->offset != y->offset)
+        return x->offset < y->offset ? -1 : 1;
+    return x->seq < y->seq ? -1 : 1;
+}
+
+static int get_vimage_dyn(vimage_t *v, vimage_dyn_t *dyn) {
+    int found = 0;
+
+    memset(dyn, 0, sizeof(vimage_dyn_t));
+    if (MODE == ELFCLASS32) {
+        Elf32_Ehdr *ehdr = (Elf32_Ehdr *)v->mem;
+        Elf32_Phdr *phdr = (Elf32_Phdr *)(v->mem + ehdr->e_phoff);
+        for (int i = 0; i < ehdr->e_phnum; i++) {
+            if (phdr[i].p_type != PT_DYNAMIC || phdr[i].p_offset + phdr[i].p_filesz > v->size)
+                continue;
+            Elf32_Dyn *d = (Elf32_Dyn *)(v->mem + phdr[i].p_offset);
+            for (int j = 0; j < phdr[i].p_filesz / sizeof(Elf32_Dyn) && d[j].d_tag != DT_NULL; j++) {
+                switch (d[j].d_tag) {
+                    case DT_RELA:       dyn->rela = d[j].d_un.d_ptr; break;
+                    case DT_RELASZ:     dyn->relasz = d[j].d_un.d_val; break;
+                    case DT_REL:        dyn->rel = d[j].d_un.d_ptr; break;
+                    case DT_RELSZ:      dyn->relsz = d[j].d_un.d_val; break;
+                    case DT_JMPREL:     dyn->jmprel = d[j].d_un.d_ptr; break;
+                    case DT_PLTRELSZ:   dyn->pltrelsz = d[j].d_un.d_val; break;
+                    case DT_PLTREL:     dyn->pltrel = d[j].d_un.d_val; break;
+                    case DT_RELR:       dyn->relr = d[j].d_un.d_ptr; break;
+                    case DT_RELRSZ:     dyn->relrsz = d[j].d_un.d_val; break;
+                    case DT_SYMTAB:     dyn->symtab = d[j].d_un.d_ptr; break;
+                    case DT_STRTAB:     dyn->strtab = d[j].d_un.d_ptr; break;
+                    case DT_STRSZ:      dyn->strsz = d[j].d_un.d_val; break;
+                }
+            }
+            found = 1;
+            break;
+        }
+    }
+
+    if (MODE == ELFCLASS64) {
+        Elf64_Ehdr *ehdr = (Elf64_Ehdr *)v->mem;
+        Elf64_Phdr *phdr = (Elf64_Phdr *)(v->mem + ehdr->e_phoff);
+        for (int i = 0; i < ehdr->e_phnum; i++) {
+            if (phdr[i].p_type != PT_DYNAMIC || phdr[i].p_offset + phdr[i].p_filesz > v->size)
+                continue;
+            Elf64_Dyn *d = (Elf64_Dyn *)(v->mem + phdr[i].p_offset);
+            for (int j = 0; j < phdr[i].p_filesz / sizeof(Elf64_Dyn) && d[j].d_tag != DT_NULL; j++) {
+                switch (d[j].d_tag) {
+                    case DT_RELA:       dyn->rela = d[j].d_un.d_ptr; break;
+                    case DT_RELASZ:     dyn->relasz = d[j].d_un.d_val; break;
+                    case DT_REL:        dyn->rel = d[j].d_un.d_ptr; break;
+                    case DT_RELSZ:      dyn->relsz = d[j].d_un.d_val; break;
+                    case DT_JMPREL:     dyn->jmprel = d[j].d_un.d_ptr; break;
+                    case DT_PLTRELSZ:   dyn->pltrelsz = d[j].d_un.d_val; break;
+                    case DT_PLTREL:     dyn->pltrel = d[j].d_un.d_val; break;
+                    case DT_RELR:       dyn->relr = d[j].d_un.d_ptr; break;
+                    case DT_RELRSZ:     dyn->relrsz = d[j].d_un.d_val; break;
+                    case DT_SYMTAB:     dyn->symtab = d[j].d_un.d_ptr; break;
+                    case DT_STRTAB:     dyn->strtab = d[j].d_un.d_ptr; break;
+                    case DT_STRSZ:      dyn->strsz = d[j].d_un.d_val; break;
+                }
+            }
+            found = 1;
+            break;
+        }
+    }
+    return found ? 0 : -1;
+}
+
+/**
+ * @brief 收集一个重定位表中视图需要应用的重定位
+ * collect the relocations of a table which the view applies
+ * @param v view
+ * @param addr table address
+ * @param size table size
+ * @param is_rela RELA or REL
+ * @param cap capacity of v->relocs
+ * @return int error code {-1:error,0:sucess}
+ */
+static int add_vrelocs(vimage_t *v, uint64_t addr, uint64_t size, int is_rela, size_t cap) {
+    int machine = ((Elf32_Ehdr *)v->mem)->e_machine;
+    int relative_type = get_relative_type(machine);
+    int irelative_type = get_irelative_type(machine);
+    size_t ent_size;
+    uint64_t table, target;
+
+    if (!addr || !size) {
+        return 0;
+    }
+    if (MODE == ELFCLASS32)
+        ent_size = is_rela ? sizeof(Elf32_Rela) : sizeof(Elf32_Rel);
+    else
+        ent_size = is_rela ? sizeof(Elf64_Rela) : sizeof(Elf64_Rel);
+    if (load_addr_to_offset(&v->loads, addr, size, &table)) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < size / ent_size && v->reloc_num < cap; i++) {
+        uint8_t *p = v->mem + table + i * ent_size;
+        vreloc_t *r = &v->relocs[v->reloc_num];
+        uint64_t r_offset;
+        uint32_t type;
+
+        memset(r, 0, sizeof(vreloc_t));
+        if (MODE == ELFCLASS32) {
+            r_offset = ((Elf32_Rel *)p)->r_offset;
+            type = ELF32_R_TYPE(((Elf32_Rel *)p)->r_info);
+            r->sym = ELF32_R_SYM(((Elf32_Rel *)p)->r_info);
+            if (is_rela)
+                r->addend = ((Elf32_Rela *)p)->r_addend;
+        } else {
+            r_offset = ((Elf64_Rel *)p)->r_offset;
+            type = ELF64_R_TYPE(((Elf64_Rel *)p)->r_info);
+            r->sym = ELF64_R_SYM(((Elf64_Rel *)p)->r_info);
+            if (is_rela)
+                r->addend = ((Elf64_Rela *)p)->r_addend;
+        }
+
+        if (type == relative_type) {
+            r->kind = VRELOC_RELATIVE;
+            r->implicit = !is_rela;
+        } else if (type == irelative_type) {
+            r->kind = VRELOC_IRELATIVE;
+            r->implicit = !is_rela;
+        } else if (r->sym && is_slot_type(machine, type)) {
+            r->kind = VRELOC_SLOT;
+        } else if (r->sym && is_glob_dat_type(machine, type)) {
+            r->kind = VRELOC_SYMBOL;
+        } else if (r->sym && is_abs_type(machine, type)) {
+            r->kind = VRELOC_SYMBOL;
+            r->implicit = !is_rela;
+        } else {
+            /* TLS and COPY relocations are not pointers of the image */
+            continue;
+        }
+        if (load_addr_to_offset(&v->loads, r_offset, v->word_size, &target)) {
+            continue;
+        }
+        r->offset = target;
+        r->seq = v->reloc_num;
+        v->reloc_num++;
+    }
+    return 0;
+}
+
+/**
+ * @brief 建立重定位后的映像视图，读取某页时才对该页批量应用RELATIVE等重定位
+ * build a relocated view of the file at a chosen base address. the RELATIVE
+ * (and optionally symbol) relocations of a page are applied in one batch when
+ * the page is read first
+ * @param mem elf file content
+ * @param size elf file size
+ * @param base load base address
+ * @param flags VIMAGE_SYMBOL or 0
+ * @param v output, free it with finit_vimage
+ * @return int error code {-1:error,0:sucess}
+ */
+int init_vimage(uint8_t *mem, size_t size, uint64_t base, int flags, vimage_t *v) {
+    vimage_dyn_t dyn;
+    uint64_t *addrs = NULL;
+    size_t relr_num = 0, cap;
+    uint64_t offset;
+    size_t rel_ent, rela_ent;
+
+    memset(v, 0, sizeof(vimage_t));
+    v->mem = mem;
+    v->size = size;
+    v->base = base;
+    v->flags = flags;
+    v->word_size = MODE == ELFCLASS32 ? 4 : 8;
+    rel_ent = MODE == ELFCLASS32 ? sizeof(Elf32_Rel) : sizeof(Elf64_Rel);
+    rela_ent = MODE == ELFCLASS32 ? sizeof(Elf32_Rela) : sizeof(Elf64_Rela);
+
+    if (init_load_index(mem, size, &v->loads)) {
+        return -1;
+    }
+    v->page_num = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+    v->pages = calloc(v->page_num + 1, sizeof(uint8_t *));
+    if (!v->pages) {
+        goto ERR_EXIT;
+    }
+
+    /* a file without dynamic segment is shown as it is */
+    if (get_vimage_dyn(v, &dyn)) {
+        return 0;
+    }
+    if (dyn.symtab && !load_addr_to_offset(&v->loads, dyn.symtab, 1, &offset))
+        v->symtab = offset;
+    if (dyn.strtab && !load_addr_to_offset(&v->loads, dyn.strtab, 1, &offset)) {
+        v->strtab = offset;
+        v->strsz = dyn.strsz;
+    }
+    if (dyn.relr && dyn.relrsz && !load_addr_to_offset(&v->loads, dyn.relr, dyn.relrsz, &offset)) {
+        if (decode_relr(mem + offset, dyn.relrsz, v->word_size, &addrs, &relr_num)) {
+            goto ERR_EXIT;
+        }
+    }
+
+    cap = dyn.relasz / rela_ent + dyn.relsz / rel_ent + dyn.pltrelsz / rel_ent + relr_num;
+    v->relocs = malloc((cap + 1) * sizeof(vreloc_t));
+    if (!v->relocs) {
+        goto ERR_EXIT;
+    }
+
+    /* some linkers count DT_JMPREL in DT_RELASZ, which is added once */
+    if (dyn.jmprel >= dyn.rela && dyn.jmprel < dyn.rela + dyn.relasz)
+        dyn.relasz = dyn.jmprel - dyn.rela;
+    if (dyn.jmprel >= dyn.rel && dyn.jmprel < dyn.rel + dyn.relsz)
+        dyn.relsz = dyn.jmprel - dyn.rel;
+    add_vrelocs(v, dyn.rel, dyn.relsz, 0, cap);
+    add_vrelocs(v, dyn.rela, dyn.relasz, 1, cap);
+    add_vrelocs(v, dyn.jmprel, dyn.pltrelsz, dyn.pltrel == DT_RELA, cap);
+    for (size_t i = 0; i < relr_num && v->reloc_num < cap; i++) {
+        vreloc_t *r = &v->relocs[v->reloc_num];
+        if (load_addr_to_offset(&v->loads, addrs[i], v->word_size, &offset))
+            continue;
+        memset(r, 0, sizeof(vreloc_t));
+        r->offset = offset;
+        r->kind = VRELOC_RELATIVE;
+        r->implicit = 1;
+        r->seq = v->reloc_num;
+        v->reloc_num++;
+    }
+    free(addrs);
+
+    qsort(v->relocs, v->reloc_num, sizeof(vreloc_t), compare_vreloc);
+    return 0;
+
+ERR_EXIT:
+    free(addrs);
+    finit_vimage(v);
+    return -1;
+}
+
+void finit_vimage(vimage_t *v) {
+    for (size_t i = 0; v->pages && i < v->page_num; i++) {
+        if (v->pages[i] && v->pages[i] != v->mem + i * PAGE_SIZE)
+            free(v->pages[i]);
+    }
+    free(v->pages);
+    free(v->relocs);
+    finit_load_index(&v->loads);
+    memset(v, 0, sizeof(vimage_t));
+}
+
+/* the first relocation whose word ends after offset */
+static size_t search_vreloc(vimage_t *v, uint64_t offset) {
+    size_t lo = 0, hi = v->reloc_num;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (v->relocs[mid].offset + v->word_size <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief 读取动态符号
+ * read a dynamic symbol
+ * @param v view
+ * @param index symbol index
+ * @param value output, symbol value
+ * @param name output, symbol name, NULL if it is out of DT_STRTAB
+ * @return int {-1:error, 0:undefined, 1:defined}
+ */
+static int get_vsym(vimage_t *v, uint32_t index, uint64_t *value, char **name) {
+    uint32_t st_name;
+    uint16_t shndx;
+
+    if (!v->symtab) {
+        return -1;
+    }
+    if (MODE == ELFCLASS32) {
+        Elf32_Sym *sym = (Elf32_Sym *)(v->mem + v->symtab) + index;
+        if (v->symtab + (index + 1) * sizeof(Elf32_Sym) > v->size)
+            return -1;
+        *value = sym->st_value;
+        st_name = sym->st_name;
+        shndx = sym->st_shndx;
+    } else {
+        Elf64_Sym *sym = (Elf64_Sym *)(v->mem + v->symtab) + index;
+        if (v->symtab + (index + 1) * sizeof(Elf64_Sym) > v->size)
+            return -1;
+        *value = sym->st_value;
+        st_name = sym->st_name;
+        shndx = sym->st_shndx;
+    }
+    *name = NULL;
+    if (v->strtab && st_name < v->strsz && v->strtab + st_name < v->size)
+        *name = (char *)v->mem + v->strtab + st_name;
+    return shndx != SHN_UNDEF;
+}
+
+/**
+ * @brief 计算重定位后的值
+ * compute the relocated word
+ * @return int {0:keep the word of the file, 1:relocated}
+ */
+static int get_vreloc_value(vimage_t *v, vreloc_t *r, uint64_t *value) {
+    uint64_t word = 0, sym_value;
+    uint64_t addend;
+    char *name;
+    int defined = 0;
+
+    memcpy(&word, v->mem + r->offset, r->offset + v->word_size <= v->size ? v->word_size : v->size - r->offset);
+    addend = r->implicit ? word : r->addend;
+    switch (r->kind) {
+        case VRELOC_RELATIVE:
+        case VRELOC_IRELATIVE:
+            /* the resolver of IRELATIVE is not called, show its address */
+            *value = v->base + addend;
+            return 1;
+        case VRELOC_SYMBOL:
+        case VRELOC_SLOT:
+            if (v->flags & VIMAGE_SYMBOL)
+                defined = get_vsym(v, r->sym, &sym_value, &name) == 1;
+            if (defined) {
+                *value = v->base + sym_value + addend;
+                return 1;
+            }
+            /* a lazy slot points back into the PLT of the image */
+            if (r->kind == VRELOC_SLOT && word) {
+                *value = v->base + word;
+                return 1;
+            }
+            return 0;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief 第一次读取某页时，复制该页并批量应用落在页内的重定位
+ * apply the relocations of a page in one batch when it is read first,
+ * a page without relocations is shared with the file
+ */
+static uint8_t *get_vpage(vimage_t *v, size_t index) {
+    uint64_t start = index * PAGE_SIZE;
+    uint64_t end = start + PAGE_SIZE > v->size ? v->size : start + PAGE_SIZE;
+    size_t i = search_vreloc(v, start);
+    uint8_t *page;
+
+    if (v->pages[index]) {
+        return v->pages[index];
+    }
+    if (i == v->reloc_num || v->relocs[i].offset >= end) {
+        v->pages[index] = v->mem + start;
+        return v->pages[index];
+    }
+
+    page = malloc(PAGE_SIZE);
+    if (!page) {
+        return NULL;
+    }
+    memcpy(page, v->mem + start, end - start);
+    for (; i < v->reloc_num && v->relocs[i].offset < end; i++) {
+        vreloc_t *r = &v->relocs[i];
+        uint8_t bytes[8];
+        uint64_t value;
+
+        if (!get_vreloc_value(v, r, &value)) {
+            continue;
+        }
+        memcpy(bytes, &value, sizeof(bytes));
+        /* a word across two pages is clipped, each page writes its part */
+        for (int j = 0; j < v->word_size; j++) {
+            if (r->offset + j >= start && r->offset + j < end)
+                page[r->offset + j - start] = bytes[j];
+        }
+    }
+    v->pages[index] = page;
+    return page;
+}
+
+/**
+ * @brief 读取视图中某个地址的内容
+ * read the relocated bytes at a virtual address
+ * @param v view
+ * @param addr virtual address, relative to base 0
+ * @param buf output
+ * @param size size to read
+ * @return int error code {-1:error,0:sucess}
+ */
+int vimage_read(vimage_t *v, uint64_t addr, void *buf, size_t size) {
+    uint64_t offset;
+    size_t done = 0;
+
+    if (load_addr_to_offset(&v->loads, addr, size, &offset) || offset + size > v->size) {
+        return -1;
+    }
+    while (done < size) {
+        size_t index = (offset + done) / PAGE_SIZE;
+        size_t in_page = (offset + done) % PAGE_SIZE;
+        size_t n = PAGE_SIZE - in_page;
+        uint8_t *page = get_vpage(v, index);
+
+        if (!page) {
+            return -1;
+        }
+        if (n > size - done)
+            n = size - done;
+        memcpy((uint8_t *)buf + done, page + in_page, n);
+        done += n;
+    }
+    return 0;
+}
+
+/**
+ * @brief 读取视图中某个地址的指针
+ * read a relocated pointer at a virtual address
+ * @param v view
+ * @param addr virtual address, relative to base 0
+ * @param value output
+ * @return int error code {-1:error,0:sucess}
+ */
+int vimage_read_word(vimage_t *v, uint64_t addr, uint64_t *value) {
+    *value = 0;
+    return vimage_read(v, addr, value, v->word_size);
+}
+
+/**
+ * @brief 得到某个地址上符号重定位的符号名
+ * get the symbol name of the relocation at a virtual address
+ * @param v view
+ * @param addr virtual address, relative to base 0
+ * @return char* symbol name, NULL if no symbol relocation is there
+ */
+char *vimage_get_symbol(vimage_t *v, uint64_t addr) {
+    uint64_t offset, value;
+    char *name = NULL, *tmp;
+    size_t i;
+
+    if (load_addr_to_offset(&v->loads, addr, v->word_size, &offset)) {
+        return NULL;
+    }
+    for (i = search_vreloc(v, offset); i < v->reloc_num && v->relocs[i].offset <= offset; i++) {
+        vreloc_t *r = &v->relocs[i];
+        if (r->offset != offset || (r->kind != VRELOC_SYMBOL && r->kind != VRELOC_SLOT))
+            continue;
+        if (get_vsym(v, r->sym, &value, &tmp) >= 0 && tmp)
+            name = tmp;
+    }
+    return name;
+}
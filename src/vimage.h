@@ -0,0 +1,106 @@
+/*
+ MIT License
+
+ Copyright (c) 2025 SecNotes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+*/
+
+/* also apply the relocations of the symbols defined in the file */
+#define VIMAGE_SYMBOL 1
+
+/* kinds of the relocations applied by the view */
+enum VRELOC_KIND {
+    VRELOC_RELATIVE = 1,    // base + addend
+    VRELOC_IRELATIVE,       // base + addend, the address of the IFUNC resolver
+    VRELOC_SYMBOL,          // base + symbol value + addend
+    VRELOC_SLOT,            // PLT slot, base + lazy stub address until bound
+};
+
+/* a dynamic relocation of one word */
+typedef struct vreloc {
+    uint64_t offset;        // file offset of the relocated word
+    int64_t addend;
+    uint32_t sym;           // index in DT_SYMTAB
+    uint16_t kind;
+    uint16_t implicit;      // REL, the addend is the word in the file
+    size_t seq;             // order of the relocation, the later one wins
+} vreloc_t;
+
+/* a relocated view of the file at a chosen base address */
+typedef struct vimage {
+    uint8_t *mem;           // file content, never modified
+    size_t size;
+    uint64_t base;
+    int flags;
+    int word_size;
+    load_index_t loads;
+    vreloc_t *relocs;       // sorted by file offset
+    size_t reloc_num;
+    uint8_t **pages;        // relocated copy of each page, built when it is read
+    size_t page_num;
+    uint64_t symtab;        // file offset of DT_SYMTAB
+    uint64_t strtab;        // file offset of DT_STRTAB
+    uint64_t strsz;
+} vimage_t;
+
+/**
+ * @brief 建立重定位后的映像视图，读取某页时才对该页批量应用RELATIVE等重定位
+ * build a relocated view of the file at a chosen base address. the RELATIVE
+ * (and optionally symbol) relocations of a page are applied in one batch when
+ * the page is read first
+ * @param mem elf file content
+ * @param size elf file size
+ * @param base load base address
+ * @param flags VIMAGE_SYMBOL or 0
+ * @param v output, free it with finit_vimage
+ * @return int error code {-1:error,0:sucess}
+ */
+int init_vimage(uint8_t *mem, size_t size, uint64_t base, int flags, vimage_t *v);
+void finit_vimage(vimage_t *v);
+
+/**
+ * @brief 读取视图中某个地址的内容
+ * read the relocated bytes at a virtual address
+ * @param v view
+ * @param addr virtual address, relative to base 0
+ * @param buf output
+ * @param size size to read
+ * @return int error code {-1:error,0:sucess}
+ */
+int vimage_read(vimage_t *v, uint64_t addr, void *buf, size_t size);
+
+/**
+ * @brief 读取视图中某个地址的指针
+ * read a relocated pointer at a virtual address
+ * @param v view
+ * @param addr virtual address, relative to base 0
+ * @param value output
+ * @return int error code {-1:error,0:sucess}
+ */
+int vimage_read_word(vimage_t *v, uint64_t addr, uint64_t *value);
+
+/**
+ * @brief 得到某个地址上符号重定位的符号名
+ * get the symbol name of the relocation at a virtual address
+ * @param v view
+ * @param addr virtual address, relative to base 0
+ * @return char* symbol name, NULL if no symbol relocation is there
+ */
+char *vimage_get_symbol(vimage_t *v, uint64_t addr);